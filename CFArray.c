@@ -27,9 +27,13 @@
 */
 
 #include <CoreFoundation/CFArray.h>
+#include <CoreFoundation/CFNumber.h>
+#include <CoreFoundation/CFDate.h>
+#include <CoreFoundation/CFString.h>
 #include <CoreFoundation/CFPriv.h>
 #include "CFInternal.h"
 #include <string.h>
+#include <math.h>
 
 
 const CFArrayCallBacks kCFTypeArrayCallBacks = {0, __CFTypeCollectionRetain, __CFTypeCollectionRelease, CFCopyDescription, CFEqual};
@@ -119,7 +123,9 @@ CF_INLINE void __CFArraySetCount(CFArrayRef array, CFIndex v) {
 }
 
 /* Only applies to immutable and mutable-deque-using arrays;
- * Returns the bucket holding the left-most real value in the latter case. */
+ * Returns the bucket holding the left-most real value in the latter case.
+ * A deque may wrap around the end of its store, so in that case only the
+ * buckets up to the end of the store follow this one contiguously. */
 CF_INLINE struct __CFArrayBucket *__CFArrayGetBucketsPtr(CFArrayRef array) {
     switch (__CFArrayGetType(array)) {
     case __kCFArrayImmutable:
@@ -132,12 +138,29 @@ CF_INLINE struct __CFArrayBucket *__CFArrayGetBucketsPtr(CFArrayRef array) {
     return NULL;
 }
 
+CF_INLINE struct __CFArrayBucket *__CFArrayDequeGetRawBuckets(struct __CFArrayDeque *deque) {
+    return (struct __CFArrayBucket *)((uint8_t *)deque + sizeof(struct __CFArrayDeque));
+}
+
+/* The deque is used as a ring: the values start at _leftIdx and continue,
+ * wrapping around to bucket 0, for _count buckets. Returns true if the
+ * values currently cross the end of the store. */
+CF_INLINE bool __CFArrayDequeIsWrapped(CFArrayRef array) {
+    struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
+    return NULL != deque && deque->_capacity < deque->_leftIdx + (uintptr_t)__CFArrayGetCount(array);
+}
+
 /* This shouldn't be called if the array count is 0. */
 CF_INLINE struct __CFArrayBucket *__CFArrayGetBucketAtIndex(CFArrayRef array, CFIndex idx) {
     switch (__CFArrayGetType(array)) {
     case __kCFArrayImmutable:
-    case __kCFArrayDeque:
 	return __CFArrayGetBucketsPtr(array) + idx;
+    case __kCFArrayDeque: {
+	struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
+	uintptr_t slot = deque->_leftIdx + idx;
+	if (deque->_capacity <= slot) slot -= deque->_capacity;
+	return __CFArrayDequeGetRawBuckets(deque) + slot;
+    }
     }
     return NULL;
 }
@@ -215,16 +238,16 @@ static void __CFArrayReleaseValues(CFArrayRef array, CFRange range, bool release
     case __kCFArrayDeque: {
 	struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
 	if (0 < range.length && NULL != deque && !hasBeenFinalized(array)) {
-	    struct __CFArrayBucket *buckets = __CFArrayGetBucketsPtr(array);
 	    if (NULL != cb->release) {
 		allocator = __CFGetAllocator(array);
 		for (idx = 0; idx < range.length; idx++) {
-		    INVOKE_CALLBACK2(cb->release, allocator, buckets[idx + range.location]._item);
-		    buckets[idx + range.location]._item = NULL; // GC:  break strong reference.
+		    struct __CFArrayBucket *bucket = __CFArrayGetBucketAtIndex(array, idx + range.location);
+		    INVOKE_CALLBACK2(cb->release, allocator, bucket->_item);
+		    bucket->_item = NULL; // GC:  break strong reference.
 		}
             } else {
 		for (idx = 0; idx < range.length; idx++) {
-		    buckets[idx + range.location]._item = NULL; // GC:  break strong reference.
+		    __CFArrayGetBucketAtIndex(array, idx + range.location)->_item = NULL; // GC:  break strong reference.
 		}
 	    }
 	}
@@ -599,6 +622,28 @@ const void *_CFArrayCheckAndGetValueAtIndex(CFArrayRef array, CFIndex idx) {
 }
 
 
+/* Copies values out of a deque, in two pieces if the range wraps around the end of the store. */
+static void __CFArrayDequeGetValues(CFArrayRef array, CFRange range, const void **values) {
+    struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
+    struct __CFArrayBucket *buckets = __CFArrayDequeGetRawBuckets(deque);
+    uintptr_t start = deque->_leftIdx + range.location;
+    if (deque->_capacity <= start) start -= deque->_capacity;
+    CFIndex head = __CFMin(range.length, (CFIndex)(deque->_capacity - start));
+    objc_memmove_collectable(values, buckets + start, head * sizeof(struct __CFArrayBucket));
+    if (head < range.length) objc_memmove_collectable(values + head, buckets, (range.length - head) * sizeof(struct __CFArrayBucket));
+}
+
+/* Copies values into a deque, in two pieces if the range wraps around the end of the store. */
+static void __CFArrayDequeSetValues(CFArrayRef array, CFRange range, const void **values) {
+    struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
+    struct __CFArrayBucket *buckets = __CFArrayDequeGetRawBuckets(deque);
+    uintptr_t start = deque->_leftIdx + range.location;
+    if (deque->_capacity <= start) start -= deque->_capacity;
+    CFIndex head = __CFMin(range.length, (CFIndex)(deque->_capacity - start));
+    objc_memmove_collectable(buckets + start, values, head * sizeof(struct __CFArrayBucket));
+    if (head < range.length) objc_memmove_collectable(buckets, values + head, (range.length - head) * sizeof(struct __CFArrayBucket));
+}
+
 void CFArrayGetValues(CFArrayRef array, CFRange range, const void **values) {
     CF_OBJC_FUNCDISPATCHV(CFArrayGetTypeID(), void, (NSArray *)array, getObjects:(id *)values range:NSMakeRange(range.location, range.length));
     __CFGenericValidateType(array, CFArrayGetTypeID());
@@ -608,9 +653,11 @@ void CFArrayGetValues(CFArrayRef array, CFRange range, const void **values) {
     if (0 < range.length) {
 	switch (__CFArrayGetType(array)) {
 	case __kCFArrayImmutable:
-	case __kCFArrayDeque:
 	    objc_memmove_collectable(values, __CFArrayGetBucketsPtr(array) + range.location, range.length * sizeof(struct __CFArrayBucket));
 	    break;
+	case __kCFArrayDeque:
+	    __CFArrayDequeGetValues(array, range, values);
+	    break;
 	}
     }
 }
@@ -618,7 +665,7 @@ void CFArrayGetValues(CFArrayRef array, CFRange range, const void **values) {
 CF_EXPORT unsigned long _CFArrayFastEnumeration(CFArrayRef array, struct __objcFastEnumerationStateEquivalent *state, void *stackbuffer, unsigned long count) {
     CHECK_FOR_MUTATION(array);
     if (array->_count == 0) return 0;
-    enum { ATSTART = 0, ATEND = 1 };
+    enum { ATSTART = 0, ATEND = 1, ATWRAP = 2 };
     switch (__CFArrayGetType(array)) {
     case __kCFArrayImmutable:
         if (state->state == ATSTART) { /* first time */
@@ -629,15 +676,27 @@ CF_EXPORT unsigned long _CFArrayFastEnumeration(CFArrayRef array, struct __objcF
             return array->_count;
         }
         return 0;			
-    case __kCFArrayDeque:
+    case __kCFArrayDeque: {
+        struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
+        CFIndex head = deque->_capacity - deque->_leftIdx;
         if (state->state == ATSTART) { /* first time */
-            state->state = ATEND;
             state->mutationsPtr = (unsigned long *)&array->_mutations;
             state->itemsPtr = (unsigned long *)__CFArrayGetBucketsPtr(array);
+            if (head < array->_count) { /* values wrap; hand out the rest from bucket 0 next time */
+                state->state = ATWRAP;
+                return head;
+            }
+            state->state = ATEND;
             return array->_count;
         }
+        if (state->state == ATWRAP) {
+            state->state = ATEND;
+            state->itemsPtr = (unsigned long *)__CFArrayDequeGetRawBuckets(deque);
+            return array->_count - head;
+        }
         return 0;
     }
+    }
     return 0;
 }
 
@@ -771,7 +830,29 @@ void CFArrayRemoveAllValues(CFMutableArrayRef array) {
     END_MUTATION(array);
 }
 
+static void __CFArrayReverseBuckets(struct __CFArrayBucket *buckets, CFIndex lo, CFIndex hi) {
+    while (lo < --hi) {
+	const void *tmp = buckets[lo]._item;
+	buckets[lo]._item = buckets[hi]._item;
+	buckets[hi]._item = tmp;
+	lo++;
+    }
+}
+
+// rotates a wrapped deque in place so its values start at bucket 0 and are
+// contiguous again; the empty (zeroed) buckets end up after them
+static void __CFArrayDequeLinearize(CFMutableArrayRef array) {
+    struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
+    struct __CFArrayBucket *buckets = __CFArrayDequeGetRawBuckets(deque);
+    CFIndex L = deque->_leftIdx, capacity = deque->_capacity;
+    __CFArrayReverseBuckets(buckets, 0, L);
+    __CFArrayReverseBuckets(buckets, L, capacity);
+    __CFArrayReverseBuckets(buckets, 0, capacity);
+    deque->_leftIdx = 0;
+}
+
 // may move deque storage, as it may need to grow deque
+// the deque must not be wrapped; see __CFArrayDequeLinearize()
 static void __CFArrayRepositionDequeRegions(CFMutableArrayRef array, CFRange range, CFIndex newCount) {
     // newCount elements are going to replace the range, and the result will fit in the deque
     struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
@@ -880,6 +961,7 @@ void _CFArraySetCapacity(CFMutableArrayRef array, CFIndex cap) {
     // effect.  The primary purpose of this API is to help avoid a bunch of the
     // resizes at the small capacities 4, 8, 16, etc.
     if (__CFArrayGetType(array) == __kCFArrayDeque) {
+	if (__CFArrayDequeIsWrapped(array)) __CFArrayDequeLinearize(array);
 	struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
 	CFIndex capacity = __CFArrayDequeRoundUpCapacity(cap);
 	CFIndex size = sizeof(struct __CFArrayDeque) + capacity * sizeof(struct __CFArrayBucket);
@@ -907,6 +989,34 @@ void _CFArraySetCapacity(CFMutableArrayRef array, CFIndex cap) {
 }
 
 
+CFIndex _CFArrayDrainValues(CFMutableArrayRef array, CFIndex maxCount, const void **values) {
+    CFIndex idx, cnt = CFArrayGetCount(array);
+    if (cnt < maxCount) maxCount = cnt;
+    if (maxCount <= 0) return 0;
+    CFAssert1(NULL != values, __kCFLogAssertion, "%s(): pointer to values may not be NULL", __PRETTY_FUNCTION__);
+    if (CF_IS_OBJC(CFArrayGetTypeID(), array)) {
+	CFArrayGetValues(array, CFRangeMake(0, maxCount), values);
+	for (idx = 0; idx < maxCount; idx++) CFRetain(values[idx]);
+	CFArrayReplaceValues(array, CFRangeMake(0, maxCount), NULL, 0);
+	return maxCount;
+    }
+    __CFGenericValidateType(array, CFArrayGetTypeID());
+    CFAssert1(__CFArrayGetType(array) != __kCFArrayImmutable, __kCFLogAssertion, "%s(): array is immutable", __PRETTY_FUNCTION__);
+    CHECK_FOR_MUTATION(array);
+    BEGIN_MUTATION(array);
+    struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
+    __CFArrayDequeGetValues(array, CFRangeMake(0, maxCount), values);
+    for (idx = 0; idx < maxCount; idx++) {
+	__CFArrayGetBucketAtIndex(array, idx)->_item = NULL; // GC:  break strong reference; the caller owns the value now.
+    }
+    deque->_leftIdx += maxCount;
+    if (deque->_capacity <= deque->_leftIdx) deque->_leftIdx -= deque->_capacity;
+    __CFArraySetCount(array, cnt - maxCount);
+    array->_mutations++;
+    END_MUTATION(array);
+    return maxCount;
+}
+
 void CFArrayReplaceValues(CFMutableArrayRef array, CFRange range, const void **newValues, CFIndex newCount) {
     CF_OBJC_FUNCDISPATCHV(CFArrayGetTypeID(), void, (NSMutableArray *)array, replaceObjectsInRange:NSMakeRange(range.location, range.length) withObjects:(id *)newValues count:(NSUInteger)newCount);
     __CFGenericValidateType(array, CFArrayGetTypeID());
@@ -973,8 +1083,23 @@ void _CFArrayReplaceValues(CFMutableArrayRef array, CFRange range, const void **
 	}
     } else {		// Deque
 	// reposition regions A and C for new region B elements in gap
+	struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
+	CFIndex capacity = deque->_capacity;
 	if (0) {
-	} else if (range.length != newCount) {
+	} else if (range.length == newCount) {
+	} else if (0 == range.length && cnt == range.location && futureCnt <= capacity) {
+	    // appending: region B grows to the right, wrapping around into bucket 0
+	} else if (0 == range.length && 0 == range.location && futureCnt <= capacity) {
+	    // prepending: region B grows to the left, wrapping around from the end
+	    deque->_leftIdx = ((CFIndex)deque->_leftIdx < newCount) ? deque->_leftIdx + capacity - newCount : deque->_leftIdx - newCount;
+	} else if (0 == newCount && 0 == range.location) {
+	    // removing from the front: the released buckets were zeroed, just step past them
+	    deque->_leftIdx += range.length;
+	    if (capacity <= (CFIndex)deque->_leftIdx) deque->_leftIdx -= capacity;
+	} else if (0 == newCount && cnt == range.location + range.length) {
+	    // removing from the back: nothing moves
+	} else {
+	    if (__CFArrayDequeIsWrapped(array)) __CFArrayDequeLinearize(array);
 	    __CFArrayRepositionDequeRegions(array, range, newCount);
 	}
     }
@@ -982,9 +1107,7 @@ void _CFArrayReplaceValues(CFMutableArrayRef array, CFRange range, const void **
     if (0 < newCount) {
 	if (0) {
 	} else {	// Deque
-	    struct __CFArrayDeque *deque = (struct __CFArrayDeque *)array->_store;
-	    struct __CFArrayBucket *raw_buckets = (struct __CFArrayBucket *)((uint8_t *)deque + sizeof(struct __CFArrayDeque));
-	    objc_memmove_collectable(raw_buckets + deque->_leftIdx + range.location, newv, newCount * sizeof(struct __CFArrayBucket));
+	    __CFArrayDequeSetValues(array, CFRangeMake(range.location, newCount), newv);
 	}
     }
     __CFArraySetCount(array, futureCnt);
@@ -1003,18 +1126,141 @@ static CFComparisonResult __CFArrayCompareValues(const void *v1, const void *v2,
     return (CFComparisonResult)(INVOKE_CALLBACK3(context->func, *val1, *val2, context->context));
 }
 
-CF_INLINE void __CFZSort(CFMutableArrayRef array, CFRange range, CFComparatorFunction comparator, void *context) {
-    CFIndex cnt = range.length;
-    while (1 < cnt) {
-	for (CFIndex idx = range.location; idx < range.location + cnt - 1; idx++) {
-            const void *a = CFArrayGetValueAtIndex(array, idx);
-            const void *b = CFArrayGetValueAtIndex(array, idx + 1);
-            if ((CFComparisonResult)(INVOKE_CALLBACK3(comparator, b, a, context)) < 0) {
-                CFArrayExchangeValuesAtIndices(array, idx, idx + 1);
+typedef struct {
+    uint64_t key;
+    const void *value;
+} __CFArraySortKey;
+
+CF_INLINE uint64_t __CFArrayKeyForDouble(double d) {
+    // Flips the sign bit of positive values and every bit of negative ones, so the bit patterns order like the values
+    uint64_t bits;
+    memmove(&bits, &d, sizeof(bits));
+    return (bits & 0x8000000000000000ULL) ? ~bits : (bits | 0x8000000000000000ULL);
+}
+
+// Fills in the keys, or returns false if some value has no order-preserving key under this comparator
+static Boolean __CFArrayGetSortKeys(const void **values, CFIndex count, CFComparatorFunction comparator, void *context, __CFArraySortKey *keys, Boolean *keysAreExact) {
+    *keysAreExact = true;
+    if (comparator == (CFComparatorFunction)CFNumberCompare) {
+        // Integers and floats compare with each other exactly, which one key per kind cannot express, so only homogeneous arrays qualify
+        CFTypeID numberType = CFNumberGetTypeID();
+        Boolean floats = false;
+        for (CFIndex idx = 0; idx < count; idx++) {
+            CFNumberRef number = (CFNumberRef)values[idx];
+            if (!number || CFGetTypeID(number) != numberType) return false;
+            Boolean isFloat = CFNumberIsFloatType(number);
+            if (0 == idx) floats = isFloat; else if (floats != isFloat) return false;
+            if (isFloat) {
+                double d;
+                CFNumberGetValue(number, kCFNumberFloat64Type, &d);
+                if (isnan(d)) return false;
+                keys[idx].key = __CFArrayKeyForDouble(d);
+            } else {
+                SInt64 v;
+                if (!CFNumberGetValue(number, kCFNumberSInt64Type, &v)) return false;
+                keys[idx].key = (uint64_t)v ^ 0x8000000000000000ULL;
             }
-	}
-	cnt--;
+            keys[idx].value = number;
+        }
+        return true;
+    }
+    if (comparator == (CFComparatorFunction)CFDateCompare) {
+        CFTypeID dateType = CFDateGetTypeID();
+        for (CFIndex idx = 0; idx < count; idx++) {
+            CFDateRef date = (CFDateRef)values[idx];
+            if (!date || CFGetTypeID(date) != dateType) return false;
+            CFAbsoluteTime at = CFDateGetAbsoluteTime(date);
+            if (isnan(at)) return false;
+            keys[idx].key = __CFArrayKeyForDouble(at);
+            keys[idx].value = date;
+        }
+        return true;
+    }
+    if (comparator == (CFComparatorFunction)CFStringCompare && 0 == (uintptr_t)context) {
+        // A literal comparison orders strings by UTF-16 code unit, which for ASCII is the byte order, so the first 8 ASCII characters make a big-endian key; longer strings sharing those are left to the comparator
+        CFTypeID stringType = CFStringGetTypeID();
+        *keysAreExact = false;
+        for (CFIndex idx = 0; idx < count; idx++) {
+            CFStringRef string = (CFStringRef)values[idx];
+            if (!string || CFGetTypeID(string) != stringType) return false;
+            CFIndex length = __CFMin(CFStringGetLength(string), 8);
+            uint8_t bytes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            if (0 < length && CFStringGetBytes(string, CFRangeMake(0, length), kCFStringEncodingASCII, 0, false, bytes, 8, NULL) != length) return false;
+            uint64_t key = 0;
+            for (CFIndex b = 0; b < 8; b++) key = (key << 8) | bytes[b];
+            keys[idx].key = key;
+            keys[idx].value = string;
+        }
+        return true;
+    }
+    return false;
+}
+
+/* Sorts by fixed-width keys when the comparator is one whose order those keys capture: CFNumberCompare and CFDateCompare on homogeneous arrays, and literal CFStringCompare on strings that start with ASCII. A least-significant-digit radix sort orders the keys, skipping byte positions where every key agrees, and the comparator is only called to break ties between string keys. Returns false, having done nothing, if the array does not qualify. */
+static Boolean __CFArraySortValuesByKey(const void **values, CFIndex count, CFComparatorFunction comparator, void *context) {
+    if (count < 64) return false;
+    if (comparator != (CFComparatorFunction)CFNumberCompare && comparator != (CFComparatorFunction)CFDateCompare && comparator != (CFComparatorFunction)CFStringCompare) return false;
+    __CFArraySortKey *keys = (__CFArraySortKey *)CFAllocatorAllocate(kCFAllocatorSystemDefault, 2 * count * sizeof(__CFArraySortKey), 0);
+    if (!keys) return false;
+    Boolean keysAreExact = true;
+    if (!__CFArrayGetSortKeys(values, count, comparator, context, keys, &keysAreExact)) {
+        CFAllocatorDeallocate(kCFAllocatorSystemDefault, keys);
+        return false;
+    }
+    __CFArraySortKey *src = keys, *dst = keys + count;
+    CFIndex counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    for (CFIndex idx = 0; idx < count; idx++) {
+        uint64_t key = src[idx].key;
+        for (CFIndex digit = 0; digit < 8; digit++) counts[digit][(key >> (8 * digit)) & 0xFF]++;
+    }
+    for (CFIndex digit = 0; digit < 8; digit++) {
+        CFIndex *digitCounts = counts[digit];
+        if (digitCounts[(src[0].key >> (8 * digit)) & 0xFF] == count) continue;
+        CFIndex offset = 0;
+        for (CFIndex b = 0; b < 256; b++) {
+            CFIndex cnt = digitCounts[b];
+            digitCounts[b] = offset;
+            offset += cnt;
+        }
+        for (CFIndex idx = 0; idx < count; idx++) {
+            dst[digitCounts[(src[idx].key >> (8 * digit)) & 0xFF]++] = src[idx];
+        }
+        __CFArraySortKey *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    for (CFIndex idx = 0; idx < count; idx++) values[idx] = src[idx].value;
+    if (!keysAreExact) {
+        struct _acompareContext ctx;
+        ctx.func = comparator;
+        ctx.context = context;
+        for (CFIndex idx = 0; idx < count;) {
+            CFIndex end = idx + 1;
+            while (end < count && src[end].key == src[idx].key) end++;
+            if (1 < end - idx) CFQSortArray(values + idx, end - idx, sizeof(void *), (CFComparatorFunction)__CFArrayCompareValues, &ctx);
+            idx = end;
+        }
+    }
+    CFAllocatorDeallocate(kCFAllocatorSystemDefault, keys);
+    return true;
+}
+
+/* Sorts the buckets of a mutable CF array in place. Used when the callbacks have only one of retain/release, where taking values out and putting them back with CFArrayReplaceValues() would release or retain them unevenly; moving buckets around never calls either. */
+static void __CFZSort(CFMutableArrayRef array, CFRange range, CFComparatorFunction comparator, void *context) {
+    if (range.length < 2) return;
+    CHECK_FOR_MUTATION(array);
+    BEGIN_MUTATION(array);
+    struct _acompareContext ctx;
+    ctx.func = comparator;
+    ctx.context = context;
+    if (__kCFArrayDeque == __CFArrayGetType(array) && __CFArrayDequeIsWrapped(array)) __CFArrayDequeLinearize(array);
+    struct __CFArrayBucket *buckets = __CFArrayGetBucketAtIndex(array, range.location);
+    if (!__CFArraySortValuesByKey((const void **)buckets, range.length, comparator, context)) {
+        CFQSortArray(buckets, range.length, sizeof(struct __CFArrayBucket), (CFComparatorFunction)__CFArrayCompareValues, &ctx);
     }
+    array->_mutations++;
+    END_MUTATION(array);
 }
 
 CF_PRIVATE void _CFArraySortValues(CFMutableArrayRef array, CFComparatorFunction comparator, void *context) {
@@ -1029,7 +1275,9 @@ CF_PRIVATE void _CFArraySortValues(CFMutableArrayRef array, CFComparatorFunction
     struct _acompareContext ctx;
     ctx.func = comparator;
     ctx.context = context;
-    CFQSortArray(values, range.length, sizeof(void *), (CFComparatorFunction)__CFArrayCompareValues, &ctx);
+    if (!__CFArraySortValuesByKey(values, range.length, comparator, context)) {
+        CFQSortArray(values, range.length, sizeof(void *), (CFComparatorFunction)__CFArrayCompareValues, &ctx);
+    }
     CFArrayReplaceValues(array, range, values, range.length);
     if (values != buffer) CFAllocatorDeallocate(kCFAllocatorSystemDefault, values);
 }
@@ -1066,7 +1314,9 @@ void CFArraySortValues(CFMutableArrayRef array, CFRange range, CFComparatorFunct
     struct _acompareContext ctx;
     ctx.func = comparator;
     ctx.context = context;
-    CFQSortArray(values, range.length, sizeof(void *), (CFComparatorFunction)__CFArrayCompareValues, &ctx);
+    if (!__CFArraySortValuesByKey(values, range.length, comparator, context)) {
+        CFQSortArray(values, range.length, sizeof(void *), (CFComparatorFunction)__CFArrayCompareValues, &ctx);
+    }
     if (!immutable) CFArrayReplaceValues(array, range, values, range.length);
     if (values != buffer) CFAllocatorDeallocate(kCFAllocatorSystemDefault, values);
 }
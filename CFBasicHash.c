@@ -328,7 +328,7 @@ struct __CFBasicHash {
         uint64_t __vret:10;
         uint64_t __krel:10;
         uint64_t __vrel:10;
-        uint64_t __:1;
+        uint64_t persistent:1;
         uint64_t null_rc:1;
         uint64_t fast_grow:1;
         uint64_t finalized:1;
@@ -707,11 +707,475 @@ CF_INLINE CFIndex __CFBasicHashGetNumBucketsIndexForCapacity(CFConstBasicHashRef
     return 0;
 }
 
+#pragma mark -
+#pragma mark Persistent Tries
+
+/* A persistent hash keeps its elements in a hash array mapped trie instead of a table, in
+   pointers[0]. Trie nodes never change once they are reachable from a hash, so every persistent
+   hash derived from another shares all the nodes that the derivation did not have to replace;
+   setting or removing one key replaces just the nodes on that key's path, of which there are
+   about log32(n). Each node holds its own retain on the keys and values stored in it and on its
+   child nodes. Persistent hashes are always immutable; the bucket index of an element is its
+   position in trie order, and the number of buckets is the number of elements.
+*/
+
+#define __CFBasicHashTrieBits 5
+#define __CFBasicHashTrieMask ((1U << __CFBasicHashTrieBits) - 1)
+#define __CFBasicHashTrieHashBits (sizeof(CFHashCode) * 8)
+
+typedef struct __CFBasicHashTrieNode __CFBasicHashTrieNode;
+
+struct __CFBasicHashTrieNode {
+    int32_t rc;
+    uint32_t collisions;    /* nonzero only in a node past the end of the hash code: the number of elements, which all have the same hash */
+    uint32_t datamap;       /* slots holding an element */
+    uint32_t nodemap;       /* slots holding a child node */
+    CFIndex count;          /* elements in this subtree */
+    uintptr_t slots[1];     /* key/value pairs in slot order, then child nodes in slot order */
+};
+
+CF_INLINE CFIndex __CFBasicHashTriePopCount(uint32_t map) {
+#if DEPLOYMENT_TARGET_WINDOWS
+    return popcountll(map);
+#else
+    return __builtin_popcount(map);
+#endif
+}
+
+// Spreads the entropy of hash codes which vary only in their high bits (pointers, mostly) into the low bits that pick the first levels' slots
+CF_INLINE CFHashCode __CFBasicHashTrieHash(CFConstBasicHashRef ht, uintptr_t stack_key) {
+    CFHashCode hash = __CFBasicHashHashKey(ht, stack_key);
+#if __LP64__
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+#else
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+#endif
+    return hash;
+}
+
+CF_INLINE CFIndex __CFBasicHashTrieDataCount(const __CFBasicHashTrieNode *node) {
+    return node->collisions ? (CFIndex)node->collisions : __CFBasicHashTriePopCount(node->datamap);
+}
+
+CF_INLINE CFIndex __CFBasicHashTrieNodeCount(const __CFBasicHashTrieNode *node) {
+    return node->collisions ? 0 : __CFBasicHashTriePopCount(node->nodemap);
+}
+
+CF_INLINE __CFBasicHashTrieNode **__CFBasicHashTrieGetChildren(const __CFBasicHashTrieNode *node) {
+    return (__CFBasicHashTrieNode **)(node->slots + 2 * __CFBasicHashTrieDataCount(node));
+}
+
+CF_INLINE Boolean __CFBasicHashTrieKeyMatches(CFConstBasicHashRef ht, const uintptr_t *slot, uintptr_t stack_key) {
+    return (slot[0] == stack_key) || __CFBasicHashTestEqualKey(ht, slot[0], stack_key);
+}
+
+static __CFBasicHashTrieNode *__CFBasicHashTrieCreateNode(CFIndex numData, CFIndex numNodes, CFIndex count) {
+    size_t size = offsetof(__CFBasicHashTrieNode, slots) + (2 * numData + numNodes) * sizeof(uintptr_t);
+    __CFBasicHashTrieNode *node = (__CFBasicHashTrieNode *)CFAllocatorAllocate(kCFAllocatorSystemDefault, size, 0);
+    if (NULL == node) HALT;
+    __SetLastAllocationEventName(node, "CFBasicHash (trie node)");
+    node->rc = 1;
+    node->collisions = 0;
+    node->datamap = 0;
+    node->nodemap = 0;
+    node->count = count;
+    return node;
+}
+
+CF_INLINE __CFBasicHashTrieNode *__CFBasicHashTrieRetain(__CFBasicHashTrieNode *node) {
+    if (node) OSAtomicIncrement32Barrier(&node->rc);
+    return node;
+}
+
+CF_INLINE void __CFBasicHashTrieRetainElement(CFConstBasicHashRef ht, uintptr_t *slot) {
+    slot[1] = __CFBasicHashImportValue(ht, slot[1]);
+    slot[0] = (ht->bits.keys_offset) ? __CFBasicHashImportKey(ht, slot[0]) : slot[1];
+}
+
+CF_INLINE void __CFBasicHashTrieReleaseElement(CFConstBasicHashRef ht, const uintptr_t *slot) {
+    __CFBasicHashEjectValue(ht, slot[1]);
+    if (ht->bits.keys_offset) __CFBasicHashEjectKey(ht, slot[0]);
+}
+
+static void __CFBasicHashTrieRelease(CFConstBasicHashRef ht, __CFBasicHashTrieNode *node) {
+    if (NULL == node || 0 < OSAtomicDecrement32Barrier(&node->rc)) return;
+    CFIndex numData = __CFBasicHashTrieDataCount(node), numNodes = __CFBasicHashTrieNodeCount(node);
+    __CFBasicHashTrieNode **children = __CFBasicHashTrieGetChildren(node);
+    for (CFIndex idx = 0; idx < numData; idx++) {
+        __CFBasicHashTrieReleaseElement(ht, node->slots + 2 * idx);
+    }
+    for (CFIndex idx = 0; idx < numNodes; idx++) {
+        __CFBasicHashTrieRelease(ht, children[idx]);
+    }
+    CFAllocatorDeallocate(kCFAllocatorSystemDefault, node);
+}
+
+/* The editing functions below build a replacement for a node from its parts. When the caller
+   hands over its reference to the node and that is the only one (move), the replacement takes
+   over the node's references to whatever it keeps, and the node's memory is freed without
+   releasing anything; otherwise the replacement retains what it keeps, and the node is left
+   alone, or released if the caller handed over its reference.
+*/
+
+CF_INLINE void __CFBasicHashTrieTakeElement(CFConstBasicHashRef ht, uintptr_t *dst, const uintptr_t *src, Boolean move) {
+    dst[0] = src[0];
+    dst[1] = src[1];
+    if (!move) __CFBasicHashTrieRetainElement(ht, dst);
+}
+
+CF_INLINE __CFBasicHashTrieNode *__CFBasicHashTrieTakeNode(__CFBasicHashTrieNode *node, Boolean move) {
+    return move ? node : __CFBasicHashTrieRetain(node);
+}
+
+CF_INLINE void __CFBasicHashTrieDispose(CFConstBasicHashRef ht, __CFBasicHashTrieNode *node, Boolean owned, Boolean move) {
+    if (move) {
+        CFAllocatorDeallocate(kCFAllocatorSystemDefault, node);
+    } else if (owned) {
+        __CFBasicHashTrieRelease(ht, node);
+    }
+}
+
+// Copies the elements of node into new_node, leaving a gap at gap (if not kCFNotFound) and skipping the element at skip (if not kCFNotFound)
+static void __CFBasicHashTrieCopyElements(CFConstBasicHashRef ht, __CFBasicHashTrieNode *new_node, const __CFBasicHashTrieNode *node, CFIndex gap, CFIndex skip, Boolean move) {
+    CFIndex numData = __CFBasicHashTrieDataCount(node);
+    uintptr_t *dst = new_node->slots;
+    for (CFIndex idx = 0; idx < numData; idx++) {
+        if (idx == gap) dst += 2;
+        if (idx == skip) continue;
+        __CFBasicHashTrieTakeElement(ht, dst, node->slots + 2 * idx, move);
+        dst += 2;
+    }
+}
+
+// As for __CFBasicHashTrieCopyElements(), for the child nodes
+static void __CFBasicHashTrieCopyChildren(__CFBasicHashTrieNode *new_node, const __CFBasicHashTrieNode *node, CFIndex gap, CFIndex skip, Boolean move) {
+    CFIndex numNodes = __CFBasicHashTrieNodeCount(node);
+    __CFBasicHashTrieNode **src = __CFBasicHashTrieGetChildren(node);
+    __CFBasicHashTrieNode **dst = __CFBasicHashTrieGetChildren(new_node);
+    for (CFIndex idx = 0; idx < numNodes; idx++) {
+        if (idx == gap) dst++;
+        if (idx == skip) continue;
+        *dst++ = __CFBasicHashTrieTakeNode(src[idx], move);
+    }
+}
+
+// Makes a subtrie of the two elements, whose references it takes over
+static __CFBasicHashTrieNode *__CFBasicHashTrieCreatePair(const uintptr_t *slot1, CFHashCode hash1, const uintptr_t *slot2, CFHashCode hash2, CFIndex shift) {
+    if (__CFBasicHashTrieHashBits <= shift) {
+        __CFBasicHashTrieNode *node = __CFBasicHashTrieCreateNode(2, 0, 2);
+        node->collisions = 2;
+        node->slots[0] = slot1[0]; node->slots[1] = slot1[1];
+        node->slots[2] = slot2[0]; node->slots[3] = slot2[1];
+        return node;
+    }
+    uint32_t frag1 = (uint32_t)(hash1 >> shift) & __CFBasicHashTrieMask, frag2 = (uint32_t)(hash2 >> shift) & __CFBasicHashTrieMask;
+    if (frag1 == frag2) {
+        __CFBasicHashTrieNode *node = __CFBasicHashTrieCreateNode(0, 1, 2);
+        node->nodemap = 1U << frag1;
+        __CFBasicHashTrieGetChildren(node)[0] = __CFBasicHashTrieCreatePair(slot1, hash1, slot2, hash2, shift + __CFBasicHashTrieBits);
+        return node;
+    }
+    __CFBasicHashTrieNode *node = __CFBasicHashTrieCreateNode(2, 0, 2);
+    node->datamap = (1U << frag1) | (1U << frag2);
+    if (frag2 < frag1) {
+        const uintptr_t *tmp = slot1; slot1 = slot2; slot2 = tmp;
+    }
+    node->slots[0] = slot1[0]; node->slots[1] = slot1[1];
+    node->slots[2] = slot2[0]; node->slots[3] = slot2[1];
+    return node;
+}
+
+/* Returns a subtrie like node but with the element in slot (whose references it takes over)
+   set into it; *added tells whether the key was new. If owned, the caller's reference to node
+   is used up.
+*/
+static __CFBasicHashTrieNode *__CFBasicHashTrieSet(CFConstBasicHashRef ht, __CFBasicHashTrieNode *node, Boolean owned, const uintptr_t *slot, CFHashCode hash, CFIndex shift, Boolean *added) {
+    Boolean move = owned && 1 == node->rc;
+    __CFBasicHashTrieNode *new_node = NULL;
+    if (node->collisions) {
+        CFIndex cnt = node->collisions, found = kCFNotFound;
+        for (CFIndex idx = 0; idx < cnt; idx++) {
+            if (__CFBasicHashTrieKeyMatches(ht, node->slots + 2 * idx, slot[0])) {
+                found = idx;
+                break;
+            }
+        }
+        CFIndex new_cnt = (kCFNotFound == found) ? cnt + 1 : cnt;
+        new_node = __CFBasicHashTrieCreateNode(new_cnt, 0, new_cnt);
+        new_node->collisions = (uint32_t)new_cnt;
+        __CFBasicHashTrieCopyElements(ht, new_node, node, found, found, move);
+        CFIndex idx = (kCFNotFound == found) ? cnt : found;
+        new_node->slots[2 * idx] = slot[0];
+        new_node->slots[2 * idx + 1] = slot[1];
+        if (kCFNotFound != found && move) __CFBasicHashTrieReleaseElement(ht, node->slots + 2 * found);
+        *added = (kCFNotFound == found);
+        __CFBasicHashTrieDispose(ht, node, owned, move);
+        return new_node;
+    }
+    uint32_t bit = 1U << ((uint32_t)(hash >> shift) & __CFBasicHashTrieMask);
+    CFIndex numData = __CFBasicHashTriePopCount(node->datamap), numNodes = __CFBasicHashTriePopCount(node->nodemap);
+    CFIndex didx = __CFBasicHashTriePopCount(node->datamap & (bit - 1)), nidx = __CFBasicHashTriePopCount(node->nodemap & (bit - 1));
+    if (node->datamap & bit) {
+        const uintptr_t *old_slot = node->slots + 2 * didx;
+        if (__CFBasicHashTrieKeyMatches(ht, old_slot, slot[0])) {
+            new_node = __CFBasicHashTrieCreateNode(numData, numNodes, node->count);
+            new_node->datamap = node->datamap;
+            new_node->nodemap = node->nodemap;
+            __CFBasicHashTrieCopyElements(ht, new_node, node, didx, didx, move);
+            new_node->slots[2 * didx] = slot[0];
+            new_node->slots[2 * didx + 1] = slot[1];
+            __CFBasicHashTrieCopyChildren(new_node, node, kCFNotFound, kCFNotFound, move);
+            if (move) __CFBasicHashTrieReleaseElement(ht, old_slot);
+            *added = false;
+        } else {
+            // The two keys share this slot, so both move down a level
+            uintptr_t pushed[2];
+            __CFBasicHashTrieTakeElement(ht, pushed, old_slot, move);
+            new_node = __CFBasicHashTrieCreateNode(numData - 1, numNodes + 1, node->count + 1);
+            new_node->datamap = node->datamap & ~bit;
+            new_node->nodemap = node->nodemap | bit;
+            __CFBasicHashTrieCopyElements(ht, new_node, node, kCFNotFound, didx, move);
+            __CFBasicHashTrieCopyChildren(new_node, node, nidx, kCFNotFound, move);
+            __CFBasicHashTrieGetChildren(new_node)[nidx] = __CFBasicHashTrieCreatePair(pushed, __CFBasicHashTrieHash(ht, pushed[0]), slot, hash, shift + __CFBasicHashTrieBits);
+            *added = true;
+        }
+    } else if (node->nodemap & bit) {
+        Boolean child_added = false;
+        __CFBasicHashTrieNode *child = __CFBasicHashTrieSet(ht, __CFBasicHashTrieGetChildren(node)[nidx], move, slot, hash, shift + __CFBasicHashTrieBits, &child_added);
+        new_node = __CFBasicHashTrieCreateNode(numData, numNodes, node->count + (child_added ? 1 : 0));
+        new_node->datamap = node->datamap;
+        new_node->nodemap = node->nodemap;
+        __CFBasicHashTrieCopyElements(ht, new_node, node, kCFNotFound, kCFNotFound, move);
+        __CFBasicHashTrieCopyChildren(new_node, node, nidx, nidx, move);
+        __CFBasicHashTrieGetChildren(new_node)[nidx] = child;
+        *added = child_added;
+    } else {
+        new_node = __CFBasicHashTrieCreateNode(numData + 1, numNodes, node->count + 1);
+        new_node->datamap = node->datamap | bit;
+        new_node->nodemap = node->nodemap;
+        __CFBasicHashTrieCopyElements(ht, new_node, node, didx, kCFNotFound, move);
+        new_node->slots[2 * didx] = slot[0];
+        new_node->slots[2 * didx + 1] = slot[1];
+        __CFBasicHashTrieCopyChildren(new_node, node, kCFNotFound, kCFNotFound, move);
+        *added = true;
+    }
+    __CFBasicHashTrieDispose(ht, node, owned, move);
+    return new_node;
+}
+
+/* Returns a subtrie like node but without stack_key, or NULL if nothing would be left;
+   *removed tells whether the key was there. If it was not, node itself is returned. References
+   are handled as for __CFBasicHashTrieSet().
+*/
+static __CFBasicHashTrieNode *__CFBasicHashTrieRemove(CFConstBasicHashRef ht, __CFBasicHashTrieNode *node, Boolean owned, uintptr_t stack_key, CFHashCode hash, CFIndex shift, Boolean *removed) {
+    Boolean move = owned && 1 == node->rc;
+    __CFBasicHashTrieNode *new_node = NULL;
+    *removed = false;
+    if (node->collisions) {
+        CFIndex cnt = node->collisions, found = kCFNotFound;
+        for (CFIndex idx = 0; idx < cnt; idx++) {
+            if (__CFBasicHashTrieKeyMatches(ht, node->slots + 2 * idx, stack_key)) {
+                found = idx;
+                break;
+            }
+        }
+        if (kCFNotFound == found) return owned ? node : __CFBasicHashTrieRetain(node);
+        if (1 < cnt) {
+            new_node = __CFBasicHashTrieCreateNode(cnt - 1, 0, cnt - 1);
+            new_node->collisions = (uint32_t)(cnt - 1);
+            __CFBasicHashTrieCopyElements(ht, new_node, node, kCFNotFound, found, move);
+        }
+        if (move) __CFBasicHashTrieReleaseElement(ht, node->slots + 2 * found);
+        *removed = true;
+        __CFBasicHashTrieDispose(ht, node, owned, move);
+        return new_node;
+    }
+    uint32_t bit = 1U << ((uint32_t)(hash >> shift) & __CFBasicHashTrieMask);
+    CFIndex numData = __CFBasicHashTriePopCount(node->datamap), numNodes = __CFBasicHashTriePopCount(node->nodemap);
+    CFIndex didx = __CFBasicHashTriePopCount(node->datamap & (bit - 1)), nidx = __CFBasicHashTriePopCount(node->nodemap & (bit - 1));
+    if (node->datamap & bit) {
+        const uintptr_t *old_slot = node->slots + 2 * didx;
+        if (!__CFBasicHashTrieKeyMatches(ht, old_slot, stack_key)) return owned ? node : __CFBasicHashTrieRetain(node);
+        if (1 < node->count) {
+            new_node = __CFBasicHashTrieCreateNode(numData - 1, numNodes, node->count - 1);
+            new_node->datamap = node->datamap & ~bit;
+            new_node->nodemap = node->nodemap;
+            __CFBasicHashTrieCopyElements(ht, new_node, node, kCFNotFound, didx, move);
+            __CFBasicHashTrieCopyChildren(new_node, node, kCFNotFound, kCFNotFound, move);
+        }
+        if (move) __CFBasicHashTrieReleaseElement(ht, old_slot);
+        *removed = true;
+        __CFBasicHashTrieDispose(ht, node, owned, move);
+        return new_node;
+    }
+    if (!(node->nodemap & bit)) return owned ? node : __CFBasicHashTrieRetain(node);
+    Boolean child_removed = false;
+    __CFBasicHashTrieNode *old_child = __CFBasicHashTrieGetChildren(node)[nidx];
+    __CFBasicHashTrieNode *child = __CFBasicHashTrieRemove(ht, old_child, move, stack_key, hash, shift + __CFBasicHashTrieBits, &child_removed);
+    if (!child_removed) {
+        // child is old_child; if the reference to it was not handed down, it is an extra one
+        if (!move) __CFBasicHashTrieRelease(ht, child);
+        return owned ? node : __CFBasicHashTrieRetain(node);
+    }
+    *removed = true;
+    if (NULL == child) {
+        if (1 < node->count) {
+            new_node = __CFBasicHashTrieCreateNode(numData, numNodes - 1, node->count - 1);
+            new_node->datamap = node->datamap;
+            new_node->nodemap = node->nodemap & ~bit;
+            __CFBasicHashTrieCopyElements(ht, new_node, node, kCFNotFound, kCFNotFound, move);
+            __CFBasicHashTrieCopyChildren(new_node, node, kCFNotFound, nidx, move);
+        }
+    } else if (1 == __CFBasicHashTrieDataCount(child) && 0 == __CFBasicHashTrieNodeCount(child)) {
+        // A lone element left in a child moves up into this node, keeping the trie as shallow as its keys allow
+        new_node = __CFBasicHashTrieCreateNode(numData + 1, numNodes - 1, node->count - 1);
+        new_node->datamap = node->datamap | bit;
+        new_node->nodemap = node->nodemap & ~bit;
+        __CFBasicHashTrieCopyElements(ht, new_node, node, didx, kCFNotFound, move);
+        Boolean move_child = (1 == child->rc);
+        __CFBasicHashTrieTakeElement(ht, new_node->slots + 2 * didx, child->slots, move_child);
+        __CFBasicHashTrieDispose(ht, child, true, move_child);
+        __CFBasicHashTrieCopyChildren(new_node, node, kCFNotFound, nidx, move);
+    } else {
+        new_node = __CFBasicHashTrieCreateNode(numData, numNodes, node->count - 1);
+        new_node->datamap = node->datamap;
+        new_node->nodemap = node->nodemap;
+        __CFBasicHashTrieCopyElements(ht, new_node, node, kCFNotFound, kCFNotFound, move);
+        __CFBasicHashTrieCopyChildren(new_node, node, nidx, nidx, move);
+        __CFBasicHashTrieGetChildren(new_node)[nidx] = child;
+    }
+    __CFBasicHashTrieDispose(ht, node, owned, move);
+    return new_node;
+}
+
+// Returns the slot holding stack_key and its position in trie order, or NULL
+static const uintptr_t *__CFBasicHashTrieFind(CFConstBasicHashRef ht, const __CFBasicHashTrieNode *node, uintptr_t stack_key, CFIndex *ordinal) {
+    CFHashCode hash = __CFBasicHashTrieHash(ht, stack_key);
+    CFIndex base = 0;
+    for (CFIndex shift = 0; node; shift += __CFBasicHashTrieBits) {
+        if (node->collisions) {
+            for (CFIndex idx = 0; idx < (CFIndex)node->collisions; idx++) {
+                if (__CFBasicHashTrieKeyMatches(ht, node->slots + 2 * idx, stack_key)) {
+                    *ordinal = base + idx;
+                    return node->slots + 2 * idx;
+                }
+            }
+            return NULL;
+        }
+        uint32_t bit = 1U << ((uint32_t)(hash >> shift) & __CFBasicHashTrieMask);
+        if (node->datamap & bit) {
+            CFIndex didx = __CFBasicHashTriePopCount(node->datamap & (bit - 1));
+            if (!__CFBasicHashTrieKeyMatches(ht, node->slots + 2 * didx, stack_key)) return NULL;
+            *ordinal = base + didx;
+            return node->slots + 2 * didx;
+        }
+        if (!(node->nodemap & bit)) return NULL;
+        CFIndex nidx = __CFBasicHashTriePopCount(node->nodemap & (bit - 1));
+        __CFBasicHashTrieNode **children = __CFBasicHashTrieGetChildren(node);
+        base += __CFBasicHashTriePopCount(node->datamap);
+        for (CFIndex idx = 0; idx < nidx; idx++) base += children[idx]->count;
+        node = children[nidx];
+    }
+    return NULL;
+}
+
+static const uintptr_t *__CFBasicHashTrieGetSlotAtOrdinal(const __CFBasicHashTrieNode *node, CFIndex ordinal) {
+    while (node && 0 <= ordinal && ordinal < node->count) {
+        CFIndex numData = __CFBasicHashTrieDataCount(node), numNodes = __CFBasicHashTrieNodeCount(node);
+        if (ordinal < numData) return node->slots + 2 * ordinal;
+        ordinal -= numData;
+        __CFBasicHashTrieNode **children = __CFBasicHashTrieGetChildren(node);
+        const __CFBasicHashTrieNode *next = NULL;
+        for (CFIndex idx = 0; idx < numNodes; idx++) {
+            if (ordinal < children[idx]->count) {
+                next = children[idx];
+                break;
+            }
+            ordinal -= children[idx]->count;
+        }
+        node = next;
+    }
+    return NULL;
+}
+
+// Calls block for the elements whose positions are in [start, end), base being the position of node's first element; returns false if block asked to stop
+static Boolean __CFBasicHashTrieApply(const __CFBasicHashTrieNode *node, CFIndex base, CFIndex start, CFIndex end, Boolean (^block)(CFIndex, const uintptr_t *)) {
+    CFIndex numData = __CFBasicHashTrieDataCount(node), numNodes = __CFBasicHashTrieNodeCount(node);
+    for (CFIndex idx = 0; idx < numData && base < end; idx++, base++) {
+        if (start <= base && !block(base, node->slots + 2 * idx)) return false;
+    }
+    __CFBasicHashTrieNode **children = __CFBasicHashTrieGetChildren(node);
+    for (CFIndex idx = 0; idx < numNodes && base < end; idx++) {
+        CFIndex cnt = children[idx]->count;
+        if (start < base + cnt && !__CFBasicHashTrieApply(children[idx], base, start, end, block)) return false;
+        base += cnt;
+    }
+    return true;
+}
+
+static size_t __CFBasicHashTrieGetSize(const __CFBasicHashTrieNode *node) {
+    if (NULL == node) return 0;
+    size_t size = malloc_size(node);
+    CFIndex numNodes = __CFBasicHashTrieNodeCount(node);
+    __CFBasicHashTrieNode **children = __CFBasicHashTrieGetChildren(node);
+    for (CFIndex idx = 0; idx < numNodes; idx++) size += __CFBasicHashTrieGetSize(children[idx]);
+    return size;
+}
+
+CF_INLINE __CFBasicHashTrieNode *__CFBasicHashGetTrie(CFConstBasicHashRef ht) {
+    return (__CFBasicHashTrieNode *)ht->pointers[0];
+}
+
+// Imports stack_key and stack_value and sets them into the trie of ht
+static void __CFBasicHashTrieSetValue(CFBasicHashRef ht, uintptr_t stack_key, uintptr_t stack_value) {
+    uintptr_t slot[2];
+    slot[1] = __CFBasicHashImportValue(ht, stack_value);
+    slot[0] = (ht->bits.keys_offset) ? __CFBasicHashImportKey(ht, stack_key) : slot[1];
+    CFHashCode hash = __CFBasicHashTrieHash(ht, stack_key);
+    __CFBasicHashTrieNode *root = __CFBasicHashGetTrie(ht);
+    Boolean added = true;
+    if (NULL == root) {
+        root = __CFBasicHashTrieCreateNode(1, 0, 1);
+        root->datamap = 1U << ((uint32_t)hash & __CFBasicHashTrieMask);
+        root->slots[0] = slot[0];
+        root->slots[1] = slot[1];
+    } else {
+        root = __CFBasicHashTrieSet(ht, root, true, slot, hash, 0, &added);
+    }
+    ht->pointers[0] = root;
+    if (added) ht->bits.used_buckets++;
+}
+
+static void __CFBasicHashTrieRemoveValue(CFBasicHashRef ht, uintptr_t stack_key) {
+    __CFBasicHashTrieNode *root = __CFBasicHashGetTrie(ht);
+    if (NULL == root) return;
+    Boolean removed = false;
+    ht->pointers[0] = __CFBasicHashTrieRemove(ht, root, true, stack_key, __CFBasicHashTrieHash(ht, stack_key), 0, &removed);
+    if (removed) ht->bits.used_buckets--;
+}
+
+CF_INLINE CFBasicHashBucket __CFBasicHashTrieMakeBucket(CFIndex ordinal, const uintptr_t *slot) {
+    CFBasicHashBucket result = {kCFNotFound, 0UL, 0UL, 0};
+    if (slot) {
+        result.idx = ordinal;
+        result.weak_key = slot[0];
+        result.weak_value = slot[1];
+        result.count = 1;
+    }
+    return result;
+}
+
 CF_PRIVATE CFIndex CFBasicHashGetNumBuckets(CFConstBasicHashRef ht) {
+    if (ht->bits.persistent) return (CFIndex)ht->bits.used_buckets;
     return __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
 }
 
 CF_PRIVATE CFIndex CFBasicHashGetCapacity(CFConstBasicHashRef ht) {
+    if (ht->bits.persistent) return (CFIndex)ht->bits.used_buckets;
     return __CFBasicHashGetCapacityForNumBuckets(ht, ht->bits.num_buckets_idx);
 }
 
@@ -721,6 +1185,9 @@ CF_PRIVATE CFIndex CFBasicHashGetCapacity(CFConstBasicHashRef ht) {
 // an add operation. For a set or multiset, the .weak_key and .weak_value
 // are the same.
 CF_PRIVATE CFBasicHashBucket CFBasicHashGetBucket(CFConstBasicHashRef ht, CFIndex idx) {
+    if (ht->bits.persistent) {
+        return __CFBasicHashTrieMakeBucket(idx, __CFBasicHashTrieGetSlotAtOrdinal(__CFBasicHashGetTrie(ht), idx));
+    }
     CFBasicHashBucket result;
     result.idx = idx;
     if (__CFBasicHashIsEmptyOrDeleted(ht, idx)) {
@@ -858,6 +1325,11 @@ static uintptr_t __CFBasicHashFold(uintptr_t dividend, uint8_t idx) {
 
 
 CF_INLINE CFBasicHashBucket __CFBasicHashFindBucket(CFConstBasicHashRef ht, uintptr_t stack_key) {
+    if (ht->bits.persistent) {
+        CFIndex ordinal = kCFNotFound;
+        const uintptr_t *slot = __CFBasicHashTrieFind(ht, __CFBasicHashGetTrie(ht), stack_key, &ordinal);
+        return __CFBasicHashTrieMakeBucket(ordinal, slot);
+    }
     if (0 == ht->bits.num_buckets_idx) {
         CFBasicHashBucket result = {kCFNotFound, 0UL, 0UL, 0};
         return result;
@@ -972,6 +1444,7 @@ CF_PRIVATE Boolean CFBasicHashesAreEqual(CFConstBasicHashRef ht1, CFConstBasicHa
     CFIndex cnt1 = CFBasicHashGetCount(ht1);
     if (cnt1 != CFBasicHashGetCount(ht2)) return false;
     if (0 == cnt1) return true;
+    if (ht1->bits.persistent && ht2->bits.persistent && __CFBasicHashGetTrie(ht1) == __CFBasicHashGetTrie(ht2)) return true;
     __block Boolean equal = true;
     CFBasicHashApply(ht1, ^(CFBasicHashBucket bkt1) {
             CFBasicHashBucket bkt2 = __CFBasicHashFindBucket(ht2, bkt1.weak_key);
@@ -989,6 +1462,12 @@ CF_PRIVATE Boolean CFBasicHashesAreEqual(CFConstBasicHashRef ht1, CFConstBasicHa
 }
 
 CF_PRIVATE void CFBasicHashApply(CFConstBasicHashRef ht, Boolean (^block)(CFBasicHashBucket)) {
+    if (ht->bits.persistent) {
+        if (__CFBasicHashGetTrie(ht)) __CFBasicHashTrieApply(__CFBasicHashGetTrie(ht), 0, 0, ht->bits.used_buckets, ^(CFIndex ordinal, const uintptr_t *slot) {
+                return block(__CFBasicHashTrieMakeBucket(ordinal, slot));
+            });
+        return;
+    }
     CFIndex used = (CFIndex)ht->bits.used_buckets, cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
     for (CFIndex idx = 0; 0 < used && idx < cnt; idx++) {
         CFBasicHashBucket bkt = CFBasicHashGetBucket(ht, idx);
@@ -1004,8 +1483,14 @@ CF_PRIVATE void CFBasicHashApply(CFConstBasicHashRef ht, Boolean (^block)(CFBasi
 CF_PRIVATE void CFBasicHashApplyIndexed(CFConstBasicHashRef ht, CFRange range, Boolean (^block)(CFBasicHashBucket)) {
     if (range.length < 0) HALT;
     if (range.length == 0) return;
-    CFIndex cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    CFIndex cnt = CFBasicHashGetNumBuckets(ht);
     if (cnt < range.location + range.length) HALT;
+    if (ht->bits.persistent) {
+        __CFBasicHashTrieApply(__CFBasicHashGetTrie(ht), 0, range.location, range.location + range.length, ^(CFIndex ordinal, const uintptr_t *slot) {
+                return block(__CFBasicHashTrieMakeBucket(ordinal, slot));
+            });
+        return;
+    }
     for (CFIndex idx = 0; idx < range.length; idx++) {
         CFBasicHashBucket bkt = CFBasicHashGetBucket(ht, range.location + idx);
         if (0 < bkt.count) {
@@ -1017,6 +1502,14 @@ CF_PRIVATE void CFBasicHashApplyIndexed(CFConstBasicHashRef ht, CFRange range, B
 }
 
 CF_PRIVATE void CFBasicHashGetElements(CFConstBasicHashRef ht, CFIndex bufferslen, uintptr_t *weak_values, uintptr_t *weak_keys) {
+    if (ht->bits.persistent) {
+        if (__CFBasicHashGetTrie(ht)) __CFBasicHashTrieApply(__CFBasicHashGetTrie(ht), 0, 0, __CFMin(bufferslen, (CFIndex)ht->bits.used_buckets), ^(CFIndex ordinal, const uintptr_t *slot) {
+                if (weak_values) { weak_values[ordinal] = slot[1]; }
+                if (weak_keys) { weak_keys[ordinal] = slot[0]; }
+                return (Boolean)true;
+            });
+        return;
+    }
     CFIndex used = (CFIndex)ht->bits.used_buckets, cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
     CFIndex offset = 0;
     for (CFIndex idx = 0; 0 < used && idx < cnt && offset < bufferslen; idx++) {
@@ -1038,6 +1531,16 @@ CF_PRIVATE unsigned long __CFBasicHashFastEnumeration(CFConstBasicHashRef ht, st
         state->mutationsPtr = (unsigned long *)&ht->bits;
     }
     state->itemsPtr = (unsigned long *)stackbuffer;
+    if (ht->bits.persistent) {
+        __block CFIndex cntx = 0;
+        CFIndex start = (CFIndex)state->state, end = __CFMin(start + (CFIndex)count, (CFIndex)ht->bits.used_buckets);
+        if (start < end) __CFBasicHashTrieApply(__CFBasicHashGetTrie(ht), 0, start, end, ^(CFIndex ordinal, const uintptr_t *slot) {
+                state->itemsPtr[cntx++] = (unsigned long)slot[0];
+                return (Boolean)true;
+            });
+        state->state += cntx;
+        return cntx;
+    }
     CFIndex cntx = 0;
     CFIndex used = (CFIndex)ht->bits.used_buckets, cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
     for (CFIndex idx = (CFIndex)state->state; 0 < used && idx < cnt && cntx < (CFIndex)count; idx++) {
@@ -1064,6 +1567,15 @@ static void __CFBasicHashDrain(CFBasicHashRef ht, Boolean forFinalization) {
     OSAtomicAdd64Barrier(-1 * (int64_t) CFBasicHashGetSize(ht, true), & __CFBasicHashTotalSize);
 #endif
 
+    if (ht->bits.persistent) {
+        __CFBasicHashTrieNode *root = __CFBasicHashGetTrie(ht);
+        ht->pointers[0] = NULL;
+        ht->bits.mutations++;
+        ht->bits.used_buckets = 0;
+        __CFBasicHashTrieRelease(ht, root);
+        return;
+    }
+
     CFIndex old_num_buckets = __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
 
     CFAllocatorRef allocator = CFGetAllocator(ht);
@@ -1466,6 +1978,10 @@ CF_PRIVATE void CFBasicHashRemoveIntValueAndDec(CFBasicHashRef ht, uintptr_t int
 
 CF_PRIVATE size_t CFBasicHashGetSize(CFConstBasicHashRef ht, Boolean total) {
     size_t size = sizeof(struct __CFBasicHash);
+    if (ht->bits.persistent) {
+        // Nodes shared with other persistent hashes are counted in full
+        return size + (total ? __CFBasicHashTrieGetSize(__CFBasicHashGetTrie(ht)) : 0);
+    }
     if (ht->bits.keys_offset) size += sizeof(CFBasicHashValue *);
     if (ht->bits.counts_offset) size += sizeof(void *);
     if (__CFBasicHashHasHashCache(ht)) size += sizeof(uintptr_t *);
@@ -1483,8 +1999,10 @@ CF_PRIVATE size_t CFBasicHashGetSize(CFConstBasicHashRef ht, Boolean total) {
 
 CF_PRIVATE CFStringRef CFBasicHashCopyDescription(CFConstBasicHashRef ht, Boolean detailed, CFStringRef prefix, CFStringRef entryPrefix, Boolean describeElements) {
     CFMutableStringRef result = CFStringCreateMutable(kCFAllocatorSystemDefault, 0);
-    CFStringAppendFormat(result, NULL, CFSTR("%@{type = %s %s%s, count = %ld,\n"), prefix, (CFBasicHashIsMutable(ht) ? "mutable" : "immutable"), ((ht->bits.counts_offset) ? "multi" : ""), ((ht->bits.keys_offset) ? "dict" : "set"), CFBasicHashGetCount(ht));
-    if (detailed) {
+    CFStringAppendFormat(result, NULL, CFSTR("%@{type = %s %s%s%s, count = %ld,\n"), prefix, (CFBasicHashIsMutable(ht) ? "mutable" : "immutable"), ((ht->bits.persistent) ? "persistent " : ""), ((ht->bits.counts_offset) ? "multi" : ""), ((ht->bits.keys_offset) ? "dict" : "set"), CFBasicHashGetCount(ht));
+    if (detailed && ht->bits.persistent) {
+        CFStringAppendFormat(result, NULL, CFSTR("%@strong values = %s, strong keys = %s, trie root = %p, total size = %ld,\n"), prefix, (CFBasicHashHasStrongValues(ht) ? "yes" : "no"), (CFBasicHashHasStrongKeys(ht) ? "yes" : "no"), __CFBasicHashGetTrie(ht), CFBasicHashGetSize(ht, true));
+    } else if (detailed) {
         const char *cb_type = "custom";
         CFStringAppendFormat(result, NULL, CFSTR("%@hash cache = %s, strong values = %s, strong keys = %s, cb = %s,\n"), prefix, (__CFBasicHashHasHashCache(ht) ? "yes" : "no"), (CFBasicHashHasStrongValues(ht) ? "yes" : "no"), (CFBasicHashHasStrongKeys(ht) ? "yes" : "no"), cb_type);
         CFStringAppendFormat(result, NULL, CFSTR("%@num bucket index = %d, num buckets = %ld, capacity = %ld, num buckets used = %u,\n"), prefix, ht->bits.num_buckets_idx, CFBasicHashGetNumBuckets(ht), (long)CFBasicHashGetCapacity(ht), ht->bits.used_buckets);
@@ -1653,7 +2171,36 @@ CF_PRIVATE CFBasicHashRef CFBasicHashCreate(CFAllocatorRef allocator, CFOptionFl
     return ht;
 }
 
+// Copies a persistent hash into an ordinary table, as a mutable copy must be
+static CFBasicHashRef __CFBasicHashCreateCopyOfTrie(CFAllocatorRef allocator, CFConstBasicHashRef src_ht) {
+    size_t size = sizeof(struct __CFBasicHash) - sizeof(CFRuntimeBase);
+    if (src_ht->bits.keys_offset) size += sizeof(CFBasicHashValue *);
+    CFBasicHashRef ht = (CFBasicHashRef)_CFRuntimeCreateInstance(allocator, CFBasicHashGetTypeID(), size, NULL);
+    if (NULL == ht) return NULL;
+
+    memmove((uint8_t *)ht + sizeof(CFRuntimeBase), (uint8_t *)src_ht + sizeof(CFRuntimeBase), sizeof(ht->bits));
+    ht->bits.persistent = 0;
+    ht->bits.finalized = 0;
+    ht->bits.mutations = 1;
+    ht->bits.num_buckets_idx = 0;
+    ht->bits.used_buckets = 0;
+    ht->bits.deleted = 0;
+    ht->pointers[0] = NULL;
+    if (ht->bits.keys_offset) ht->pointers[ht->bits.keys_offset] = NULL;
+
+    CFIndex cnt = (CFIndex)src_ht->bits.used_buckets;
+    if (0 < cnt) {
+        CFBasicHashSetCapacity(ht, cnt);
+        __CFBasicHashTrieApply(__CFBasicHashGetTrie(src_ht), 0, 0, cnt, ^(CFIndex ordinal, const uintptr_t *slot) {
+                CFBasicHashAddValue(ht, slot[0], slot[1]);
+                return (Boolean)true;
+            });
+    }
+    return ht;
+}
+
 CF_PRIVATE CFBasicHashRef CFBasicHashCreateCopy(CFAllocatorRef allocator, CFConstBasicHashRef src_ht) {
+    if (src_ht->bits.persistent) return __CFBasicHashCreateCopyOfTrie(allocator, src_ht);
     size_t size = CFBasicHashGetSize(src_ht, false) - sizeof(CFRuntimeBase);
     CFIndex new_num_buckets = __CFBasicHashTableSizes[src_ht->bits.num_buckets_idx];
     CFBasicHashValue *new_values = NULL, *new_keys = NULL;
@@ -1767,4 +2314,52 @@ CF_PRIVATE CFBasicHashRef CFBasicHashCreateCopy(CFAllocatorRef allocator, CFCons
     return ht;
 }
 
+CF_PRIVATE Boolean CFBasicHashIsPersistent(CFConstBasicHashRef ht) {
+    return ht->bits.persistent ? true : false;
+}
+
+CF_PRIVATE CFBasicHashRef CFBasicHashCreatePersistentCopy(CFAllocatorRef allocator, CFConstBasicHashRef src_ht) {
+    // Trie nodes come from the system allocator and cannot keep multiple values per key, weak references, or keys that live in their values
+    if (src_ht->bits.counts_offset || src_ht->bits.indirect_keys || src_ht->bits.weak_values || src_ht->bits.weak_keys) return NULL;
+    if (CF_IS_COLLECTABLE_ALLOCATOR(allocator)) return NULL;
+
+    size_t size = sizeof(struct __CFBasicHash) - sizeof(CFRuntimeBase);
+    CFBasicHashRef ht = (CFBasicHashRef)_CFRuntimeCreateInstance(allocator, CFBasicHashGetTypeID(), size, NULL);
+    if (NULL == ht) return NULL;
 
+    memmove((uint8_t *)ht + sizeof(CFRuntimeBase), (uint8_t *)src_ht + sizeof(CFRuntimeBase), sizeof(ht->bits));
+    ht->bits.persistent = 1;
+    ht->bits.hashes_offset = 0;
+    ht->bits.null_rc = 0;
+    ht->bits.finalized = 0;
+    ht->bits.mutations = 1;
+    ht->bits.num_buckets_idx = 0;
+    ht->bits.deleted = 0;
+    ht->pointers[0] = NULL;
+
+    if (src_ht->bits.persistent) {
+        ht->pointers[0] = __CFBasicHashTrieRetain(__CFBasicHashGetTrie(src_ht));
+    } else {
+        ht->bits.used_buckets = 0;
+        CFBasicHashApply(src_ht, ^(CFBasicHashBucket bkt) {
+                __CFBasicHashTrieSetValue(ht, bkt.weak_key, bkt.weak_value);
+                return (Boolean)true;
+            });
+    }
+    CFBasicHashMakeImmutable(ht);
+    return ht;
+}
+
+CF_PRIVATE CFBasicHashRef CFBasicHashCreatePersistentCopyBySettingValue(CFAllocatorRef allocator, CFConstBasicHashRef src_ht, uintptr_t stack_key, uintptr_t stack_value) {
+    CFBasicHashRef ht = CFBasicHashCreatePersistentCopy(allocator, src_ht);
+    if (NULL == ht) return NULL;
+    __CFBasicHashTrieSetValue(ht, stack_key, stack_value);
+    return ht;
+}
+
+CF_PRIVATE CFBasicHashRef CFBasicHashCreatePersistentCopyByRemovingValue(CFAllocatorRef allocator, CFConstBasicHashRef src_ht, uintptr_t stack_key) {
+    CFBasicHashRef ht = CFBasicHashCreatePersistentCopy(allocator, src_ht);
+    if (NULL == ht) return NULL;
+    __CFBasicHashTrieRemoveValue(ht, stack_key);
+    return ht;
+}
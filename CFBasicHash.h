@@ -151,6 +151,15 @@ extern unsigned long __CFBasicHashFastEnumeration(CFConstBasicHashRef ht, struct
 CFBasicHashRef CFBasicHashCreate(CFAllocatorRef allocator, CFOptionFlags flags, const CFBasicHashCallbacks *cb);
 CFBasicHashRef CFBasicHashCreateCopy(CFAllocatorRef allocator, CFConstBasicHashRef ht);
 
+// persistent hashes keep their elements in a trie shared with the hashes they were derived
+// from; the creation functions return immutable CFBasicHashRefs, or NULL if ht has counts,
+// weak or indirect keys or values; a copy of a persistent hash made with CFBasicHashCreateCopy()
+// is an ordinary mutable one
+Boolean CFBasicHashIsPersistent(CFConstBasicHashRef ht);
+CFBasicHashRef CFBasicHashCreatePersistentCopy(CFAllocatorRef allocator, CFConstBasicHashRef ht);
+CFBasicHashRef CFBasicHashCreatePersistentCopyBySettingValue(CFAllocatorRef allocator, CFConstBasicHashRef ht, uintptr_t stack_key, uintptr_t stack_value);
+CFBasicHashRef CFBasicHashCreatePersistentCopyByRemovingValue(CFAllocatorRef allocator, CFConstBasicHashRef ht, uintptr_t stack_key);
+
 
 CF_EXTERN_C_END
 
@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <math.h>
 #include "CFInternal.h"
 
 
@@ -576,3 +577,705 @@ char *_CFBigNumCopyDescription(const _CFBigNum *num) {
     return result;
 }
 
+
+#pragma mark -
+#pragma mark Decimals
+
+#define BIG_DECIMAL_BASE    1000000000000000000ULL
+#define BIG_DECIMAL_DIGITS_PER_LIMB 18
+#define BIG_DECIMAL_WIDE_LIMBS  14  // enough for any intermediate result below
+
+static const uint64_t __CFBigDecimalPowersOfTen[19] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+    1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL
+};
+
+static CFIndex __CFBigDecimalLimbLength(const uint64_t *limbs, CFIndex n) {
+    while (0 < n && 0 == limbs[n - 1]) n--;
+    return n;
+}
+
+static CFIndex __CFBigDecimalDigitCount(const uint64_t *limbs, CFIndex n) {
+    n = __CFBigDecimalLimbLength(limbs, n);
+    if (0 == n) return 0;
+    uint64_t top = limbs[n - 1];
+    CFIndex digits = 1;
+    while (digits < BIG_DECIMAL_DIGITS_PER_LIMB && __CFBigDecimalPowersOfTen[digits] <= top) digits++;
+    return (n - 1) * BIG_DECIMAL_DIGITS_PER_LIMB + digits;
+}
+
+// limbs *= m, for m <= 10^18; returns the carry out of the top limb
+static uint64_t __CFBigDecimalMultiplySmall(uint64_t *limbs, CFIndex n, uint64_t m) {
+    uint64_t carry = 0;
+    for (CFIndex i = 0; i < n; i++) {
+        __uint128_t t = (__uint128_t)limbs[i] * m + carry;
+        carry = (uint64_t)(t / BIG_DECIMAL_BASE);
+        limbs[i] = (uint64_t)(t - (__uint128_t)carry * BIG_DECIMAL_BASE);
+    }
+    return carry;
+}
+
+// limbs /= d, for 0 < d <= 10^18; returns the remainder
+static uint64_t __CFBigDecimalDivideSmall(uint64_t *limbs, CFIndex n, uint64_t d) {
+    uint64_t rem = 0;
+    for (CFIndex i = n; i--;) {
+        __uint128_t t = (__uint128_t)rem * BIG_DECIMAL_BASE + limbs[i];
+        limbs[i] = (uint64_t)(t / d);
+        rem = (uint64_t)(t - (__uint128_t)limbs[i] * d);
+    }
+    return rem;
+}
+
+static void __CFBigDecimalIncrement(uint64_t *limbs, CFIndex n) {
+    for (CFIndex i = 0; i < n; i++) {
+        if (++limbs[i] < BIG_DECIMAL_BASE) return;
+        limbs[i] = 0;
+    }
+}
+
+// wide = limbs * 10^shift; the result must fit in wideCount limbs
+static void __CFBigDecimalScale(uint64_t *wide, CFIndex wideCount, const uint64_t *limbs, CFIndex n, CFIndex shift) {
+    CFIndex limbShift = shift / BIG_DECIMAL_DIGITS_PER_LIMB;
+    n = __CFBigDecimalLimbLength(limbs, n);
+    memset(wide, 0, wideCount * sizeof(uint64_t));
+    if (0 == n) return;
+    memmove(wide + limbShift, limbs, n * sizeof(uint64_t));
+    if (0 != shift % BIG_DECIMAL_DIGITS_PER_LIMB) {
+        __CFBigDecimalMultiplySmall(wide + limbShift, wideCount - limbShift, __CFBigDecimalPowersOfTen[shift % BIG_DECIMAL_DIGITS_PER_LIMB]);
+    }
+}
+
+static CFComparisonResult __CFBigDecimalCompareLimbs(const uint64_t *a, const uint64_t *b, CFIndex n) {
+    for (CFIndex i = n; i--;) {
+        if (a[i] != b[i]) return (a[i] < b[i]) ? kCFCompareLessThan : kCFCompareGreaterThan;
+    }
+    return kCFCompareEqualTo;
+}
+
+// r = a + b, or a - b for a >= b
+static void __CFBigDecimalAddLimbs(uint64_t *r, const uint64_t *a, const uint64_t *b, CFIndex n) {
+    uint64_t carry = 0;
+    for (CFIndex i = 0; i < n; i++) {
+        uint64_t t = a[i] + b[i] + carry;
+        carry = (BIG_DECIMAL_BASE <= t);
+        r[i] = carry ? t - BIG_DECIMAL_BASE : t;
+    }
+}
+
+static void __CFBigDecimalSubtractLimbs(uint64_t *r, const uint64_t *a, const uint64_t *b, CFIndex n) {
+    uint64_t borrow = 0;
+    for (CFIndex i = 0; i < n; i++) {
+        uint64_t s = b[i] + borrow;
+        borrow = (a[i] < s);
+        r[i] = borrow ? a[i] + BIG_DECIMAL_BASE - s : a[i] - s;
+    }
+}
+
+// Divides limbs by 10^drop, rounding as mode says for a number of the given sign; sticky says
+// whether nonzero digits were already lost below these.  Returns whether the result is inexact.
+static Boolean __CFBigDecimalDropDigits(uint64_t *limbs, CFIndex n, CFIndex drop, int8_t sign, Boolean sticky, _CFBigDecimalRoundingMode mode) {
+    Boolean restNonZero = sticky;
+    uint64_t first = 0;	// the most significant digit dropped
+    if (0 < drop) {
+        CFIndex limbDrop = (drop - 1) / BIG_DECIMAL_DIGITS_PER_LIMB, digitDrop = (drop - 1) % BIG_DECIMAL_DIGITS_PER_LIMB;
+        for (CFIndex i = 0; i < limbDrop; i++) {
+            if (0 != limbs[i]) restNonZero = true;
+        }
+        memmove(limbs, limbs + limbDrop, (n - limbDrop) * sizeof(uint64_t));
+        memset(limbs + n - limbDrop, 0, limbDrop * sizeof(uint64_t));
+        if (0 < digitDrop && 0 != __CFBigDecimalDivideSmall(limbs, n, __CFBigDecimalPowersOfTen[digitDrop])) restNonZero = true;
+        first = __CFBigDecimalDivideSmall(limbs, n, 10);
+    }
+    Boolean inexact = (0 != first) || restNonZero;
+    Boolean increment = false;
+    switch (mode) {
+    case _kCFBigDecimalRoundPlain: increment = (5 <= first); break;
+    case _kCFBigDecimalRoundDown: increment = inexact && sign < 0; break;
+    case _kCFBigDecimalRoundUp: increment = inexact && 0 <= sign; break;
+    case _kCFBigDecimalRoundBankers: increment = (5 < first) || (5 == first && (restNonZero || (limbs[0] & 1))); break;
+    case _kCFBigDecimalRoundTowardZero: break;
+    }
+    if (increment) __CFBigDecimalIncrement(limbs, n);
+    return inexact;
+}
+
+// Rounds a wide coefficient to the digits and exponent range of a _CFBigDecimal and stores it in r
+static _CFBigDecimalError __CFBigDecimalFinish(_CFBigDecimal *r, uint64_t *wide, CFIndex n, int64_t exponent, int8_t sign, Boolean sticky, _CFBigDecimalRoundingMode mode) {
+    CFIndex digits = __CFBigDecimalDigitCount(wide, n);
+    CFIndex drop = (_kCFBigDecimalMaxDigits < digits) ? digits - _kCFBigDecimalMaxDigits : 0;
+    Boolean inexact = false;
+    if (exponent + drop < _kCFBigDecimalMinExponent) drop = (CFIndex)(_kCFBigDecimalMinExponent - exponent);
+    if (digits + 1 < drop) {
+        // everything goes; keep the leading zero as the first digit dropped
+        inexact = __CFBigDecimalDropDigits(wide, n, digits + 1, sign, sticky, mode);
+        exponent += drop;
+    } else if (0 < drop || sticky) {
+        inexact = __CFBigDecimalDropDigits(wide, n, drop, sign, sticky, mode);
+        exponent += drop;
+        if (_kCFBigDecimalMaxDigits < __CFBigDecimalDigitCount(wide, n)) {
+            // rounded up to a power of ten one digit too long
+            __CFBigDecimalDivideSmall(wide, n, 10);
+            exponent++;
+        }
+    }
+    digits = __CFBigDecimalDigitCount(wide, n);
+    memset(r, 0, sizeof(*r));
+    if (0 == digits) {
+        exponent = (exponent < _kCFBigDecimalMinExponent) ? _kCFBigDecimalMinExponent : (_kCFBigDecimalMaxExponent < exponent) ? _kCFBigDecimalMaxExponent : exponent;
+        r->exponent = (int32_t)exponent;
+        return inexact ? _kCFBigDecimalUnderflow : _kCFBigDecimalNoError;
+    }
+    if (_kCFBigDecimalMaxExponent < exponent) {
+        // trade exponent for trailing zeros if there is room
+        if (_kCFBigDecimalMaxDigits < digits + (exponent - _kCFBigDecimalMaxExponent)) {
+            r->isNaN = 1;
+            return _kCFBigDecimalOverflow;
+        }
+        CFIndex shift = (CFIndex)(exponent - _kCFBigDecimalMaxExponent);
+        uint64_t tmp[_kCFBigDecimalLimbCount];
+        memmove(tmp, wide, sizeof(tmp));
+        __CFBigDecimalScale(wide, _kCFBigDecimalLimbCount, tmp, _kCFBigDecimalLimbCount, shift);
+        exponent = _kCFBigDecimalMaxExponent;
+    }
+    memmove(r->limbs, wide, sizeof(r->limbs));
+    r->exponent = (int32_t)exponent;
+    r->sign = (sign < 0) ? -1 : 0;
+    return inexact ? _kCFBigDecimalLossOfPrecision : _kCFBigDecimalNoError;
+}
+
+void _CFBigDecimalInitNaN(_CFBigDecimal *r) {
+    memset(r, 0, sizeof(*r));
+    r->isNaN = 1;
+}
+
+Boolean _CFBigDecimalIsNaN(const _CFBigDecimal *num) {
+    return num->isNaN ? true : false;
+}
+
+void _CFBigDecimalInitWithInt64(_CFBigDecimal *r, int64_t mantissa, int32_t exponent) {
+    uint64_t wide[2];
+    uint64_t magnitude = (mantissa < 0) ? -(uint64_t)mantissa : (uint64_t)mantissa;
+    wide[0] = magnitude % BIG_DECIMAL_BASE;
+    wide[1] = magnitude / BIG_DECIMAL_BASE;
+    uint64_t padded[_kCFBigDecimalLimbCount] = {wide[0], wide[1], 0, 0};
+    __CFBigDecimalFinish(r, padded, _kCFBigDecimalLimbCount, exponent, (mantissa < 0) ? -1 : 0, false, _kCFBigDecimalRoundBankers);
+}
+
+void _CFBigDecimalInitWithBigNum(_CFBigDecimal *r, const _CFBigNum *num) {
+    memset(r, 0, sizeof(*r));
+    r->limbs[0] = num->digits[0] + (uint64_t)num->digits[1] * BIG_DIGITS_LIMIT;
+    r->limbs[1] = num->digits[2] + (uint64_t)num->digits[3] * BIG_DIGITS_LIMIT;
+    r->limbs[2] = num->digits[4];
+    if (0 != __CFBigDecimalLimbLength(r->limbs, _kCFBigDecimalLimbCount)) r->sign = (num->sign < 0) ? -1 : 0;
+}
+
+CFComparisonResult _CFBigDecimalCompare(const _CFBigDecimal *a, const _CFBigDecimal *b) {
+    if (a->isNaN || b->isNaN) {
+        if (a->isNaN && b->isNaN) return kCFCompareEqualTo;
+        return a->isNaN ? kCFCompareLessThan : kCFCompareGreaterThan;
+    }
+    CFIndex la = __CFBigDecimalDigitCount(a->limbs, _kCFBigDecimalLimbCount);
+    CFIndex lb = __CFBigDecimalDigitCount(b->limbs, _kCFBigDecimalLimbCount);
+    if (0 == la || 0 == lb) {
+        if (0 == la && 0 == lb) return kCFCompareEqualTo;
+        if (0 == la) return (b->sign < 0) ? kCFCompareGreaterThan : kCFCompareLessThan;
+        return (a->sign < 0) ? kCFCompareLessThan : kCFCompareGreaterThan;
+    }
+    if (a->sign != b->sign) return (a->sign < b->sign) ? kCFCompareLessThan : kCFCompareGreaterThan;
+    Boolean negative = (a->sign < 0);
+    CFComparisonResult magnitude;
+    int64_t ta = (int64_t)a->exponent + la, tb = (int64_t)b->exponent + lb;
+    if (ta != tb) {
+        magnitude = (ta < tb) ? kCFCompareLessThan : kCFCompareGreaterThan;
+    } else {
+        // the leading digits line up, so the exponents are within 72 of each other
+        uint64_t wa[2 * _kCFBigDecimalLimbCount + 1], wb[2 * _kCFBigDecimalLimbCount + 1];
+        int32_t emin = (a->exponent < b->exponent) ? a->exponent : b->exponent;
+        __CFBigDecimalScale(wa, 2 * _kCFBigDecimalLimbCount + 1, a->limbs, _kCFBigDecimalLimbCount, a->exponent - emin);
+        __CFBigDecimalScale(wb, 2 * _kCFBigDecimalLimbCount + 1, b->limbs, _kCFBigDecimalLimbCount, b->exponent - emin);
+        magnitude = __CFBigDecimalCompareLimbs(wa, wb, 2 * _kCFBigDecimalLimbCount + 1);
+    }
+    if (negative && kCFCompareEqualTo != magnitude) magnitude = (kCFCompareLessThan == magnitude) ? kCFCompareGreaterThan : kCFCompareLessThan;
+    return magnitude;
+}
+
+static _CFBigDecimalError __CFBigDecimalAddSigned(_CFBigDecimal *r, const _CFBigDecimal *a, const _CFBigDecimal *b, int8_t bSign, _CFBigDecimalRoundingMode mode) {
+    if (a->isNaN || b->isNaN) {
+        _CFBigDecimalInitNaN(r);
+        return _kCFBigDecimalNoError;
+    }
+    int8_t aSign = a->sign;
+    CFIndex na = __CFBigDecimalLimbLength(a->limbs, _kCFBigDecimalLimbCount);
+    CFIndex nb = __CFBigDecimalLimbLength(b->limbs, _kCFBigDecimalLimbCount);
+    if (na <= 1 && nb <= 1 && a->exponent == b->exponent) {
+        // the common case of small amounts at one scale; no rounding is possible
+        uint64_t x = a->limbs[0], y = b->limbs[0], sum;
+        int8_t sign = aSign;
+        if (aSign == bSign) {
+            sum = x + y;
+        } else if (y <= x) {
+            sum = x - y;
+        } else {
+            sum = y - x;
+            sign = bSign;
+        }
+        int32_t exponent = a->exponent;
+        memset(r, 0, sizeof(*r));
+        r->limbs[0] = sum % BIG_DECIMAL_BASE;
+        r->limbs[1] = sum / BIG_DECIMAL_BASE;
+        r->exponent = exponent;
+        r->sign = (0 != sum && sign < 0) ? -1 : 0;
+        return _kCFBigDecimalNoError;
+    }
+
+    // Line the operands up at the lower exponent.  An operand whose digits all lie more than
+    // 144 places below the top of the other can only decide the rounding, so it is replaced
+    // by a single unit there; a zero far below just gives up its exponent.
+    const uint64_t unit[_kCFBigDecimalLimbCount] = {1, 0, 0, 0};
+    const uint64_t *la = a->limbs, *lb = b->limbs;
+    int64_t ea = a->exponent, eb = b->exponent;
+    int64_t ta = ea + __CFBigDecimalDigitCount(la, _kCFBigDecimalLimbCount), tb = eb + __CFBigDecimalDigitCount(lb, _kCFBigDecimalLimbCount);
+    int64_t top = (0 == na) ? tb : (0 == nb || tb < ta) ? ta : tb;	// zeros have no digits to line up
+    int64_t floorExponent = top - 3 * _kCFBigDecimalMaxDigits;
+    if (0 == na) {
+        if (ea < floorExponent && 0 != nb) ea = floorExponent;
+    } else if (ta < top - 2 * _kCFBigDecimalMaxDigits) {
+        la = unit;
+        ea = top - 2 * _kCFBigDecimalMaxDigits - 1;
+    }
+    if (0 == nb) {
+        if (eb < floorExponent && 0 != na) eb = floorExponent;
+    } else if (tb < top - 2 * _kCFBigDecimalMaxDigits) {
+        lb = unit;
+        eb = top - 2 * _kCFBigDecimalMaxDigits - 1;
+    }
+    int64_t emin = (ea < eb) ? ea : eb;
+    uint64_t wa[BIG_DECIMAL_WIDE_LIMBS], wb[BIG_DECIMAL_WIDE_LIMBS], sum[BIG_DECIMAL_WIDE_LIMBS];
+    __CFBigDecimalScale(wa, BIG_DECIMAL_WIDE_LIMBS, la, _kCFBigDecimalLimbCount, (CFIndex)(ea - emin));
+    __CFBigDecimalScale(wb, BIG_DECIMAL_WIDE_LIMBS, lb, _kCFBigDecimalLimbCount, (CFIndex)(eb - emin));
+    int8_t sign = aSign;
+    if (aSign == bSign) {
+        __CFBigDecimalAddLimbs(sum, wa, wb, BIG_DECIMAL_WIDE_LIMBS);
+    } else if (kCFCompareLessThan != __CFBigDecimalCompareLimbs(wa, wb, BIG_DECIMAL_WIDE_LIMBS)) {
+        __CFBigDecimalSubtractLimbs(sum, wa, wb, BIG_DECIMAL_WIDE_LIMBS);
+    } else {
+        __CFBigDecimalSubtractLimbs(sum, wb, wa, BIG_DECIMAL_WIDE_LIMBS);
+        sign = bSign;
+    }
+    return __CFBigDecimalFinish(r, sum, BIG_DECIMAL_WIDE_LIMBS, emin, sign, false, mode);
+}
+
+_CFBigDecimalError _CFBigDecimalAdd(_CFBigDecimal *r, const _CFBigDecimal *a, const _CFBigDecimal *b, _CFBigDecimalRoundingMode mode) {
+    return __CFBigDecimalAddSigned(r, a, b, b->sign, mode);
+}
+
+_CFBigDecimalError _CFBigDecimalSubtract(_CFBigDecimal *r, const _CFBigDecimal *a, const _CFBigDecimal *b, _CFBigDecimalRoundingMode mode) {
+    return __CFBigDecimalAddSigned(r, a, b, (b->sign < 0) ? 0 : -1, mode);
+}
+
+_CFBigDecimalError _CFBigDecimalMultiply(_CFBigDecimal *r, const _CFBigDecimal *a, const _CFBigDecimal *b, _CFBigDecimalRoundingMode mode) {
+    if (a->isNaN || b->isNaN) {
+        _CFBigDecimalInitNaN(r);
+        return _kCFBigDecimalNoError;
+    }
+    CFIndex na = __CFBigDecimalLimbLength(a->limbs, _kCFBigDecimalLimbCount);
+    CFIndex nb = __CFBigDecimalLimbLength(b->limbs, _kCFBigDecimalLimbCount);
+    int64_t exponent = (int64_t)a->exponent + b->exponent;
+    int8_t sign = (a->sign < 0) != (b->sign < 0) ? -1 : 0;
+    uint64_t product[2 * _kCFBigDecimalLimbCount];
+    memset(product, 0, sizeof(product));
+    for (CFIndex i = 0; i < na; i++) {
+        uint64_t carry = 0;
+        for (CFIndex j = 0; j < nb; j++) {
+            __uint128_t t = (__uint128_t)a->limbs[i] * b->limbs[j] + product[i + j] + carry;
+            carry = (uint64_t)(t / BIG_DECIMAL_BASE);
+            product[i + j] = (uint64_t)(t - (__uint128_t)carry * BIG_DECIMAL_BASE);
+        }
+        product[i + nb] = carry;
+    }
+    return __CFBigDecimalFinish(r, product, 2 * _kCFBigDecimalLimbCount, exponent, sign, false, mode);
+}
+
+// Knuth's algorithm D in base 10^18: q = u / v, with u of m + n limbs and v of n >= 2 limbs, the
+// top one nonzero.  u is destroyed; returns whether the remainder is nonzero.
+static Boolean __CFBigDecimalDivideLimbs(uint64_t *q, uint64_t *u, CFIndex m, const uint64_t *vIn, CFIndex n) {
+    uint64_t v[_kCFBigDecimalLimbCount];
+    memmove(v, vIn, n * sizeof(uint64_t));
+    // normalize so the top limb of v is at least half the base
+    uint64_t d = BIG_DECIMAL_BASE / (v[n - 1] + 1);
+    u[m + n] = __CFBigDecimalMultiplySmall(u, m + n, d);
+    __CFBigDecimalMultiplySmall(v, n, d);
+    for (CFIndex j = m + 1; j--;) {
+        __uint128_t num = (__uint128_t)u[j + n] * BIG_DECIMAL_BASE + u[j + n - 1];
+        __uint128_t qhat = num / v[n - 1];
+        __uint128_t rhat = num - qhat * v[n - 1];
+        while (BIG_DECIMAL_BASE <= qhat || qhat * v[n - 2] > rhat * BIG_DECIMAL_BASE + u[j + n - 2]) {
+            qhat--;
+            rhat += v[n - 1];
+            if (BIG_DECIMAL_BASE <= rhat) break;
+        }
+        // u[j .. j + n] -= qhat * v
+        uint64_t carry = 0, borrow = 0;
+        for (CFIndex i = 0; i < n; i++) {
+            __uint128_t p = qhat * v[i] + carry;
+            carry = (uint64_t)(p / BIG_DECIMAL_BASE);
+            uint64_t s = (uint64_t)(p - (__uint128_t)carry * BIG_DECIMAL_BASE) + borrow;
+            borrow = (u[i + j] < s);
+            u[i + j] = borrow ? u[i + j] + BIG_DECIMAL_BASE - s : u[i + j] - s;
+        }
+        uint64_t s = carry + borrow;
+        if (u[j + n] < s) {
+            // qhat was one too large; add v back
+            qhat--;
+            carry = 0;
+            for (CFIndex i = 0; i < n; i++) {
+                uint64_t t = u[i + j] + v[i] + carry;
+                carry = (BIG_DECIMAL_BASE <= t);
+                u[i + j] = carry ? t - BIG_DECIMAL_BASE : t;
+            }
+            u[j + n] = 0;
+        } else {
+            u[j + n] -= s;
+        }
+        q[j] = (uint64_t)qhat;
+    }
+    return 0 != __CFBigDecimalLimbLength(u, n);
+}
+
+_CFBigDecimalError _CFBigDecimalDivide(_CFBigDecimal *r, const _CFBigDecimal *a, const _CFBigDecimal *b, _CFBigDecimalRoundingMode mode) {
+    if (a->isNaN || b->isNaN) {
+        _CFBigDecimalInitNaN(r);
+        return _kCFBigDecimalNoError;
+    }
+    CFIndex nb = __CFBigDecimalLimbLength(b->limbs, _kCFBigDecimalLimbCount);
+    if (0 == nb) {
+        _CFBigDecimalInitNaN(r);
+        return _kCFBigDecimalDivideByZero;
+    }
+    int64_t idealExponent = (int64_t)a->exponent - b->exponent;
+    int8_t sign = (a->sign < 0) != (b->sign < 0) ? -1 : 0;
+    CFIndex la = __CFBigDecimalDigitCount(a->limbs, _kCFBigDecimalLimbCount);
+    CFIndex lb = __CFBigDecimalDigitCount(b->limbs, _kCFBigDecimalLimbCount);
+    uint64_t q[BIG_DECIMAL_WIDE_LIMBS], u[BIG_DECIMAL_WIDE_LIMBS];
+    memset(q, 0, sizeof(q));
+    if (0 == la) {
+        return __CFBigDecimalFinish(r, q, BIG_DECIMAL_WIDE_LIMBS, idealExponent, 0, false, mode);
+    }
+    // scale a up so the quotient has at least two digits more than are kept
+    CFIndex shift = _kCFBigDecimalMaxDigits + 2 + lb - la;
+    if (shift < 0) shift = 0;
+    CFIndex m = (la + shift + BIG_DECIMAL_DIGITS_PER_LIMB - 1) / BIG_DECIMAL_DIGITS_PER_LIMB;	// limbs of the scaled a
+    __CFBigDecimalScale(u, BIG_DECIMAL_WIDE_LIMBS, a->limbs, _kCFBigDecimalLimbCount, shift);
+    Boolean inexact;
+    if (1 == nb) {
+        inexact = (0 != __CFBigDecimalDivideSmall(u, m, b->limbs[0]));
+        memmove(q, u, m * sizeof(uint64_t));
+    } else {
+        if (m < nb) m = nb;
+        inexact = __CFBigDecimalDivideLimbs(q, u, m - nb, b->limbs, nb);
+    }
+    int64_t exponent = idealExponent - shift;
+    if (!inexact) {
+        // an exact quotient drops the trailing zeros the scaling added
+        while (exponent < idealExponent && 0 == q[0] % 10) {
+            __CFBigDecimalDivideSmall(q, BIG_DECIMAL_WIDE_LIMBS, 10);
+            exponent++;
+        }
+    }
+    return __CFBigDecimalFinish(r, q, BIG_DECIMAL_WIDE_LIMBS, exponent, sign, inexact, mode);
+}
+
+_CFBigDecimalError _CFBigDecimalRound(_CFBigDecimal *r, const _CFBigDecimal *a, CFIndex scale, _CFBigDecimalRoundingMode mode) {
+    if (a->isNaN) {
+        _CFBigDecimalInitNaN(r);
+        return _kCFBigDecimalNoError;
+    }
+    int64_t target = -(int64_t)scale;
+    if (target <= a->exponent) {
+        memmove(r, a, sizeof(*a));
+        return _kCFBigDecimalNoError;
+    }
+    uint64_t wide[_kCFBigDecimalLimbCount + 1];
+    memset(wide, 0, sizeof(wide));
+    memmove(wide, a->limbs, sizeof(a->limbs));
+    int64_t drop = target - a->exponent;
+    CFIndex digits = __CFBigDecimalDigitCount(wide, _kCFBigDecimalLimbCount + 1);
+    if (digits + 1 < drop) drop = digits + 1;	// all digits go; the first dropped is a leading zero
+    Boolean inexact = __CFBigDecimalDropDigits(wide, _kCFBigDecimalLimbCount + 1, (CFIndex)drop, a->sign, false, mode);
+    _CFBigDecimalError error = __CFBigDecimalFinish(r, wide, _kCFBigDecimalLimbCount + 1, target, a->sign, false, mode);
+    if (_kCFBigDecimalNoError == error && inexact) error = _kCFBigDecimalLossOfPrecision;
+    return error;
+}
+
+Boolean _CFBigDecimalInitWithCString(_CFBigDecimal *r, const char *string) {
+    // keep two digits more than fit, for rounding, and note whether anything beyond is nonzero
+    char digits[_kCFBigDecimalMaxDigits + 2];
+    CFIndex count = 0, seen = 0;
+    int64_t exponent = 0;
+    Boolean sticky = false, isNegative = false;
+    const char *s = string;
+    if ('-' == *s || '+' == *s) isNegative = ('-' == *s++);
+    for (Boolean inFraction = false; ; s++) {
+        if ('.' == *s && !inFraction) {
+            inFraction = true;
+            continue;
+        }
+        if (*s < '0' || '9' < *s) break;
+        seen++;
+        if (inFraction) exponent--;
+        if (0 == count && '0' == *s) continue;
+        if (count < (CFIndex)sizeof(digits)) {
+            digits[count++] = *s;
+        } else {
+            exponent++;
+            if ('0' != *s) sticky = true;
+        }
+    }
+    if (0 == seen) {
+        _CFBigDecimalInitNaN(r);
+        return false;
+    }
+    if ('e' == *s || 'E' == *s) {
+        Boolean expNegative = false;
+        int64_t value = 0;
+        s++;
+        if ('-' == *s || '+' == *s) expNegative = ('-' == *s++);
+        if (*s < '0' || '9' < *s) {
+            _CFBigDecimalInitNaN(r);
+            return false;
+        }
+        for (; '0' <= *s && *s <= '9'; s++) {
+            if (value < 1000000000) value = value * 10 + (*s - '0');
+        }
+        exponent += expNegative ? -value : value;
+    }
+    if ('\0' != *s) {
+        _CFBigDecimalInitNaN(r);
+        return false;
+    }
+    uint64_t wide[_kCFBigDecimalLimbCount + 1];
+    memset(wide, 0, sizeof(wide));
+    for (CFIndex end = count, limb = 0; 0 < end; end -= BIG_DECIMAL_DIGITS_PER_LIMB, limb++) {
+        CFIndex start = (end < BIG_DECIMAL_DIGITS_PER_LIMB) ? 0 : end - BIG_DECIMAL_DIGITS_PER_LIMB;
+        uint64_t value = 0;
+        for (CFIndex i = start; i < end; i++) value = value * 10 + (digits[i] - '0');
+        wide[limb] = value;
+    }
+    return (_kCFBigDecimalOverflow != __CFBigDecimalFinish(r, wide, _kCFBigDecimalLimbCount + 1, exponent, isNegative ? -1 : 0, sticky, _kCFBigDecimalRoundBankers));
+}
+
+Boolean _CFBigDecimalInitWithCFString(_CFBigDecimal *r, CFStringRef string) {
+    const char *cString = CFStringGetCStringPtr(string, kCFStringEncodingASCII);
+    if (cString) return _CFBigDecimalInitWithCString(r, cString);
+    CFIndex length = CFStringGetLength(string);
+    char stackBuffer[256];
+    char *buffer = (length < (CFIndex)sizeof(stackBuffer)) ? stackBuffer : (char *)malloc(length + 1);
+    Boolean result = false;
+    if (CFStringGetCString(string, buffer, length + 1, kCFStringEncodingASCII)) {
+        result = _CFBigDecimalInitWithCString(r, buffer);
+    } else {
+        _CFBigDecimalInitNaN(r);
+    }
+    if (buffer != stackBuffer) free(buffer);
+    return result;
+}
+
+void _CFBigDecimalInitWithCFNumber(_CFBigDecimal *r, CFNumberRef number) {
+    if (CFNumberIsFloatType(number)) {
+        double d;
+        char buffer[32];
+        CFNumberGetValue(number, kCFNumberDoubleType, &d);
+        if (!isfinite(d)) {
+            _CFBigDecimalInitNaN(r);
+            return;
+        }
+        __CFDoubleFormatShortest(d, buffer);
+        _CFBigDecimalInitWithCString(r, buffer);
+        return;
+    }
+    _CFBigNum num;
+    _CFBigNumInitWithCFNumber(&num, number);
+    _CFBigDecimalInitWithBigNum(r, &num);
+}
+
+// the coefficient's digits, without leading zeros; returns their count
+static CFIndex __CFBigDecimalCoefficientToCString(const _CFBigDecimal *num, char *buffer) {
+    CFIndex n = __CFBigDecimalLimbLength(num->limbs, _kCFBigDecimalLimbCount);
+    if (0 == n) {
+        buffer[0] = '0';
+        buffer[1] = '\0';
+        return 1;
+    }
+    CFIndex length = snprintf(buffer, 20, "%llu", (unsigned long long)num->limbs[n - 1]);
+    for (CFIndex i = n - 1; i--;) {
+        length += snprintf(buffer + length, 19, "%018llu", (unsigned long long)num->limbs[i]);
+    }
+    return length;
+}
+
+void _CFBigDecimalToCString(const _CFBigDecimal *num, char *buffer, size_t buflen) {
+    char tmp[200], digits[_kCFBigDecimalMaxDigits + 1];
+    char *dst = tmp;
+    if (num->isNaN) {
+        strlcpy(buffer, "NaN", buflen);
+        return;
+    }
+    CFIndex count = __CFBigDecimalCoefficientToCString(num, digits);
+    int64_t exponent = num->exponent;
+    int64_t point = count + exponent;	// digits before the decimal point
+    if (num->sign < 0) *dst++ = '-';
+    if (100 < exponent || point < -100) {
+        *dst++ = digits[0];
+        if (1 < count) {
+            *dst++ = '.';
+            memmove(dst, digits + 1, count - 1);
+            dst += count - 1;
+        }
+        dst += snprintf(dst, 16, "E%+lld", (long long)(point - 1));
+    } else if (0 <= exponent) {
+        memmove(dst, digits, count);
+        dst += count;
+        memset(dst, '0', exponent);
+        dst += exponent;
+    } else if (0 < point) {
+        memmove(dst, digits, point);
+        dst += point;
+        *dst++ = '.';
+        memmove(dst, digits + point, count - point);
+        dst += count - point;
+    } else {
+        *dst++ = '0';
+        *dst++ = '.';
+        memset(dst, '0', -point);
+        dst += -point;
+        memmove(dst, digits, count);
+        dst += count;
+    }
+    *dst = '\0';
+    strlcpy(buffer, tmp, buflen);
+}
+
+CFStringRef _CFStringCreateWithBigDecimal(CFAllocatorRef allocator, const _CFBigDecimal *num) {
+    char buffer[200];
+    _CFBigDecimalToCString(num, buffer, sizeof(buffer));
+    return CFStringCreateWithCString(allocator, buffer, kCFStringEncodingASCII);
+}
+
+double _CFBigDecimalGetDouble(const _CFBigDecimal *num) {
+    char buffer[_kCFBigDecimalMaxDigits + 16];
+    double result;
+    if (num->isNaN) return NAN;
+    // digits and an exponent, with no decimal point, read the same in every locale
+    CFIndex length = __CFBigDecimalCoefficientToCString(num, buffer);
+    length += snprintf(buffer + length, 16, "e%d", num->exponent);
+    if (__CFDoubleParseDecimal(buffer, length, &result) != length) result = strtod(buffer, NULL);
+    return (num->sign < 0) ? -result : result;
+}
+
+CFNumberRef _CFNumberCreateWithBigDecimal(const _CFBigDecimal *input) {
+    if (input->isNaN) return (CFNumberRef)CFRetain(kCFNumberNaN);
+    CFIndex digits = __CFBigDecimalDigitCount(input->limbs, _kCFBigDecimalLimbCount);
+    uint64_t wide[_kCFBigDecimalLimbCount];
+    int64_t exponent = input->exponent;
+    memmove(wide, input->limbs, sizeof(wide));
+    // an integral value sheds its trailing zeros after the point
+    while (exponent < 0 && 0 < digits && 0 == wide[0] % 10) {
+        __CFBigDecimalDivideSmall(wide, _kCFBigDecimalLimbCount, 10);
+        exponent++;
+        digits--;
+    }
+    if (0 == digits || (0 <= exponent && digits + exponent <= 45)) {
+        uint64_t scaled[_kCFBigDecimalLimbCount];
+        if (0 == digits) exponent = 0;
+        __CFBigDecimalScale(scaled, _kCFBigDecimalLimbCount, wide, _kCFBigDecimalLimbCount, (CFIndex)exponent);
+        _CFBigNum num;
+        memset(&num, 0, sizeof(num));
+        num.digits[0] = (uint32_t)(scaled[0] % BIG_DIGITS_LIMIT);
+        num.digits[1] = (uint32_t)(scaled[0] / BIG_DIGITS_LIMIT);
+        num.digits[2] = (uint32_t)(scaled[1] % BIG_DIGITS_LIMIT);
+        num.digits[3] = (uint32_t)(scaled[1] / BIG_DIGITS_LIMIT);
+        num.digits[4] = (uint32_t)scaled[2];
+        num.sign = input->sign;
+        CFNumberRef result = _CFNumberCreateWithBigNum(&num);
+        if (result) return result;
+    }
+    double d = _CFBigDecimalGetDouble(input);
+    return CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberDoubleType, &d);
+}
+
+_CFBigDecimalError _CFBigDecimalOperateOnArrays(_CFBigDecimalOperation op, _CFBigDecimal *results, const _CFBigDecimal *a, const _CFBigDecimal *b, CFIndex count, _CFBigDecimalRoundingMode mode) {
+    _CFBigDecimalError (*function)(_CFBigDecimal *, const _CFBigDecimal *, const _CFBigDecimal *, _CFBigDecimalRoundingMode) = NULL;
+    _CFBigDecimalError worst = _kCFBigDecimalNoError;
+    switch (op) {
+    case _kCFBigDecimalOperationAdd: function = _CFBigDecimalAdd; break;
+    case _kCFBigDecimalOperationSubtract: function = _CFBigDecimalSubtract; break;
+    case _kCFBigDecimalOperationMultiply: function = _CFBigDecimalMultiply; break;
+    case _kCFBigDecimalOperationDivide: function = _CFBigDecimalDivide; break;
+    default:
+        for (CFIndex idx = 0; idx < count; idx++) _CFBigDecimalInitNaN(results + idx);
+        return _kCFBigDecimalInvalidOperation;
+    }
+    for (CFIndex idx = 0; idx < count; idx++) {
+        _CFBigDecimalError error = function(results + idx, a + idx, b + idx, mode);
+        if (worst < error) worst = error;
+    }
+    return worst;
+}
+
+_CFBigDecimalError _CFBigDecimalRoundArray(_CFBigDecimal *results, const _CFBigDecimal *values, CFIndex count, CFIndex scale, _CFBigDecimalRoundingMode mode) {
+    _CFBigDecimalError worst = _kCFBigDecimalNoError;
+    for (CFIndex idx = 0; idx < count; idx++) {
+        _CFBigDecimalError error = _CFBigDecimalRound(results + idx, values + idx, scale, mode);
+        if (worst < error) worst = error;
+    }
+    return worst;
+}
+
+_CFBigDecimalError _CFBigDecimalSum(_CFBigDecimal *r, const _CFBigDecimal *values, CFIndex count, _CFBigDecimalRoundingMode mode) {
+    CFIndex idx;
+    if (0 == count) {
+        _CFBigDecimalInitWithInt64(r, 0, 0);
+        return _kCFBigDecimalNoError;
+    }
+    for (idx = 0; idx < count; idx++) {
+        if (values[idx].isNaN || values[idx].exponent != values[0].exponent) break;
+    }
+    if (idx < count) {
+        // mixed exponents: add one at a time
+        _CFBigDecimalError worst = _kCFBigDecimalNoError;
+        _CFBigDecimal sum = values[0];
+        for (idx = 1; idx < count; idx++) {
+            _CFBigDecimalError error = _CFBigDecimalAdd(&sum, &sum, values + idx, mode);
+            if (worst < error) worst = error;
+        }
+        *r = sum;
+        return worst;
+    }
+    // One exponent: add the coefficients into separate positive and negative totals.  Limbs
+    // are below 10^18, so sixteen can be added up before the carries must be propagated.
+    uint64_t totals[2][_kCFBigDecimalLimbCount + 2];
+    memset(totals, 0, sizeof(totals));
+    for (idx = 0; idx < count; idx++) {
+        uint64_t *total = totals[(values[idx].sign < 0) ? 1 : 0];
+        for (CFIndex i = 0; i < _kCFBigDecimalLimbCount; i++) total[i] += values[idx].limbs[i];
+        if (15 == idx % 16 || idx + 1 == count) {
+            for (CFIndex t = 0; t < 2; t++) {
+                for (CFIndex i = 0; i < _kCFBigDecimalLimbCount + 1; i++) {
+                    totals[t][i + 1] += totals[t][i] / BIG_DECIMAL_BASE;
+                    totals[t][i] %= BIG_DECIMAL_BASE;
+                }
+            }
+        }
+    }
+    uint64_t sum[_kCFBigDecimalLimbCount + 2];
+    int8_t sign = 0;
+    if (kCFCompareLessThan != __CFBigDecimalCompareLimbs(totals[0], totals[1], _kCFBigDecimalLimbCount + 2)) {
+        __CFBigDecimalSubtractLimbs(sum, totals[0], totals[1], _kCFBigDecimalLimbCount + 2);
+    } else {
+        __CFBigDecimalSubtractLimbs(sum, totals[1], totals[0], _kCFBigDecimalLimbCount + 2);
+        sign = -1;
+    }
+    return __CFBigDecimalFinish(r, sum, _kCFBigDecimalLimbCount + 2, values[0].exponent, sign, false, mode);
+}
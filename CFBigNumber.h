@@ -89,5 +89,87 @@ void _CFBigNumFromCString(_CFBigNum *r, const char *string);
 char *_CFBigNumCopyDescription(const _CFBigNum *num); // caller must free() returned ptr
 
 
+// Decimal floating point: (sign < 0 ? -1 : 1) * coefficient * 10^exponent, where the coefficient
+// has up to 72 digits held in base 10^18 limbs, least significant first.  Results that need more
+// digits are rounded to 72; the exponent ranges over -32767 to 32767.  Operations may be done in
+// place: r can be the same as any operand.
+#define _kCFBigDecimalLimbCount 4
+#define _kCFBigDecimalMaxDigits 72
+#define _kCFBigDecimalMaxExponent 32767
+#define _kCFBigDecimalMinExponent (-32767)
+
+typedef struct {
+    uint64_t limbs[_kCFBigDecimalLimbCount];
+    int32_t exponent;
+    int8_t sign;	// -1 or 0, as for _CFBigNum; zero is never negative
+    uint8_t isNaN;
+    uint16_t __;
+} _CFBigDecimal;
+
+typedef enum {
+    _kCFBigDecimalRoundPlain,		// to nearest, halves away from zero
+    _kCFBigDecimalRoundDown,		// toward negative infinity
+    _kCFBigDecimalRoundUp,		// toward positive infinity
+    _kCFBigDecimalRoundBankers,		// to nearest, halves to even
+    _kCFBigDecimalRoundTowardZero
+} _CFBigDecimalRoundingMode;
+
+// in increasing order of severity
+typedef enum {
+    _kCFBigDecimalNoError = 0,
+    _kCFBigDecimalLossOfPrecision,	// the result was rounded
+    _kCFBigDecimalUnderflow,		// the result was rounded to zero
+    _kCFBigDecimalOverflow,		// the result is NaN
+    _kCFBigDecimalDivideByZero,		// the result is NaN
+    _kCFBigDecimalInvalidOperation	// op was not a _CFBigDecimalOperation; the results are NaN
+} _CFBigDecimalError;
+
+void _CFBigDecimalInitWithInt64(_CFBigDecimal *r, int64_t mantissa, int32_t exponent);
+void _CFBigDecimalInitWithBigNum(_CFBigDecimal *r, const _CFBigNum *num);
+// floating point numbers take the shortest decimal that reads back as the same double
+void _CFBigDecimalInitWithCFNumber(_CFBigDecimal *r, CFNumberRef number);
+// [+-]digits[.digits][(e|E)[+-]digits]; anything else, or a value too large, gives NaN and false
+Boolean _CFBigDecimalInitWithCString(_CFBigDecimal *r, const char *string);
+Boolean _CFBigDecimalInitWithCFString(_CFBigDecimal *r, CFStringRef string);
+void _CFBigDecimalInitNaN(_CFBigDecimal *r);
+
+Boolean _CFBigDecimalIsNaN(const _CFBigDecimal *num);
+double _CFBigDecimalGetDouble(const _CFBigDecimal *num);	// correctly rounded
+// integral values that fit become integer CFNumbers, others doubles
+CFNumberRef _CFNumberCreateWithBigDecimal(const _CFBigDecimal *input);
+
+// plain notation, such as -1234.50, unless that takes more than 100 zeros; then 1.2345E+120.
+// A buffer of 200 bytes always suffices.
+void _CFBigDecimalToCString(const _CFBigDecimal *num, char *buffer, size_t buflen);
+CFStringRef _CFStringCreateWithBigDecimal(CFAllocatorRef allocator, const _CFBigDecimal *num);
+
+// by value, so 1.50 and 1.5 are equal; NaN is less than any number
+CFComparisonResult _CFBigDecimalCompare(const _CFBigDecimal *a, const _CFBigDecimal *b);
+
+// Sums, differences and products are exact when they fit in 72 digits, and keep the exponent of
+// the operands (1.10 + 2.20 is 3.30).  Quotients are rounded to 72 digits; exact ones take the
+// exponent of a minus that of b when the digits allow it, as in 3.00 / 1.5 = 2.0.
+_CFBigDecimalError _CFBigDecimalAdd(_CFBigDecimal *r, const _CFBigDecimal *a, const _CFBigDecimal *b, _CFBigDecimalRoundingMode mode);
+_CFBigDecimalError _CFBigDecimalSubtract(_CFBigDecimal *r, const _CFBigDecimal *a, const _CFBigDecimal *b, _CFBigDecimalRoundingMode mode);
+_CFBigDecimalError _CFBigDecimalMultiply(_CFBigDecimal *r, const _CFBigDecimal *a, const _CFBigDecimal *b, _CFBigDecimalRoundingMode mode);
+_CFBigDecimalError _CFBigDecimalDivide(_CFBigDecimal *r, const _CFBigDecimal *a, const _CFBigDecimal *b, _CFBigDecimalRoundingMode mode);
+// rounds to scale digits after the decimal point (before it, for a negative scale); a value
+// with fewer digits after the point is left as it is
+_CFBigDecimalError _CFBigDecimalRound(_CFBigDecimal *r, const _CFBigDecimal *a, CFIndex scale, _CFBigDecimalRoundingMode mode);
+
+typedef enum {
+    _kCFBigDecimalOperationAdd,
+    _kCFBigDecimalOperationSubtract,
+    _kCFBigDecimalOperationMultiply,
+    _kCFBigDecimalOperationDivide
+} _CFBigDecimalOperation;
+
+// results[i] = a[i] op b[i]; returns the most severe error of any element
+_CFBigDecimalError _CFBigDecimalOperateOnArrays(_CFBigDecimalOperation op, _CFBigDecimal *results, const _CFBigDecimal *a, const _CFBigDecimal *b, CFIndex count, _CFBigDecimalRoundingMode mode);
+_CFBigDecimalError _CFBigDecimalRoundArray(_CFBigDecimal *results, const _CFBigDecimal *values, CFIndex count, CFIndex scale, _CFBigDecimalRoundingMode mode);
+// rounds once, at the end, when all the values have the same exponent
+_CFBigDecimalError _CFBigDecimalSum(_CFBigDecimal *r, const _CFBigDecimal *values, CFIndex count, _CFBigDecimalRoundingMode mode);
+
+
 #endif /* ! __COREFOUNDATION_CFBIGNUMBER__ */
 
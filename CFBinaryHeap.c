@@ -45,6 +45,17 @@ CF_INLINE CFIndex __CFBinaryHeapNumBucketsForCapacity(CFIndex capacity) {
     return capacity;
 }
 
+/* The heap is 4-ary: the children of bucket i are buckets 4i+1 through 4i+4. That halves the depth of a binary heap, and the four children of a bucket usually share a cache line. */
+#define __CF_HEAP_ARITY 4
+
+CF_INLINE CFIndex __CFBinaryHeapParent(CFIndex idx) {
+    return (idx - 1) / __CF_HEAP_ARITY;
+}
+
+CF_INLINE CFIndex __CFBinaryHeapFirstChild(CFIndex idx) {
+    return idx * __CF_HEAP_ARITY + 1;
+}
+
 struct __CFBinaryHeap {
     CFRuntimeBase _base;
     CFIndex _count;	/* number of objects */
@@ -52,6 +63,12 @@ struct __CFBinaryHeap {
     CFBinaryHeapCallBacks _callbacks;
     CFBinaryHeapCompareContext _context;
     struct __CFBinaryHeapBucket *_buckets;
+    /* Indexed heaps only; NULL otherwise */
+    CFIndex *_handles;		/* handle of the value in each bucket */
+    CFIndex *_positions;	/* bucket holding each handle's value; free handles hold -2 - (next free handle) */
+    CFIndex _freeHandle;	/* first free handle, or -1 */
+    CFIndex _handleLimit;	/* handles below this have been handed out at some point */
+    CFMutableDictionaryRef _valueCounts;	/* value pointer -> number of occurrences, for constant-time containment */
 };
 
 CF_INLINE CFIndex __CFBinaryHeapCount(CFBinaryHeapRef heap) {
@@ -187,6 +204,9 @@ static void __CFBinaryHeapDeallocate(CFTypeRef cf) {
     if (__CFBinaryHeapMutableVariety(heap) == kCFBinaryHeapMutable) {
 	_CFAllocatorDeallocateGC(allocator, heap->_buckets);
     }
+    if (heap->_handles) CFAllocatorDeallocate(allocator, heap->_handles);
+    if (heap->_positions) CFAllocatorDeallocate(allocator, heap->_positions);
+    if (heap->_valueCounts) CFRelease(heap->_valueCounts);
 }
 
 static CFTypeID __kCFBinaryHeapTypeID = _kCFRuntimeNotATypeID;
@@ -209,6 +229,90 @@ CFTypeID CFBinaryHeapGetTypeID(void) {
     return __kCFBinaryHeapTypeID;
 }
 
+static void __CFBinaryHeapGrow(CFBinaryHeapRef heap, CFIndex numNewValues);
+
+CF_INLINE Boolean __CFBinaryHeapLess(CFBinaryHeapRef heap, const void *item1, const void *item2) {
+    CFComparisonResult (*compare)(const void *, const void *, void *) = heap->_callbacks.compare;
+    return compare ? (kCFCompareLessThan == compare(item1, item2, heap->_context.info)) : (item1 < item2);
+}
+
+// Puts item, whose handle is handle in an indexed heap, in bucket idx
+CF_INLINE void __CFBinaryHeapPlace(CFBinaryHeapRef heap, CFIndex idx, void *item, CFIndex handle) {
+    __CFAssignWithWriteBarrier((void **)&heap->_buckets[idx]._item, item);
+    if (heap->_handles) {
+        heap->_handles[idx] = handle;
+        heap->_positions[handle] = idx;
+    }
+}
+
+// Moves item up from the hole at idx until its parent is not greater; returns where it ends up
+static CFIndex __CFBinaryHeapSiftUp(CFBinaryHeapRef heap, CFIndex idx, void *item, CFIndex handle) {
+    while (0 < idx) {
+        CFIndex pidx = __CFBinaryHeapParent(idx);
+        void *parent = heap->_buckets[pidx]._item;
+        if (!__CFBinaryHeapLess(heap, item, parent)) break;
+        __CFBinaryHeapPlace(heap, idx, parent, heap->_handles ? heap->_handles[pidx] : 0);
+        idx = pidx;
+    }
+    __CFBinaryHeapPlace(heap, idx, item, handle);
+    return idx;
+}
+
+// Moves item down from the hole at idx until no child is smaller; returns where it ends up
+static CFIndex __CFBinaryHeapSiftDown(CFBinaryHeapRef heap, CFIndex idx, void *item, CFIndex handle) {
+    CFIndex cnt = __CFBinaryHeapCount(heap);
+    for (;;) {
+        CFIndex cidx = __CFBinaryHeapFirstChild(idx);
+        if (cnt <= cidx) break;
+        CFIndex climit = __CFMin(cidx + __CF_HEAP_ARITY, cnt);
+        CFIndex midx = cidx;
+        void *min = heap->_buckets[cidx]._item;
+        for (cidx++; cidx < climit; cidx++) {
+            void *child = heap->_buckets[cidx]._item;
+            if (__CFBinaryHeapLess(heap, child, min)) {
+                midx = cidx;
+                min = child;
+            }
+        }
+        if (!__CFBinaryHeapLess(heap, min, item)) break;
+        __CFBinaryHeapPlace(heap, idx, min, heap->_handles ? heap->_handles[midx] : 0);
+        idx = midx;
+    }
+    __CFBinaryHeapPlace(heap, idx, item, handle);
+    return idx;
+}
+
+static void __CFBinaryHeapNoteValueAdded(CFBinaryHeapRef heap, const void *value) {
+    if (!heap->_valueCounts) return;
+    uintptr_t cnt = (uintptr_t)CFDictionaryGetValue(heap->_valueCounts, value);
+    CFDictionarySetValue(heap->_valueCounts, value, (const void *)(cnt + 1));
+}
+
+static void __CFBinaryHeapNoteValueRemoved(CFBinaryHeapRef heap, const void *value) {
+    if (!heap->_valueCounts) return;
+    uintptr_t cnt = (uintptr_t)CFDictionaryGetValue(heap->_valueCounts, value);
+    if (cnt <= 1) {
+        CFDictionaryRemoveValue(heap->_valueCounts, value);
+    } else {
+        CFDictionarySetValue(heap->_valueCounts, value, (const void *)(cnt - 1));
+    }
+}
+
+static CFIndex __CFBinaryHeapAllocateHandle(CFBinaryHeapRef heap) {
+    CFIndex handle = heap->_freeHandle;
+    if (0 <= handle) {
+        heap->_freeHandle = -2 - heap->_positions[handle];
+    } else {
+        handle = heap->_handleLimit++;
+    }
+    return handle;
+}
+
+static void __CFBinaryHeapFreeHandle(CFBinaryHeapRef heap, CFIndex handle) {
+    heap->_positions[handle] = -2 - heap->_freeHandle;
+    heap->_freeHandle = handle;
+}
+
 static CFBinaryHeapRef __CFBinaryHeapInit(CFAllocatorRef allocator, UInt32 flags, CFIndex capacity, const void **values, CFIndex numValues, const CFBinaryHeapCallBacks *callBacks, const CFBinaryHeapCompareContext *compareContext) {
     CFBinaryHeapRef memory;
     CFIndex idx;
@@ -250,10 +354,26 @@ static CFBinaryHeapRef __CFBinaryHeapInit(CFAllocatorRef allocator, UInt32 flags
 	memory->_callbacks.compare = 0;
     }
     if (compareContext) memcpy(&memory->_context, compareContext, sizeof(CFBinaryHeapCompareContext));
+    memory->_handles = NULL;
+    memory->_positions = NULL;
+    memory->_freeHandle = -1;
+    memory->_handleLimit = 0;
+    memory->_valueCounts = NULL;
 // CF: retain info for proper operation
     __CFBinaryHeapSetMutableVariety(memory, kCFBinaryHeapMutable);
-    for (idx = 0; idx < numValues; idx++) {
-	CFBinaryHeapAddValue(memory, values[idx]);
+    if (0 < numValues) {
+        // Floyd's bottom-up construction: sifting down each internal bucket from the last is O(n), against O(n log n) for adding one at a time
+        if (__CFBinaryHeapCapacity(memory) < numValues) __CFBinaryHeapGrow(memory, numValues);
+        for (idx = 0; idx < numValues; idx++) {
+            void *value = (void *)values[idx];
+            if (memory->_callbacks.retain) value = (void *)memory->_callbacks.retain(allocator, value);
+            __CFAssignWithWriteBarrier((void **)&memory->_buckets[idx]._item, value);
+        }
+        __CFBinaryHeapSetNumBucketsUsed(memory, numValues);
+        __CFBinaryHeapSetCount(memory, numValues);
+        for (idx = __CFBinaryHeapParent(numValues - 1) + 1; idx--;) {
+            __CFBinaryHeapSiftDown(memory, idx, memory->_buckets[idx]._item, 0);
+        }
     }
     __CFBinaryHeapSetMutableVariety(memory, __CFBinaryHeapMutableVarietyFromFlags(flags));
     return memory;
@@ -295,6 +415,11 @@ Boolean CFBinaryHeapContainsValue(CFBinaryHeapRef heap, const void *value) {
     CFIndex length;
     __CFGenericValidateType(heap, CFBinaryHeapGetTypeID());
     compare = heap->_callbacks.compare;
+    if (heap->_valueCounts) {
+        // The value itself being present settles it; without a comparator nothing else can match
+        if (CFDictionaryContainsKey(heap->_valueCounts, value)) return true;
+        if (!compare) return false;
+    }
     length = __CFBinaryHeapCount(heap);
     for (idx = 0; idx < length; idx++) {
 	const void *item = heap->_buckets[idx]._item;
@@ -362,13 +487,17 @@ static void __CFBinaryHeapGrow(CFBinaryHeapRef heap, CFIndex numNewValues) {
     __CFAssignWithWriteBarrier((void **)&heap->_buckets, buckets);
     if (__CFOASafe) __CFSetLastAllocationEventName(heap->_buckets, "CFBinaryHeap (store)");
     if (NULL == heap->_buckets) HALT;
+    if (heap->_handles) {
+        // Live handles never outnumber the values, so the handle table grows with the buckets
+        heap->_handles = (CFIndex *)CFAllocatorReallocate(allocator, heap->_handles, capacity * sizeof(CFIndex), 0);
+        heap->_positions = (CFIndex *)CFAllocatorReallocate(allocator, heap->_positions, capacity * sizeof(CFIndex), 0);
+        if (NULL == heap->_handles || NULL == heap->_positions) HALT;
+    }
 }
 
-void CFBinaryHeapAddValue(CFBinaryHeapRef heap, const void *value) {
-    CFIndex idx, pidx;
+static CFIndex __CFBinaryHeapAddValue(CFBinaryHeapRef heap, const void *value) {
     CFIndex cnt;
     CFAllocatorRef allocator = CFGetAllocator(heap);
-    __CFGenericValidateType(heap, CFBinaryHeapGetTypeID());
     switch (__CFBinaryHeapMutableVariety(heap)) {
     case kCFBinaryHeapMutable:
 	if (__CFBinaryHeapNumBucketsUsed(heap) == __CFBinaryHeapCapacity(heap))
@@ -376,57 +505,45 @@ void CFBinaryHeapAddValue(CFBinaryHeapRef heap, const void *value) {
 	break;
     }
     cnt = __CFBinaryHeapCount(heap);
-    idx = cnt;
     __CFBinaryHeapSetNumBucketsUsed(heap, cnt + 1);
     __CFBinaryHeapSetCount(heap, cnt + 1);
-    CFComparisonResult (*compare)(const void *, const void *, void *) = heap->_callbacks.compare;
-    pidx = (idx - 1) >> 1;
-    while (0 < idx) {
-	void *item = heap->_buckets[pidx]._item;
-	if ((!compare && item <= value) || (compare && kCFCompareGreaterThan != compare(item, value, heap->_context.info))) break;
-	__CFAssignWithWriteBarrier((void **)&heap->_buckets[idx]._item, item);
-	idx = pidx;
-	pidx = (idx - 1) >> 1;
-    }
-    if (heap->_callbacks.retain) {
-	__CFAssignWithWriteBarrier((void **)&heap->_buckets[idx]._item, (void *)heap->_callbacks.retain(allocator, (void *)value));
-    } else {
-	__CFAssignWithWriteBarrier((void **)&heap->_buckets[idx]._item, (void *)value);
-    }
+    void *item = heap->_callbacks.retain ? (void *)heap->_callbacks.retain(allocator, (void *)value) : (void *)value;
+    CFIndex handle = heap->_handles ? __CFBinaryHeapAllocateHandle(heap) : kCFNotFound;
+    __CFBinaryHeapSiftUp(heap, cnt, item, handle);
+    __CFBinaryHeapNoteValueAdded(heap, item);
+    return handle;
 }
 
-void CFBinaryHeapRemoveMinimumValue(CFBinaryHeapRef heap) {
-    void *val;
-    CFIndex idx, cidx;
-    CFIndex cnt;
-    CFAllocatorRef allocator;
+void CFBinaryHeapAddValue(CFBinaryHeapRef heap, const void *value) {
     __CFGenericValidateType(heap, CFBinaryHeapGetTypeID());
-    cnt = __CFBinaryHeapCount(heap);
-    if (0 == cnt) return;
-    idx = 0;
+    __CFBinaryHeapAddValue(heap, value);
+}
+
+// Takes the value in bucket idx out of the heap, releasing it, and refills the hole from the last bucket
+static void __CFBinaryHeapRemoveValueAtIndex(CFBinaryHeapRef heap, CFIndex idx) {
+    CFIndex cnt = __CFBinaryHeapCount(heap);
+    void *removed = heap->_buckets[idx]._item;
+    if (heap->_handles) __CFBinaryHeapFreeHandle(heap, heap->_handles[idx]);
+    __CFBinaryHeapNoteValueRemoved(heap, removed);
     __CFBinaryHeapSetNumBucketsUsed(heap, cnt - 1);
     __CFBinaryHeapSetCount(heap, cnt - 1);
-    CFComparisonResult (*compare)(const void *, const void *, void *) = heap->_callbacks.compare;
-    allocator = CFGetAllocator(heap);
-    if (heap->_callbacks.release)
-	heap->_callbacks.release(allocator, heap->_buckets[idx]._item);
-    val = heap->_buckets[cnt - 1]._item;
-    cidx = (idx << 1) + 1;
-    while (cidx < __CFBinaryHeapCount(heap)) {
-	void *item = heap->_buckets[cidx]._item;
-	if (cidx + 1 < __CFBinaryHeapCount(heap)) {
-	    void *item2 = heap->_buckets[cidx + 1]._item;
-	    if ((!compare && item > item2) || (compare && kCFCompareGreaterThan == compare(item, item2, heap->_context.info))) {
-		cidx++;
-		item = item2;
-	    }
-	}
-	if ((!compare && item > val) || (compare && kCFCompareGreaterThan == compare(item, val, heap->_context.info))) break;
-	__CFAssignWithWriteBarrier((void **)&heap->_buckets[idx]._item, item);
-	idx = cidx;
-	cidx = (idx << 1) + 1;
+    if (idx < cnt - 1) {
+        void *last = heap->_buckets[cnt - 1]._item;
+        CFIndex lastHandle = heap->_handles ? heap->_handles[cnt - 1] : 0;
+        // The last value may belong above or below the hole when the hole is not at the root
+        if (0 < idx && __CFBinaryHeapLess(heap, last, heap->_buckets[__CFBinaryHeapParent(idx)]._item)) {
+            __CFBinaryHeapSiftUp(heap, idx, last, lastHandle);
+        } else {
+            __CFBinaryHeapSiftDown(heap, idx, last, lastHandle);
+        }
     }
-    __CFAssignWithWriteBarrier((void **)&heap->_buckets[idx]._item, val);
+    if (heap->_callbacks.release) heap->_callbacks.release(CFGetAllocator(heap), removed);
+}
+
+void CFBinaryHeapRemoveMinimumValue(CFBinaryHeapRef heap) {
+    __CFGenericValidateType(heap, CFBinaryHeapGetTypeID());
+    if (0 == __CFBinaryHeapCount(heap)) return;
+    __CFBinaryHeapRemoveValueAtIndex(heap, 0);
 }
 
 void CFBinaryHeapRemoveAllValues(CFBinaryHeapRef heap) {
@@ -439,5 +556,70 @@ void CFBinaryHeapRemoveAllValues(CFBinaryHeapRef heap) {
 	    heap->_callbacks.release(CFGetAllocator(heap), heap->_buckets[idx]._item);
     __CFBinaryHeapSetNumBucketsUsed(heap, 0);
     __CFBinaryHeapSetCount(heap, 0);
+    heap->_freeHandle = -1;
+    heap->_handleLimit = 0;
+    if (heap->_valueCounts) CFDictionaryRemoveAllValues(heap->_valueCounts);
+}
+
+#pragma mark -
+#pragma mark Indexed Heaps
+
+CFBinaryHeapRef _CFBinaryHeapCreateIndexed(CFAllocatorRef allocator, CFIndex capacity, const CFBinaryHeapCallBacks *callBacks, const CFBinaryHeapCompareContext *compareContext) {
+    CFBinaryHeapRef heap = __CFBinaryHeapInit(allocator, kCFBinaryHeapMutable, capacity, NULL, 0, callBacks, compareContext);
+    if (NULL == heap) return NULL;
+    allocator = CFGetAllocator(heap);
+    heap->_handles = (CFIndex *)CFAllocatorAllocate(allocator, __CFBinaryHeapCapacity(heap) * sizeof(CFIndex), 0);
+    heap->_positions = (CFIndex *)CFAllocatorAllocate(allocator, __CFBinaryHeapCapacity(heap) * sizeof(CFIndex), 0);
+    heap->_valueCounts = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, NULL, NULL);
+    if (NULL == heap->_handles || NULL == heap->_positions || NULL == heap->_valueCounts) {
+        CFRelease(heap);
+        return NULL;
+    }
+    return heap;
+}
+
+CF_INLINE Boolean __CFBinaryHeapIsLiveHandle(CFBinaryHeapRef heap, CFIndex handle) {
+    return heap->_handles && 0 <= handle && handle < heap->_handleLimit && 0 <= heap->_positions[handle];
+}
+
+CFIndex _CFBinaryHeapAddValueReturningHandle(CFBinaryHeapRef heap, const void *value) {
+    __CFGenericValidateType(heap, CFBinaryHeapGetTypeID());
+    CFAssert1(NULL != heap->_handles, __kCFLogAssertion, "%s(): binary heap is not indexed", __PRETTY_FUNCTION__);
+    return __CFBinaryHeapAddValue(heap, value);
+}
+
+Boolean _CFBinaryHeapContainsHandle(CFBinaryHeapRef heap, CFIndex handle) {
+    __CFGenericValidateType(heap, CFBinaryHeapGetTypeID());
+    return __CFBinaryHeapIsLiveHandle(heap, handle);
+}
+
+const void *_CFBinaryHeapGetValueForHandle(CFBinaryHeapRef heap, CFIndex handle) {
+    __CFGenericValidateType(heap, CFBinaryHeapGetTypeID());
+    if (!__CFBinaryHeapIsLiveHandle(heap, handle)) return NULL;
+    return heap->_buckets[heap->_positions[handle]]._item;
+}
+
+void _CFBinaryHeapUpdateValueForHandle(CFBinaryHeapRef heap, CFIndex handle, const void *value) {
+    __CFGenericValidateType(heap, CFBinaryHeapGetTypeID());
+    if (!__CFBinaryHeapIsLiveHandle(heap, handle)) return;
+    CFAllocatorRef allocator = CFGetAllocator(heap);
+    CFIndex idx = heap->_positions[handle];
+    void *old = heap->_buckets[idx]._item;
+    void *item = heap->_callbacks.retain ? (void *)heap->_callbacks.retain(allocator, (void *)value) : (void *)value;
+    __CFBinaryHeapNoteValueRemoved(heap, old);
+    __CFBinaryHeapNoteValueAdded(heap, item);
+    // The same value may be passed back after its priority changed, so where it belongs is decided by its neighbours, not by comparing it with its old self
+    if (0 < idx && __CFBinaryHeapLess(heap, item, heap->_buckets[__CFBinaryHeapParent(idx)]._item)) {
+        __CFBinaryHeapSiftUp(heap, idx, item, handle);
+    } else {
+        __CFBinaryHeapSiftDown(heap, idx, item, handle);
+    }
+    if (heap->_callbacks.release) heap->_callbacks.release(allocator, old);
+}
+
+void _CFBinaryHeapRemoveValueForHandle(CFBinaryHeapRef heap, CFIndex handle) {
+    __CFGenericValidateType(heap, CFBinaryHeapGetTypeID());
+    if (!__CFBinaryHeapIsLiveHandle(heap, handle)) return;
+    __CFBinaryHeapRemoveValueAtIndex(heap, heap->_positions[handle]);
 }
 
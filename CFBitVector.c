@@ -27,6 +27,7 @@
 */
 
 #include <CoreFoundation/CFBitVector.h>
+#include <CoreFoundation/CFByteOrder.h>
 #include "CFInternal.h"
 #include <string.h>
 
@@ -61,8 +62,12 @@ struct __CFBitVector {
     CFIndex _count;	/* number of bits */
     CFIndex _capacity;	/* maximum number of bits */
     __CFBitVectorBucket *_buckets;
+    CFIndex * volatile _rankIndex;	/* immutable only; count of 1 bits before each __CF_RANK_BLOCK_BITS block, plus the total */
 };
 
+/* The rank index samples the count of 1 bits every __CF_RANK_BLOCK_BITS bits, costing about 1.6% of the vector's size; a count over any prefix then needs at most a block's worth of word popcounts. */
+#define __CF_RANK_BLOCK_BITS 512
+
 CF_INLINE UInt32 __CFBitVectorMutableVariety(const void *cf) {
     return __CFBitfieldGetValue(((const CFRuntimeBase *)cf)->_cfinfo[CF_INFO_BITS], 3, 2);
 }
@@ -134,6 +139,162 @@ CF_INLINE void __CFFlipBitVectorBit(__CFBitVectorBucket *buckets, CFIndex idx) {
     buckets[bucketIdx] ^= (1 << (__CF_BITS_PER_BUCKET - 1 - bitOfBucket));
 }
 
+/* Word kernels. Since bit 0 is the most significant bit of byte 0, eight consecutive buckets loaded big-endian form a 64-bit word whose most significant bit is the lowest numbered; counting and bitwise operations do not care about the byte order at all. */
+
+CF_INLINE CFIndex __CFBitVectorPopCount64(uint64_t w) {
+#if DEPLOYMENT_TARGET_WINDOWS
+    return popcountll(w);
+#else
+    return __builtin_popcountll(w);
+#endif
+}
+
+CF_INLINE CFIndex __CFBitVectorLeadingZeros64(uint64_t w) {	// w must be non-zero
+#if DEPLOYMENT_TARGET_WINDOWS
+    CFIndex n = 0;
+    while (!(w & 0x8000000000000000ULL)) w <<= 1, n++;
+    return n;
+#else
+    return __builtin_clzll(w);
+#endif
+}
+
+CF_INLINE CFIndex __CFBitVectorTrailingZeros64(uint64_t w) {	// w must be non-zero
+#if DEPLOYMENT_TARGET_WINDOWS
+    CFIndex n = 0;
+    while (!(w & 1)) w >>= 1, n++;
+    return n;
+#else
+    return __builtin_ctzll(w);
+#endif
+}
+
+CF_INLINE uint64_t __CFBitVectorLoadWord(const __CFBitVectorBucket *buckets) {
+    uint64_t w;
+    memmove(&w, buckets, sizeof(w));
+    return CFSwapInt64BigToHost(w);
+}
+
+// Mask of the bits of a byte from bit first through bit last, numbered from the left
+CF_INLINE uint8_t __CFBitVectorByteMask(CFIndex first, CFIndex last) {
+    return (uint8_t)((0xFF >> first) & (0xFF << (7 - last)));
+}
+
+static CFIndex __CFBitVectorCountOnesInBytes(const __CFBitVectorBucket *buckets, CFIndex cnt) {
+    CFIndex count = 0;
+    for (; 32 <= cnt; cnt -= 32, buckets += 32) {
+        uint64_t w[4];
+        memmove(w, buckets, sizeof(w));
+        count += __CFBitVectorPopCount64(w[0]) + __CFBitVectorPopCount64(w[1]) + __CFBitVectorPopCount64(w[2]) + __CFBitVectorPopCount64(w[3]);
+    }
+    for (; 8 <= cnt; cnt -= 8, buckets += 8) {
+        uint64_t w;
+        memmove(&w, buckets, sizeof(w));
+        count += __CFBitVectorPopCount64(w);
+    }
+    while (cnt--) count += __CFBitVectorPopCount64(*buckets++);
+    return count;
+}
+
+// Counts the 1 bits of [start, end); end must be greater than start
+static CFIndex __CFBitVectorCountOnes(const __CFBitVectorBucket *buckets, CFIndex start, CFIndex end) {
+    CFIndex firstByte = start / __CF_BITS_PER_BYTE, lastByte = (end - 1) / __CF_BITS_PER_BYTE;
+    CFIndex firstBit = start & __CF_BITS_PER_BYTE_MASK, lastBit = (end - 1) & __CF_BITS_PER_BYTE_MASK;
+    if (firstByte == lastByte) return __CFBitVectorPopCount64(buckets[firstByte] & __CFBitVectorByteMask(firstBit, lastBit));
+    CFIndex count = __CFBitVectorPopCount64(buckets[firstByte] & __CFBitVectorByteMask(firstBit, 7));
+    count += __CFBitVectorCountOnesInBytes(buckets + firstByte + 1, lastByte - firstByte - 1);
+    count += __CFBitVectorPopCount64(buckets[lastByte] & __CFBitVectorByteMask(0, lastBit));
+    return count;
+}
+
+enum {
+    __kCFBitVectorClearBits = 0,
+    __kCFBitVectorSetBits = 1,
+    __kCFBitVectorFlipBits = 2
+};
+
+CF_INLINE void __CFBitVectorApplyToByte(__CFBitVectorBucket *bucket, uint8_t mask, CFIndex op) {
+    switch (op) {
+    case __kCFBitVectorClearBits: *bucket &= ~mask; break;
+    case __kCFBitVectorSetBits: *bucket |= mask; break;
+    case __kCFBitVectorFlipBits: *bucket ^= mask; break;
+    }
+}
+
+// Clears, sets or flips the bits of [start, end); end must be greater than start
+static void __CFBitVectorApplyToBits(__CFBitVectorBucket *buckets, CFIndex start, CFIndex end, CFIndex op) {
+    CFIndex firstByte = start / __CF_BITS_PER_BYTE, lastByte = (end - 1) / __CF_BITS_PER_BYTE;
+    CFIndex firstBit = start & __CF_BITS_PER_BYTE_MASK, lastBit = (end - 1) & __CF_BITS_PER_BYTE_MASK;
+    if (firstByte == lastByte) {
+        __CFBitVectorApplyToByte(buckets + firstByte, __CFBitVectorByteMask(firstBit, lastBit), op);
+        return;
+    }
+    __CFBitVectorApplyToByte(buckets + firstByte, __CFBitVectorByteMask(firstBit, 7), op);
+    __CFBitVectorBucket *bytes = buckets + firstByte + 1;
+    CFIndex cnt = lastByte - firstByte - 1;
+    if (__kCFBitVectorFlipBits == op) {
+        for (; 8 <= cnt; cnt -= 8, bytes += 8) {
+            uint64_t w;
+            memmove(&w, bytes, sizeof(w));
+            w = ~w;
+            memmove(bytes, &w, sizeof(w));
+        }
+        while (cnt--) *bytes = ~*bytes, bytes++;
+    } else {
+        memset(bytes, (__kCFBitVectorSetBits == op) ? 0xFF : 0, cnt);
+    }
+    __CFBitVectorApplyToByte(buckets + lastByte, __CFBitVectorByteMask(0, lastBit), op);
+}
+
+// Returns the index of the first bit of [start, end) equal to value, or kCFNotFound; end must be greater than start
+static CFIndex __CFBitVectorFindFirst(const __CFBitVectorBucket *buckets, CFIndex start, CFIndex end, CFBit value) {
+    uint8_t invert = value ? 0 : 0xFF;
+    CFIndex byteIdx = start / __CF_BITS_PER_BYTE, lastByte = (end - 1) / __CF_BITS_PER_BYTE;
+    CFIndex lastBit = (end - 1) & __CF_BITS_PER_BYTE_MASK;
+    uint8_t v = (buckets[byteIdx] ^ invert) & __CFBitVectorByteMask(start & __CF_BITS_PER_BYTE_MASK, (byteIdx == lastByte) ? lastBit : 7);
+    if (v) return byteIdx * __CF_BITS_PER_BYTE + __CFBitVectorLeadingZeros64((uint64_t)v << 56);
+    byteIdx++;
+    uint64_t invertWord = value ? 0 : ~(uint64_t)0;
+    for (; byteIdx + 8 <= lastByte; byteIdx += 8) {
+        uint64_t w = __CFBitVectorLoadWord(buckets + byteIdx) ^ invertWord;
+        if (w) return byteIdx * __CF_BITS_PER_BYTE + __CFBitVectorLeadingZeros64(w);
+    }
+    for (; byteIdx <= lastByte; byteIdx++) {
+        v = (buckets[byteIdx] ^ invert) & ((byteIdx == lastByte) ? __CFBitVectorByteMask(0, lastBit) : 0xFF);
+        if (v) return byteIdx * __CF_BITS_PER_BYTE + __CFBitVectorLeadingZeros64((uint64_t)v << 56);
+    }
+    return kCFNotFound;
+}
+
+// Returns the index of the last bit of [start, end) equal to value, or kCFNotFound; end must be greater than start
+static CFIndex __CFBitVectorFindLast(const __CFBitVectorBucket *buckets, CFIndex start, CFIndex end, CFBit value) {
+    uint8_t invert = value ? 0 : 0xFF;
+    CFIndex firstByte = start / __CF_BITS_PER_BYTE, byteIdx = (end - 1) / __CF_BITS_PER_BYTE;
+    CFIndex firstBit = start & __CF_BITS_PER_BYTE_MASK;
+    uint8_t v = (buckets[byteIdx] ^ invert) & __CFBitVectorByteMask((byteIdx == firstByte) ? firstBit : 0, (end - 1) & __CF_BITS_PER_BYTE_MASK);
+    if (v) return byteIdx * __CF_BITS_PER_BYTE + 7 - __CFBitVectorTrailingZeros64(v);
+    uint64_t invertWord = value ? 0 : ~(uint64_t)0;
+    for (; firstByte + 8 < byteIdx; byteIdx -= 8) {
+        uint64_t w = __CFBitVectorLoadWord(buckets + byteIdx - 8) ^ invertWord;
+        if (w) return (byteIdx - 8) * __CF_BITS_PER_BYTE + 63 - __CFBitVectorTrailingZeros64(w);
+    }
+    while (firstByte < byteIdx) {
+        byteIdx--;
+        v = (buckets[byteIdx] ^ invert) & ((byteIdx == firstByte) ? __CFBitVectorByteMask(firstBit, 7) : 0xFF);
+        if (v) return byteIdx * __CF_BITS_PER_BYTE + 7 - __CFBitVectorTrailingZeros64(v);
+    }
+    return kCFNotFound;
+}
+
+// Number of 1 bits before idx, using the rank index
+CF_INLINE CFIndex __CFBitVectorRank(CFBitVectorRef bv, const CFIndex *rankIndex, CFIndex idx) {
+    CFIndex block = idx / __CF_RANK_BLOCK_BITS;
+    CFIndex blockStart = block * __CF_RANK_BLOCK_BITS;
+    CFIndex count = rankIndex[block];
+    if (blockStart < idx) count += __CFBitVectorCountOnes(bv->_buckets, blockStart, idx);
+    return count;
+}
+
 #if defined(DEBUG)
 CF_INLINE void __CFBitVectorValidateRange(CFBitVectorRef bv, CFRange range, const char *func) {
     CFAssert2(0 <= range.location && range.location < __CFBitVectorCount(bv), __kCFLogAssertion, "%s(): range.location index (%d) out of bounds", func, range.location);
@@ -205,6 +366,7 @@ static void __CFBitVectorDeallocate(CFTypeRef cf) {
     CFMutableBitVectorRef bv = (CFMutableBitVectorRef)cf;
     CFAllocatorRef allocator = CFGetAllocator(bv);
     if (bv->_buckets) _CFAllocatorDeallocateGC(allocator, bv->_buckets);
+    if (bv->_rankIndex) free(bv->_rankIndex);
 }
 
 static CFTypeID __kCFBitVectorTypeID = _kCFRuntimeNotATypeID;
@@ -246,6 +408,7 @@ static CFMutableBitVectorRef __CFBitVectorInit(CFAllocatorRef allocator, CFOptio
 	return NULL;
     }
     memset(memory->_buckets, 0, __CFBitVectorNumBuckets(memory) * sizeof(__CFBitVectorBucket));
+    memory->_rankIndex = NULL;
     __CFBitVectorSetNumBucketsUsed(memory, numBits / __CF_BITS_PER_BUCKET + 1);
     __CFBitVectorSetCount(memory, numBits);
     if (bytes) {
@@ -315,38 +478,25 @@ static void __CFBitVectorInternalMap(CFMutableBitVectorRef bv, CFRange range, __
     }
 }
 
-struct _occursContext {
-    CFBit value;
-    CFIndex count;
-};
-
-static __CFBitVectorBucket __CFBitVectorCountBits(__CFBitVectorBucket bucketValue, __CFBitVectorBucket bucketValueMask, struct _occursContext *context) {
-    static const __CFBitVectorBucket __CFNibbleBitCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
-    __CFBitVectorBucket val;
-    CFIndex idx;
-    val = (context->value) ? (bucketValue & bucketValueMask) : (~bucketValue & bucketValueMask);
-    for (idx = 0; idx < (CFIndex)sizeof(__CFBitVectorBucket) * 2; idx++) {
-	context->count += __CFNibbleBitCount[val & 0xF];
-	val = val >> 4;
-    }
-    return bucketValue;
-}
-
 CFIndex CFBitVectorGetCountOfBit(CFBitVectorRef bv, CFRange range, CFBit value) {
-    struct _occursContext context;
     __CFGenericValidateType(bv, CFBitVectorGetTypeID());
     __CFBitVectorValidateRange(bv, range, __PRETTY_FUNCTION__);
     if (0 == range.length) return 0;
-    context.value = value;
-    context.count = 0;
-    __CFBitVectorInternalMap((CFMutableBitVectorRef)bv, range, (__CFInternalMapper)__CFBitVectorCountBits, &context);
-    return context.count;
+    CFIndex ones;
+    const CFIndex *rankIndex = bv->_rankIndex;
+    if (rankIndex) {
+        ones = __CFBitVectorRank(bv, rankIndex, range.location + range.length) - __CFBitVectorRank(bv, rankIndex, range.location);
+    } else {
+        ones = __CFBitVectorCountOnes(bv->_buckets, range.location, range.location + range.length);
+    }
+    return value ? ones : range.length - ones;
 }
 
 Boolean CFBitVectorContainsBit(CFBitVectorRef bv, CFRange range, CFBit value) {
     __CFGenericValidateType(bv, CFBitVectorGetTypeID());
     __CFBitVectorValidateRange(bv, range, __PRETTY_FUNCTION__);
-    return (CFBitVectorGetCountOfBit(bv, range, value) != 0) ? true : false;
+    if (0 == range.length) return false;
+    return (__CFBitVectorFindFirst(bv->_buckets, range.location, range.location + range.length, value) != kCFNotFound) ? true : false;
 }
 
 CFBit CFBitVectorGetBitAtIndex(CFBitVectorRef bv, CFIndex idx) {
@@ -411,27 +561,17 @@ void CFBitVectorGetBits(CFBitVectorRef bv, CFRange range, uint8_t *bytes) {
 }
 
 CFIndex CFBitVectorGetFirstIndexOfBit(CFBitVectorRef bv, CFRange range, CFBit value) {
-    CFIndex idx;
     __CFGenericValidateType(bv, CFBitVectorGetTypeID());
     __CFBitVectorValidateRange(bv, range, __PRETTY_FUNCTION__);
-    for (idx = 0; idx < range.length; idx++) {
-	if (value == CFBitVectorGetBitAtIndex(bv, range.location + idx)) {
-	    return range.location + idx;
-	}
-    }
-    return kCFNotFound;
+    if (0 == range.length) return kCFNotFound;
+    return __CFBitVectorFindFirst(bv->_buckets, range.location, range.location + range.length, value);
 }
 
 CFIndex CFBitVectorGetLastIndexOfBit(CFBitVectorRef bv, CFRange range, CFBit value) {
-    CFIndex idx;
     __CFGenericValidateType(bv, CFBitVectorGetTypeID());
     __CFBitVectorValidateRange(bv, range, __PRETTY_FUNCTION__);
-    for (idx = range.length; idx--;) {
-	if (value == CFBitVectorGetBitAtIndex(bv, range.location + idx)) {
-	    return range.location + idx;
-	}
-    }
-    return kCFNotFound;
+    if (0 == range.length) return kCFNotFound;
+    return __CFBitVectorFindLast(bv->_buckets, range.location, range.location + range.length, value);
 }
 
 static void __CFBitVectorGrow(CFMutableBitVectorRef bv, CFIndex numNewValues) {
@@ -445,14 +585,6 @@ static void __CFBitVectorGrow(CFMutableBitVectorRef bv, CFIndex numNewValues) {
     if (NULL == bv->_buckets) HALT;
 }
 
-static __CFBitVectorBucket __CFBitVectorZeroBits(__CFBitVectorBucket bucketValue, __CFBitVectorBucket bucketValueMask, void *context) {
-    return 0;
-}
-
-static __CFBitVectorBucket __CFBitVectorOneBits(__CFBitVectorBucket bucketValue, __CFBitVectorBucket bucketValueMask, void *context) {
-    return ~(__CFBitVectorBucket)0;
-}
-
 void CFBitVectorSetCount(CFMutableBitVectorRef bv, CFIndex count) {
     CFIndex cnt;
     CFAssert1(__CFBitVectorMutableVariety(bv) == kCFBitVectorMutable, __kCFLogAssertion, "%s(): bit vector is immutable", __PRETTY_FUNCTION__);
@@ -465,8 +597,7 @@ void CFBitVectorSetCount(CFMutableBitVectorRef bv, CFIndex count) {
 	break;
     }
     if (cnt < count) {
-	CFRange range = CFRangeMake(cnt, count - cnt);
-        __CFBitVectorInternalMap(bv, range, __CFBitVectorZeroBits, NULL);
+        __CFBitVectorApplyToBits(bv->_buckets, cnt, count, __kCFBitVectorClearBits);
     }
     __CFBitVectorSetNumBucketsUsed(bv, count / __CF_BITS_PER_BUCKET + 1);
     __CFBitVectorSetCount(bv, count);
@@ -479,16 +610,12 @@ void CFBitVectorFlipBitAtIndex(CFMutableBitVectorRef bv, CFIndex idx) {
     __CFFlipBitVectorBit(bv->_buckets, idx);
 }
 
-static __CFBitVectorBucket __CFBitVectorFlipBits(__CFBitVectorBucket bucketValue, __CFBitVectorBucket bucketValueMask, void *context) {
-    return (~(__CFBitVectorBucket)0) ^ bucketValue;
-}
-
 void CFBitVectorFlipBits(CFMutableBitVectorRef bv, CFRange range) {
     __CFGenericValidateType(bv, CFBitVectorGetTypeID());
     __CFBitVectorValidateRange(bv, range, __PRETTY_FUNCTION__);
     CFAssert1(__CFBitVectorMutableVariety(bv) == kCFBitVectorMutable, __kCFLogAssertion, "%s(): bit vector is immutable", __PRETTY_FUNCTION__);
     if (0 == range.length) return;
-    __CFBitVectorInternalMap(bv, range, __CFBitVectorFlipBits, NULL);
+    __CFBitVectorApplyToBits(bv->_buckets, range.location, range.location + range.length, __kCFBitVectorFlipBits);
 }
 
 void CFBitVectorSetBitAtIndex(CFMutableBitVectorRef bv, CFIndex idx, CFBit value) {
@@ -503,11 +630,7 @@ void CFBitVectorSetBits(CFMutableBitVectorRef bv, CFRange range, CFBit value) {
     __CFBitVectorValidateRange(bv, range, __PRETTY_FUNCTION__);
     CFAssert1(__CFBitVectorMutableVariety(bv) == kCFBitVectorMutable , __kCFLogAssertion, "%s(): bit vector is immutable", __PRETTY_FUNCTION__);
     if (0 == range.length) return;
-    if (value) {
-	__CFBitVectorInternalMap(bv, range, __CFBitVectorOneBits, NULL);
-    } else {
-	__CFBitVectorInternalMap(bv, range, __CFBitVectorZeroBits, NULL);
-    }
+    __CFBitVectorApplyToBits(bv->_buckets, range.location, range.location + range.length, value ? __kCFBitVectorSetBits : __kCFBitVectorClearBits);
 }
 
 void CFBitVectorSetAllBits(CFMutableBitVectorRef bv, CFBit value) {
@@ -517,15 +640,68 @@ void CFBitVectorSetAllBits(CFMutableBitVectorRef bv, CFBit value) {
     nBuckets = __CFBitVectorCount(bv) / __CF_BITS_PER_BUCKET;
     leftover = __CFBitVectorCount(bv) - nBuckets * __CF_BITS_PER_BUCKET;
     if (0 < leftover) {
-	CFRange range = CFRangeMake(nBuckets * __CF_BITS_PER_BUCKET, leftover);
-	if (value) {
-	    __CFBitVectorInternalMap(bv, range, __CFBitVectorOneBits, NULL);
-	} else {
-	    __CFBitVectorInternalMap(bv, range, __CFBitVectorZeroBits, NULL);
-	}
+        __CFBitVectorApplyToBits(bv->_buckets, nBuckets * __CF_BITS_PER_BUCKET, __CFBitVectorCount(bv), value ? __kCFBitVectorSetBits : __kCFBitVectorClearBits);
     }
     memset(bv->_buckets, (value ? ~0 : 0), nBuckets);
 }
 
+void _CFBitVectorBuildRankIndex(CFBitVectorRef bv) {
+    __CFGenericValidateType(bv, CFBitVectorGetTypeID());
+    // Only an immutable vector can keep an index, since nothing invalidates it
+    if (__CFBitVectorMutableVariety(bv) != kCFBitVectorImmutable || bv->_rankIndex) return;
+    CFIndex count = __CFBitVectorCount(bv);
+    CFIndex blocks = count / __CF_RANK_BLOCK_BITS + 1;
+    CFIndex *rankIndex = (CFIndex *)malloc((blocks + 1) * sizeof(CFIndex));
+    if (!rankIndex) return;
+    CFIndex ones = 0;
+    for (CFIndex block = 0; block < blocks; block++) {
+        rankIndex[block] = ones;
+        CFIndex start = block * __CF_RANK_BLOCK_BITS, end = __CFMin(start + __CF_RANK_BLOCK_BITS, count);
+        if (start < end) ones += __CFBitVectorCountOnes(bv->_buckets, start, end);
+    }
+    rankIndex[blocks] = ones;
+    if (!OSAtomicCompareAndSwapPtrBarrier(NULL, rankIndex, (void * volatile *)&((struct __CFBitVector *)bv)->_rankIndex)) {
+        free(rankIndex);
+    }
+}
+
+CFIndex _CFBitVectorGetIndexOfNthBit(CFBitVectorRef bv, CFIndex n, CFBit value) {
+    __CFGenericValidateType(bv, CFBitVectorGetTypeID());
+    CFIndex count = __CFBitVectorCount(bv);
+    if (n < 0 || count <= n) return kCFNotFound;
+    CFIndex blockStart = 0, remaining = n;
+    const CFIndex *rankIndex = bv->_rankIndex;
+    if (rankIndex) {
+        // Binary search for the last block starting before the nth matching bit
+        CFIndex blocks = count / __CF_RANK_BLOCK_BITS + 1;
+        CFIndex total = value ? rankIndex[blocks] : count - rankIndex[blocks];
+        if (total <= n) return kCFNotFound;
+        CFIndex lo = 0, hi = blocks - 1;
+        while (lo < hi) {
+            CFIndex mid = lo + (hi - lo + 1) / 2;
+            CFIndex before = value ? rankIndex[mid] : mid * __CF_RANK_BLOCK_BITS - rankIndex[mid];
+            if (before <= n) lo = mid; else hi = mid - 1;
+        }
+        blockStart = lo * __CF_RANK_BLOCK_BITS;
+        remaining = n - (value ? rankIndex[lo] : blockStart - rankIndex[lo]);
+    }
+    // Skip whole words, then find the bit within the word holding it
+    CFIndex idx = blockStart;
+    uint64_t invertWord = value ? 0 : ~(uint64_t)0;
+    for (; idx + 64 <= count; idx += 64) {
+        uint64_t w = __CFBitVectorLoadWord(bv->_buckets + idx / __CF_BITS_PER_BYTE) ^ invertWord;
+        CFIndex matches = __CFBitVectorPopCount64(w);
+        if (remaining < matches) {
+            while (remaining--) w &= ~(0x8000000000000000ULL >> __CFBitVectorLeadingZeros64(w));
+            return idx + __CFBitVectorLeadingZeros64(w);
+        }
+        remaining -= matches;
+    }
+    for (; idx < count; idx++) {
+        if (__CFBitVectorBit(bv->_buckets, idx) == value && 0 == remaining--) return idx;
+    }
+    return kCFNotFound;
+}
+
 #undef __CFBitVectorValidateRange
 
@@ -42,6 +42,7 @@ struct __CFCalendar {
     CFStringRef _localeID;
     CFTimeZoneRef _tz;
     UCalendar *_cal;
+    Boolean _customGregorianStart;	// _cal has a non-default Julian to Gregorian cutover
 };
 
 static Boolean __CFCalendarEqual(CFTypeRef cf1, CFTypeRef cf2) {
@@ -90,6 +91,13 @@ CFTypeID CFCalendarGetTypeID(void) {
 }
 
 CF_PRIVATE UCalendar *__CFCalendarCreateUCalendar(CFStringRef calendarID, CFStringRef localeID, CFTimeZoneRef tz) {
+    // Calendars for the same calendar, locale and zone are cloned from a cached prototype rather than opened
+    char key[BUFFER_SIZE], calbuffer[BUFFER_SIZE], locbuffer[BUFFER_SIZE], tzbuffer[BUFFER_SIZE];
+    CFStringRef tznam = CFTimeZoneGetName(tz);
+    Boolean cacheable = (!calendarID || CFStringGetCString(calendarID, calbuffer, BUFFER_SIZE, kCFStringEncodingASCII)) && CFStringGetCString(localeID, locbuffer, BUFFER_SIZE, kCFStringEncodingASCII) && CFStringGetCString(tznam, tzbuffer, BUFFER_SIZE, kCFStringEncodingASCII) && snprintf(key, BUFFER_SIZE, "%s|%s|%s", calendarID ? calbuffer : "", locbuffer, tzbuffer) < BUFFER_SIZE;
+    UCalendar *cal = cacheable ? (UCalendar *)__CFLocaleCopyCachedICUObject(__kCFICUCalendar, key) : NULL;
+    if (cal) return cal;
+
     if (calendarID) {
 	CFDictionaryRef components = CFLocaleCreateComponentsFromLocaleIdentifier(kCFAllocatorSystemDefault, localeID);
 	CFMutableDictionaryRef mcomponents = CFDictionaryCreateMutableCopy(kCFAllocatorSystemDefault, 0, components);
@@ -110,13 +118,13 @@ CF_PRIVATE UCalendar *__CFCalendarCreateUCalendar(CFStringRef calendarID, CFStri
     }
     
     UChar ubuffer[BUFFER_SIZE];
-    CFStringRef tznam = CFTimeZoneGetName(tz);
     CFIndex cnt = CFStringGetLength(tznam);
     if (BUFFER_SIZE < cnt) cnt = BUFFER_SIZE;
     CFStringGetCharacters(tznam, CFRangeMake(0, cnt), (UniChar *)ubuffer);
 
     UErrorCode status = U_ZERO_ERROR;
-    UCalendar *cal = ucal_open(ubuffer, cnt, cstr, UCAL_DEFAULT, &status);
+    cal = ucal_open(ubuffer, cnt, cstr, UCAL_DEFAULT, &status);
+    if (cal && cacheable) __CFLocaleCacheICUObject(__kCFICUCalendar, key, cal);
     if (calendarID) CFRelease(localeID);
     return cal;
 }
@@ -128,6 +136,7 @@ static void __CFCalendarSetupCal(CFCalendarRef calendar) {
 static void __CFCalendarZapCal(CFCalendarRef calendar) {
     ucal_close(calendar->_cal);
     calendar->_cal = NULL;
+    ((struct __CFCalendar *)calendar)->_customGregorianStart = false;
 }
 
 CFCalendarRef CFCalendarCopyCurrent(void) {
@@ -169,6 +178,7 @@ CFCalendarRef CFCalendarCreateWithIdentifier(CFAllocatorRef allocator, CFStringR
     calendar->_localeID = CFLocaleGetIdentifier(CFLocaleGetSystem());
     calendar->_tz = CFTimeZoneCopyDefault();
     calendar->_cal = NULL;
+    calendar->_customGregorianStart = false;
     return (CFCalendarRef)calendar;
 }
 
@@ -273,6 +283,7 @@ void CFCalendarSetGregorianStartDate(CFCalendarRef calendar, CFDateRef date) {
 	if (cal && U_SUCCESS(status)) {
 	    status = U_ZERO_ERROR;
 	    if (calendar->_cal) ucal_setGregorianChange(calendar->_cal, udate, &status);
+	    if (U_SUCCESS(status)) ((struct __CFCalendar *)calendar)->_customGregorianStart = false;
 	}
 	if (cal) ucal_close(cal);
     } else {
@@ -280,6 +291,7 @@ void CFCalendarSetGregorianStartDate(CFCalendarRef calendar, CFDateRef date) {
 	UDate udate = (at + kCFAbsoluteTimeIntervalSince1970) * 1000.0;
 	UErrorCode status = U_ZERO_ERROR;
 	if (calendar->_cal) ucal_setGregorianChange(calendar->_cal, udate, &status);
+	((struct __CFCalendar *)calendar)->_customGregorianStart = true;
     }
 }
 
@@ -723,7 +735,109 @@ CFIndex CFCalendarGetOrdinalityOfUnit(CFCalendarRef calendar, CFCalendarUnit sma
     return result;
 }
 
+/* Pure arithmetic compose and decompose for the Gregorian calendar.  Results match ICU's
+   lenient GregorianCalendar with its default wall time options, provided the dates fall
+   after the default Julian cutover and the cutover was not moved; week-based fields and
+   fields whose resolution depends on which was set last are left to ICU.  The offset from
+   GMT comes from the CFTimeZone itself, so fixed-offset and TZif-backed zones both work.
+   CFTimeZone keeps no periods from before 1932, though, and ICU's own zone data goes back
+   further, so earlier times in zones that have transitions are left to ICU as well.
+   These return false when the request must go through ICU instead.
+*/
+#define __kCFCalendarFastMinYear 1583
+#define __kCFCalendarFastMaxYear 1000000
+#define __kCFCalendarMillisecondsPerDay 86400000LL
+#define __kCFCalendarDaysFrom1970To2001 11323LL
+#define __kCFCalendarJulianDayOf1970 2440588LL
+
+CF_INLINE Boolean __CFCalendarCanUseGregorianFastPath(CFCalendarRef calendar) {
+    return (kCFGregorianCalendar == calendar->_identifier) && !calendar->_customGregorianStart;
+}
+
+CF_INLINE int64_t __CFCalendarGetOffsetMilliseconds(CFTimeZoneRef tz, CFAbsoluteTime at) {
+    return (int64_t)(CFTimeZoneGetSecondsFromGMT(tz, at) * 1000.0);
+}
+
+static Boolean __CFCalendarComposeGregorianFast(CFCalendarRef calendar, CFAbsoluteTime *atp, const char *componentDesc, const int *vector) {
+    int64_t year = 1, month = 1, day = 1, hour = 0, minute = 0, second = 0, msec = 0;
+    for (const char *desc = componentDesc; *desc; desc++, vector++) {
+	int value = *vector;
+	switch (*desc) {
+	case 'G': if (1 != value) return false; break;	// BC dates predate the cutover
+	case 'y': year = value; break;
+	case 'M': month = value; break;
+	case 'd': day = value; break;
+	case 'H': hour = value; break;
+	case 'm': minute = value; break;
+	case 's': second = value; break;
+	case 'S': msec = value; break;
+	default: return false;
+	}
+    }
+    int64_t monthCarry = (0 < month) ? (month - 1) / 12 : (month - 12) / 12;
+    if (year + monthCarry < __kCFCalendarFastMinYear || __kCFCalendarFastMaxYear < year + monthCarry) return false;
+    int64_t days = __CFDaysFromGregorianYMD(year, month, day) + __kCFCalendarDaysFrom1970To2001;
+    int64_t local = days * __kCFCalendarMillisecondsPerDay + ((hour * 60 + minute) * 60 + second) * 1000 + msec;
+    if (local < (__CFDaysFromGregorianYMD(__kCFCalendarFastMinYear, 1, 1) + __kCFCalendarDaysFrom1970To2001) * __kCFCalendarMillisecondsPerDay) return false;
+
+    // Resolve the wall time like ICU's UCAL_WALLTIME_LAST: a repeated wall time takes the
+    // later instant, and a skipped one is read with the offset in effect before the gap.
+    CFTimeZoneRef tz = calendar->_tz;
+    CFAbsoluteTime wall = (double)local / 1000.0 - kCFAbsoluteTimeIntervalSince1970;
+    if (wall - 2 * 86400.0 < __CFTimeZoneGetDataStart(tz)) return false;
+    int64_t offsetBefore = __CFCalendarGetOffsetMilliseconds(tz, wall - 86400.0);
+    int64_t offsetAfter = __CFCalendarGetOffsetMilliseconds(tz, wall + 86400.0);
+    int64_t offset = offsetBefore;
+    if (offsetBefore != offsetAfter) {
+	if (__CFCalendarGetOffsetMilliseconds(tz, (double)(local - offsetAfter) / 1000.0 - kCFAbsoluteTimeIntervalSince1970) == offsetAfter) offset = offsetAfter;
+    } else if (__CFCalendarGetOffsetMilliseconds(tz, (double)(local - offset) / 1000.0 - kCFAbsoluteTimeIntervalSince1970) != offset) {
+	return false;	// transitions closer than a day apart
+    }
+    UDate udate = (double)(local - offset);
+    if (atp) *atp = (udate / 1000.0) - kCFAbsoluteTimeIntervalSince1970;
+    return true;
+}
+
+static Boolean __CFCalendarDecomposeGregorianFast(CFCalendarRef calendar, CFAbsoluteTime at, const char *componentDesc, int **vector) {
+    for (const char *desc = componentDesc; *desc; desc++) {
+	if (!strchr("GyMdHhamsSEDg", *desc)) return false;
+    }
+    UDate udate = floor((at + kCFAbsoluteTimeIntervalSince1970) * 1000.0);
+    if (!(-1.0E17 < udate && udate < 1.0E17)) return false;	// also rejects NaN
+    CFAbsoluteTime instant = udate / 1000.0 - kCFAbsoluteTimeIntervalSince1970;
+    if (instant < __CFTimeZoneGetDataStart(calendar->_tz)) return false;
+    int64_t local = (int64_t)udate + __CFCalendarGetOffsetMilliseconds(calendar->_tz, instant);
+    int64_t days = ((0 <= local) ? local : local - (__kCFCalendarMillisecondsPerDay - 1)) / __kCFCalendarMillisecondsPerDay;
+    int64_t msInDay = local - days * __kCFCalendarMillisecondsPerDay;
+    int64_t year;
+    int8_t month, day;
+    __CFGregorianYMDFromDays(days - __kCFCalendarDaysFrom1970To2001, &year, &month, &day);
+    if (year < __kCFCalendarFastMinYear || __kCFCalendarFastMaxYear < year) return false;
+    int hour = (int)(msInDay / 3600000);
+    for (const char *desc = componentDesc; *desc; desc++, vector++) {
+	int value = 0;
+	switch (*desc) {
+	case 'G': value = 1; break;
+	case 'y': value = (int)year; break;
+	case 'M': value = month; break;
+	case 'd': value = day; break;
+	case 'H': value = hour; break;
+	case 'h': value = hour % 12; break;
+	case 'a': value = hour / 12; break;
+	case 'm': value = (int)(msInDay / 60000 % 60); break;
+	case 's': value = (int)(msInDay / 1000 % 60); break;
+	case 'S': value = (int)(msInDay % 1000); break;
+	case 'E': value = (int)((days % 7 + 7 + 4) % 7) + 1; break;	// 1970/1/1 was a Thursday; Sunday is 1
+	case 'D': value = (int)(days - __kCFCalendarDaysFrom1970To2001 - __CFDaysFromGregorianYMD(year, 1, 1)) + 1; break;
+	case 'g': value = (int)(days + __kCFCalendarJulianDayOf1970); break;
+	}
+	*(*vector) = value;
+    }
+    return true;
+}
+
 Boolean _CFCalendarComposeAbsoluteTimeV(CFCalendarRef calendar, /* out */ CFAbsoluteTime *atp, const char *componentDesc, int *vector, int count) {
+    if (__CFCalendarCanUseGregorianFastPath(calendar) && __CFCalendarComposeGregorianFast(calendar, atp, componentDesc, vector)) return true;
     if (!calendar->_cal) __CFCalendarSetupCal(calendar);
     if (calendar->_cal) {
 	UErrorCode status = U_ZERO_ERROR;
@@ -766,6 +880,7 @@ Boolean _CFCalendarComposeAbsoluteTimeV(CFCalendarRef calendar, /* out */ CFAbso
 }
 
 Boolean _CFCalendarDecomposeAbsoluteTimeV(CFCalendarRef calendar, CFAbsoluteTime at, const char *componentDesc, int **vector, int count) {
+    if (__CFCalendarCanUseGregorianFastPath(calendar) && __CFCalendarDecomposeGregorianFast(calendar, at, componentDesc, vector)) return true;
     if (!calendar->_cal) __CFCalendarSetupCal(calendar);
     if (calendar->_cal) {
 	UErrorCode status = U_ZERO_ERROR;
@@ -894,6 +1009,151 @@ Boolean CFCalendarDecomposeAbsoluteTime(CFCalendarRef calendar, CFAbsoluteTime a
     return _CFCalendarDecomposeAbsoluteTimeV(calendar, at, componentDesc, vector, cnt);
 }
 
+/* Batched decomposition.  The Gregorian path works through the times in chunks, each in a few
+   loops over plain arrays with 32-bit lanes, constant divisors and selects in place of
+   branches, so the compiler can vectorize them.  Each time gives the same result as
+   __CFCalendarDecomposeGregorianFast(); times outside its years go through
+   _CFCalendarDecomposeAbsoluteTimeV() one at a time.
+*/
+#define __kCFCalendarBatchChunk 256
+#define __kCFCalendarBatchFastUnits (kCFCalendarUnitEra | kCFCalendarUnitYear | kCFCalendarUnitQuarter | kCFCalendarUnitMonth | kCFCalendarUnitDay | kCFCalendarUnitHour | kCFCalendarUnitMinute | kCFCalendarUnitSecond | kCFCalendarUnitWeekday | kCFCalendarUnitWeekdayOrdinal)
+#define __kCFCalendarDaysFrom0000_03_01To1970 719468
+
+static Boolean __CFCalendarDecomposeOne(CFCalendarRef calendar, CFAbsoluteTime at, CFCalendarUnit units, const _CFCalendarComponentArrays *arrays, CFIndex idx) {
+    char desc[16];
+    int *vector[16];
+    int cnt = 0, month = 0;
+    if (units & kCFCalendarUnitEra) { desc[cnt] = 'G'; vector[cnt++] = arrays->era + idx; }
+    if (units & kCFCalendarUnitYear) { desc[cnt] = 'y'; vector[cnt++] = arrays->year + idx; }
+    if (units & (kCFCalendarUnitMonth | kCFCalendarUnitQuarter)) { desc[cnt] = 'M'; vector[cnt++] = &month; }
+    if (units & kCFCalendarUnitDay) { desc[cnt] = 'd'; vector[cnt++] = arrays->day + idx; }
+    if (units & kCFCalendarUnitHour) { desc[cnt] = 'H'; vector[cnt++] = arrays->hour + idx; }
+    if (units & kCFCalendarUnitMinute) { desc[cnt] = 'm'; vector[cnt++] = arrays->minute + idx; }
+    if (units & kCFCalendarUnitSecond) { desc[cnt] = 's'; vector[cnt++] = arrays->second + idx; }
+    if (units & kCFCalendarUnitWeekday) { desc[cnt] = 'E'; vector[cnt++] = arrays->weekday + idx; }
+    if (units & kCFCalendarUnitWeekdayOrdinal) { desc[cnt] = 'F'; vector[cnt++] = arrays->weekdayOrdinal + idx; }
+    if (units & kCFCalendarUnitWeekOfMonth) { desc[cnt] = 'W'; vector[cnt++] = arrays->weekOfMonth + idx; }
+    if (units & kCFCalendarUnitWeekOfYear) { desc[cnt] = 'w'; vector[cnt++] = arrays->weekOfYear + idx; }
+    if (units & kCFCalendarUnitYearForWeekOfYear) { desc[cnt] = 'Y'; vector[cnt++] = arrays->yearForWeekOfYear + idx; }
+    desc[cnt] = '\0';
+    if (0 == cnt) return true;
+    Boolean result = _CFCalendarDecomposeAbsoluteTimeV(calendar, at, desc, vector, cnt);
+    if (units & kCFCalendarUnitMonth) arrays->month[idx] = month;
+    if (units & kCFCalendarUnitQuarter) arrays->quarter[idx] = (month + 2) / 3;
+    return result;
+}
+
+static void __CFCalendarDecomposeGregorianChunk(CFCalendarRef calendar, const CFAbsoluteTime *times, CFIndex count, CFCalendarUnit units, const _CFCalendarComponentArrays *arrays, CFIndex base, Boolean isFixed, int32_t fixedOffset, CFAbsoluteTime dataStart, uint8_t *bad) {
+    int32_t offsets[__kCFCalendarBatchChunk], days[__kCFCalendarBatchChunk], msInDay[__kCFCalendarBatchChunk];
+    int32_t years[__kCFCalendarBatchChunk], months[__kCFCalendarBatchChunk], mdays[__kCFCalendarBatchChunk];
+    // local milliseconds from 1970 this path handles: the fast path's first year, up to where
+    // doubles stop holding whole milliseconds exactly (about the year 287000)
+    const double minLocal = (double)((__CFDaysFromGregorianYMD(__kCFCalendarFastMinYear, 1, 1) + __kCFCalendarDaysFrom1970To2001) * __kCFCalendarMillisecondsPerDay);
+    const double maxLocal = 9007199254740992.0;
+    CFIndex idx;
+
+    if (isFixed) {
+	for (idx = 0; idx < count; idx++) offsets[idx] = fixedOffset * 1000;
+    } else {
+	for (idx = 0; idx < count; idx++) {
+	    UDate udate = floor((times[idx] + kCFAbsoluteTimeIntervalSince1970) * 1000.0);
+	    offsets[idx] = (int32_t)__CFCalendarGetOffsetMilliseconds(calendar->_tz, udate / 1000.0 - kCFAbsoluteTimeIntervalSince1970);
+	}
+    }
+    for (idx = 0; idx < count; idx++) {
+	double local = floor((times[idx] + kCFAbsoluteTimeIntervalSince1970) * 1000.0) + offsets[idx];
+	uint8_t outside = !((minLocal <= local) & (local < maxLocal)) | (times[idx] < dataStart);	// also catches NaN
+	local = outside ? minLocal : local;
+	double day = floor(local / 86400000.0);
+	double rem = local - day * 86400000.0;
+	// far from 1970 the quotient can round onto the neighbouring day
+	day = day - (double)(rem < 0.0) + (double)(86400000.0 <= rem);
+	days[idx] = (int32_t)day;
+	msInDay[idx] = (int32_t)(local - day * 86400000.0);
+	bad[idx] = outside;
+    }
+    // civil from days, as in __CFGregorianYMDFromDays(), counting from 0000/3/1 so it is unsigned
+    for (idx = 0; idx < count; idx++) {
+	uint32_t z = (uint32_t)(days[idx] + __kCFCalendarDaysFrom0000_03_01To1970);
+	uint32_t era = z / 146097;
+	uint32_t doe = z - era * 146097;
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint32_t mp = (5 * doy + 2) / 153;
+	uint32_t m = (mp < 10) ? mp + 3 : mp - 9;
+	years[idx] = (int32_t)(yoe + era * 400 + (m <= 2));
+	months[idx] = (int32_t)m;
+	mdays[idx] = (int32_t)(doy - (153 * mp + 2) / 5 + 1);
+    }
+    if (units & kCFCalendarUnitEra) {
+	int *out = arrays->era + base;
+	for (idx = 0; idx < count; idx++) out[idx] = 1;
+    }
+    if (units & kCFCalendarUnitYear) {
+	int *out = arrays->year + base;
+	for (idx = 0; idx < count; idx++) out[idx] = years[idx];
+    }
+    if (units & kCFCalendarUnitQuarter) {
+	int *out = arrays->quarter + base;
+	for (idx = 0; idx < count; idx++) out[idx] = (months[idx] + 2) / 3;
+    }
+    if (units & kCFCalendarUnitMonth) {
+	int *out = arrays->month + base;
+	for (idx = 0; idx < count; idx++) out[idx] = months[idx];
+    }
+    if (units & kCFCalendarUnitDay) {
+	int *out = arrays->day + base;
+	for (idx = 0; idx < count; idx++) out[idx] = mdays[idx];
+    }
+    if (units & kCFCalendarUnitHour) {
+	int *out = arrays->hour + base;
+	for (idx = 0; idx < count; idx++) out[idx] = (int)((uint32_t)msInDay[idx] / 3600000);
+    }
+    if (units & kCFCalendarUnitMinute) {
+	int *out = arrays->minute + base;
+	for (idx = 0; idx < count; idx++) out[idx] = (int)((uint32_t)msInDay[idx] / 60000 % 60);
+    }
+    if (units & kCFCalendarUnitSecond) {
+	int *out = arrays->second + base;
+	for (idx = 0; idx < count; idx++) out[idx] = (int)((uint32_t)msInDay[idx] / 1000 % 60);
+    }
+    if (units & kCFCalendarUnitWeekday) {
+	int *out = arrays->weekday + base;
+	// 0000/3/1 was a Wednesday; Sunday is 1
+	for (idx = 0; idx < count; idx++) out[idx] = (int)(((uint32_t)(days[idx] + __kCFCalendarDaysFrom0000_03_01To1970) + 3) % 7) + 1;
+    }
+    if (units & kCFCalendarUnitWeekdayOrdinal) {
+	int *out = arrays->weekdayOrdinal + base;
+	for (idx = 0; idx < count; idx++) out[idx] = (mdays[idx] - 1) / 7 + 1;
+    }
+}
+
+Boolean _CFCalendarDecomposeAbsoluteTimes(CFCalendarRef calendar, const CFAbsoluteTime *times, CFIndex count, CFCalendarUnit units, const _CFCalendarComponentArrays *arrays) {
+    __CFGenericValidateType(calendar, CFCalendarGetTypeID());
+    CFAssert1(0 <= count, __kCFLogAssertion, "%s(): count cannot be negative", __PRETTY_FUNCTION__);
+    Boolean result = true;
+    CFIndex idx, base;
+    if (__CFCalendarCanUseGregorianFastPath(calendar) && 0 == (units & ~__kCFCalendarBatchFastUnits)) {
+	uint8_t bad[__kCFCalendarBatchChunk];
+	int32_t fixedOffset = 0;
+	Boolean isFixed = __CFTimeZoneGetFixedOffset(calendar->_tz, &fixedOffset);
+	// as in the single time fast path, ICU has the offsets from before the zone's own data
+	CFAbsoluteTime dataStart = __CFTimeZoneGetDataStart(calendar->_tz);
+	for (base = 0; base < count; base += __kCFCalendarBatchChunk) {
+	    CFIndex cnt = (count - base < __kCFCalendarBatchChunk) ? count - base : __kCFCalendarBatchChunk;
+	    __CFCalendarDecomposeGregorianChunk(calendar, times + base, cnt, units, arrays, base, isFixed, fixedOffset, dataStart, bad);
+	    for (idx = 0; idx < cnt; idx++) {
+		if (bad[idx] && !__CFCalendarDecomposeOne(calendar, times[base + idx], units, arrays, base + idx)) result = false;
+	    }
+	}
+	return result;
+    }
+    for (idx = 0; idx < count; idx++) {
+	if (!__CFCalendarDecomposeOne(calendar, times[idx], units, arrays, idx)) result = false;
+    }
+    return result;
+}
+
 Boolean CFCalendarAddComponents(CFCalendarRef calendar, /* inout */ CFAbsoluteTime *atp, CFOptionFlags options, const char *componentDesc, ...) {
     va_list args;
     va_start(args, componentDesc);
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2015 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*	CFCompiledFormatter.c
+	Copyright (c) 2015, Apple Inc. All rights reserved.
+*/
+
+/*
+ A compiled formatter owns a private clone of its source formatter's ICU
+ formatter, which is never used to format; it is only cloned again, which ICU
+ allows from several threads at once.  The per-thread clones live in a small
+ table in the __CFTSDKeyCompiledFormatters slot, keyed by a serial number
+ rather than by the compiled formatter's address, so that a slot left behind
+ by a deallocated compiled formatter can never be mistaken for that of a new
+ one at the same address; such slots are reused round-robin and freed when
+ the thread exits.
+ */
+
+#include <CoreFoundation/CFCompiledFormatter.h>
+#include "CFInternal.h"
+#include "CFICULogging.h"
+
+#define BUFFER_SIZE 768
+
+CF_PRIVATE CFIndex __CFDateFormatterFormatAbsoluteTime(UDateFormat *df, Boolean insertRTLMarker, CFAbsoluteTime at, UniChar *buffer, CFIndex capacity);
+CF_PRIVATE UDateFormat *__CFDateFormatterCopyUDateFormat(CFDateFormatterRef formatter, Boolean *insertRTLMarker);
+CF_PRIVATE CFIndex __CFNumberFormatterFormatValue(UNumberFormat *nf, double multiplier, CFStringRef zeroSym, Boolean insertRTLMarker, CFNumberType numberType, const void *valuePtr, UniChar *chars, CFIndex capacity, Boolean *usedZeroSym);
+CF_PRIVATE UNumberFormat *__CFNumberFormatterCopyUNumberFormat(CFNumberFormatterRef formatter, double *multiplierp, CFStringRef *zeroSymp, Boolean *insertRTLMarker);
+
+struct __CFCompiledFormatter {
+    CFRuntimeBase _base;
+    int64_t _serial;		// names this formatter's per-thread clones; never 0
+    Boolean _isDateFormatter;
+    Boolean _insertRTLMarker;
+    void *_icuFormatter;	// UDateFormat or UNumberFormat, only ever cloned
+    double _multiplier;		// number formatters only
+    CFStringRef _zeroSym;	// number formatters only
+};
+
+enum {
+    __kCFCompiledFormatterThreadSlots = 8
+};
+
+typedef struct {
+    int64_t _serial;		// 0 for an empty slot
+    Boolean _isDateFormatter;
+    void *_icuFormatter;
+} __CFCompiledFormatterThreadSlot;
+
+typedef struct {
+    uint8_t _nextSlot;
+    __CFCompiledFormatterThreadSlot _slots[__kCFCompiledFormatterThreadSlots];
+} __CFCompiledFormatterThreadData;
+
+static volatile int64_t __CFCompiledFormatterLastSerial = 0;
+
+static void __CFCompiledFormatterCloseICUFormatter(Boolean isDateFormatter, void *icuFormatter) {
+    if (!icuFormatter) return;
+    if (isDateFormatter) {
+	__cficu_udat_close((UDateFormat *)icuFormatter);
+    } else {
+	__cficu_unum_close((UNumberFormat *)icuFormatter);
+    }
+}
+
+static void __CFCompiledFormatterThreadDataDestructor(void *context) {
+    __CFCompiledFormatterThreadData *data = (__CFCompiledFormatterThreadData *)context;
+    for (CFIndex idx = 0; idx < __kCFCompiledFormatterThreadSlots; idx++) {
+	__CFCompiledFormatterThreadSlot *slot = &data->_slots[idx];
+	if (0 != slot->_serial) __CFCompiledFormatterCloseICUFormatter(slot->_isDateFormatter, slot->_icuFormatter);
+    }
+    CFAllocatorDeallocate(kCFAllocatorSystemDefault, data);
+}
+
+// Returns this thread's clone of the formatter's ICU formatter, making it if needed; NULL if cloning fails
+static void *__CFCompiledFormatterGetThreadICUFormatter(CFCompiledFormatterRef formatter) {
+    __CFCompiledFormatterThreadData *data = (__CFCompiledFormatterThreadData *)_CFGetTSD(__CFTSDKeyCompiledFormatters);
+    if (NULL == data) {
+	data = (__CFCompiledFormatterThreadData *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(__CFCompiledFormatterThreadData), 0);
+	memset(data, 0, sizeof(__CFCompiledFormatterThreadData));
+	_CFSetTSD(__CFTSDKeyCompiledFormatters, data, __CFCompiledFormatterThreadDataDestructor);
+    }
+    for (CFIndex idx = 0; idx < __kCFCompiledFormatterThreadSlots; idx++) {
+	if (data->_slots[idx]._serial == formatter->_serial) return data->_slots[idx]._icuFormatter;
+    }
+
+    UErrorCode status = U_ZERO_ERROR;
+    void *clone = formatter->_isDateFormatter ? (void *)__cficu_udat_clone((UDateFormat *)formatter->_icuFormatter, &status) : (void *)__cficu_unum_clone((UNumberFormat *)formatter->_icuFormatter, &status);
+    if (U_FAILURE(status)) return NULL;
+    __CFCompiledFormatterThreadSlot *slot = &data->_slots[data->_nextSlot];
+    if (0 != slot->_serial) __CFCompiledFormatterCloseICUFormatter(slot->_isDateFormatter, slot->_icuFormatter);
+    slot->_serial = formatter->_serial;
+    slot->_isDateFormatter = formatter->_isDateFormatter;
+    slot->_icuFormatter = clone;
+    data->_nextSlot = (data->_nextSlot + 1) % __kCFCompiledFormatterThreadSlots;
+    return clone;
+}
+
+static CFStringRef __CFCompiledFormatterCopyDescription(CFTypeRef cf) {
+    CFCompiledFormatterRef formatter = (CFCompiledFormatterRef)cf;
+    return CFStringCreateWithFormat(CFGetAllocator(formatter), NULL, CFSTR("<CFCompiledFormatter %p [%p]>{kind = %s}"), cf, CFGetAllocator(formatter), formatter->_isDateFormatter ? "date" : "number");
+}
+
+static void __CFCompiledFormatterDeallocate(CFTypeRef cf) {
+    CFCompiledFormatterRef formatter = (CFCompiledFormatterRef)cf;
+    // Other threads' clones are reclaimed as their slots are reused, or when those threads exit
+    __CFCompiledFormatterThreadData *data = (__CFCompiledFormatterThreadData *)_CFGetTSD(__CFTSDKeyCompiledFormatters);
+    if (data) {
+	for (CFIndex idx = 0; idx < __kCFCompiledFormatterThreadSlots; idx++) {
+	    __CFCompiledFormatterThreadSlot *slot = &data->_slots[idx];
+	    if (slot->_serial == formatter->_serial) {
+		__CFCompiledFormatterCloseICUFormatter(slot->_isDateFormatter, slot->_icuFormatter);
+		slot->_serial = 0;
+		slot->_icuFormatter = NULL;
+	    }
+	}
+    }
+    __CFCompiledFormatterCloseICUFormatter(formatter->_isDateFormatter, formatter->_icuFormatter);
+    if (formatter->_zeroSym) CFRelease(formatter->_zeroSym);
+}
+
+static CFTypeID __kCFCompiledFormatterTypeID = _kCFRuntimeNotATypeID;
+
+static const CFRuntimeClass __CFCompiledFormatterClass = {
+    0,
+    "CFCompiledFormatter",
+    NULL,	// init
+    NULL,	// copy
+    __CFCompiledFormatterDeallocate,
+    NULL,
+    NULL,
+    NULL,	//
+    __CFCompiledFormatterCopyDescription
+};
+
+CFTypeID CFCompiledFormatterGetTypeID(void) {
+    static dispatch_once_t initOnce;
+    dispatch_once(&initOnce, ^{ __kCFCompiledFormatterTypeID = _CFRuntimeRegisterClass(&__CFCompiledFormatterClass); });
+    return __kCFCompiledFormatterTypeID;
+}
+
+static struct __CFCompiledFormatter *__CFCompiledFormatterCreate(CFAllocatorRef allocator, Boolean isDateFormatter) {
+    if (allocator == NULL) allocator = __CFGetDefaultAllocator();
+    __CFGenericValidateType(allocator, CFAllocatorGetTypeID());
+    uint32_t size = sizeof(struct __CFCompiledFormatter) - sizeof(CFRuntimeBase);
+    struct __CFCompiledFormatter *memory = (struct __CFCompiledFormatter *)_CFRuntimeCreateInstance(allocator, CFCompiledFormatterGetTypeID(), size, NULL);
+    if (NULL == memory) {
+	return NULL;
+    }
+    memory->_serial = OSAtomicAdd64Barrier(1, &__CFCompiledFormatterLastSerial);
+    memory->_isDateFormatter = isDateFormatter;
+    memory->_insertRTLMarker = false;
+    memory->_icuFormatter = NULL;
+    memory->_multiplier = 1.0;
+    memory->_zeroSym = NULL;
+    return memory;
+}
+
+CFCompiledFormatterRef CFCompiledFormatterCreateWithDateFormatter(CFAllocatorRef allocator, CFDateFormatterRef formatter) {
+    struct __CFCompiledFormatter *memory = __CFCompiledFormatterCreate(allocator, true);
+    if (NULL == memory) return NULL;
+    memory->_icuFormatter = __CFDateFormatterCopyUDateFormat(formatter, &memory->_insertRTLMarker);
+    if (NULL == memory->_icuFormatter) {
+	CFRelease(memory);
+	return NULL;
+    }
+    return (CFCompiledFormatterRef)memory;
+}
+
+CFCompiledFormatterRef CFCompiledFormatterCreateWithNumberFormatter(CFAllocatorRef allocator, CFNumberFormatterRef formatter) {
+    struct __CFCompiledFormatter *memory = __CFCompiledFormatterCreate(allocator, false);
+    if (NULL == memory) return NULL;
+    memory->_icuFormatter = __CFNumberFormatterCopyUNumberFormat(formatter, &memory->_multiplier, &memory->_zeroSym, &memory->_insertRTLMarker);
+    if (NULL == memory->_icuFormatter) {
+	CFRelease(memory);
+	return NULL;
+    }
+    return (CFCompiledFormatterRef)memory;
+}
+
+Boolean CFCompiledFormatterIsDateFormatter(CFCompiledFormatterRef formatter) {
+    __CFGenericValidateType(formatter, CFCompiledFormatterGetTypeID());
+    return formatter->_isDateFormatter;
+}
+
+// Formats into chars with this thread's clone; same result convention as the formatters' own helpers
+CF_INLINE CFIndex __CFCompiledFormatterFormatAbsoluteTime(CFCompiledFormatterRef formatter, void *icuFormatter, CFAbsoluteTime at, UniChar *chars, CFIndex capacity) {
+    return __CFDateFormatterFormatAbsoluteTime((UDateFormat *)icuFormatter, formatter->_insertRTLMarker, at, chars, capacity);
+}
+
+CF_INLINE CFIndex __CFCompiledFormatterFormatNumber(CFCompiledFormatterRef formatter, void *icuFormatter, CFNumberRef number, UniChar *chars, CFIndex capacity) {
+    // The values of CFNumbers with large unsigned 64-bit ints don't survive well through this
+    CFNumberType type = CFNumberGetType(number);
+    char value[64];
+    CFNumberGetValue(number, type, value);
+    return __CFNumberFormatterFormatValue((UNumberFormat *)icuFormatter, formatter->_multiplier, formatter->_zeroSym, formatter->_insertRTLMarker, type, value, chars, capacity, NULL);
+}
+
+#define CREATE_STRING(FORMAT, VALUE) do { \
+	UniChar *ustr = NULL, ubuffer[BUFFER_SIZE]; \
+	CFIndex used = FORMAT(formatter, icuFormatter, VALUE, ubuffer, BUFFER_SIZE); \
+	if (BUFFER_SIZE < used) { \
+	    CFIndex cnt = used; \
+	    ustr = (UniChar *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(UniChar) * cnt, 0); \
+	    used = FORMAT(formatter, icuFormatter, VALUE, ustr, cnt); \
+	    if (cnt < used) used = -1; \
+	} \
+	if (0 <= used) string = CFStringCreateWithCharacters(allocator, ustr ? ustr : ubuffer, used); \
+	if (ustr) CFAllocatorDeallocate(kCFAllocatorSystemDefault, ustr); \
+    } while (0)
+
+CFStringRef CFCompiledFormatterCreateStringWithAbsoluteTime(CFAllocatorRef allocator, CFCompiledFormatterRef formatter, CFAbsoluteTime at) {
+    if (allocator == NULL) allocator = __CFGetDefaultAllocator();
+    __CFGenericValidateType(allocator, CFAllocatorGetTypeID());
+    __CFGenericValidateType(formatter, CFCompiledFormatterGetTypeID());
+    CFAssert1(formatter->_isDateFormatter, __kCFLogAssertion, "%s(): formatter is not a date formatter", __PRETTY_FUNCTION__);
+    void *icuFormatter = __CFCompiledFormatterGetThreadICUFormatter(formatter);
+    if (NULL == icuFormatter) return NULL;
+    CFStringRef string = NULL;
+    CREATE_STRING(__CFCompiledFormatterFormatAbsoluteTime, at);
+    return string;
+}
+
+CFStringRef CFCompiledFormatterCreateStringWithNumber(CFAllocatorRef allocator, CFCompiledFormatterRef formatter, CFNumberRef number) {
+    if (allocator == NULL) allocator = __CFGetDefaultAllocator();
+    __CFGenericValidateType(allocator, CFAllocatorGetTypeID());
+    __CFGenericValidateType(formatter, CFCompiledFormatterGetTypeID());
+    __CFGenericValidateType(number, CFNumberGetTypeID());
+    CFAssert1(!formatter->_isDateFormatter, __kCFLogAssertion, "%s(): formatter is not a number formatter", __PRETTY_FUNCTION__);
+    if (formatter->_zeroSym) {
+	// keep the identity of the zero symbol, as CFNumberFormatter does
+	Float64 value;
+	CFNumberGetValue(number, kCFNumberFloat64Type, &value);
+	if (0 == value) return (CFStringRef)CFRetain(formatter->_zeroSym);
+    }
+    void *icuFormatter = __CFCompiledFormatterGetThreadICUFormatter(formatter);
+    if (NULL == icuFormatter) return NULL;
+    CFStringRef string = NULL;
+    CREATE_STRING(__CFCompiledFormatterFormatNumber, number);
+    return string;
+}
+
+#undef CREATE_STRING
+
+#define FORMAT_BATCH(FORMAT, VALUES) do { \
+	CFIndex end = 0; \
+	for (idx = 0; idx < count; idx++) { \
+	    CFIndex used = FORMAT(formatter, icuFormatter, VALUES[idx], buffer + end, bufferLength - end); \
+	    if (used < 0 || bufferLength - end < used) break; \
+	    end += used; \
+	    ends[idx] = end; \
+	} \
+    } while (0)
+
+CFIndex CFCompiledFormatterFormatAbsoluteTimes(CFCompiledFormatterRef formatter, const CFAbsoluteTime *times, CFIndex count, UniChar *buffer, CFIndex bufferLength, CFIndex *ends) {
+    __CFGenericValidateType(formatter, CFCompiledFormatterGetTypeID());
+    CFAssert1(formatter->_isDateFormatter, __kCFLogAssertion, "%s(): formatter is not a date formatter", __PRETTY_FUNCTION__);
+    CFAssert2(0 <= count && 0 <= bufferLength, __kCFLogAssertion, "%s(): count (%d) or buffer length is negative", __PRETTY_FUNCTION__, count);
+    void *icuFormatter = __CFCompiledFormatterGetThreadICUFormatter(formatter);
+    if (NULL == icuFormatter) return 0;
+    CFIndex idx;
+    FORMAT_BATCH(__CFCompiledFormatterFormatAbsoluteTime, times);
+    return idx;
+}
+
+CFIndex CFCompiledFormatterFormatNumbers(CFCompiledFormatterRef formatter, const CFNumberRef *numbers, CFIndex count, UniChar *buffer, CFIndex bufferLength, CFIndex *ends) {
+    __CFGenericValidateType(formatter, CFCompiledFormatterGetTypeID());
+    CFAssert1(!formatter->_isDateFormatter, __kCFLogAssertion, "%s(): formatter is not a number formatter", __PRETTY_FUNCTION__);
+    CFAssert2(0 <= count && 0 <= bufferLength, __kCFLogAssertion, "%s(): count (%d) or buffer length is negative", __PRETTY_FUNCTION__, count);
+    void *icuFormatter = __CFCompiledFormatterGetThreadICUFormatter(formatter);
+    if (NULL == icuFormatter) return 0;
+    CFIndex idx;
+    FORMAT_BATCH(__CFCompiledFormatterFormatNumber, numbers);
+    return idx;
+}
+
+#undef FORMAT_BATCH
+#undef BUFFER_SIZE
+
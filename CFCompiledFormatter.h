@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2015 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*	CFCompiledFormatter.h
+	Copyright (c) 2015, Apple Inc. All rights reserved.
+*/
+/*!
+        @header CFCompiledFormatter
+A CFCompiledFormatter is an immutable snapshot of the settings of a
+CFDateFormatter or CFNumberFormatter.  Unlike the formatters themselves, it
+may be used from any number of threads at once without locking: each thread
+formats with its own copy of the underlying ICU formatter, cloned from the
+snapshot the first time that thread uses it and kept in the thread's
+CF thread-specific data.  Later changes to the source formatter do not
+affect a compiled formatter created from it.
+
+Each thread keeps copies for a handful of compiled formatters at a time; a
+thread that cycles through more than that re-clones as it goes.
+*/
+
+#if !defined(__COREFOUNDATION_CFCOMPILEDFORMATTER__)
+#define __COREFOUNDATION_CFCOMPILEDFORMATTER__ 1
+
+#include <CoreFoundation/CFBase.h>
+#include <CoreFoundation/CFDate.h>
+#include <CoreFoundation/CFNumber.h>
+#include <CoreFoundation/CFDateFormatter.h>
+#include <CoreFoundation/CFNumberFormatter.h>
+
+CF_EXTERN_C_BEGIN
+
+typedef const struct __CFCompiledFormatter *CFCompiledFormatterRef;
+
+CF_EXPORT CFTypeID CFCompiledFormatterGetTypeID(void);
+
+/*!
+        @function CFCompiledFormatterCreateWithDateFormatter
+        Creates a compiled formatter that formats dates exactly as the
+        date formatter does at the time of the call. Returns NULL if
+        the formatter's ICU state cannot be copied.
+*/
+CF_EXPORT CFCompiledFormatterRef CFCompiledFormatterCreateWithDateFormatter(CFAllocatorRef allocator, CFDateFormatterRef formatter);
+
+/*!
+        @function CFCompiledFormatterCreateWithNumberFormatter
+        Creates a compiled formatter that formats numbers exactly as
+        the number formatter does at the time of the call. Returns
+        NULL if the formatter's ICU state cannot be copied.
+*/
+CF_EXPORT CFCompiledFormatterRef CFCompiledFormatterCreateWithNumberFormatter(CFAllocatorRef allocator, CFNumberFormatterRef formatter);
+
+CF_EXPORT Boolean CFCompiledFormatterIsDateFormatter(CFCompiledFormatterRef formatter);
+
+/* Formatting a date with a number formatter, or a number with a date
+   formatter, is a programming error. */
+CF_EXPORT CFStringRef CFCompiledFormatterCreateStringWithAbsoluteTime(CFAllocatorRef allocator, CFCompiledFormatterRef formatter, CFAbsoluteTime at);
+
+CF_EXPORT CFStringRef CFCompiledFormatterCreateStringWithNumber(CFAllocatorRef allocator, CFCompiledFormatterRef formatter, CFNumberRef number);
+
+/*!
+        @function CFCompiledFormatterFormatAbsoluteTimes
+        Formats count times back to back into buffer, without
+        separators, in one call.
+	@param ends On return, ends[i] is the index in buffer just past
+		the text for times[i], so the text for times[i] starts at
+		ends[i - 1], or at 0 for the first.
+	@result The number of times formatted. This is less than count
+		if the next text did not fit in the remaining buffer, or
+		could not be formatted.
+*/
+CF_EXPORT CFIndex CFCompiledFormatterFormatAbsoluteTimes(CFCompiledFormatterRef formatter, const CFAbsoluteTime *times, CFIndex count, UniChar *buffer, CFIndex bufferLength, CFIndex *ends);
+
+/*!
+        @function CFCompiledFormatterFormatNumbers
+        Like CFCompiledFormatterFormatAbsoluteTimes(), for an array of
+        CFNumbers.
+*/
+CF_EXPORT CFIndex CFCompiledFormatterFormatNumbers(CFCompiledFormatterRef formatter, const CFNumberRef *numbers, CFIndex count, UniChar *buffer, CFIndex bufferLength, CFIndex *ends);
+
+CF_EXTERN_C_END
+
+#endif /* ! __COREFOUNDATION_CFCOMPILEDFORMATTER__ */
+
@@ -100,7 +100,7 @@ static Boolean constructFD(_CFFileStreamContext *fileStream, CFStreamError *erro
     wchar_t path[CFMaxPathSize];
     flags |= (_O_BINARY|_O_NOINHERIT);
     if (_CFURLGetWideFileSystemRepresentation(fileStream->url, TRUE, path, CFMaxPathSize) == FALSE)
-#elif DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI
+#elif DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI || DEPLOYMENT_TARGET_LINUX
     char path[CFMaxPathSize];
     if (CFURLGetFileSystemRepresentation(fileStream->url, TRUE, (UInt8 *)path, CFMaxPathSize) == FALSE)
 #endif
@@ -115,7 +115,7 @@ static Boolean constructFD(_CFFileStreamContext *fileStream, CFStreamError *erro
     }
     
     do {
-#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI || DEPLOYMENT_TARGET_LINUX
         fileStream->fd = open((const char *)path, flags, 0666);
 #elif DEPLOYMENT_TARGET_WINDOWS
 	fileStream->fd = _wopen(path, flags, 0666);
@@ -169,7 +169,10 @@ static Boolean fileOpen(struct _CFStream *stream, CFStreamError *errorCode, Bool
 }
 
 CF_PRIVATE CFIndex fdRead(int fd, UInt8 *buffer, CFIndex bufferLength, CFStreamError *errorCode, Boolean *atEOF) {
-    CFIndex bytesRead = read(fd, buffer, bufferLength);
+    CFIndex bytesRead;
+    do {
+        bytesRead = read(fd, buffer, bufferLength);
+    } while (bytesRead < 0 && errno == EINTR);
     if (bytesRead < 0) {
         errorCode->error = errno;
         errorCode->domain = kCFStreamErrorDomainPOSIX;
@@ -247,7 +250,10 @@ static Boolean fileCanRead(CFReadStreamRef stream, void *info) {
 }
 
 CF_PRIVATE CFIndex fdWrite(int fd, const UInt8 *buffer, CFIndex bufferLength, CFStreamError *errorCode) {
-    CFIndex bytesWritten = write(fd, buffer, bufferLength);
+    CFIndex bytesWritten;
+    do {
+        bytesWritten = write(fd, buffer, bufferLength);
+    } while (bytesWritten < 0 && errno == EINTR);
     if (bytesWritten < 0) {
         errorCode->error = errno;
         errorCode->domain = kCFStreamErrorDomainPOSIX;
@@ -538,15 +544,16 @@ typedef struct {
     char _padding[3];
 } _CFReadDataStreamContext;
 
-#define BUF_SIZE 1024
 typedef struct _CFStreamByteBuffer {
     UInt8 *bytes;
     CFIndex capacity, length;
     struct _CFStreamByteBuffer *next;
 } _CFStreamByteBuffer;
 
+// If bufferAllocator is kCFAllocatorNull, the stream writes into the single caller-supplied buffer in firstBuf; otherwise bytes are appended to chain, whose chunks are never moved or copied until someone asks for kCFStreamPropertyDataWritten
 typedef struct {
     _CFStreamByteBuffer *firstBuf, *currentBuf;
+    __CFChainedBuffer chain;
     CFAllocatorRef bufferAllocator;
     Boolean scheduled;
     char _padding[3];
@@ -657,42 +664,22 @@ static void writeDataSchedule(struct _CFStream *stream, CFRunLoopRef rl, CFStrin
 
 static CFIndex dataWrite(CFWriteStreamRef stream, const UInt8 *buffer, CFIndex bufferLength, CFStreamError *errorCode, void *info) {
     _CFWriteDataStreamContext *dataStream = (_CFWriteDataStreamContext *)info;
-    CFIndex result;
-    CFIndex freeSpace = dataStream->currentBuf->capacity - dataStream->currentBuf->length;
-    if (dataStream->bufferAllocator == kCFAllocatorNull && bufferLength > freeSpace) {
+    CFIndex result = bufferLength;
+    if (dataStream->bufferAllocator == kCFAllocatorNull) {
+        CFIndex freeSpace = dataStream->currentBuf->capacity - dataStream->currentBuf->length;
+        if (bufferLength > freeSpace) {
+            errorCode->error = ENOMEM;
+            errorCode->domain = kCFStreamErrorDomainPOSIX;
+            return -1;
+        }
+        memmove(dataStream->currentBuf->bytes + dataStream->currentBuf->length, buffer, bufferLength);
+        dataStream->currentBuf->length += bufferLength;
+    } else if (!__CFChainedBufferAppendBytes(&dataStream->chain, buffer, bufferLength)) {
         errorCode->error = ENOMEM;
         errorCode->domain = kCFStreamErrorDomainPOSIX;
         return -1;
-    } else {
-        result = bufferLength;
-        while (bufferLength > 0) {
-            CFIndex amountToCopy = (bufferLength > freeSpace) ? freeSpace : bufferLength;
-            if (freeSpace > 0) {
-                memmove(dataStream->currentBuf->bytes + dataStream->currentBuf->length, buffer, amountToCopy);
-                buffer += amountToCopy;
-                bufferLength -= amountToCopy;
-                dataStream->currentBuf->length += amountToCopy;
-            }
-            if (bufferLength > 0) {
-                CFIndex bufSize = BUF_SIZE > bufferLength ? BUF_SIZE : bufferLength;
-                _CFStreamByteBuffer *newBuf = (_CFStreamByteBuffer *)CFAllocatorAllocate(dataStream->bufferAllocator, sizeof(_CFStreamByteBuffer) + bufSize, 0);
-                if (newBuf == NULL) {
-                    errorCode->error = ENOMEM;
-                    errorCode->domain = kCFStreamErrorDomainPOSIX;
-                    return -1;
-                } else {
-                    newBuf->bytes = (UInt8 *)(newBuf + 1);
-                    newBuf->capacity = bufSize;
-                    newBuf->length = 0;
-                    newBuf->next = NULL;
-                    dataStream->currentBuf->next = newBuf;
-                    dataStream->currentBuf = newBuf;
-                    freeSpace = bufSize;
-                }
-            }
-        }
-        errorCode->error = 0;
     }
+    errorCode->error = 0;
     if (dataStream->scheduled && (dataStream->bufferAllocator != kCFAllocatorNull || dataStream->currentBuf->capacity > dataStream->currentBuf->length)) {
         CFWriteStreamSignalEvent(stream, kCFStreamEventCanAcceptBytes, NULL);
     }
@@ -708,22 +695,16 @@ static  Boolean dataCanWrite(CFWriteStreamRef stream, void *info) {
 
 static CFPropertyListRef dataCopyProperty(struct _CFStream *stream, CFStringRef propertyName, void *info) {
     _CFWriteDataStreamContext *dataStream = (_CFWriteDataStreamContext *)info;
-    CFIndex size = 0;
-    _CFStreamByteBuffer *buf;
+    CFIndex size;
     CFAllocatorRef alloc;
-    UInt8 *bytes, *currByte;
+    UInt8 *bytes;
     if (!CFEqual(propertyName, kCFStreamPropertyDataWritten)) return NULL;
     if (dataStream->bufferAllocator == kCFAllocatorNull)  return NULL;
     alloc = dataStream->bufferAllocator;
-    for (buf = dataStream->firstBuf; buf != NULL; buf = buf->next) {
-        size += buf->length;
-    }
+    size = dataStream->chain.length;
     bytes = (UInt8 *)CFAllocatorAllocate(alloc, size, 0);
-    currByte = bytes;
-    for (buf = dataStream->firstBuf; buf != NULL; buf = buf->next) {
-        memmove(currByte, buf->bytes, buf->length);
-        currByte += buf->length;
-    }
+    if (size && !bytes) return NULL;
+    __CFChainedBufferCopyBytes(&dataStream->chain, bytes);
     return CFDataCreateWithBytesNoCopy(alloc, bytes, size, alloc);
 }
 
@@ -753,13 +734,10 @@ static void *writeDataCreate(struct _CFStream *stream, void *info) {
     if (ctxt->bufferAllocator != kCFAllocatorNull) {
         if (ctxt->bufferAllocator == NULL) ctxt->bufferAllocator = CFAllocatorGetDefault();
         CFRetain(ctxt->bufferAllocator);
-        newCtxt = (_CFWriteDataStreamContext *)CFAllocatorAllocate(CFGetAllocator(stream), sizeof(_CFWriteDataStreamContext) + sizeof(_CFStreamByteBuffer) + BUF_SIZE, 0);
-        newCtxt->firstBuf = (_CFStreamByteBuffer *)(newCtxt + 1);
-        newCtxt->firstBuf->bytes = (UInt8 *)(newCtxt->firstBuf + 1);
-        newCtxt->firstBuf->capacity = BUF_SIZE;
-        newCtxt->firstBuf->length = 0;
-        newCtxt->firstBuf->next = NULL;
-        newCtxt->currentBuf = newCtxt->firstBuf;
+        newCtxt = (_CFWriteDataStreamContext *)CFAllocatorAllocate(CFGetAllocator(stream), sizeof(_CFWriteDataStreamContext), 0);
+        newCtxt->firstBuf = NULL;
+        newCtxt->currentBuf = NULL;
+        __CFChainedBufferInit(&newCtxt->chain, ctxt->bufferAllocator);
         newCtxt->bufferAllocator = ctxt->bufferAllocator;
         newCtxt->scheduled = FALSE;
     } else {
@@ -779,12 +757,7 @@ static void *writeDataCreate(struct _CFStream *stream, void *info) {
 static void writeDataFinalize(struct _CFStream *stream, void *info) {
     _CFWriteDataStreamContext *ctxt = (_CFWriteDataStreamContext *)info;
     if (ctxt->bufferAllocator != kCFAllocatorNull) {
-        _CFStreamByteBuffer *buf = ctxt->firstBuf->next, *next;
-        while (buf != NULL) {
-            next = buf->next;
-            CFAllocatorDeallocate(ctxt->bufferAllocator, buf);
-            buf = next;
-        }
+        __CFChainedBufferDestroy(&ctxt->chain);
         CFRelease(ctxt->bufferAllocator);
     }
     CFAllocatorDeallocate(CFGetAllocator(stream), ctxt);
@@ -879,5 +852,18 @@ CF_EXPORT CFWriteStreamRef CFWriteStreamCreateWithAllocatedBuffers(CFAllocatorRe
     return (CFWriteStreamRef)_CFStreamCreateWithConstantCallbacks(alloc, &ctxt, (struct _CFStreamCallBacks *)(&writeDataCallBacks), FALSE);
 }
 
-#undef BUF_SIZE
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI || DEPLOYMENT_TARGET_LINUX
+CF_EXPORT CFIndex _CFWriteStreamWriteDataWrittenToFileDescriptor(CFWriteStreamRef stream, int fd) {
+    if (!_CFStreamHasConstantCallBacks((struct _CFStream *)stream, (const struct _CFStreamCallBacks *)&writeDataCallBacks)) {
+        errno = EINVAL;
+        return -1;
+    }
+    _CFWriteDataStreamContext *dataStream = (_CFWriteDataStreamContext *)_CFStreamGetInfoPointer((struct _CFStream *)stream);
+    if (dataStream->bufferAllocator == kCFAllocatorNull) {
+        errno = EINVAL;
+        return -1;
+    }
+    return __CFChainedBufferWriteToFileDescriptor(&dataStream->chain, fd);
+}
+#endif
 
@@ -30,6 +30,9 @@
 #include <CoreFoundation/CFPriv.h>
 #include "CFInternal.h"
 #include <string.h>
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI || DEPLOYMENT_TARGET_LINUX
+#include <sys/uio.h>
+#endif
 
 
 
@@ -799,6 +802,145 @@ CFRange CFDataFind(CFDataRef data, CFDataRef dataToFind, CFRange searchRange, CF
     return _CFDataFindBytes(data, dataToFind, searchRange, compareOptions);
 }
 
+
+#pragma mark -
+#pragma mark Chained Buffer
+
+// Each chunk is one allocation of this size, header included
+#define CHAINED_BUFFER_CHUNK_SIZE (16 * 1024)
+#define CHAINED_BUFFER_CHUNK_CAPACITY ((CFIndex)(CHAINED_BUFFER_CHUNK_SIZE - sizeof(__CFChainedBufferChunk)))
+
+CF_PRIVATE void __CFChainedBufferInit(__CFChainedBuffer *buf, CFAllocatorRef allocator) {
+    buf->allocator = allocator ? (CFAllocatorRef)CFRetain(allocator) : (CFAllocatorRef)CFRetain(__CFGetDefaultAllocator());
+    buf->first = buf->last = NULL;
+    buf->length = 0;
+}
+
+CF_PRIVATE void __CFChainedBufferDestroy(__CFChainedBuffer *buf) {
+    __CFChainedBufferChunk *chunk = buf->first;
+    while (chunk) {
+        __CFChainedBufferChunk *next = chunk->next;
+        CFAllocatorDeallocate(buf->allocator, chunk);
+        chunk = next;
+    }
+    buf->first = buf->last = NULL;
+    buf->length = 0;
+    if (buf->allocator) CFRelease(buf->allocator);
+    buf->allocator = NULL;
+}
+
+static __CFChainedBufferChunk *__CFChainedBufferAllocateChunk(CFAllocatorRef allocator, CFIndex capacity) {
+    __CFChainedBufferChunk *chunk = (__CFChainedBufferChunk *)CFAllocatorAllocate(allocator, sizeof(__CFChainedBufferChunk) + capacity, 0);
+    if (!chunk) return NULL;
+    if (__CFOASafe) __CFSetLastAllocationEventName(chunk, "CFData (chained buffer chunk)");
+    chunk->next = NULL;
+    chunk->length = 0;
+    chunk->capacity = capacity;
+    return chunk;
+}
+
+CF_PRIVATE Boolean __CFChainedBufferAppendBytes(__CFChainedBuffer *buf, const UInt8 *bytes, CFIndex length) {
+    if (length <= 0) return true;
+    __CFChainedBufferChunk *last = buf->last;
+    CFIndex freeSpace = last ? last->capacity - last->length : 0;
+    // Allocate everything that is needed up front, so that a failure leaves the buffer unchanged
+    __CFChainedBufferChunk *newFirst = NULL, *newLast = NULL;
+    for (CFIndex needed = length - freeSpace; needed > 0; needed -= CHAINED_BUFFER_CHUNK_CAPACITY) {
+        __CFChainedBufferChunk *chunk = __CFChainedBufferAllocateChunk(buf->allocator, CHAINED_BUFFER_CHUNK_CAPACITY);
+        if (!chunk) {
+            while (newFirst) {
+                __CFChainedBufferChunk *next = newFirst->next;
+                CFAllocatorDeallocate(buf->allocator, newFirst);
+                newFirst = next;
+            }
+            return false;
+        }
+        if (newLast) newLast->next = chunk; else newFirst = chunk;
+        newLast = chunk;
+    }
+    if (freeSpace > 0) {
+        CFIndex amountToCopy = __CFMin(freeSpace, length);
+        memmove(last->bytes + last->length, bytes, amountToCopy);
+        last->length += amountToCopy;
+        bytes += amountToCopy;
+        length -= amountToCopy;
+        buf->length += amountToCopy;
+    }
+    for (__CFChainedBufferChunk *chunk = newFirst; chunk; chunk = chunk->next) {
+        CFIndex amountToCopy = __CFMin(chunk->capacity, length);
+        memmove(chunk->bytes, bytes, amountToCopy);
+        chunk->length = amountToCopy;
+        bytes += amountToCopy;
+        length -= amountToCopy;
+        buf->length += amountToCopy;
+    }
+    if (newFirst) {
+        if (last) last->next = newFirst; else buf->first = newFirst;
+        buf->last = newLast;
+    }
+    return true;
+}
+
+CF_PRIVATE void __CFChainedBufferCopyBytes(const __CFChainedBuffer *buf, UInt8 *dst) {
+    for (__CFChainedBufferChunk *chunk = buf->first; chunk; chunk = chunk->next) {
+        memmove(dst, chunk->bytes, chunk->length);
+        dst += chunk->length;
+    }
+}
+
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI || DEPLOYMENT_TARGET_LINUX
+
+#define CHAINED_BUFFER_IOV_BATCH 64
+
+CF_PRIVATE CFIndex __CFChainedBufferWriteToFileDescriptor(const __CFChainedBuffer *buf, int fd) {
+    struct iovec vecs[CHAINED_BUFFER_IOV_BATCH];
+    __CFChainedBufferChunk *chunk = buf->first;
+    CFIndex offset = 0;	// bytes of chunk already written
+    CFIndex total = 0;
+    while (chunk) {
+        CFIndex count = 0;
+        __CFChainedBufferChunk *cur = chunk;
+        CFIndex curOffset = offset;
+        for (; cur && count < CHAINED_BUFFER_IOV_BATCH; cur = cur->next, curOffset = 0) {
+            if (cur->length - curOffset <= 0) continue;
+            vecs[count].iov_base = cur->bytes + curOffset;
+            vecs[count].iov_len = cur->length - curOffset;
+            count++;
+        }
+        if (0 == count) break;
+        ssize_t written = writev(fd, vecs, (int)count);
+        if (written < 0) {
+            if (EINTR == errno) continue;
+            return -1;
+        }
+        total += written;
+        // Advance past what was written; a short write leaves us partway into a chunk
+        while (chunk && written > 0) {
+            CFIndex remaining = chunk->length - offset;
+            if (written >= remaining) {
+                written -= remaining;
+                chunk = chunk->next;
+                offset = 0;
+            } else {
+                offset += written;
+                written = 0;
+            }
+        }
+        while (chunk && chunk->length == offset) {
+            chunk = chunk->next;
+            offset = 0;
+        }
+    }
+    return total;
+}
+
+#undef CHAINED_BUFFER_IOV_BATCH
+
+#endif
+
+#undef CHAINED_BUFFER_CHUNK_CAPACITY
+#undef CHAINED_BUFFER_CHUNK_SIZE
+
 #undef __CFDataValidateRange
 #undef __CFGenericValidateMutabilityFlags
 #undef INLINE_BYTES_THRESHOLD
@@ -103,21 +103,62 @@ struct __CFDate {
     CFAbsoluteTime _time;       /* immutable */
 };
 
+#if CF_HAVE_TAGGED_POINTERS
+/* Tagged CFDate payload (see CFInternal.h), the Float64 with a narrowed exponent:
+    Bit 60: sign
+    Bits 59..52: 0 for zero, else the exponent rebased so 1..255 covers 2^-127 to 2^127
+    Bits 51..0: mantissa
+   Any time within about 10^38 seconds of the reference date, at full precision, fits.
+*/
+#define __CFTaggedDateExponentBias (1023 - 128)
+
+static CFDateRef __CFDateCreateTagged(CFAbsoluteTime at) {
+    uint64_t bits;
+    memmove(&bits, &at, 8);
+    uint64_t sign = bits >> 63;
+    uint64_t exponent = (bits >> 52) & 0x7FF;
+    uint64_t mantissa = bits & 0xFFFFFFFFFFFFFULL;
+    if (0 == exponent && 0 == mantissa) {
+        // zero keeps exponent 0
+    } else if (__CFTaggedDateExponentBias < exponent && exponent <= __CFTaggedDateExponentBias + 255) {
+        exponent -= __CFTaggedDateExponentBias;
+    } else {
+        return NULL;
+    }
+    return (CFDateRef)__CFTaggedPointerCreate(__kCFTaggedObjectID_Date, (sign << 60) | (exponent << 52) | mantissa);
+}
+#endif
+
+CF_INLINE CFAbsoluteTime __CFDateGetTime(CFDateRef date) {
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(date)) {
+        uint64_t payload = __CFTaggedPointerGetPayload(date);
+        uint64_t exponent = (payload >> 52) & 0xFF;
+        if (0 != exponent) exponent += __CFTaggedDateExponentBias;
+        uint64_t bits = ((payload >> 60) << 63) | (exponent << 52) | (payload & 0xFFFFFFFFFFFFFULL);
+        CFAbsoluteTime at;
+        memmove(&at, &bits, 8);
+        return at;
+    }
+#endif
+    return date->_time;
+}
+
 static Boolean __CFDateEqual(CFTypeRef cf1, CFTypeRef cf2) {
     CFDateRef date1 = (CFDateRef)cf1;
     CFDateRef date2 = (CFDateRef)cf2;
-    if (date1->_time != date2->_time) return false;
+    if (__CFDateGetTime(date1) != __CFDateGetTime(date2)) return false;
     return true;
 }
 
 static CFHashCode __CFDateHash(CFTypeRef cf) {
     CFDateRef date = (CFDateRef)cf;
-    return (CFHashCode)(float)floor(date->_time);
+    return (CFHashCode)(float)floor(__CFDateGetTime(date));
 }
 
 static CFStringRef __CFDateCopyDescription(CFTypeRef cf) {
     CFDateRef date = (CFDateRef)cf;
-    return CFStringCreateWithFormat(CFGetAllocator(date), NULL, CFSTR("<CFDate %p [%p]>{time = %0.09g}"), cf, CFGetAllocator(date), date->_time);
+    return CFStringCreateWithFormat(CFGetAllocator(date), NULL, CFSTR("<CFDate %p [%p]>{time = %0.09g}"), cf, CFGetAllocator(date), __CFDateGetTime(date));
 }
 
 static CFTypeID __kCFDateTypeID = _kCFRuntimeNotATypeID;
@@ -168,6 +209,12 @@ CFTypeID CFDateGetTypeID(void) {
 CFDateRef CFDateCreate(CFAllocatorRef allocator, CFAbsoluteTime at) {
     CFDateRef memory; 
     uint32_t size;
+#if CF_HAVE_TAGGED_POINTERS
+    if (_CFAllocatorIsSystemDefault(allocator)) {
+        memory = __CFDateCreateTagged(at);
+        if (NULL != memory) return memory;
+    }
+#endif
     size = sizeof(struct __CFDate) - sizeof(CFRuntimeBase);
     memory = (CFDateRef)_CFRuntimeCreateInstance(allocator, CFDateGetTypeID(), size, NULL);
     if (NULL == memory) {
@@ -180,22 +227,23 @@ CFDateRef CFDateCreate(CFAllocatorRef allocator, CFAbsoluteTime at) {
 CFTimeInterval CFDateGetAbsoluteTime(CFDateRef date) {
     CF_OBJC_FUNCDISPATCHV(CFDateGetTypeID(), CFTimeInterval, (NSDate *)date, timeIntervalSinceReferenceDate);
     __CFGenericValidateType(date, CFDateGetTypeID());
-    return date->_time;
+    return __CFDateGetTime(date);
 }
 
 CFTimeInterval CFDateGetTimeIntervalSinceDate(CFDateRef date, CFDateRef otherDate) {
     CF_OBJC_FUNCDISPATCHV(CFDateGetTypeID(), CFTimeInterval, (NSDate *)date, timeIntervalSinceDate:(NSDate *)otherDate);
     __CFGenericValidateType(date, CFDateGetTypeID());
     __CFGenericValidateType(otherDate, CFDateGetTypeID());
-    return date->_time - otherDate->_time;
+    return __CFDateGetTime(date) - __CFDateGetTime(otherDate);
 }   
     
 CFComparisonResult CFDateCompare(CFDateRef date, CFDateRef otherDate, void *context) {
     CF_OBJC_FUNCDISPATCHV(CFDateGetTypeID(), CFComparisonResult, (NSDate *)date, compare:(NSDate *)otherDate);
     __CFGenericValidateType(date, CFDateGetTypeID());
     __CFGenericValidateType(otherDate, CFDateGetTypeID());
-    if (date->_time < otherDate->_time) return kCFCompareLessThan;
-    if (date->_time > otherDate->_time) return kCFCompareGreaterThan;
+    CFAbsoluteTime time = __CFDateGetTime(date), otherTime = __CFDateGetTime(otherDate);
+    if (time < otherTime) return kCFCompareLessThan;
+    if (time > otherTime) return kCFCompareGreaterThan;
     return kCFCompareEqualTo;
 }
 
@@ -285,6 +333,36 @@ static double __CFAbsoluteFromYMD(int64_t year, int8_t month, int8_t day) {
     return absolute;
 }
 
+/* Closed-form proleptic Gregorian conversions; year arg is the Gregorian year and days
+   count from 2001/1/1 = day 0.  month and day may lie outside their usual ranges and
+   roll over into neighbouring months and years, as a lenient calendar does. */
+CF_PRIVATE int64_t __CFDaysFromGregorianYMD(int64_t year, int64_t month, int64_t day) {
+    int64_t m0 = month - 1;
+    int64_t carry = (0 <= m0) ? m0 / 12 : (m0 - 11) / 12;
+    year += carry;
+    month = m0 - carry * 12 + 1;
+    // count years from March 1 so the leap day falls at the end
+    if (month <= 2) year -= 1;
+    int64_t era = ((0 <= year) ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;
+    int64_t doy = (153 * (month + ((2 < month) ? -3 : 9)) + 2) / 5;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 730791 + day - 1;	// 730791 days from 0000/3/1 to 2001/1/1
+}
+
+CF_PRIVATE void __CFGregorianYMDFromDays(int64_t days, int64_t *year, int8_t *month, int8_t *day) {
+    days += 730791;
+    int64_t era = ((0 <= days) ? days : days - 146096) / 146097;
+    int64_t doe = days - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int64_t m = (mp < 10) ? mp + 3 : mp - 9;
+    if (year) *year = yoe + era * 400 + (m <= 2);
+    if (month) *month = (int8_t)m;
+    if (day) *day = (int8_t)(doy - (153 * mp + 2) / 5 + 1);
+}
+
 Boolean CFGregorianDateIsValid(CFGregorianDate gdate, CFOptionFlags unitFlags) {
     if ((unitFlags & kCFGregorianUnitsYears) && (gdate.year <= 0)) return false;
     if ((unitFlags & kCFGregorianUnitsMonths) && (gdate.month < 1 || 12 < gdate.month)) return false;
@@ -222,6 +222,7 @@ struct __CFDateFormatter {
     CFDateFormatterStyle _dateStyle;
     CFStringRef _format;
     CFStringRef _defformat;
+    uint8_t _fixedFormat;	// __kCFDateFormatterFixed* fields of a machine format handled without ICU, or 0
     struct {
         CFBooleanRef _IsLenient;
 	CFBooleanRef _DoesRelativeDateFormatting;
@@ -364,6 +365,7 @@ extern CFDictionaryRef __CFLocaleGetPrefs(CFLocaleRef locale);
 static void __substituteFormatStringFromPrefsDFRelative(CFDateFormatterRef formatter);
 static void __substituteFormatStringFromPrefsDF(CFDateFormatterRef formatter, bool doTime);
 static void __CFDateFormatterSetSymbolsArray(UDateFormat *icudf, int32_t icucode, int index_base, CFTypeRef value);
+static void __CFDateFormatterUpdateFixedFormat(CFDateFormatterRef formatter);
     
 static void __ReadCustomUDateFormatProperty(CFDateFormatterRef formatter) {
     CFDictionaryRef prefs = __CFLocaleGetPrefs(formatter->_locale);
@@ -598,6 +600,7 @@ static void __SetCalendarProperties(CFDateFormatterRef df) {
 static void __ResetUDateFormat(CFDateFormatterRef df, Boolean goingToHaveCustomFormat) {
     if (df->_df) __cficu_udat_close(df->_df);
     df->_df = NULL;
+    df->_fixedFormat = 0;
 
     // uses _timeStyle, _dateStyle, _locale, _property._TimeZone; sets _df, _format, _defformat
     char loc_buffer[BUFFER_SIZE];
@@ -761,6 +764,7 @@ static void __ResetUDateFormat(CFDateFormatterRef df, Boolean goingToHaveCustomF
     RESET_PROPERTY(_AmbiguousYearStrategy, kCFDateFormatterAmbiguousYearStrategyKey);
     RESET_PROPERTY(_UsesCharacterDirection, kCFDateFormatterUsesCharacterDirectionKey);
     RESET_PROPERTY(_FormattingContext, kCFDateFormatterFormattingContextKey);
+    __CFDateFormatterUpdateFixedFormat(df);
 }
 
 static CFTypeID __kCFDateFormatterTypeID = _kCFRuntimeNotATypeID;
@@ -797,6 +801,7 @@ CFDateFormatterRef CFDateFormatterCreate(CFAllocatorRef allocator, CFLocaleRef l
     memory->_locale = NULL;
     memory->_format = NULL;
     memory->_defformat = NULL;
+    memory->_fixedFormat = 0;
     memory->_dateStyle = dateStyle;
     memory->_timeStyle = timeStyle;
     memory->_property._IsLenient = NULL;
@@ -1211,11 +1216,265 @@ void CFDateFormatterSetFormat(CFDateFormatterRef formatter, CFStringRef formatSt
             if (formatter->_format) CFRelease(formatter->_format);
             formatter->_format = (CFStringRef)CFStringCreateCopy(CFGetAllocator(formatter), formatString);
             formatter->_property._HasCustomFormat = kCFBooleanTrue;
+            __CFDateFormatterUpdateFixedFormat(formatter);
         }
     }
     if (formatString) CFRelease(formatString);
 }
 
+/*
+ Machine formats such as "yyyy-MM-dd'T'HH:mm:ss.SSSZ" in the en_US_POSIX locale are formatted
+ and parsed here with integer code, as ASCII, rather than through ICU.  Anything the code below
+ cannot reproduce exactly as ICU would -- years outside 1583...9999, zone offsets with seconds,
+ non-canonical input, wall times near a zone transition -- is left to ICU.
+ */
+enum {
+    __kCFDateFormatterFixedTime = 0x01,		// " HH:mm:ss" or "'T'HH:mm:ss" after yyyy-MM-dd
+    __kCFDateFormatterFixedSpace = 0x02,	// ' ' rather than 'T' before the time
+    __kCFDateFormatterFixedMillis = 0x04,	// ".SSS" after the seconds
+    __kCFDateFormatterFixedZoneRFC822 = 0x08,	// "Z": +hhmm
+    __kCFDateFormatterFixedZoneISO8601 = 0x10,	// "ZZZZZ", "XXX", "XXXXX": Z or +hh:mm
+    __kCFDateFormatterFixedRFC1123 = 0x20,	// "EEE, dd MMM yyyy HH:mm:ss GMT"
+    __kCFDateFormatterFixedDate = 0x80		// yyyy-MM-dd, and nothing else
+};
+
+#define FIXED_ISO_TIME (__kCFDateFormatterFixedTime)
+#define FIXED_ISO_TIME_MILLIS (__kCFDateFormatterFixedTime | __kCFDateFormatterFixedMillis)
+
+static const struct {
+    const char *pattern;
+    uint8_t fields;
+} __CFDateFormatterFixedFormats[] = {
+    {"yyyy-MM-dd", __kCFDateFormatterFixedDate},
+    {"yyyy-MM-dd'T'HH:mm:ss", FIXED_ISO_TIME},
+    {"yyyy-MM-dd'T'HH:mm:ss.SSS", FIXED_ISO_TIME_MILLIS},
+    {"yyyy-MM-dd HH:mm:ss", FIXED_ISO_TIME | __kCFDateFormatterFixedSpace},
+    {"yyyy-MM-dd HH:mm:ss.SSS", FIXED_ISO_TIME_MILLIS | __kCFDateFormatterFixedSpace},
+    {"yyyy-MM-dd'T'HH:mm:ssZ", FIXED_ISO_TIME | __kCFDateFormatterFixedZoneRFC822},
+    {"yyyy-MM-dd'T'HH:mm:ss.SSSZ", FIXED_ISO_TIME_MILLIS | __kCFDateFormatterFixedZoneRFC822},
+    {"yyyy-MM-dd'T'HH:mm:ssZZZZZ", FIXED_ISO_TIME | __kCFDateFormatterFixedZoneISO8601},
+    {"yyyy-MM-dd'T'HH:mm:ss.SSSZZZZZ", FIXED_ISO_TIME_MILLIS | __kCFDateFormatterFixedZoneISO8601},
+    {"yyyy-MM-dd'T'HH:mm:ssXXX", FIXED_ISO_TIME | __kCFDateFormatterFixedZoneISO8601},
+    {"yyyy-MM-dd'T'HH:mm:ss.SSSXXX", FIXED_ISO_TIME_MILLIS | __kCFDateFormatterFixedZoneISO8601},
+    {"yyyy-MM-dd'T'HH:mm:ssXXXXX", FIXED_ISO_TIME | __kCFDateFormatterFixedZoneISO8601},
+    {"yyyy-MM-dd'T'HH:mm:ss.SSSXXXXX", FIXED_ISO_TIME_MILLIS | __kCFDateFormatterFixedZoneISO8601},
+    {"EEE, dd MMM yyyy HH:mm:ss zzz", __kCFDateFormatterFixedRFC1123},
+    {"EEE, dd MMM yyyy HH:mm:ss 'GMT'", __kCFDateFormatterFixedRFC1123},
+    {"EEE',' dd MMM yyyy HH':'mm':'ss 'GMT'", __kCFDateFormatterFixedRFC1123},
+};
+
+#undef FIXED_ISO_TIME
+#undef FIXED_ISO_TIME_MILLIS
+
+static const char __CFDateFormatterFixedWeekdays[7][4] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char __CFDateFormatterFixedMonths[12][4] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+#define FIXED_MIN_YEAR 1583	// the first whole year after the default Gregorian cutover
+#define FIXED_MAX_YEAR 9999	// the last year "yyyy" formats in four digits
+#define FIXED_BUFFER_SIZE 40
+#define MS_PER_DAY 86400000LL
+
+static void __CFDateFormatterUpdateFixedFormat(CFDateFormatterRef formatter) {
+    uint8_t fields = 0;
+    char pattern[64];
+    CFStringRef calident = formatter->_locale ? (CFStringRef)CFLocaleGetValue(formatter->_locale, kCFLocaleCalendarIdentifierKey) : NULL;
+    if (formatter->_df && formatter->_format && formatter->_property._TimeZone && !formatter->_property._GregorianStartDate && calident && CFEqual(calident, kCFCalendarIdentifierGregorian) && CFEqual(CFLocaleGetIdentifier(formatter->_locale), CFSTR("en_US_POSIX")) && CFStringGetCString(formatter->_format, pattern, sizeof(pattern), kCFStringEncodingASCII)) {
+        for (CFIndex idx = 0; idx < sizeof(__CFDateFormatterFixedFormats) / sizeof(__CFDateFormatterFixedFormats[0]); idx++) {
+            if (0 == strcmp(pattern, __CFDateFormatterFixedFormats[idx].pattern)) {
+                fields = __CFDateFormatterFixedFormats[idx].fields;
+                break;
+            }
+        }
+    }
+    if (fields & __kCFDateFormatterFixedRFC1123) {
+        // The English names are only right without replacement symbols, and "GMT" only in GMT
+        if (formatter->_property._ShortWeekdaySymbols || formatter->_property._ShortMonthSymbols || formatter->_property._CustomShortWeekdaySymbols || formatter->_property._CustomShortMonthSymbols || !CFEqual(CFTimeZoneGetName(formatter->_property._TimeZone), CFSTR("GMT"))) {
+            fields = 0;
+        }
+    }
+    formatter->_fixedFormat = fields;
+}
+
+CF_INLINE char *__CFDateFormatterFixedPutDigits(char *dst, int64_t value, int count) {
+    for (int idx = count - 1; 0 <= idx; idx--) {
+        dst[idx] = '0' + (char)(value % 10);
+        value /= 10;
+    }
+    return dst + count;
+}
+
+// Formats at as ASCII into buffer, which holds FIXED_BUFFER_SIZE bytes; returns the length, or -1 to use ICU
+static CFIndex __CFDateFormatterFormatFixed(CFDateFormatterRef formatter, CFAbsoluteTime at, char *buffer) {
+    uint8_t fields = formatter->_fixedFormat;
+    // ICU is handed the same rounded UDate as in __CFDateFormatterFormatAbsoluteTime(), and floors it
+    double udate = floor((at + kCFAbsoluteTimeIntervalSince1970) * 1000.0 + 0.5);
+    if (!(-1.0E17 < udate && udate < 1.0E17)) return -1;	// also rejects NaN
+    int64_t offset = (int64_t)(CFTimeZoneGetSecondsFromGMT(formatter->_property._TimeZone, udate / 1000.0 - kCFAbsoluteTimeIntervalSince1970) * 1000.0);
+    if ((fields & (__kCFDateFormatterFixedZoneRFC822 | __kCFDateFormatterFixedZoneISO8601)) && 0 != offset % 60000) return -1;
+    if ((fields & __kCFDateFormatterFixedRFC1123) && 0 != offset) return -1;
+    int64_t local = (int64_t)udate - (int64_t)(kCFAbsoluteTimeIntervalSince1970 * 1000.0) + offset;
+    int64_t days = ((0 <= local) ? local : local - (MS_PER_DAY - 1)) / MS_PER_DAY;
+    int64_t msInDay = local - days * MS_PER_DAY;
+    int64_t year;
+    int8_t month, day;
+    __CFGregorianYMDFromDays(days, &year, &month, &day);
+    if (year < FIXED_MIN_YEAR || FIXED_MAX_YEAR < year) return -1;
+
+    char *dst = buffer;
+    if (fields & __kCFDateFormatterFixedRFC1123) {
+        memmove(dst, __CFDateFormatterFixedWeekdays[((days % 7) + 8) % 7], 3);	// 2001-01-01 was a Monday
+        dst[3] = ',';
+        dst[4] = ' ';
+        dst = __CFDateFormatterFixedPutDigits(dst + 5, day, 2);
+        *dst++ = ' ';
+        memmove(dst, __CFDateFormatterFixedMonths[month - 1], 3);
+        dst[3] = ' ';
+        dst = __CFDateFormatterFixedPutDigits(dst + 4, year, 4);
+        *dst++ = ' ';
+    } else {
+        dst = __CFDateFormatterFixedPutDigits(dst, year, 4);
+        *dst++ = '-';
+        dst = __CFDateFormatterFixedPutDigits(dst, month, 2);
+        *dst++ = '-';
+        dst = __CFDateFormatterFixedPutDigits(dst, day, 2);
+        if (fields & __kCFDateFormatterFixedDate) return dst - buffer;
+        *dst++ = (fields & __kCFDateFormatterFixedSpace) ? ' ' : 'T';
+    }
+    dst = __CFDateFormatterFixedPutDigits(dst, msInDay / 3600000, 2);
+    *dst++ = ':';
+    dst = __CFDateFormatterFixedPutDigits(dst, (msInDay / 60000) % 60, 2);
+    *dst++ = ':';
+    dst = __CFDateFormatterFixedPutDigits(dst, (msInDay / 1000) % 60, 2);
+    if (fields & __kCFDateFormatterFixedMillis) {
+        *dst++ = '.';
+        dst = __CFDateFormatterFixedPutDigits(dst, msInDay % 1000, 3);
+    }
+    if (fields & __kCFDateFormatterFixedRFC1123) {
+        memmove(dst, " GMT", 4);
+        dst += 4;
+    } else if (fields & (__kCFDateFormatterFixedZoneRFC822 | __kCFDateFormatterFixedZoneISO8601)) {
+        Boolean iso = (fields & __kCFDateFormatterFixedZoneISO8601) ? true : false;
+        if (iso && 0 == offset) {
+            *dst++ = 'Z';
+        } else {
+            int64_t minutes = ((offset < 0) ? -offset : offset) / 60000;
+            *dst++ = (offset < 0) ? '-' : '+';
+            dst = __CFDateFormatterFixedPutDigits(dst, minutes / 60, 2);
+            if (iso) *dst++ = ':';
+            dst = __CFDateFormatterFixedPutDigits(dst, minutes % 60, 2);
+        }
+    }
+    return dst - buffer;
+}
+
+CF_INLINE Boolean __CFDateFormatterFixedScanDigits(const UChar *src, int count, int64_t *value) {
+    int64_t result = 0;
+    for (int idx = 0; idx < count; idx++) {
+        if (src[idx] < '0' || '9' < src[idx]) return false;
+        result = result * 10 + (src[idx] - '0');
+    }
+    *value = result;
+    return true;
+}
+
+CF_INLINE Boolean __CFDateFormatterFixedScanName(const UChar *src, const char (*names)[4], int count, int64_t *index) {
+    for (int idx = 0; idx < count; idx++) {
+        if (src[0] == names[idx][0] && src[1] == names[idx][1] && src[2] == names[idx][2]) {
+            *index = idx;
+            return true;
+        }
+    }
+    return false;
+}
+
+CF_INLINE Boolean __CFDateFormatterFixedMatch(const UChar *src, const char *literal) {
+    for (; *literal; src++, literal++) {
+        if (*src != (UChar)*literal) return false;
+    }
+    return true;
+}
+
+// Parses the whole of ustr; returns false to use ICU, which may still succeed
+static Boolean __CFDateFormatterParseFixed(CFDateFormatterRef formatter, const UChar *ustr, CFIndex length, CFAbsoluteTime *atp) {
+    uint8_t fields = formatter->_fixedFormat;
+    const UChar *src = ustr, *end = ustr + length;
+    int64_t year, month, day, hour = 0, minute = 0, second = 0, msec = 0, weekday = -1, offset = 0;
+    Boolean hasOffset = false;
+#define NEED(N) if (end - src < (N)) return false
+    if (fields & __kCFDateFormatterFixedRFC1123) {
+        NEED(17);
+        if (!__CFDateFormatterFixedScanName(src, __CFDateFormatterFixedWeekdays, 7, &weekday) || !__CFDateFormatterFixedMatch(src + 3, ", ")) return false;
+        if (!__CFDateFormatterFixedScanDigits(src + 5, 2, &day) || ' ' != src[7]) return false;
+        if (!__CFDateFormatterFixedScanName(src + 8, __CFDateFormatterFixedMonths, 12, &month) || ' ' != src[11]) return false;
+        month++;
+        if (!__CFDateFormatterFixedScanDigits(src + 12, 4, &year) || ' ' != src[16]) return false;
+        src += 17;
+    } else {
+        NEED(10);
+        if (!__CFDateFormatterFixedScanDigits(src, 4, &year) || '-' != src[4] || !__CFDateFormatterFixedScanDigits(src + 5, 2, &month) || '-' != src[7] || !__CFDateFormatterFixedScanDigits(src + 8, 2, &day)) return false;
+        src += 10;
+        if (!(fields & __kCFDateFormatterFixedDate)) {
+            NEED(1);
+            if (*src++ != ((fields & __kCFDateFormatterFixedSpace) ? ' ' : 'T')) return false;
+        }
+    }
+    if (!(fields & __kCFDateFormatterFixedDate)) {
+        NEED(8);
+        if (!__CFDateFormatterFixedScanDigits(src, 2, &hour) || ':' != src[2] || !__CFDateFormatterFixedScanDigits(src + 3, 2, &minute) || ':' != src[5] || !__CFDateFormatterFixedScanDigits(src + 6, 2, &second)) return false;
+        src += 8;
+    }
+    if (fields & __kCFDateFormatterFixedMillis) {
+        NEED(4);
+        if ('.' != src[0] || !__CFDateFormatterFixedScanDigits(src + 1, 3, &msec)) return false;
+        src += 4;
+    }
+    if (fields & __kCFDateFormatterFixedRFC1123) {
+        NEED(4);
+        if (!__CFDateFormatterFixedMatch(src, " GMT")) return false;
+        src += 4;
+        hasOffset = true;
+    } else if (fields & (__kCFDateFormatterFixedZoneRFC822 | __kCFDateFormatterFixedZoneISO8601)) {
+        Boolean iso = (fields & __kCFDateFormatterFixedZoneISO8601) ? true : false;
+        int64_t offsetHours, offsetMinutes;
+        NEED(1);
+        if (iso && 'Z' == *src) {
+            src++;
+        } else {
+            NEED(iso ? 6 : 5);
+            if (('+' != src[0] && '-' != src[0]) || !__CFDateFormatterFixedScanDigits(src + 1, 2, &offsetHours) || (iso && ':' != src[3]) || !__CFDateFormatterFixedScanDigits(src + (iso ? 4 : 3), 2, &offsetMinutes)) return false;
+            if (23 < offsetHours || 59 < offsetMinutes) return false;
+            offset = (offsetHours * 60 + offsetMinutes) * 60000;
+            if ('-' == src[0]) offset = -offset;
+            src += iso ? 6 : 5;
+        }
+        hasOffset = true;
+    }
+#undef NEED
+    if (src != end) return false;
+    if (year < FIXED_MIN_YEAR || FIXED_MAX_YEAR < year || month < 1 || 12 < month || day < 1 || 23 < hour || 59 < minute || 59 < second) return false;
+    int64_t days = __CFDaysFromGregorianYMD(year, month, day);
+    int64_t check;
+    int8_t checkMonth, checkDay;
+    __CFGregorianYMDFromDays(days, &check, &checkMonth, &checkDay);
+    if (checkDay != day) return false;	// past the end of the month
+    if (0 <= weekday && ((days % 7) + 8) % 7 != weekday) return false;
+    int64_t local = days * MS_PER_DAY + ((hour * 60 + minute) * 60 + second) * 1000 + msec;
+    if (!hasOffset) {
+        // Only a wall time well clear of any zone transition is unambiguous
+        CFTimeZoneRef tz = formatter->_property._TimeZone;
+        CFAbsoluteTime wall = (double)local / 1000.0;
+        double offsetBefore = CFTimeZoneGetSecondsFromGMT(tz, wall - 86400.0);
+        if (offsetBefore != CFTimeZoneGetSecondsFromGMT(tz, wall + 86400.0) || offsetBefore != CFTimeZoneGetSecondsFromGMT(tz, wall - offsetBefore)) return false;
+        offset = (int64_t)(offsetBefore * 1000.0);
+    }
+    if (atp) *atp = (double)(local - offset) / 1000.0;
+    return true;
+}
+
+#undef FIXED_MIN_YEAR
+#undef FIXED_MAX_YEAR
+#undef MS_PER_DAY
+
 CFStringRef CFDateFormatterCreateStringWithDate(CFAllocatorRef allocator, CFDateFormatterRef formatter, CFDateRef date) {
     if (allocator == NULL) allocator = __CFGetDefaultAllocator();
     __CFGenericValidateType(allocator, CFAllocatorGetTypeID());
@@ -1224,33 +1483,54 @@ CFStringRef CFDateFormatterCreateStringWithDate(CFAllocatorRef allocator, CFDate
     return CFDateFormatterCreateStringWithAbsoluteTime(allocator, formatter, CFDateGetAbsoluteTime(date));
 }
 
+CF_INLINE Boolean __CFDateFormatterInsertsRTLMarker(CFDateFormatterRef formatter) {
+    return formatter->_property._UsesCharacterDirection == kCFBooleanTrue && CFLocaleGetLanguageCharacterDirection(CFLocaleGetIdentifier(formatter->_locale)) == kCFLocaleLanguageDirectionRightToLeft;
+}
+
+// Formats at with df into buffer, after a Unicode RTL marker if insertRTLMarker is true.
+// Returns the length of the result, which exceeds capacity when the buffer was too small, or -1 on failure.
+CF_PRIVATE CFIndex __CFDateFormatterFormatAbsoluteTime(UDateFormat *df, Boolean insertRTLMarker, CFAbsoluteTime at, UniChar *buffer, CFIndex capacity) {
+    CFIndex prefix = insertRTLMarker ? 1 : 0;
+    CFIndex cnt = (prefix < capacity) ? capacity - prefix : 0;
+    UErrorCode status = U_ZERO_ERROR;
+    UDate ud = (at + kCFAbsoluteTimeIntervalSince1970) * 1000.0 + 0.5;
+    CFIndex used = __cficu_udat_format(df, ud, cnt ? (UChar *)buffer + prefix : NULL, cnt, NULL, &status);
+    if (U_FAILURE(status) && status != U_BUFFER_OVERFLOW_ERROR) return -1;
+    if (prefix && 0 < capacity) buffer[0] = 0x200F;
+    return used + prefix;
+}
+
+// Clones the formatter's current ICU formatter, for callers that format from other threads
+CF_PRIVATE UDateFormat *__CFDateFormatterCopyUDateFormat(CFDateFormatterRef formatter, Boolean *insertRTLMarker) {
+    __CFGenericValidateType(formatter, CFDateFormatterGetTypeID());
+    UErrorCode status = U_ZERO_ERROR;
+    UDateFormat *df = __cficu_udat_clone(formatter->_df, &status);
+    if (U_FAILURE(status)) return NULL;
+    if (insertRTLMarker) *insertRTLMarker = __CFDateFormatterInsertsRTLMarker(formatter);
+    return df;
+}
+
 CFStringRef CFDateFormatterCreateStringWithAbsoluteTime(CFAllocatorRef allocator, CFDateFormatterRef formatter, CFAbsoluteTime at) {
     if (allocator == NULL) allocator = __CFGetDefaultAllocator();
     __CFGenericValidateType(allocator, CFAllocatorGetTypeID());
     __CFGenericValidateType(formatter, CFDateFormatterGetTypeID());
-    UChar *ustr = NULL, ubuffer[BUFFER_SIZE + 1];
-    UErrorCode status = U_ZERO_ERROR;
-    CFIndex used, cnt = BUFFER_SIZE;
-    UDate ud = (at + kCFAbsoluteTimeIntervalSince1970) * 1000.0 + 0.5;
-    used = __cficu_udat_format(formatter->_df, ud, ubuffer + 1, cnt, NULL, &status);
-    if (status == U_BUFFER_OVERFLOW_ERROR || cnt < used) {
-        cnt = used + 1 + 1; // leave room for RTL marker if needed
-        ustr = (UChar *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(UChar) * cnt, 0);
-        status = U_ZERO_ERROR;
-        used = __cficu_udat_format(formatter->_df, ud, ustr + 1, cnt, NULL, &status);
+    if (formatter->_fixedFormat) {
+        char fixed[FIXED_BUFFER_SIZE];
+        CFIndex length = __CFDateFormatterFormatFixed(formatter, at, fixed);
+        if (0 <= length) return CFStringCreateWithBytes(allocator, (const UInt8 *)fixed, length, kCFStringEncodingASCII, false);
+    }
+    UniChar *ustr = NULL, ubuffer[BUFFER_SIZE + 1];
+    Boolean insertRTLMarker = __CFDateFormatterInsertsRTLMarker(formatter);
+    CFIndex used = __CFDateFormatterFormatAbsoluteTime(formatter->_df, insertRTLMarker, at, ubuffer, BUFFER_SIZE + 1);
+    if (BUFFER_SIZE + 1 < used) {
+        CFIndex cnt = used;
+        ustr = (UniChar *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(UniChar) * cnt, 0);
+        used = __CFDateFormatterFormatAbsoluteTime(formatter->_df, insertRTLMarker, at, ustr, cnt);
+        if (cnt < used) used = -1;
     }
     CFStringRef string = NULL;
-    if (U_SUCCESS(status)) {
-        UniChar *bufferToUse = ustr ? (UniChar *)ustr : (UniChar *)ubuffer;
-        if (formatter->_property._UsesCharacterDirection == kCFBooleanTrue && CFLocaleGetLanguageCharacterDirection(CFLocaleGetIdentifier(formatter->_locale)) == kCFLocaleLanguageDirectionRightToLeft) {
-            // Insert Unicode RTL marker
-            bufferToUse[0] = 0x200F;
-            used++;
-        } else {
-            // Move past direction marker
-            bufferToUse++;
-        }
-        string = CFStringCreateWithCharacters(allocator, bufferToUse, used);
+    if (0 <= used) {
+        string = CFStringCreateWithCharacters(allocator, ustr ? ustr : ubuffer, used);
     }
     if (ustr) CFAllocatorDeallocate(kCFAllocatorSystemDefault, ustr);
     return string;
@@ -1558,6 +1838,11 @@ Boolean CFDateFormatterGetAbsoluteTimeFromString(CFDateFormatterRef formatter, C
     } else {
         ustr += range.location;
     }
+    // The default date would supply the fields a fixed format leaves out
+    if (formatter->_fixedFormat && !formatter->_property._DefaultDate && __CFDateFormatterParseFixed(formatter, ustr, range.length, atp)) {
+        if (rangep) rangep->length = range.length;
+        return true;
+    }
     UDate udate;
     int32_t dpos = 0;
     UErrorCode status = U_ZERO_ERROR;
@@ -1874,6 +2159,7 @@ static void __CFDateFormatterSetProperty(CFDateFormatterRef formatter, CFStringR
 
 void CFDateFormatterSetProperty(CFDateFormatterRef formatter, CFStringRef key, CFTypeRef value) {
     __CFDateFormatterSetProperty(formatter, key, value, false);
+    __CFDateFormatterUpdateFixedFormat(formatter);
 }
 
 CFTypeRef CFDateFormatterCopyProperty(CFDateFormatterRef formatter, CFStringRef key) {
@@ -316,6 +316,8 @@ CFHashRef CFDictionaryCreateCopy(CFAllocatorRef allocator, CFHashRef other) {
         }
         if (klist != kbuffer && klist != vlist) CFAllocatorDeallocate(kCFAllocatorSystemDefault, klist);
         if (vlist != vbuffer) CFAllocatorDeallocate(kCFAllocatorSystemDefault, vlist);
+    } else if (CFBasicHashIsPersistent((CFBasicHashRef)other)) {
+        ht = CFBasicHashCreatePersistentCopy(allocator, (CFBasicHashRef)other);
     } else {
         ht = CFBasicHashCreateCopy(allocator, (CFBasicHashRef)other);
     }
@@ -360,6 +362,65 @@ CFMutableHashRef CFDictionaryCreateMutableCopy(CFAllocatorRef allocator, CFIndex
     return (CFMutableHashRef)ht;
 }
 
+#if CFDictionary || CFSet
+// Persistent collections are immutable and share their storage with the persistent collection they were derived from; see CFBasicHashCreatePersistentCopy()
+CFHashRef _CFDictionaryCreatePersistentCopy(CFAllocatorRef allocator, CFHashRef other) {
+    CFTypeID typeID = CFDictionaryGetTypeID();
+    CFAssert1(other, __kCFLogAssertion, "%s(): other CFDictionary cannot be NULL", __PRETTY_FUNCTION__);
+    __CFGenericValidateType(other, typeID);
+    CFBasicHashRef ht = NULL;
+    if (!CF_IS_OBJC(typeID, other)) ht = CFBasicHashCreatePersistentCopy(allocator, (CFBasicHashRef)other);
+    if (!ht) return CFDictionaryCreateCopy(allocator, other);
+    _CFRuntimeSetInstanceTypeIDAndIsa(ht, typeID);
+    if (__CFOASafe) __CFSetLastAllocationEventName(ht, "CFDictionary (persistent)");
+    return (CFHashRef)ht;
+}
+
+#if CFDictionary
+CFHashRef _CFDictionaryCreateCopyBySettingValue(CFAllocatorRef allocator, CFHashRef other, const_any_pointer_t key, const_any_pointer_t value) {
+#endif
+#if CFSet
+CFHashRef _CFDictionaryCreateCopyBySettingValue(CFAllocatorRef allocator, CFHashRef other, const_any_pointer_t key) {
+    const_any_pointer_t value = key;
+#endif
+    CFTypeID typeID = CFDictionaryGetTypeID();
+    CFAssert1(other, __kCFLogAssertion, "%s(): other CFDictionary cannot be NULL", __PRETTY_FUNCTION__);
+    __CFGenericValidateType(other, typeID);
+    CFBasicHashRef ht = NULL;
+    if (!CF_IS_OBJC(typeID, other)) ht = CFBasicHashCreatePersistentCopyBySettingValue(allocator, (CFBasicHashRef)other, (uintptr_t)key, (uintptr_t)value);
+    if (!ht) {
+        ht = (CFBasicHashRef)CFDictionaryCreateMutableCopy(allocator, 0, other);
+        if (!ht) return NULL;
+        CFBasicHashSetValue(ht, (uintptr_t)key, (uintptr_t)value);
+        CFBasicHashMakeImmutable(ht);
+        if (__CFOASafe) __CFSetLastAllocationEventName(ht, "CFDictionary (immutable)");
+        return (CFHashRef)ht;
+    }
+    _CFRuntimeSetInstanceTypeIDAndIsa(ht, typeID);
+    if (__CFOASafe) __CFSetLastAllocationEventName(ht, "CFDictionary (persistent)");
+    return (CFHashRef)ht;
+}
+
+CFHashRef _CFDictionaryCreateCopyByRemovingValue(CFAllocatorRef allocator, CFHashRef other, const_any_pointer_t key) {
+    CFTypeID typeID = CFDictionaryGetTypeID();
+    CFAssert1(other, __kCFLogAssertion, "%s(): other CFDictionary cannot be NULL", __PRETTY_FUNCTION__);
+    __CFGenericValidateType(other, typeID);
+    CFBasicHashRef ht = NULL;
+    if (!CF_IS_OBJC(typeID, other)) ht = CFBasicHashCreatePersistentCopyByRemovingValue(allocator, (CFBasicHashRef)other, (uintptr_t)key);
+    if (!ht) {
+        ht = (CFBasicHashRef)CFDictionaryCreateMutableCopy(allocator, 0, other);
+        if (!ht) return NULL;
+        CFBasicHashRemoveValue(ht, (uintptr_t)key);
+        CFBasicHashMakeImmutable(ht);
+        if (__CFOASafe) __CFSetLastAllocationEventName(ht, "CFDictionary (immutable)");
+        return (CFHashRef)ht;
+    }
+    _CFRuntimeSetInstanceTypeIDAndIsa(ht, typeID);
+    if (__CFOASafe) __CFSetLastAllocationEventName(ht, "CFDictionary (persistent)");
+    return (CFHashRef)ht;
+}
+#endif
+
 CFIndex CFDictionaryGetCount(CFHashRef hc) {
 #if CFDictionary
     if (CFDictionary) CF_OBJC_FUNCDISPATCHV(CFDictionaryGetTypeID(), CFIndex, (NSDictionary *)hc, count);
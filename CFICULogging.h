@@ -91,6 +91,7 @@
 #define __cficu_udat_toPatternRelativeDate udat_toPatternRelativeDate
 #define __cficu_udat_toPatternRelativeTime udat_toPatternRelativeTime
 #define __cficu_unum_applyPattern unum_applyPattern
+#define __cficu_unum_clone unum_clone
 #define __cficu_unum_close unum_close
 #define __cficu_unum_formatDecimal unum_formatDecimal
 #define __cficu_unum_formatDouble unum_formatDouble
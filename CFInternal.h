@@ -127,6 +127,7 @@ CF_EXPORT void _CFMachPortInstallNotifyPort(CFRunLoopRef rl, CFStringRef mode);
 
 
 CF_PRIVATE CFIndex __CFActiveProcessorCount();
+CF_PRIVATE void __CFApplyConcurrently(size_t count, void *context, void (*work)(void *context, size_t idx));
 
 #ifndef CLANG_ANALYZER_NORETURN
 #if __has_feature(attribute_analyzer_noreturn)
@@ -217,6 +218,7 @@ enum {
 	__CFTSDKeyRunLoopCntr = 11,
         __CFTSDKeyMachMessageBoost = 12, // valid only in the context of a CFMachPort callout
         __CFTSDKeyMachMessageHasVoucher = 13,
+	__CFTSDKeyCompiledFormatters = 14,
 	// autorelease pool stuff must be higher than run loop constants
 	__CFTSDKeyAutoreleaseData2 = 61,
 	__CFTSDKeyAutoreleaseData1 = 62,
@@ -293,6 +295,22 @@ extern CFTimeInterval __CFTSRToTimeInterval(uint64_t tsr);
 CF_PRIVATE CFTimeInterval __CFTimeIntervalUntilTSR(uint64_t tsr);
 CF_PRIVATE dispatch_time_t __CFTSRToDispatchTime(uint64_t tsr);
 CF_PRIVATE uint64_t __CFTSRToNanoseconds(uint64_t tsr);
+CF_PRIVATE int64_t __CFDaysFromGregorianYMD(int64_t year, int64_t month, int64_t day);
+CF_PRIVATE void __CFGregorianYMDFromDays(int64_t days, int64_t *year, int8_t *month, int8_t *day);
+// true if tz has the same offset from GMT at all times
+CF_PRIVATE Boolean __CFTimeZoneGetFixedOffset(CFTimeZoneRef tz, int32_t *seconds);
+// start of the first period tz knows; before it tz repeats that period's offset (-DBL_MAX if fixed)
+CF_PRIVATE CFAbsoluteTime __CFTimeZoneGetDataStart(CFTimeZoneRef tz);
+
+/* Prototype ICU objects, cached by CFLocale.c under a key naming the calendar, locale and zone
+   they were opened with.  __CFLocaleCopyCachedICUObject() returns a clone for the caller to close, or
+   NULL; __CFLocaleCacheICUObject() caches a clone of a freshly opened object. */
+enum {
+    __kCFICUCalendar = 0	// UCalendar
+};
+CF_PRIVATE void *__CFLocaleCopyCachedICUObject(CFIndex kind, const char *key);
+CF_PRIVATE void __CFLocaleCacheICUObject(CFIndex kind, const char *key, const void *object);
+CF_PRIVATE void __CFLocaleIdentifierGetCacheStatistics(CFIndex *hits, CFIndex *misses);
 
 extern CFStringRef __CFCopyFormattingDescription(CFTypeRef cf, CFDictionaryRef formatOptions);
 
@@ -308,6 +326,15 @@ extern Boolean __CFStringScanInteger(CFStringInlineBuffer *buf, CFTypeRef locale
 extern Boolean __CFStringScanDouble(CFStringInlineBuffer *buf, CFTypeRef locale, SInt32 *indexPtr, double *resultPtr); 
 extern Boolean __CFStringScanHex(CFStringInlineBuffer *buf, SInt32 *indexPtr, unsigned *result);
 
+/* Writes the shortest decimal that reads back as value, laid out as by printf's %.17g, and a
+   terminating NUL into buffer, which holds at least 32 bytes; value must be finite.  Returns the length.
+*/
+CF_PRIVATE CFIndex __CFDoubleFormatShortest(double value, char *buffer);
+/* Parses the longest prefix of chars that strtod() would, when chars holds only [0-9.eE+-];
+   returns the number of chars parsed, or 0 if strtod() must decide.
+*/
+CF_PRIVATE CFIndex __CFDoubleParseDecimal(const char *chars, CFIndex length, double *result);
+
 extern const char *__CFgetenv(const char *n);
 
 CF_PRIVATE Boolean __CFProcessIsRestricted();
@@ -522,6 +549,33 @@ CF_PRIVATE CFMutableArrayRef _CFCreateContentsOfDirectory(CFAllocatorRef alloc,
     /* alloc may be NULL */
     /* return value is CFArray of CFURLs */
 
+/* ==================== Chained byte buffer ==================== */
+/* A segmented, append-only byte buffer: a list of fixed-size chunks. Appending never moves bytes that are already in the buffer, so growing to n bytes costs O(n) total instead of the repeated realloc copies of a CFMutableData. The contents can be written to a file descriptor with writev(), or copied out contiguously in one pass when a flat copy is actually needed. The structure is meant to be embedded by value (on the stack or in a stream context); it is not thread safe. */
+
+typedef struct __CFChainedBufferChunk {
+    struct __CFChainedBufferChunk *next;
+    CFIndex length;
+    CFIndex capacity;
+    UInt8 bytes[];
+} __CFChainedBufferChunk;
+
+typedef struct {
+    CFAllocatorRef allocator;
+    __CFChainedBufferChunk *first, *last;
+    CFIndex length;	// total bytes in all chunks
+} __CFChainedBuffer;
+
+CF_PRIVATE void __CFChainedBufferInit(__CFChainedBuffer *buf, CFAllocatorRef allocator);
+CF_PRIVATE void __CFChainedBufferDestroy(__CFChainedBuffer *buf);
+CF_PRIVATE Boolean __CFChainedBufferAppendBytes(__CFChainedBuffer *buf, const UInt8 *bytes, CFIndex length);
+    /* returns false (and appends nothing) if a chunk could not be allocated */
+CF_PRIVATE void __CFChainedBufferCopyBytes(const __CFChainedBuffer *buf, UInt8 *dst);
+    /* copies all buffer->length bytes to dst */
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI || DEPLOYMENT_TARGET_LINUX
+CF_PRIVATE CFIndex __CFChainedBufferWriteToFileDescriptor(const __CFChainedBuffer *buf, int fd);
+    /* writes the whole buffer with writev(), retrying on short writes and EINTR; returns the byte count, or -1 with errno set */
+#endif
+
 CF_PRIVATE SInt32 _CFGetPathProperties(CFAllocatorRef alloc, char *path, Boolean *exists, SInt32 *posixMode, SInt64 *size, CFDateRef *modTime, SInt32 *ownerID, CFArrayRef *dirContents);
     /* alloc may be NULL */
     /* any of exists, posixMode, size, modTime, and dirContents can be NULL.  Usually it is not a good idea to pass NULL for exists, since interpretting the other values sometimes requires that you know whether the file existed or not.  Except for dirContents, it is pretty cheap to compute any of these things as loing as one of them must be computed. */
@@ -661,6 +715,48 @@ CF_PRIVATE CFComparisonResult _CFCompareStringsWithLocale(CFStringInlineBuffer *
 CF_PRIVATE CFArrayRef _CFBundleCopyUserLanguages();
 
 
+/* CF-native tagged pointers.  Where there is no ObjC runtime to supply them, 64-bit
+   Linux encodes some small immutable instances directly in the pointer value instead of
+   allocating them.  Every real CF object is at least 8-byte aligned, so a set low bit
+   marks a tagged pointer; bits 1-2 hold the tag and the upper 61 bits a payload whose
+   layout belongs to the tagged class.  Tagged instances are never retained, released or
+   deallocated, and their allocator is always kCFAllocatorSystemDefault.
+*/
+#if DEPLOYMENT_TARGET_LINUX && __LP64__
+#define CF_HAVE_TAGGED_POINTERS 1
+#else
+#define CF_HAVE_TAGGED_POINTERS 0
+#endif
+
+#if CF_HAVE_TAGGED_POINTERS
+enum {
+    __kCFTaggedObjectID_Invalid = 0,
+    __kCFTaggedObjectID_Number = 1,
+    __kCFTaggedObjectID_Date = 2,
+};
+
+#define __kCFTaggedPointerPayloadBits 61
+
+CF_INLINE Boolean __CFIsTaggedPointer(CFTypeRef cf) {
+    return ((uintptr_t)cf & 0x1) ? true : false;
+}
+
+CF_INLINE uintptr_t __CFTaggedPointerGetTag(CFTypeRef cf) {
+    return ((uintptr_t)cf >> 1) & 0x3;
+}
+
+CF_INLINE uint64_t __CFTaggedPointerGetPayload(CFTypeRef cf) {
+    return (uint64_t)(uintptr_t)cf >> 3;
+}
+
+// payload must fit in __kCFTaggedPointerPayloadBits
+CF_INLINE CFTypeRef __CFTaggedPointerCreate(uintptr_t tag, uint64_t payload) {
+    return (CFTypeRef)(uintptr_t)((payload << 3) | (tag << 1) | 0x1);
+}
+
+CF_PRIVATE CFTypeID __CFTaggedPointerGetTypeID(CFTypeRef cf);
+#endif
+
 // This should only be used in CF types, not toll-free bridged objects!
 // It should not be used with CFAllocator arguments!
 // Use CFGetAllocator() in the general case, and this inline function in a few limited (but often called) situations.
@@ -669,6 +765,11 @@ CF_INLINE CFAllocatorRef __CFGetAllocator(CFTypeRef cf) {	// !!! Use with CF typ
     if (_objc_isTaggedPointer(cf)) {
         return kCFAllocatorSystemDefault;
     }
+#endif
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(cf)) {
+        return kCFAllocatorSystemDefault;
+    }
 #endif
     if (__builtin_expect(__CFBitfieldGetValue(((const CFRuntimeBase *)cf)->_cfinfo[CF_INFO_BITS], 7, 7), 1)) {
 	return kCFAllocatorSystemDefault;
@@ -35,6 +35,7 @@
 #include <CoreFoundation/CFPreferences.h>
 #include <CoreFoundation/CFCalendar.h>
 #include <CoreFoundation/CFNumber.h>
+#include <CoreFoundation/CFPriv.h>
 #include "CFInternal.h"
 #include "CFLocaleInternal.h"
 #if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_WINDOWS || DEPLOYMENT_TARGET_LINUX
@@ -1355,5 +1356,133 @@ static bool __CFLocaleNoName(const char *locale, const char *value, CFStringRef
     return false;
 }
 
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_WINDOWS || DEPLOYMENT_TARGET_LINUX
+
+// Prototypes of ICU calendars, as first opened for a calendar, locale and zone.  Opening
+// loads and parses locale data; cloning a prototype only copies it.  ICU formatters are
+// not cached, as cloning one costs about as much as opening it.  Entries are replaced
+// least recently used first.  A prototype is cloned outside the lock, which is safe as
+// ucal_clone() only reads it, so each holds a reference for every clone in progress and
+// is closed when the last one goes.
+#define kCFICUPrototypeCacheSize 32
+#define kCFICUPrototypeKeySize 240
+
+typedef struct {
+    int32_t _refs;
+    CFIndex _kind;
+    void *_object;
+    char _key[kCFICUPrototypeKeySize];
+} __CFICUPrototype;
+
+static __CFICUPrototype *__CFICUPrototypes[kCFICUPrototypeCacheSize];
+static uint32_t __CFICUPrototypeLastUse[kCFICUPrototypeCacheSize];
+static uint32_t __CFICUPrototypeClock = 0;
+static CFIndex __CFICUPrototypeHits = 0;
+static CFIndex __CFICUPrototypeMisses = 0;
+static CFLock_t __CFICUPrototypeLock = CFLockInit;
+
+static void __CFICUObjectClose(CFIndex kind, void *object) {
+    switch (kind) {
+    case __kCFICUCalendar: ucal_close((UCalendar *)object); break;
+    }
+}
+
+static void *__CFICUObjectClone(CFIndex kind, const void *object) {
+    UErrorCode status = U_ZERO_ERROR;
+    void *clone = NULL;
+    switch (kind) {
+    case __kCFICUCalendar: clone = ucal_clone((const UCalendar *)object, &status); break;
+    }
+    if (clone && U_FAILURE(status)) {
+	__CFICUObjectClose(kind, clone);
+	clone = NULL;
+    }
+    return clone;
+}
+
+static void __CFICUPrototypeRelease(__CFICUPrototype *prototype) {
+    __CFLock(&__CFICUPrototypeLock);
+    int32_t refs = --prototype->_refs;
+    __CFUnlock(&__CFICUPrototypeLock);
+    if (0 == refs) {
+	__CFICUObjectClose(prototype->_kind, prototype->_object);
+	CFAllocatorDeallocate(kCFAllocatorSystemDefault, prototype);
+    }
+}
+
+CF_PRIVATE void *__CFLocaleCopyCachedICUObject(CFIndex kind, const char *key) {
+    __CFICUPrototype *prototype = NULL;
+    __CFLock(&__CFICUPrototypeLock);
+    for (CFIndex idx = 0; idx < kCFICUPrototypeCacheSize; idx++) {
+	__CFICUPrototype *candidate = __CFICUPrototypes[idx];
+	if (candidate && candidate->_kind == kind && 0 == strcmp(candidate->_key, key)) {
+	    prototype = candidate;
+	    prototype->_refs++;
+	    __CFICUPrototypeLastUse[idx] = ++__CFICUPrototypeClock;
+	    break;
+	}
+    }
+    if (prototype) __CFICUPrototypeHits++; else __CFICUPrototypeMisses++;
+    __CFUnlock(&__CFICUPrototypeLock);
+    if (!prototype) return NULL;
+    void *clone = __CFICUObjectClone(kind, prototype->_object);
+    __CFICUPrototypeRelease(prototype);
+    return clone;
+}
+
+CF_PRIVATE void __CFLocaleCacheICUObject(CFIndex kind, const char *key, const void *object) {
+    if (kCFICUPrototypeKeySize <= strlen(key)) return;
+    __CFICUPrototype *prototype = (__CFICUPrototype *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(__CFICUPrototype), 0);
+    if (!prototype) return;
+    prototype->_object = __CFICUObjectClone(kind, object);
+    if (!prototype->_object) {
+	CFAllocatorDeallocate(kCFAllocatorSystemDefault, prototype);
+	return;
+    }
+    prototype->_refs = 1;
+    prototype->_kind = kind;
+    strlcpy(prototype->_key, key, kCFICUPrototypeKeySize);
+    __CFICUPrototype *evicted = NULL;
+    __CFLock(&__CFICUPrototypeLock);
+    CFIndex victim = 0;
+    for (CFIndex idx = 0; idx < kCFICUPrototypeCacheSize; idx++) {
+	__CFICUPrototype *candidate = __CFICUPrototypes[idx];
+	if (!candidate) {
+	    victim = idx;
+	    break;
+	}
+	if (candidate->_kind == kind && 0 == strcmp(candidate->_key, key)) {
+	    // another thread got here first
+	    victim = kCFNotFound;
+	    break;
+	}
+	if ((int32_t)(__CFICUPrototypeLastUse[idx] - __CFICUPrototypeLastUse[victim]) < 0) victim = idx;
+    }
+    if (kCFNotFound != victim) {
+	evicted = __CFICUPrototypes[victim];
+	__CFICUPrototypes[victim] = prototype;
+	__CFICUPrototypeLastUse[victim] = ++__CFICUPrototypeClock;
+    } else {
+	evicted = prototype;
+    }
+    __CFUnlock(&__CFICUPrototypeLock);
+    if (evicted) __CFICUPrototypeRelease(evicted);
+}
+
+#endif
+
+void _CFLocaleGetCacheStatistics(_CFLocaleCacheStatistics *statistics) {
+    __CFLocaleIdentifierGetCacheStatistics(&statistics->identifierHits, &statistics->identifierMisses);
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_WINDOWS || DEPLOYMENT_TARGET_LINUX
+    __CFLock(&__CFICUPrototypeLock);
+    statistics->icuHits = __CFICUPrototypeHits;
+    statistics->icuMisses = __CFICUPrototypeMisses;
+    __CFUnlock(&__CFICUPrototypeLock);
+#else
+    statistics->icuHits = 0;
+    statistics->icuMisses = 0;
+#endif
+}
+
 #undef kMaxICUNameSize
 
@@ -1867,9 +1867,98 @@ CFStringRef CFLocaleCreateCanonicalLanguageIdentifierFromString(CFAllocatorRef a
 }
 
 
+// Identifiers canonicalized lately, so that creating locales again and again from the same
+// few identifiers does not redo the table lookups and string surgery each time.  Entries are
+// replaced least recently used first.
+#define kCFLocaleIdentifierCacheSize 64
+
+typedef struct {
+    CFStringRef key;		// NULL for an empty entry
+    CFStringRef result;
+    CFHashCode hash;
+    uint32_t lastUse;
+} __CFLocaleIdentifierCacheEntry;
+
+static __CFLocaleIdentifierCacheEntry __CFLocaleIdentifierCache[kCFLocaleIdentifierCacheSize];
+static uint32_t __CFLocaleIdentifierCacheClock = 0;
+static CFIndex __CFLocaleIdentifierCacheHits = 0;
+static CFIndex __CFLocaleIdentifierCacheMisses = 0;
+static CFLock_t __CFLocaleIdentifierCacheLock = CFLockInit;
+
+// Returns the cached canonical form of localeIdentifier, retained, or NULL
+static CFStringRef __CFLocaleIdentifierCacheCopy(CFStringRef localeIdentifier, CFHashCode hash) {
+    CFStringRef result = NULL;
+    __CFLock(&__CFLocaleIdentifierCacheLock);
+    for (CFIndex idx = 0; idx < kCFLocaleIdentifierCacheSize; idx++) {
+	__CFLocaleIdentifierCacheEntry *entry = &__CFLocaleIdentifierCache[idx];
+	if (entry->key && entry->hash == hash && CFEqual(entry->key, localeIdentifier)) {
+	    entry->lastUse = ++__CFLocaleIdentifierCacheClock;
+	    result = (CFStringRef)CFRetain(entry->result);
+	    break;
+	}
+    }
+    if (result) __CFLocaleIdentifierCacheHits++; else __CFLocaleIdentifierCacheMisses++;
+    __CFUnlock(&__CFLocaleIdentifierCacheLock);
+    return result;
+}
+
+static void __CFLocaleIdentifierCacheAdd(CFStringRef localeIdentifier, CFHashCode hash, CFStringRef result) {
+    // the cache outlives the caller's allocator and any later mutation of the caller's string
+    CFStringRef key = CFStringCreateCopy(kCFAllocatorSystemDefault, localeIdentifier);
+    result = CFStringCreateCopy(kCFAllocatorSystemDefault, result);
+    CFStringRef oldKey = NULL, oldResult = NULL;
+    __CFLock(&__CFLocaleIdentifierCacheLock);
+    __CFLocaleIdentifierCacheEntry *victim = &__CFLocaleIdentifierCache[0];
+    for (CFIndex idx = 0; idx < kCFLocaleIdentifierCacheSize; idx++) {
+	__CFLocaleIdentifierCacheEntry *entry = &__CFLocaleIdentifierCache[idx];
+	if (!entry->key) {
+	    victim = entry;
+	    break;
+	}
+	if (entry->hash == hash && CFEqual(entry->key, key)) {
+	    // another thread got here first
+	    victim = NULL;
+	    break;
+	}
+	if ((int32_t)(entry->lastUse - victim->lastUse) < 0) victim = entry;
+    }
+    if (victim) {
+	oldKey = victim->key;
+	oldResult = victim->result;
+	victim->key = key;
+	victim->result = result;
+	victim->hash = hash;
+	victim->lastUse = ++__CFLocaleIdentifierCacheClock;
+	key = result = NULL;
+    }
+    __CFUnlock(&__CFLocaleIdentifierCacheLock);
+    if (key) CFRelease(key);
+    if (result) CFRelease(result);
+    if (oldKey) CFRelease(oldKey);
+    if (oldResult) CFRelease(oldResult);
+}
+
+CF_PRIVATE void __CFLocaleIdentifierGetCacheStatistics(CFIndex *hits, CFIndex *misses) {
+    __CFLock(&__CFLocaleIdentifierCacheLock);
+    *hits = __CFLocaleIdentifierCacheHits;
+    *misses = __CFLocaleIdentifierCacheMisses;
+    __CFUnlock(&__CFLocaleIdentifierCacheLock);
+}
+
 CFStringRef CFLocaleCreateCanonicalLocaleIdentifierFromString(CFAllocatorRef allocator, CFStringRef localeIdentifier) {
     char            inLocaleString[kLocaleIdentifierCStringMax];
     CFStringRef     outStringRef = NULL;
+    CFHashCode      hash = 0;
+
+    if (localeIdentifier) {
+        hash = CFHash(localeIdentifier);
+        CFStringRef cached = __CFLocaleIdentifierCacheCopy(localeIdentifier, hash);
+        if (cached) {
+            outStringRef = CFStringCreateCopy(allocator, cached);
+            CFRelease(cached);
+            return outStringRef;
+        }
+    }
     
     if ( localeIdentifier && CFStringGetCString(localeIdentifier, inLocaleString,  sizeof(inLocaleString), kCFStringEncodingASCII) ) {
         KeyStringToResultString     testEntry;
@@ -1933,6 +2022,7 @@ CFStringRef CFLocaleCreateCanonicalLocaleIdentifierFromString(CFAllocatorRef all
         
         // Now create the CFString (even if empty!)
         outStringRef = CFStringCreateWithCString(allocator, inLocaleString, kCFStringEncodingASCII);
+        if (outStringRef) __CFLocaleIdentifierCacheAdd(localeIdentifier, hash, outStringRef);
     }
 
     return outStringRef;
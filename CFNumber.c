@@ -106,39 +106,6 @@ Boolean CFBooleanGetValue(CFBooleanRef boolean) {
 
 /*** CFNumber ***/
 
-#define OLD_CRAP_TOO 0
-
-#if OLD_CRAP_TOO
-
-// old implementation, for runtime comparison purposes
-
-typedef union {
-    SInt32 valSInt32;
-    int64_t valSInt64;
-    Float32 valFloat32;
-    Float64 valFloat64;
-} __CFNumberValue_old;
-
-struct __CFNumber_old {             /* Only as many bytes as necessary are allocated */
-    CFRuntimeBase _base;
-    __CFNumberValue_old value;
-};
-
-static Boolean __CFNumberEqual_old(CFTypeRef cf1, CFTypeRef cf2);
-static CFHashCode __CFNumberHash_old(CFTypeRef cf);
-static CFStringRef __CFNumberCopyDescription_old(CFTypeRef cf);
-CF_PRIVATE CFStringRef __CFNumberCopyFormattingDescriptionAsFloat64_old(CFTypeRef cf);
-static CFStringRef __CFNumberCopyFormattingDescription_old(CFTypeRef cf, CFDictionaryRef formatOptions);
-static struct __CFNumber_old * CFNumberCreate_old(CFAllocatorRef allocator, CFNumberType type, const void *valuePtr);
-static CFNumberType CFNumberGetType_old(struct __CFNumber_old * number);
-static CFIndex CFNumberGetByteSize_old(struct __CFNumber_old * number);
-static Boolean CFNumberIsFloatType_old(struct __CFNumber_old * number);
-static Boolean CFNumberGetValue_old(struct __CFNumber_old * number, CFNumberType type, void *valuePtr);
-static CFComparisonResult CFNumberCompare_old(struct __CFNumber_old * number1, struct __CFNumber_old * number2, void *context);
-
-#endif
-
-
 #define __CFAssertIsNumber(cf) __CFGenericValidateType(cf, CFNumberGetTypeID())
 #define __CFAssertIsValidNumberType(type) CFAssert2((0 < type && type <= kCFNumberMaxType) || (type == kCFNumberSInt128Type), __kCFLogAssertion, "%s(): bad CFNumber type %d", __PRETTY_FUNCTION__, type);
 
@@ -152,10 +119,14 @@ static CFComparisonResult CFNumberCompare_old(struct __CFNumber_old * number1, s
 #define BITSFORDOUBLENEGINF	((uint64_t)0xfff0000000000000ULL)
 
 #if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI || DEPLOYMENT_TARGET_LINUX
+#define FLOAT_NEGATIVE_2_TO_THE_63	-0x1.0p+63L
+#define FLOAT_POSITIVE_2_TO_THE_63	0x1.0p+63L
 #define FLOAT_POSITIVE_2_TO_THE_64	0x1.0p+64L
 #define FLOAT_NEGATIVE_2_TO_THE_127	-0x1.0p+127L
 #define FLOAT_POSITIVE_2_TO_THE_127	0x1.0p+127L
 #elif DEPLOYMENT_TARGET_WINDOWS
+#define FLOAT_NEGATIVE_2_TO_THE_63	-9223372036854775808.0
+#define FLOAT_POSITIVE_2_TO_THE_63	9223372036854775808.0
 #define FLOAT_POSITIVE_2_TO_THE_64	18446744073709551616.0
 #define FLOAT_NEGATIVE_2_TO_THE_127	-170141183460469231731687303715884105728.0
 #define FLOAT_POSITIVE_2_TO_THE_127	170141183460469231731687303715884105728.0
@@ -354,10 +325,6 @@ static void cvtFloat64ToSInt128(CFSInt128Struct *out, const Float64 *in) {
 
 struct __CFNumber {
     CFRuntimeBase _base;
-#if OLD_CRAP_TOO
-    struct __CFNumber_old *__old__;
-    void * __dummy__;
-#endif
     uint64_t _pad; // need this space here for the constant objects
     /* 0 or 8 more bytes allocated here */
 };
@@ -367,6 +334,19 @@ struct __CFNumber {
     Bits 4..0: CFNumber type
 */
 
+#define MinCachedInt (-1)
+#define MaxCachedInt (12)
+#define NotToBeCached (MinCachedInt - 1)
+
+#if CF_HAVE_TAGGED_POINTERS
+/* Tagged CFNumber payload (see CFInternal.h):
+    Bits 60..5: value; a sign-extended integer, the Float32 bits, or the top 56 Float64 bits
+    Bits 4..0: CFNumber type, as in the base bits above
+*/
+#define __CFTaggedNumberMinInt (-(1LL << 55))
+#define __CFTaggedNumberMaxInt ((1LL << 55) - 1)
+#endif
+
 static struct __CFNumber __kCFNumberNaN = {
     INIT_CFRUNTIME_BASE(), 0ULL
 };
@@ -424,9 +404,70 @@ static const struct {
 };
 
 CF_INLINE CFNumberType __CFNumberGetType(CFNumberRef num) {
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(num)) return (CFNumberType)(__CFTaggedPointerGetPayload(num) & 0x1F);
+#endif
     return __CFBitfieldGetValue(num->_base._cfinfo[CF_INFO_BITS], 4, 0);
 }
 
+// Returns the number's value storage; a tagged number is unpacked into *buffer, laid out as _pad would be
+CF_INLINE const void *__CFNumberGetValueStorage(CFNumberRef num, uint64_t *buffer) {
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(num)) {
+	switch (__CFNumberGetType(num)) {
+	case kCFNumberFloat32Type: {
+	    uint32_t bits = (uint32_t)((uintptr_t)num >> 8);
+	    *buffer = 0;
+	    memmove(buffer, &bits, 4);
+	    break;
+	}
+	case kCFNumberFloat64Type: *buffer = ((uint64_t)(uintptr_t)num >> 8) << 8; break;
+	default: *buffer = (uint64_t)((int64_t)(intptr_t)num >> 8); break;
+	}
+	return buffer;
+    }
+#endif
+    return &(num->_pad);
+}
+
+#if CF_HAVE_TAGGED_POINTERS
+// Returns NULL when the value has no tagged representation. Integers from MinCachedInt to MaxCachedInt are typed
+// kCFNumberSInt32Type when normalize is true, as cached numbers are, so their type does not depend on how they were created
+static CFNumberRef __CFNumberCreateTagged(CFNumberType type, const void *valuePtr, Boolean normalize) {
+    CFNumberType canonicalType = __CFNumberTypeTable[type].canonicalType;
+    uint64_t value;
+    switch (canonicalType) {
+    case kCFNumberSInt8Type:   value = (uint64_t)(int64_t)*(int8_t *)valuePtr; break;
+    case kCFNumberSInt16Type:  value = (uint64_t)(int64_t)*(int16_t *)valuePtr; break;
+    case kCFNumberSInt32Type:  value = (uint64_t)(int64_t)*(int32_t *)valuePtr; break;
+    case kCFNumberSInt64Type: {
+	int64_t val;
+	memmove(&val, valuePtr, 8);
+	if (val < __CFTaggedNumberMinInt || __CFTaggedNumberMaxInt < val) return NULL;
+	value = (uint64_t)val;
+	break;
+    }
+    case kCFNumberFloat32Type: {
+	uint32_t bits;
+	memmove(&bits, valuePtr, 4);
+	value = bits;
+	break;
+    }
+    case kCFNumberFloat64Type: {
+	uint64_t bits;
+	memmove(&bits, valuePtr, 8);
+	if (bits & 0xFF) return NULL;	// would lose low mantissa bits
+	value = bits >> 8;
+	break;
+    }
+    default: return NULL;
+    }
+    if (normalize && !__CFNumberTypeTable[canonicalType].floatBit && MinCachedInt <= (int64_t)value && (int64_t)value <= MaxCachedInt) canonicalType = kCFNumberSInt32Type;
+    uint64_t payload = ((value << 5) | canonicalType) & ((1ULL << __kCFTaggedPointerPayloadBits) - 1);
+    return (CFNumberRef)__CFTaggedPointerCreate(__kCFTaggedObjectID_Number, payload);
+}
+#endif
+
 #define CVT(SRC_TYPE, DST_TYPE, DST_MIN, DST_MAX) do { \
 	SRC_TYPE sv; memmove(&sv, data, sizeof(SRC_TYPE)); \
 	DST_TYPE dv = (sv < DST_MIN) ? (DST_TYPE)DST_MIN : (DST_TYPE)(((DST_MAX < sv) ? DST_MAX : sv)); \
@@ -454,7 +495,8 @@ CF_INLINE CFNumberType __CFNumberGetType(CFNumberRef num) {
 static Boolean __CFNumberGetValue(CFNumberRef number, CFNumberType type, void *valuePtr) {
     type = __CFNumberTypeTable[type].canonicalType;
     CFNumberType ntype = __CFNumberGetType(number);
-    const void *data = &(number->_pad);
+    uint64_t unpacked;
+    const void *data = __CFNumberGetValueStorage(number, &unpacked);
     switch (type) {
     case kCFNumberSInt8Type:
 	if (__CFNumberTypeTable[ntype].floatBit) {
@@ -644,7 +686,8 @@ static Boolean __CFNumberGetValue(CFNumberRef number, CFNumberType type, void *v
 static Boolean __CFNumberGetValueCompat(CFNumberRef number, CFNumberType type, void *valuePtr) {
     type = __CFNumberTypeTable[type].canonicalType;
     CFNumberType ntype = __CFNumberGetType(number);
-    const void *data = &(number->_pad);
+    uint64_t unpacked;
+    const void *data = __CFNumberGetValueStorage(number, &unpacked);
     switch (type) {
     case kCFNumberSInt8Type:
 	if (__CFNumberTypeTable[ntype].floatBit) {
@@ -802,9 +845,6 @@ static Boolean __CFNumberGetValueCompat(CFNumberRef number, CFNumberType type, v
     return false;
 }
 
-#if OLD_CRAP_TOO
-static void FAIL(void) {}
-#endif
 
 static CFStringRef __CFNumberCopyDescription(CFTypeRef cf) {
     CFNumberRef number = (CFNumberRef)cf;
@@ -844,22 +884,29 @@ static CFStringRef __CFNumberCopyDescription(CFTypeRef cf) {
 	}
 	CFStringAppendFormat(mstr, NULL, CFSTR("%s, type = %s}"), buffer, typeName);
     }
-#if OLD_CRAP_TOO
-if (! number->__old__) {
-
-printf("*** Test skipped in __CFNumberCopyDescription for number %p\n", cf);
-} else {
-CFStringRef test = __CFNumberCopyDescription_old(number->__old__);
-if (!CFEqual(test, mstr)) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL in __CFNumberCopyDescription: '%@' '%@'"), test, mstr);  FAIL();
-}
-}
-#endif
     return mstr;
 }
 
 // This function separated out from __CFNumberCopyFormattingDescription() so the plist creation can use it as well.
 
+// Writes the formatting description of d into buffer, which holds at least 32 bytes, as a C string; returns its length.
+CF_PRIVATE CFIndex __CFNumberGetFormattingDescriptionAsFloat64CString(Float64 d, char *buffer) {
+    const char *special = NULL;
+    if (isnan(d)) {
+	special = "nan";
+    } else if (isinf(d)) {
+	special = (0.0 < d) ? "+infinity" : "-infinity";
+    } else if (0.0 == d) {
+	special = "0.0";
+    }
+    if (special) {
+	strlcpy(buffer, special, 32);
+	return strlen(special);
+    }
+    // the shortest digits that read back as d; "%.*g" with DBL_DIG + 2 gave 17, often one too many
+    return __CFDoubleFormatShortest(d, buffer);
+}
+
 static CFStringRef __CFNumberCreateFormattingDescriptionAsFloat64(CFAllocatorRef allocator, CFTypeRef cf) {
     Float64 d;
     CFNumberGetValue((CFNumberRef)cf, kCFNumberFloat64Type, &d);
@@ -872,24 +919,13 @@ static CFStringRef __CFNumberCreateFormattingDescriptionAsFloat64(CFAllocatorRef
     if (0.0 == d) {
 	return (CFStringRef)CFRetain(CFSTR("0.0"));
     }
-    // if %g is used here, need to use DBL_DIG + 2 on Mac OS X, but %f needs +1
-    return CFStringCreateWithFormat(allocator, NULL, CFSTR("%.*g"), DBL_DIG + 2, d);
+    char buffer[32];
+    CFIndex length = __CFDoubleFormatShortest(d, buffer);
+    return CFStringCreateWithBytes(allocator, (const UInt8 *)buffer, length, kCFStringEncodingASCII, false);
 }
 
 CF_PRIVATE CFStringRef __CFNumberCopyFormattingDescriptionAsFloat64(CFTypeRef cf) {
-    CFStringRef result = __CFNumberCreateFormattingDescriptionAsFloat64(kCFAllocatorSystemDefault, cf);
-#if OLD_CRAP_TOO
-CFNumberRef number = (CFNumberRef)cf;
-if (! number->__old__) {
-printf("*** Test skipped in __CFNumberCopyFormattingDescriptionAsFloat64 for number %p\n", cf);
-} else {
-CFStringRef test = __CFNumberCopyFormattingDescriptionAsFloat64_old(number->__old__);
-if (!CFEqual(test, result)) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL in __CFNumberCopyFormattingDescriptionAsFloat64: '%@' '%@'"), test, result);  FAIL();
-}
-}
-#endif
-    return result;
+    return __CFNumberCreateFormattingDescriptionAsFloat64(kCFAllocatorSystemDefault, cf);
 }
 
 CF_PRIVATE CFStringRef __CFNumberCreateFormattingDescription(CFAllocatorRef allocator, CFTypeRef cf, CFDictionaryRef formatOptions) {
@@ -905,84 +941,157 @@ CF_PRIVATE CFStringRef __CFNumberCreateFormattingDescription(CFAllocatorRef allo
     return CFStringCreateWithFormat(allocator, NULL, CFSTR("%s"), buffer);
 }
 
-static CFStringRef __CFNumberCopyFormattingDescription_new(CFTypeRef cf, CFDictionaryRef formatOptions) {
-    CFNumberRef number = (CFNumberRef)cf;
-    CFNumberType type = __CFNumberGetType(number);
-    if (__CFNumberTypeTable[type].floatBit) {
-        return __CFNumberCopyFormattingDescriptionAsFloat64(number);
-    }
-    CFSInt128Struct i;
-    __CFNumberGetValue(number, kCFNumberSInt128Type, &i);
-    char buffer[128];
-    emit128(buffer, &i, false);
-    return CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("%s"), buffer);
-}
-
 CF_PRIVATE CFStringRef __CFNumberCopyFormattingDescription(CFTypeRef cf, CFDictionaryRef formatOptions) {
-    CFStringRef result = __CFNumberCopyFormattingDescription_new(cf, formatOptions);
-#if OLD_CRAP_TOO
-CFNumberRef number = (CFNumberRef)cf;
-if (! number->__old__) {
-printf("*** Test skipped in __CFNumberCopyFormattingDescription for number %p\n", cf);
-} else {
-CFStringRef test = __CFNumberCopyFormattingDescription_old(number->__old__, formatOptions);
-if (!CFEqual(test, result)) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL in __CFNumberCopyFormattingDescription: '%@' '%@'"), test, result);  FAIL();
-}
-}
-#endif
-    return result;
+    return __CFNumberCreateFormattingDescription(kCFAllocatorSystemDefault, cf, formatOptions);
 }
 
 
-static Boolean __CFNumberEqual(CFTypeRef cf1, CFTypeRef cf2) {
-    Boolean b = CFNumberCompare((CFNumberRef)cf1, (CFNumberRef)cf2, 0) == kCFCompareEqualTo;
-#if OLD_CRAP_TOO
-CFNumberRef number1 = (CFNumberRef)cf1;
-CFNumberRef number2 = (CFNumberRef)cf2;
-if (! number1->__old__ || !number2->__old__) {
-printf("*** Test skipped in __CFNumberEqual for numbers %p %p\n", cf1, cf2);
-} else {
-Boolean b2 = __CFNumberEqual_old(number1->__old__, number2->__old__);
-if (b2 != b) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL in __CFNumberEqual: '%d' '%d'"), b2, b);  FAIL();
+// The value of a number stored as Float32 or Float64
+CF_INLINE Float64 __CFNumberGetFloat64(CFNumberType type, const void *data) {
+    if (kCFNumberFloat64Type == type) {
+	Float64 d;
+	memmove(&d, data, 8);
+	return d;
+    }
+    Float32 f;
+    memmove(&f, data, 4);
+    return (Float64)f;
+}
+
+// Compares d with i exactly, as 128-bit integers would, but without the conversions
+static CFComparisonResult __CFNumberCompareFloat64ToSInt64(Float64 d, int64_t i) {
+    // NaN is less than zero and the positive integers, and greater than the negative ones
+    if (isnan(d)) return (i < 0) ? kCFCompareGreaterThan : kCFCompareLessThan;
+    if (d < FLOAT_NEGATIVE_2_TO_THE_63) return kCFCompareLessThan;
+    if (FLOAT_POSITIVE_2_TO_THE_63 <= d) return kCFCompareGreaterThan;
+    int64_t t = (int64_t)d;	// truncated toward zero, and exact in this range
+    if (t != i) return (t < i) ? kCFCompareLessThan : kCFCompareGreaterThan;
+    Float64 fraction = d - (Float64)t;
+    if (fraction < 0.0) return kCFCompareLessThan;
+    if (0.0 < fraction) return kCFCompareGreaterThan;
+    // -0.0 is less than 0, as it is less than +0.0
+    return (0 == i && copysign(1.0, d) < 0.0) ? kCFCompareLessThan : kCFCompareEqualTo;
+}
+
+static CFComparisonResult __CFNumberCompareFloat64ToSInt128(Float64 d1, const CFSInt128Struct *i2) {
+    if (isnan(d1)) return isNeg128(i2) ? kCFCompareGreaterThan : kCFCompareLessThan;
+    // At large integer values, the precision of double is quite low
+    // e.g. all values roughly 2^127 +- 2^73 are represented by 1 double, 2^127.
+    // If we just used double compare, that would make the 2^73 largest 128-bit
+    // integers look equal, so we have to use integer comparison when possible.
+    // if the double value is really big, cannot be equal to integer
+    if (d1 < FLOAT_NEGATIVE_2_TO_THE_127) return kCFCompareLessThan;
+    if (FLOAT_POSITIVE_2_TO_THE_127 <= d1) return kCFCompareGreaterThan;
+    CFSInt128Struct i1;
+    cvtFloat64ToSInt128(&i1, &d1);
+    CFComparisonResult res = cmp128(&i1, i2);
+    if (kCFCompareEqualTo != res) return res;
+    // now things are equal, but perhaps due to rounding
+    double s1 = copysign(1.0, d1);
+    double s2 = isNeg128(i2) ? -1.0 : 1.0;
+    if (s1 < s2) return kCFCompareLessThan;
+    if (s2 < s1) return kCFCompareGreaterThan;
+    // at this point, we know the signs are the same; do not combine these tests
+    Float64 d2;
+    cvtSInt128ToFloat64(&d2, i2);
+    if (d1 < d2) return kCFCompareLessThan;
+    if (d2 < d1) return kCFCompareGreaterThan;
+    return kCFCompareEqualTo;
 }
+
+static CFComparisonResult __CFNumberCompare(CFNumberRef number1, CFNumberRef number2) {
+    CFNumberType type1 = __CFNumberGetType(number1);
+    CFNumberType type2 = __CFNumberGetType(number2);
+    uint64_t unpacked1, unpacked2;
+    const void *data1 = __CFNumberGetValueStorage(number1, &unpacked1);
+    const void *data2 = __CFNumberGetValueStorage(number2, &unpacked2);
+    Boolean float1 = __CFNumberTypeTable[type1].floatBit, float2 = __CFNumberTypeTable[type2].floatBit;
+    // Both numbers are integers; all but SInt128 are stored as SInt64
+    if (!float1 && !float2) {
+	if (kCFNumberSInt128Type != type1 && kCFNumberSInt128Type != type2) {
+	    int64_t i1, i2;
+	    memmove(&i1, data1, 8);
+	    memmove(&i2, data2, 8);
+	    return (i1 < i2) ? kCFCompareLessThan : (i2 < i1) ? kCFCompareGreaterThan : kCFCompareEqualTo;
+	}
+        CFSInt128Struct i1, i2;
+        __CFNumberGetValue(number1, kCFNumberSInt128Type, &i1);
+        __CFNumberGetValue(number2, kCFNumberSInt128Type, &i2);
+        return cmp128(&i1, &i2);
+    }
+    // Both numbers are floats
+    if (float1 && float2) {
+	Float64 d1 = __CFNumberGetFloat64(type1, data1);
+	Float64 d2 = __CFNumberGetFloat64(type2, data2);
+	double s1 = copysign(1.0, d1);
+	double s2 = copysign(1.0, d2);
+	if (isnan(d1) && isnan(d2)) return kCFCompareEqualTo;
+	if (isnan(d1)) return (s2 < 0.0) ? kCFCompareGreaterThan : kCFCompareLessThan;
+	if (isnan(d2)) return (s1 < 0.0) ? kCFCompareLessThan : kCFCompareGreaterThan;
+	// at this point, we know we don't have any NaNs
+	if (s1 < s2) return kCFCompareLessThan;
+	if (s2 < s1) return kCFCompareGreaterThan;
+	// at this point, we know the signs are the same; do not combine these tests
+	if (d1 < d2) return kCFCompareLessThan;
+	if (d2 < d1) return kCFCompareGreaterThan;
+        return kCFCompareEqualTo;
+    }
+    // One float, one integer; swap if necessary so number1 is the float
+    Boolean swapResult = false;
+    if (float2) {
+	CFNumberType tmpType = type1;
+	const void *tmpData = data1;
+	type1 = type2;
+	data1 = data2;
+	type2 = tmpType;
+	data2 = tmpData;
+	swapResult = true;
+    }
+    Float64 d1 = __CFNumberGetFloat64(type1, data1);
+    CFComparisonResult res;
+    if (kCFNumberSInt128Type != type2) {
+	int64_t i2;
+	memmove(&i2, data2, 8);
+	res = __CFNumberCompareFloat64ToSInt64(d1, i2);
+    } else {
+	CFSInt128Struct i2;
+	memmove(&i2, data2, 16);
+	res = __CFNumberCompareFloat64ToSInt128(d1, &i2);
+    }
+    return !swapResult ? res : -res;
 }
-#endif
-    return b;
+
+static Boolean __CFNumberEqual(CFTypeRef cf1, CFTypeRef cf2) {
+    return __CFNumberCompare((CFNumberRef)cf1, (CFNumberRef)cf2) == kCFCompareEqualTo;
 }
 
 static CFHashCode __CFNumberHash(CFTypeRef cf) {
-    CFHashCode h;
     CFNumberRef number = (CFNumberRef)cf;
-    switch (__CFNumberGetType(number)) {
+    CFNumberType type = __CFNumberGetType(number);
+    uint64_t unpacked;
+    const void *data = __CFNumberGetValueStorage(number, &unpacked);
+    switch (type) {
 	case kCFNumberSInt8Type:
 	case kCFNumberSInt16Type:
-	case kCFNumberSInt32Type: {
-	    SInt32 i;
-	    __CFNumberGetValue(number, kCFNumberSInt32Type, &i);
-	    h = _CFHashInt(i);
-	    break;
+	case kCFNumberSInt32Type:
+	case kCFNumberSInt64Type: {
+	    int64_t i;
+	    memmove(&i, data, 8);
+	    // below 2^52 in magnitude, _CFHashDouble() of an integer is _CFHashInt() of it
+	    if (-(1LL << 52) < i && i < (1LL << 52) && LONG_MIN < i && i <= LONG_MAX) return _CFHashInt((long)i);
+	    return _CFHashDouble((double)i);
 	}
+	case kCFNumberFloat32Type:
+	case kCFNumberFloat64Type:
+	    return _CFHashDouble(__CFNumberGetFloat64(type, data));
 	default: {
+	    CFSInt128Struct i;
 	    Float64 d;
-	    __CFNumberGetValue(number, kCFNumberFloat64Type, &d);
-	    h = _CFHashDouble((double)d);
-	    break;
+	    memmove(&i, data, 16);
+	    cvtSInt128ToFloat64(&d, &i);
+	    return _CFHashDouble(d);
 	}
     }
-#if OLD_CRAP_TOO
-CFNumberRef number1 = (CFNumberRef)cf;
-if (! number1->__old__) {
-printf("*** Test skipped in __CFNumberHash for number %p\n", cf);
-} else {
-CFHashCode h2 = __CFNumberHash_old(number1->__old__);
-if (h2 != h) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL in __CFNumberHash: '%d' '%d'"), h2, h);  FAIL();
-}
-}
-#endif
-    return h;
 }
 
 static CFTypeID __kCFNumberTypeID = _kCFRuntimeNotATypeID;
@@ -1031,9 +1140,6 @@ CFTypeID CFNumberGetTypeID(void) {
     return __kCFNumberTypeID;
 }
 
-#define MinCachedInt (-1)
-#define MaxCachedInt (12)
-#define NotToBeCached (MinCachedInt - 1)
 static CFNumberRef __CFNumberCache[MaxCachedInt - MinCachedInt + 1] = {NULL};	// Storing CFNumberRefs for range MinCachedInt..MaxCachedInt
 
 CFNumberRef CFNumberCreate(CFAllocatorRef allocator, CFNumberType type, const void *valuePtr) {
@@ -1042,6 +1148,18 @@ CFNumberRef CFNumberCreate(CFAllocatorRef allocator, CFNumberType type, const vo
 
     if (!allocator) allocator = __CFGetDefaultAllocator();
 
+    // An SInt128 value that fits in 64 bits is kept as an SInt64, which takes half the
+    // space, can be tagged or cached, and compares and hashes without 128-bit arithmetic
+    int64_t narrowed;
+    if (kCFNumberSInt128Type == type) {
+	CFSInt128Struct s;
+	memmove(&s, valuePtr, 16);
+	if (s.high == ((int64_t)s.low >> 63)) {
+	    narrowed = (int64_t)s.low;
+	    type = kCFNumberSInt64Type;
+	    valuePtr = &narrowed;
+	}
+    }
 
     // Look for cases where we can return a cached instance.
     // We only use cached objects if the allocator is the system
@@ -1063,13 +1181,25 @@ CFNumberRef CFNumberCreate(CFAllocatorRef allocator, CFNumberType type, const vo
 	    if (isinf(d)) cached = (d < 0.0) ? kCFNumberNegativeInfinity : kCFNumberPositiveInfinity;
 	}
 	if (cached) return (CFNumberRef)CFRetain(cached);
-    } else if (_CFAllocatorIsSystemDefault(allocator) && (__CFNumberCaching == kCFNumberCachingEnabled)) {
+    }
+
+#if CF_HAVE_TAGGED_POINTERS
+    // Tagging subsumes the small integer cache below; "CFNumberDisableCache=all" turns it off
+    if (_CFAllocatorIsSystemDefault(allocator) && (__CFNumberCaching != kCFNumberCachingFullyDisabled)) {
+	CFNumberRef tagged = __CFNumberCreateTagged(type, valuePtr, __CFNumberCaching == kCFNumberCachingEnabled);
+	if (NULL != tagged) return tagged;
+    }
+#endif
+
+    if (!__CFNumberTypeTable[type].floatBit && _CFAllocatorIsSystemDefault(allocator) && (__CFNumberCaching == kCFNumberCachingEnabled)) {
+	int64_t val = NotToBeCached;
 	switch (__CFNumberTypeTable[type].canonicalType) {
-	case kCFNumberSInt8Type:   {int8_t  val = *(int8_t *)valuePtr;  if (MinCachedInt <= val && val <= MaxCachedInt) valToBeCached = (int64_t)val; break;}
-	case kCFNumberSInt16Type:  {int16_t val = *(int16_t *)valuePtr; if (MinCachedInt <= val && val <= MaxCachedInt) valToBeCached = (int64_t)val; break;}
-	case kCFNumberSInt32Type:  {int32_t val = *(int32_t *)valuePtr; if (MinCachedInt <= val && val <= MaxCachedInt) valToBeCached = (int64_t)val; break;}
-	case kCFNumberSInt64Type:  {int64_t val = *(int64_t *)valuePtr; if (MinCachedInt <= val && val <= MaxCachedInt) valToBeCached = (int64_t)val; break;}
+	case kCFNumberSInt8Type:   val = *(int8_t *)valuePtr; break;
+	case kCFNumberSInt16Type:  val = *(int16_t *)valuePtr; break;
+	case kCFNumberSInt32Type:  val = *(int32_t *)valuePtr; break;
+	case kCFNumberSInt64Type:  memmove(&val, valuePtr, 8); break;
 	}
+	if (MinCachedInt <= val && val <= MaxCachedInt) valToBeCached = val;
 	if (NotToBeCached != valToBeCached) {
 	    CFNumberRef cached = __CFNumberCache[valToBeCached - MinCachedInt];	    // Atomic to access the value in the cache
 	    if (NULL != cached) return (CFNumberRef)CFRetain(cached);
@@ -1077,20 +1207,12 @@ CFNumberRef CFNumberCreate(CFAllocatorRef allocator, CFNumberType type, const vo
     }
 
     CFIndex size = 8 + ((!__CFNumberTypeTable[type].floatBit && __CFNumberTypeTable[type].storageBit) ? 8 : 0);
-#if OLD_CRAP_TOO
-    size += 2 * sizeof(void *);
-#endif
     CFNumberRef result = (CFNumberRef)_CFRuntimeCreateInstance(allocator, CFNumberGetTypeID(), size, NULL);
     if (NULL == result) {
 	return NULL;
     }
     __CFBitfieldSetValue(((struct __CFNumber *)result)->_base._cfinfo[CF_INFO_BITS], 4, 0, (uint8_t)__CFNumberTypeTable[type].canonicalType);
 
-#if OLD_CRAP_TOO
-    ((struct __CFNumber *)result)->__old__ = CFNumberCreate_old(allocator, type, valuePtr);
-CFLog(kCFLogLevelWarning, CFSTR("+++ Create old number '%@'"), __CFNumberCopyDescription_old(result->__old__));
-
-#endif
 
     // for a value to be cached, we already have the value handy
     if (NotToBeCached != valToBeCached) {
@@ -1135,16 +1257,6 @@ CFNumberType CFNumberGetType(CFNumberRef number) {
     CFNumberType type = __CFNumberGetType(number);
     if (kCFNumberSInt128Type == type) type = kCFNumberSInt64Type; // must hide this type, since it is not public
 //printf("  => %d\n", type);
-#if OLD_CRAP_TOO
-if (! number->__old__) {
-printf("*** Test skipped in CFNumberGetType for number %p\n", number);
-} else {
-CFNumberType t2 = CFNumberGetType_old(number->__old__);
-if (t2 != type) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL in CFNumberGetType: '%d' '%d'"), t2, type);  FAIL();
-}
-}
-#endif
     return type;
 }
 
@@ -1159,16 +1271,6 @@ CFIndex CFNumberGetByteSize(CFNumberRef number) {
     __CFAssertIsNumber(number);
     CFIndex r = 1 << __CFNumberTypeTable[CFNumberGetType(number)].lgByteSize;
 //printf("  => %d\n", r);
-#if OLD_CRAP_TOO
-if (! number->__old__) {
-printf("*** Test skipped in CFNumberGetByteSize for number %p\n", number);
-} else {
-CFIndex r2 = CFNumberGetByteSize_old(number->__old__);
-if (r2 != r) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL in CFNumberGetByteSize: '%d' '%d'"), r2, r);  FAIL();
-}
-}
-#endif
     return r;
 }
 
@@ -1177,16 +1279,6 @@ Boolean CFNumberIsFloatType(CFNumberRef number) {
     __CFAssertIsNumber(number);
     Boolean r = __CFNumberTypeTable[CFNumberGetType(number)].floatBit;
 //printf("  => %d\n", r);
-#if OLD_CRAP_TOO
-if (! number->__old__) {
-printf("*** Test skipped in CFNumberIsFloatType for number %p\n", number);
-} else {
-Boolean r2 = CFNumberIsFloatType_old(number->__old__);
-if (r2 != r) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL in CFNumberIsFloatType: '%d' '%d'"), r2, r);  FAIL();
-}
-}
-#endif
     return r;
 }
 
@@ -1199,472 +1291,18 @@ Boolean CFNumberGetValue(CFNumberRef number, CFNumberType type, void *valuePtr)
     uint8_t localMemory[128];
     Boolean r = __CFNumberGetValueCompat(number, type, valuePtr ? valuePtr : localMemory);
 //printf("  => %d\n", r);
-#if OLD_CRAP_TOO
-if (! number->__old__) {
-printf("*** Test skipped in CFNumberGetValue for number %p\n", number);
-} else {
-    uint8_t localMemory2[128];
-Boolean r2 = CFNumberGetValue_old(number->__old__, type, localMemory2);
-if (r2 != r) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL 1 in CFNumberGetValue: '%d' '%d'"), r2, r);  FAIL();
-}
-if (0 != memcmp(localMemory2, valuePtr, CFNumberGetByteSize(number))) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL 2 in CFNumberGetValue: BYTES NOT SAME"));  FAIL();
-}
-}
-#endif
     return r;
 }
 
-static CFComparisonResult CFNumberCompare_new(CFNumberRef number1, CFNumberRef number2, void *context) {
+CFComparisonResult CFNumberCompare(CFNumberRef number1, CFNumberRef number2, void *context) {
+//printf("+ [%p] CFNumberCompare(%p, %p, %p)\n", pthread_self(), number1, number2, context);
     CF_OBJC_FUNCDISPATCHV(CFNumberGetTypeID(), CFComparisonResult, (NSNumber *)number1, compare:(NSNumber *)number2);
     CF_OBJC_FUNCDISPATCHV(CFNumberGetTypeID(), CFComparisonResult, (NSNumber *)number2, _reverseCompare:(NSNumber *)number1);
     __CFAssertIsNumber(number1);
     __CFAssertIsNumber(number2);
-
-    CFNumberType type1 = __CFNumberGetType(number1);
-    CFNumberType type2 = __CFNumberGetType(number2);
-    // Both numbers are integers
-    if (!__CFNumberTypeTable[type1].floatBit && !__CFNumberTypeTable[type2].floatBit) {
-        CFSInt128Struct i1, i2;
-        __CFNumberGetValue(number1, kCFNumberSInt128Type, &i1);
-        __CFNumberGetValue(number2, kCFNumberSInt128Type, &i2);
-        return cmp128(&i1, &i2);
-    }
-    // Both numbers are floats
-    if (__CFNumberTypeTable[type1].floatBit && __CFNumberTypeTable[type2].floatBit) {
-	Float64 d1, d2;
-        __CFNumberGetValue(number1, kCFNumberFloat64Type, &d1);
-        __CFNumberGetValue(number2, kCFNumberFloat64Type, &d2);
-	double s1 = copysign(1.0, d1);
-	double s2 = copysign(1.0, d2);
-	if (isnan(d1) && isnan(d2)) return kCFCompareEqualTo;
-	if (isnan(d1)) return (s2 < 0.0) ? kCFCompareGreaterThan : kCFCompareLessThan;
-	if (isnan(d2)) return (s1 < 0.0) ? kCFCompareLessThan : kCFCompareGreaterThan;
-	// at this point, we know we don't have any NaNs
-	if (s1 < s2) return kCFCompareLessThan;
-	if (s2 < s1) return kCFCompareGreaterThan;
-	// at this point, we know the signs are the same; do not combine these tests
-	if (d1 < d2) return kCFCompareLessThan;
-	if (d2 < d1) return kCFCompareGreaterThan;
-        return kCFCompareEqualTo;
-    }
-    // One float, one integer; swap if necessary so number1 is the float
-    Boolean swapResult = false;
-    if (__CFNumberTypeTable[type2].floatBit) {
-        CFNumberRef tmp = number1;
-	number1 = number2;
-	number2 = tmp;
-	swapResult = true;
-    }
-    // At large integer values, the precision of double is quite low
-    // e.g. all values roughly 2^127 +- 2^73 are represented by 1 double, 2^127.
-    // If we just used double compare, that would make the 2^73 largest 128-bit
-    // integers look equal, so we have to use integer comparison when possible.
-    Float64 d1, d2;
-    __CFNumberGetValue(number1, kCFNumberFloat64Type, &d1);
-    // if the double value is really big, cannot be equal to integer
-    // nan d1 will not compare true here
-    if (d1 < FLOAT_NEGATIVE_2_TO_THE_127) {
-	return !swapResult ? kCFCompareLessThan : kCFCompareGreaterThan;
-    }
-    if (FLOAT_POSITIVE_2_TO_THE_127 <= d1) {
-	return !swapResult ? kCFCompareGreaterThan : kCFCompareLessThan;
-    }
-    CFSInt128Struct i1, i2;
-    __CFNumberGetValue(number1, kCFNumberSInt128Type, &i1);
-    __CFNumberGetValue(number2, kCFNumberSInt128Type, &i2);
-    CFComparisonResult res = cmp128(&i1, &i2);
-    if (kCFCompareEqualTo != res) {
-	return !swapResult ? res : -res;
-    }
-    // now things are equal, but perhaps due to rounding or nan
-    if (isnan(d1)) {
-	if (isNeg128(&i2)) {
-	    return !swapResult ? kCFCompareGreaterThan : kCFCompareLessThan;
-	}
-	// nan compares less than positive 0 too
-	return !swapResult ? kCFCompareLessThan : kCFCompareGreaterThan;
-    }
-    // at this point, we know we don't have NaN
-    double s1 = copysign(1.0, d1);
-    double s2 = isNeg128(&i2) ? -1.0 : 1.0;
-    if (s1 < s2) return !swapResult ? kCFCompareLessThan : kCFCompareGreaterThan;
-    if (s2 < s1) return !swapResult ? kCFCompareGreaterThan : kCFCompareLessThan;
-    // at this point, we know the signs are the same; do not combine these tests
-    __CFNumberGetValue(number2, kCFNumberFloat64Type, &d2);
-    if (d1 < d2) return !swapResult ? kCFCompareLessThan : kCFCompareGreaterThan;
-    if (d2 < d1) return !swapResult ? kCFCompareGreaterThan : kCFCompareLessThan;
-    return kCFCompareEqualTo;
-}
-
-CFComparisonResult CFNumberCompare(CFNumberRef number1, CFNumberRef number2, void *context) {
-//printf("+ [%p] CFNumberCompare(%p, %p, %p)\n", pthread_self(), number1, number2, context);
-    CFComparisonResult r = CFNumberCompare_new(number1, number2, context);
-//printf("  => %d\n", r);
-#if OLD_CRAP_TOO
-if (! number1->__old__ || !number2->__old__) {
-printf("*** Test skipped in CFNumberCompare for numbers %p %p\n", number1, number2);
-} else {
-CFComparisonResult r2 = CFNumberCompare_old(number1->__old__, number2->__old__, context);
-if (r2 != r) {
-CFLog(kCFLogLevelWarning, CFSTR("*** TEST FAIL in CFNumberCompare: '%d' '%d'"), r2, r);  FAIL();
+    return __CFNumberCompare(number1, number2);
 }
-}
-#endif
-    return r;
-}
-
-#if OLD_CRAP_TOO
-
-static const unsigned char __CFNumberCanonicalType[kCFNumberMaxType + 1] = {
-    0, kCFNumberSInt8Type, kCFNumberSInt16Type, kCFNumberSInt32Type, kCFNumberSInt64Type, kCFNumberFloat32Type, kCFNumberFloat64Type,
-    kCFNumberSInt8Type, kCFNumberSInt16Type, kCFNumberSInt32Type, kCFNumberSInt32Type, kCFNumberSInt64Type, kCFNumberFloat32Type, kCFNumberFloat64Type,
-    kCFNumberSInt32Type, kCFNumberSInt32Type, kCFNumberFloat32Type
-};
-
-static const unsigned char __CFNumberStorageType[kCFNumberMaxType + 1] = {
-    0, kCFNumberSInt32Type, kCFNumberSInt32Type, kCFNumberSInt32Type, kCFNumberSInt64Type, kCFNumberFloat32Type, kCFNumberFloat64Type,
-    kCFNumberSInt32Type, kCFNumberSInt32Type, kCFNumberSInt32Type, kCFNumberSInt32Type, kCFNumberSInt64Type, kCFNumberFloat32Type, kCFNumberFloat64Type,
-    kCFNumberSInt32Type, kCFNumberSInt32Type, kCFNumberFloat32Type
-};
-
-
-
-// Returns the type that is used to store the specified type
-static CFNumberType __CFNumberGetStorageTypeForType_old(CFNumberType type) {
-    return __CFNumberStorageType[type];
-}
-
-// Returns the canonical type used to represent the specified type
-static CFNumberType __CFNumberGetCanonicalTypeForType_old(CFNumberType type) {
-    return __CFNumberCanonicalType[type];
-}
-
-// Extracts and returns the type out of the CFNumber
-static CFNumberType __CFNumberGetType_old(struct __CFNumber_old * num) {
-    return __CFBitfieldGetValue(num->_base._cfinfo[CF_INFO_BITS], 4, 0);
-}
-
-// Returns true if the argument type is float or double
-static Boolean __CFNumberTypeIsFloat_old(CFNumberType type) {
-    return (type == kCFNumberFloat64Type) || (type == kCFNumberFloat32Type) || (type == kCFNumberDoubleType) || (type == kCFNumberFloatType);
-}
-
-// Returns the number of bytes necessary to store the specified type
-// Needs to handle all canonical types
-static CFIndex __CFNumberSizeOfType_old(CFNumberType type) {
-    switch (type) {
-        case kCFNumberSInt8Type:        return sizeof(int8_t);
-        case kCFNumberSInt16Type:       return sizeof(int16_t);
-        case kCFNumberSInt32Type:       return sizeof(SInt32);
-        case kCFNumberSInt64Type:       return sizeof(int64_t);
-        case kCFNumberFloat32Type:      return sizeof(Float32);
-        case kCFNumberFloat64Type:      return sizeof(Float64);
-        default:                        printf("*** WARNING: 0 size from __CFNumberSizeOfType_old \n"); return 0;
-    }
-}
-
-// Copies an external value of a given type into the appropriate slot in the union (does no type conversion)
-// Needs to handle all canonical types
-#define SET_VALUE(valueUnion, type, valuePtr)   \
-    switch (type) {                             \
-        case kCFNumberSInt8Type:        (valueUnion)->valSInt32 = *(int8_t *)(valuePtr); break; \
-        case kCFNumberSInt16Type:       (valueUnion)->valSInt32 = *(int16_t *)(valuePtr); break;        \
-        case kCFNumberSInt32Type:       (valueUnion)->valSInt32 = *(SInt32 *)(valuePtr); break; \
-        case kCFNumberSInt64Type:       (valueUnion)->valSInt64 = *(int64_t *)(valuePtr); break;        \
-        case kCFNumberFloat32Type:      (valueUnion)->valFloat32 = *(Float32 *)(valuePtr); break;       \
-        case kCFNumberFloat64Type:      (valueUnion)->valFloat64 = *(Float64 *)(valuePtr); break;       \
-        default: printf("*** WARNING: default case in SET_VALUE \n"); break; \
-    }
 
-// Casts the specified value into the specified type and copies it into the provided memory
-// Needs to handle all canonical types
-#define GET_VALUE(value, type, resultPtr)       \
-    switch (type) {                             \
-        case kCFNumberSInt8Type:        *(int8_t *)(resultPtr) = (int8_t)value; break;  \
-        case kCFNumberSInt16Type:       *(int16_t *)(resultPtr) = (int16_t)value; break;        \
-        case kCFNumberSInt32Type:       *(SInt32 *)(resultPtr) = (SInt32)value; break;  \
-        case kCFNumberSInt64Type:       *(int64_t *)(resultPtr) = (int64_t)value; break;        \
-        case kCFNumberFloat32Type:      *(Float32 *)(resultPtr) = (Float32)value; break;        \
-        case kCFNumberFloat64Type:      *(Float64 *)(resultPtr) = (Float64)value; break;        \
-        default: printf("*** WARNING: default case in GET_VALUE \n"); break; \
-    }
-
-// Extracts the stored type out of the union and copies it in the desired type into the provided memory
-// Needs to handle all storage types
-static void __CFNumberGetValue_old(const __CFNumberValue_old *value, CFNumberType numberType, CFNumberType typeToGet, void *valuePtr) {
-    switch (numberType) {
-        case kCFNumberSInt32Type:       GET_VALUE(value->valSInt32, typeToGet, valuePtr); break;
-        case kCFNumberSInt64Type:       GET_VALUE(value->valSInt64, typeToGet, valuePtr); break;
-        case kCFNumberFloat32Type:      GET_VALUE(value->valFloat32, typeToGet, valuePtr); break;
-        case kCFNumberFloat64Type:      GET_VALUE(value->valFloat64, typeToGet, valuePtr); break;
-        default: printf("*** WARNING: default case in __CFNumberGetValue_old \n"); break; \
-    }
-}
-
-// Sees if two value union structs have the same value (will do type conversion)
-static Boolean __CFNumberEqualValue_old(const __CFNumberValue_old *value1, CFNumberType type1, const __CFNumberValue_old *value2, CFNumberType type2) {
-    if (__CFNumberTypeIsFloat_old(type1) || __CFNumberTypeIsFloat_old(type2)) {
-        Float64 d1, d2;
-        __CFNumberGetValue_old(value1, type1, kCFNumberFloat64Type, &d1);
-        __CFNumberGetValue_old(value2, type2, kCFNumberFloat64Type, &d2);
-            if (isnan(d1) && isnan(d2)) return true;    // Not mathematically sound, but required
-        return d1 == d2;
-    } else {
-        int64_t i1, i2;
-        __CFNumberGetValue_old(value1, type1, kCFNumberSInt64Type, &i1);
-        __CFNumberGetValue_old(value2, type2, kCFNumberSInt64Type, &i2);
-        return i1 == i2;
-    }
-}
-
-static Boolean __CFNumberEqual_old(CFTypeRef cf1, CFTypeRef cf2) {
-    struct __CFNumber_old * number1 = (struct __CFNumber_old *)cf1;
-    struct __CFNumber_old * number2 = (struct __CFNumber_old *)cf2;
-    return __CFNumberEqualValue_old(&(number1->value), __CFNumberGetType_old(number1), &(number2->value), __CFNumberGetType_old(number2));
-}
-
-static CFHashCode __CFNumberHash_old(CFTypeRef cf) {
-    struct __CFNumber_old * number = (struct __CFNumber_old *)cf;
-    switch (__CFNumberGetType_old((struct __CFNumber_old *)cf)) {
-        case kCFNumberSInt32Type: return _CFHashInt(number->value.valSInt32);
-        case kCFNumberSInt64Type: return _CFHashDouble((double)(number->value.valSInt64));
-        case kCFNumberFloat32Type: return _CFHashDouble((double)(number->value.valFloat32));
-        case kCFNumberFloat64Type: return _CFHashDouble((double)(number->value.valFloat64));
-        default: printf("*** WARNING default case in __CFNumberHash_old\n");
-            return 0;
-    }
-}
-
-#define BUFFER_SIZE 100
-#define emitChar(ch) \
-    {if (buf - stackBuf == BUFFER_SIZE) {CFStringAppendCharacters(mstr, stackBuf, BUFFER_SIZE); buf = stackBuf;} *buf++ = ch;}
-                 
-static void __CFNumberEmitInt64_old(CFMutableStringRef mstr, int64_t value, int32_t width, UniChar pad, bool explicitPlus) {
-    UniChar stackBuf[BUFFER_SIZE], *buf = stackBuf;
-    uint64_t uvalue, factor, tmp;
-    int32_t w;
-    bool neg;
-
-    neg = (value < 0) ? true : false;
-    uvalue = (neg) ? -value : value;
-    if (neg || explicitPlus) width--;
-    width--;
-    factor = 1;
-    tmp = uvalue;
-    while (9 < tmp) {
-        width--;
-        factor *= 10;
-        tmp /= 10;
-    }
-    for (w = 0; w < width; w++) emitChar(pad);
-    if (neg) {
-        emitChar('-');
-    } else if (explicitPlus) {
-        emitChar('+');
-    }
-    while (0 < factor) {
-        UniChar ch = '0' + (UniChar)(uvalue / factor);
-        uvalue %= factor;
-        emitChar(ch);
-        factor /= 10;
-    }
-    if (buf > stackBuf) CFStringAppendCharacters(mstr, stackBuf, buf - stackBuf);
-}
-
-static CFStringRef __CFNumberCopyDescription_old(CFTypeRef cf) {
-    struct __CFNumber_old * number = (struct __CFNumber_old *)cf;
-    CFMutableStringRef mstr = CFStringCreateMutable(kCFAllocatorSystemDefault, 0);
-    CFStringAppendFormat(mstr, NULL, CFSTR("<CFNumber %p [%p]>{value = "), cf, CFGetAllocator(cf));
-    switch (__CFNumberGetType_old(number)) {
-    case kCFNumberSInt32Type:
-        __CFNumberEmitInt64_old(mstr, number->value.valSInt32, 0, ' ', true);
-        CFStringAppendFormat(mstr, NULL, CFSTR(", type = kCFNumberSInt32Type}"));
-        break;
-    case kCFNumberSInt64Type:
-        __CFNumberEmitInt64_old(mstr, number->value.valSInt64, 0, ' ', true);
-        CFStringAppendFormat(mstr, NULL, CFSTR(", type = kCFNumberSInt64Type}"));
-        break;
-    case kCFNumberFloat32Type:
-        // debugging formatting is intentionally more verbose and explicit about the value of the number
-        if (isnan(number->value.valFloat32)) {
-            CFStringAppend(mstr, CFSTR("nan"));
-        } else if (isinf(number->value.valFloat32)) {
-            CFStringAppend(mstr, (0.0f < number->value.valFloat32) ? CFSTR("+infinity") : CFSTR("-infinity"));
-        } else if (0.0f == number->value.valFloat32) {
-            CFStringAppend(mstr, (copysign(1.0, number->value.valFloat32) < 0.0) ? CFSTR("-0.0") : CFSTR("+0.0"));
-        } else {
-            CFStringAppendFormat(mstr, NULL, CFSTR("%+.10f"), number->value.valFloat32);
-        }
-        CFStringAppend(mstr, CFSTR(", type = kCFNumberFloat32Type}"));
-        break;
-    case kCFNumberFloat64Type:
-        // debugging formatting is intentionally more verbose and explicit about the value of the number
-        if (isnan(number->value.valFloat64)) {
-            CFStringAppend(mstr, CFSTR("nan"));
-        } else if (isinf(number->value.valFloat64)) {
-            CFStringAppend(mstr, (0.0 < number->value.valFloat64) ? CFSTR("+infinity") : CFSTR("-infinity"));
-        } else if (0.0 == number->value.valFloat64) {
-            CFStringAppend(mstr, (copysign(1.0, number->value.valFloat64) < 0.0) ? CFSTR("-0.0") : CFSTR("+0.0"));
-        } else {
-            CFStringAppendFormat(mstr, NULL, CFSTR("%+.20f"), number->value.valFloat64);
-        }
-        CFStringAppend(mstr, CFSTR(", type = kCFNumberFloat64Type}"));
-        break;
-    default:
-        CFRelease(mstr);
-        return NULL;
-    }
-    return mstr;
-}
-
-// This function separated out from __CFNumberCopyFormattingDescription() so the plist creation can use it as well.
-
-CF_PRIVATE CFStringRef __CFNumberCopyFormattingDescriptionAsFloat64_old(CFTypeRef cf) {
-    double d;
-    CFNumberGetValue_old((struct __CFNumber_old *)cf, kCFNumberFloat64Type, &d);
-        if (isnan(d)) {
-            return (CFStringRef)CFRetain(CFSTR("nan"));
-        }
-        if (isinf(d)) {
-            return (CFStringRef)CFRetain((0.0 < d) ? CFSTR("+infinity") : CFSTR("-infinity"));
-        }
-        if (0.0 == d) {
-            return (CFStringRef)CFRetain(CFSTR("0.0"));
-        }
-        // if %g is used here, need to use DBL_DIG + 2 on Mac OS X, but %f needs +1
-        return CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("%.*g"), DBL_DIG + 2, d);
-}
-
-static CFStringRef __CFNumberCopyFormattingDescription_old(CFTypeRef cf, CFDictionaryRef formatOptions) {
-    struct __CFNumber_old * number = (struct __CFNumber_old *)cf;
-    CFMutableStringRef mstr;
-    int64_t value;
-    switch (__CFNumberGetType_old(number)) {
-    case kCFNumberSInt32Type:
-    case kCFNumberSInt64Type: 
-        value = (__CFNumberGetType_old(number) == kCFNumberSInt32Type) ? number->value.valSInt32 : number->value.valSInt64;
-        mstr = CFStringCreateMutable(kCFAllocatorSystemDefault, 0);
-        __CFNumberEmitInt64_old(mstr, value, 0, ' ', false);
-        return mstr;
-    case kCFNumberFloat32Type:
-            if (isnan(number->value.valFloat32)) {
-                return (CFStringRef)CFRetain(CFSTR("nan"));
-            }
-            if (isinf(number->value.valFloat32)) {
-                return (CFStringRef)CFRetain((0.0f < number->value.valFloat32) ? CFSTR("+infinity") : CFSTR("-infinity"));
-            }
-            if (0.0f == number->value.valFloat32) {
-                return (CFStringRef)CFRetain(CFSTR("0.0"));
-            }
-            // if %g is used here, need to use FLT_DIG + 2 on Mac OS X, but %f needs +1
-            return CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("%.*g"), FLT_DIG + 2, number->value.valFloat32);
-    case kCFNumberFloat64Type:
-        return __CFNumberCopyFormattingDescriptionAsFloat64_old(number);
-        break;
-    default:
-        return NULL;
-    }
-}
-
-
-
-static struct __CFNumber_old * CFNumberCreate_old(CFAllocatorRef allocator, CFNumberType type, const void *valuePtr) {
-    struct __CFNumber_old * num;
-    CFNumberType equivType, storageType;
-
-if (type == 17) {
-CFSInt128Struct *s = valuePtr;
-s->high = (int64_t)s->low;
-type = kCFNumberSInt64Type;
-}
-
-    
-    equivType = __CFNumberGetCanonicalTypeForType_old(type);
-
-    storageType = __CFNumberGetStorageTypeForType_old(type);
-
-    num = (struct __CFNumber_old *)_CFRuntimeCreateInstance(allocator, CFNumberGetTypeID(), __CFNumberSizeOfType_old(storageType), NULL);
-    if (NULL == num) {
-        return NULL;
-    }
-    SET_VALUE((__CFNumberValue_old *)&(num->value), equivType, valuePtr);
-    __CFBitfieldSetValue(((struct __CFNumber_old *)num)->_base._cfinfo[CF_INFO_BITS], 6, 0, (uint8_t)storageType);
-    
-if (__CFNumberGetType_old(num) == 0) printf("*** ERROR: new number %p type is 0 (%d)\n", num, storageType);
-    return num;
-}
-
-static CFNumberType CFNumberGetType_old(struct __CFNumber_old * number) {
-
-    return __CFNumberGetType_old(number);
-}
-
-static CFIndex CFNumberGetByteSize_old(struct __CFNumber_old * number) {
-    return __CFNumberSizeOfType_old(CFNumberGetType_old(number));
-}
-
-static Boolean CFNumberIsFloatType_old(struct __CFNumber_old * number) {
-    return __CFNumberTypeIsFloat_old(CFNumberGetType_old(number));
-}
-
-static Boolean CFNumberGetValue_old(struct __CFNumber_old * number, CFNumberType type, void *valuePtr) {
-    uint8_t localMemory[sizeof(__CFNumberValue_old)];
-    __CFNumberValue_old localValue;
-    CFNumberType numType;
-    CFNumberType storageTypeForType;
-
-if (type == 17) type = kCFNumberSInt64Type;
-
-    storageTypeForType = __CFNumberGetStorageTypeForType_old(type);
-    type = __CFNumberGetCanonicalTypeForType_old(type);
-    if (!valuePtr) valuePtr = &localMemory;
-
-    numType = __CFNumberGetType_old(number);
-    __CFNumberGetValue_old((__CFNumberValue_old *)&(number->value), numType, type, valuePtr);
-
-    // If the types match, then we're fine!
-    if (numType == storageTypeForType) return true;
-
-    // Test to see if the returned value is intact...
-    SET_VALUE(&localValue, type, valuePtr);
-    return __CFNumberEqualValue_old(&localValue, storageTypeForType, &(number->value), numType);
-}
-
-static CFComparisonResult CFNumberCompare_old(struct __CFNumber_old * number1, struct __CFNumber_old * number2, void *context) {
-    CFNumberType type1, type2;
-
-
-    type1 = __CFNumberGetType_old(number1);
-    type2 = __CFNumberGetType_old(number2);
-
-    if (__CFNumberTypeIsFloat_old(type1) || __CFNumberTypeIsFloat_old(type2)) {
-        Float64 d1, d2;
-        double s1, s2;
-        __CFNumberGetValue_old(&(number1->value), type1, kCFNumberFloat64Type, &d1);
-        __CFNumberGetValue_old(&(number2->value), type2, kCFNumberFloat64Type, &d2);
-        s1 = copysign(1.0, d1);
-        s2 = copysign(1.0, d2);
-        if (isnan(d1) && isnan(d2)) return kCFCompareEqualTo;
-        if (isnan(d1)) return (s2 < 0.0) ? kCFCompareGreaterThan : kCFCompareLessThan;
-        if (isnan(d2)) return (s1 < 0.0) ? kCFCompareLessThan : kCFCompareGreaterThan;
-        // at this point, we know we don't have any NaNs
-        if (s1 < s2) return kCFCompareLessThan;
-        if (s2 < s1) return kCFCompareGreaterThan;
-        // at this point, we know the signs are the same; do not combine these tests
-        if (d1 < d2) return kCFCompareLessThan;
-        if (d2 < d1) return kCFCompareGreaterThan;
-        return kCFCompareEqualTo;
-    } else {
-        int64_t i1, i2;
-        __CFNumberGetValue_old(&(number1->value), type1, kCFNumberSInt64Type, &i1);
-        __CFNumberGetValue_old(&(number2->value), type2, kCFNumberSInt64Type, &i2);
-        return (i1 > i2) ? kCFCompareGreaterThan : ((i1 < i2) ? kCFCompareLessThan : kCFCompareEqualTo);
-    }
-}
-
-#endif
 
 
 #undef __CFAssertIsBoolean
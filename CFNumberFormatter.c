@@ -434,22 +434,15 @@ CFStringRef CFNumberFormatterCreateStringWithNumber(CFAllocatorRef allocator, CF
 
 #define FORMAT_FLT(T, FUNC)							\
 	T value = *(T *)valuePtr;					\
-	if (0 == value && formatter->_zeroSym) { return (CFStringRef)CFRetain(formatter->_zeroSym); }	\
+	if (0 == value && zeroSym) goto zero;				\
 	if (1.0 != multiplier) {					\
 		value = (T)(value * multiplier);                     \
 	}								\
-	status = U_ZERO_ERROR;						\
-	used = FUNC(formatter->_nf, value, ubuffer + 1, cnt, NULL, &status); \
-	if (status == U_BUFFER_OVERFLOW_ERROR || cnt < used) {		\
-	    cnt = used + 1 + 1;						\
-	    ustr = (UChar *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(UChar) * cnt, 0); \
-	    status = U_ZERO_ERROR;					\
-	    used = FUNC(formatter->_nf, value, ustr + 1, cnt, NULL, &status); \
-	}
+	used = FUNC(nf, value, dst, cnt, NULL, &status);
 
 #define FORMAT_INT(T, FUN)                                                   \
         T value = *(T *)valuePtr;					\
-        if (0 == value && formatter->_zeroSym) { return (CFStringRef)CFRetain(formatter->_zeroSym); }	\
+        if (0 == value && zeroSym) goto zero;				\
         if (1.0 != multiplier) {					\
             value = (T)(value * multiplier);                        \
         }                                                           \
@@ -457,23 +450,22 @@ CFStringRef CFNumberFormatterCreateStringWithNumber(CFAllocatorRef allocator, CF
         FUN(&bignum, value);                                        \
         char buffer[BUFFER_SIZE + 1];                                           \
         _CFBigNumToCString(&bignum, false, true, buffer, BUFFER_SIZE);      \
-        status = U_ZERO_ERROR;                                      \
-        used = __cficu_unum_formatDecimal(formatter->_nf, buffer, strlen(buffer), ubuffer + 1, BUFFER_SIZE, NULL, &status);     \
-        if (status == U_BUFFER_OVERFLOW_ERROR || cnt < used) {      \
-            cnt = used + 1 + 1;                                         \
-            ustr = (UChar *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(UChar) * cnt, 0);                 \
-            status = U_ZERO_ERROR;                                  \
-            used = __cficu_unum_formatDecimal(formatter->_nf, buffer, strlen(buffer), ustr + 1, cnt, NULL, &status);            \
-        }                                                           \
+        used = __cficu_unum_formatDecimal(nf, buffer, strlen(buffer), dst, cnt, NULL, &status);
 
-CFStringRef CFNumberFormatterCreateStringWithValue(CFAllocatorRef allocator, CFNumberFormatterRef formatter, CFNumberType numberType, const void *valuePtr) {
-    if (allocator == NULL) allocator = __CFGetDefaultAllocator();
-    __CFGenericValidateType(allocator, CFAllocatorGetTypeID());
-    __CFGenericValidateType(formatter, CFNumberFormatterGetTypeID());
-    GET_MULTIPLIER;
-    UChar *ustr = NULL, ubuffer[BUFFER_SIZE + 1];
+CF_INLINE Boolean __CFNumberFormatterInsertsRTLMarker(CFNumberFormatterRef formatter) {
+    return formatter->_usesCharacterDirection && CFLocaleGetLanguageCharacterDirection(CFLocaleGetIdentifier(formatter->_locale)) == kCFLocaleLanguageDirectionRightToLeft;
+}
+
+// Formats the value with nf into chars, after a Unicode RTL marker if insertRTLMarker is true; a zero
+// value formats as zeroSym instead, if there is one, and sets *usedZeroSym.  Returns the length of the
+// result, which exceeds capacity when the buffer was too small, or -1 on failure.
+CF_PRIVATE CFIndex __CFNumberFormatterFormatValue(UNumberFormat *nf, double multiplier, CFStringRef zeroSym, Boolean insertRTLMarker, CFNumberType numberType, const void *valuePtr, UniChar *chars, CFIndex capacity, Boolean *usedZeroSym) {
+    CFIndex prefix = insertRTLMarker ? 1 : 0;
+    CFIndex cnt = (prefix < capacity) ? capacity - prefix : 0;
+    UChar *dst = cnt ? (UChar *)chars + prefix : NULL;
     UErrorCode status = U_ZERO_ERROR;
-    CFIndex used, cnt = BUFFER_SIZE;
+    CFIndex used;
+    if (usedZeroSym) *usedZeroSym = false;
     if (numberType == kCFNumberFloat64Type || numberType == kCFNumberDoubleType) {
 	FORMAT_FLT(double, __cficu_unum_formatDouble)
     } else if (numberType == kCFNumberFloat32Type || numberType == kCFNumberFloatType) {
@@ -494,20 +486,50 @@ CFStringRef CFNumberFormatterCreateStringWithValue(CFAllocatorRef allocator, CFN
 	FORMAT_INT(int8_t, _CFBigNumInitWithInt8)
     } else {
 	CFAssert2(0, __kCFLogAssertion, "%s(): unknown CFNumberType (%d)", __PRETTY_FUNCTION__, numberType);
-	return NULL;
+	return -1;
+    }
+    if (U_FAILURE(status) && status != U_BUFFER_OVERFLOW_ERROR) return -1;
+    if (prefix && 0 < capacity) chars[0] = 0x200F;
+    return used + prefix;
+
+zero:
+    used = CFStringGetLength(zeroSym);
+    CFStringGetCharacters(zeroSym, CFRangeMake(0, (used < capacity) ? used : capacity), chars);
+    if (usedZeroSym) *usedZeroSym = true;
+    return used;
+}
+
+// Clones the formatter's current ICU formatter, for callers that format from other threads
+CF_PRIVATE UNumberFormat *__CFNumberFormatterCopyUNumberFormat(CFNumberFormatterRef formatter, double *multiplierp, CFStringRef *zeroSymp, Boolean *insertRTLMarker) {
+    __CFGenericValidateType(formatter, CFNumberFormatterGetTypeID());
+    UErrorCode status = U_ZERO_ERROR;
+    UNumberFormat *nf = __cficu_unum_clone(formatter->_nf, &status);
+    if (U_FAILURE(status)) return NULL;
+    GET_MULTIPLIER;
+    if (multiplierp) *multiplierp = multiplier;
+    if (zeroSymp) *zeroSymp = formatter->_zeroSym ? (CFStringRef)CFRetain(formatter->_zeroSym) : NULL;
+    if (insertRTLMarker) *insertRTLMarker = __CFNumberFormatterInsertsRTLMarker(formatter);
+    return nf;
+}
+
+CFStringRef CFNumberFormatterCreateStringWithValue(CFAllocatorRef allocator, CFNumberFormatterRef formatter, CFNumberType numberType, const void *valuePtr) {
+    if (allocator == NULL) allocator = __CFGetDefaultAllocator();
+    __CFGenericValidateType(allocator, CFAllocatorGetTypeID());
+    __CFGenericValidateType(formatter, CFNumberFormatterGetTypeID());
+    GET_MULTIPLIER;
+    UniChar *ustr = NULL, ubuffer[BUFFER_SIZE + 1];
+    Boolean insertRTLMarker = __CFNumberFormatterInsertsRTLMarker(formatter), usedZeroSym;
+    CFIndex used = __CFNumberFormatterFormatValue(formatter->_nf, multiplier, formatter->_zeroSym, insertRTLMarker, numberType, valuePtr, ubuffer, BUFFER_SIZE + 1, &usedZeroSym);
+    if (usedZeroSym) return (CFStringRef)CFRetain(formatter->_zeroSym);
+    if (BUFFER_SIZE + 1 < used) {
+        CFIndex cnt = used;
+        ustr = (UniChar *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(UniChar) * cnt, 0);
+        used = __CFNumberFormatterFormatValue(formatter->_nf, multiplier, NULL, insertRTLMarker, numberType, valuePtr, ustr, cnt, NULL);
+        if (cnt < used) used = -1;
     }
     CFStringRef string = NULL;
-    if (U_SUCCESS(status)) {
-        UniChar *bufferToUse = ustr ? (UniChar *)ustr : (UniChar *)ubuffer;
-        if (formatter->_usesCharacterDirection && CFLocaleGetLanguageCharacterDirection(CFLocaleGetIdentifier(formatter->_locale)) == kCFLocaleLanguageDirectionRightToLeft) {
-            // Insert Unicode RTL marker
-            bufferToUse[0] = 0x200F;
-            used++;
-        } else {
-            // Move past direction marker
-            bufferToUse++;
-        }
-        string = CFStringCreateWithCharacters(allocator, bufferToUse, used);
+    if (0 <= used) {
+        string = CFStringCreateWithCharacters(allocator, ustr ? ustr : ubuffer, used);
     }
     if (ustr) CFAllocatorDeallocate(kCFAllocatorSystemDefault, ustr);
     return string;
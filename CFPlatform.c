@@ -1104,6 +1104,14 @@ int32_t OSAtomicDecrement32(volatile int32_t *theValue) {
     return OSAtomicDecrement32Barrier(theValue);
 }
 
+int64_t OSAtomicAdd64Barrier( int64_t theAmount, volatile int64_t *theValue ) {
+    return __sync_fetch_and_add(theValue, theAmount) + theAmount;
+}
+
+int64_t OSAtomicAdd64( int64_t theAmount, volatile int64_t *theValue ) {
+    return OSAtomicAdd64Barrier(theAmount, theValue);
+}
+
 void OSMemoryBarrier() {
     __sync_synchronize();
 }
@@ -35,6 +35,10 @@
 #include <string.h>
 #include <CoreFoundation/CFBase.h>
 #include <CoreFoundation/CFArray.h>
+#include <CoreFoundation/CFBinaryHeap.h>
+#include <CoreFoundation/CFBitVector.h>
+#include <CoreFoundation/CFCalendar.h>
+#include <CoreFoundation/CFTree.h>
 #include <CoreFoundation/CFString.h>
 #include <CoreFoundation/CFURL.h>
 #include <CoreFoundation/CFLocale.h>
@@ -77,6 +81,30 @@ CF_EXPORT SInt32 CFRunLoopRunSpecific(CFRunLoopRef rl, CFStringRef modeName, CFT
 
 CF_EXPORT void _CFRunLoopStopMode(CFRunLoopRef rl, CFStringRef modeName);
 
+/* Per-mode callout, timer lateness and sleep statistics, off by default. The copied dictionary is keyed by mode name; durations are histograms of log2 microsecond buckets. */
+CF_EXPORT void _CFRunLoopSetProfilingEnabled(CFRunLoopRef rl, Boolean enabled);
+CF_EXPORT Boolean _CFRunLoopIsProfilingEnabled(CFRunLoopRef rl);
+CF_EXPORT CFDictionaryRef _CFRunLoopCopyProfilingStatistics(CFRunLoopRef rl);
+CF_EXPORT void _CFRunLoopResetProfilingStatistics(CFRunLoopRef rl);
+
+/* A fixed set of threads, one per core by default, each running its own run loop in kCFRunLoopDefaultMode. Sources and timers are placed on the least loaded loop, or on the loop the key hashes to when a key is given; the run loop chosen is returned and must be passed back on removal. Statistics are one dictionary per loop. */
+typedef struct __CFRunLoopGroup * _CFRunLoopGroupRef;
+
+CF_EXPORT _CFRunLoopGroupRef _CFRunLoopGroupCreate(CFIndex count);
+CF_EXPORT void _CFRunLoopGroupDestroy(_CFRunLoopGroupRef group);
+CF_EXPORT CFIndex _CFRunLoopGroupGetCount(_CFRunLoopGroupRef group);
+CF_EXPORT CFRunLoopRef _CFRunLoopGroupGetRunLoopAtIndex(_CFRunLoopGroupRef group, CFIndex idx);
+CF_EXPORT CFIndex _CFRunLoopGroupGetIndexForKey(_CFRunLoopGroupRef group, CFTypeRef key);
+CF_EXPORT CFIndex _CFRunLoopGroupGetLeastLoadedIndex(_CFRunLoopGroupRef group);
+CF_EXPORT CFRunLoopRef _CFRunLoopGroupAddSource(_CFRunLoopGroupRef group, CFRunLoopSourceRef rls, CFTypeRef key);
+CF_EXPORT void _CFRunLoopGroupRemoveSource(_CFRunLoopGroupRef group, CFRunLoopRef rl, CFRunLoopSourceRef rls);
+CF_EXPORT CFRunLoopRef _CFRunLoopGroupAddTimer(_CFRunLoopGroupRef group, CFRunLoopTimerRef rlt, CFTypeRef key);
+CF_EXPORT void _CFRunLoopGroupRemoveTimer(_CFRunLoopGroupRef group, CFRunLoopRef rl, CFRunLoopTimerRef rlt);
+#if __BLOCKS__
+CF_EXPORT void _CFRunLoopGroupPerformBlock(_CFRunLoopGroupRef group, CFIndex idx, void (^block)(void));
+#endif
+CF_EXPORT CFArrayRef _CFRunLoopGroupCopyStatistics(_CFRunLoopGroupRef group);
+
 CF_EXPORT CFIndex CFMachPortGetQueuedMessageCount(CFMachPortRef mp);
 
 CF_EXPORT CFPropertyListRef _CFURLCopyPropertyListRepresentation(CFURLRef url);
@@ -253,6 +281,61 @@ CF_EXPORT const CFStringRef _kCFSystemVersionBuildStringKey;		// Localized strin
 CF_EXPORT void CFMergeSortArray(void *list, CFIndex count, CFIndex elementSize, CFComparatorFunction comparator, void *context);
 CF_EXPORT void CFQSortArray(void *list, CFIndex count, CFIndex elementSize, CFComparatorFunction comparator, void *context);
 
+/* Builds a rank index on an immutable bit vector (it does nothing for a mutable one), after which CFBitVectorGetCountOfBit() takes constant time for any range. _CFBitVectorGetIndexOfNthBit() returns the index of the nth (from 0) bit equal to value, or kCFNotFound; it uses the index when there is one. */
+CF_EXPORT void _CFBitVectorBuildRankIndex(CFBitVectorRef bv);
+CF_EXPORT CFIndex _CFBitVectorGetIndexOfNthBit(CFBitVectorRef bv, CFIndex n, CFBit value);
+
+/* An indexed binary heap hands out a handle for each value added through _CFBinaryHeapAddValueReturningHandle(), through which that value can be replaced (re-prioritized) or removed in O(log n); handles stay valid until their value leaves the heap. Indexed heaps also answer CFBinaryHeapContainsValue() in constant time when the value itself is present or the heap has no comparator. */
+CF_EXPORT CFBinaryHeapRef _CFBinaryHeapCreateIndexed(CFAllocatorRef allocator, CFIndex capacity, const CFBinaryHeapCallBacks *callBacks, const CFBinaryHeapCompareContext *compareContext);
+CF_EXPORT CFIndex _CFBinaryHeapAddValueReturningHandle(CFBinaryHeapRef heap, const void *value);
+CF_EXPORT Boolean _CFBinaryHeapContainsHandle(CFBinaryHeapRef heap, CFIndex handle);
+CF_EXPORT const void *_CFBinaryHeapGetValueForHandle(CFBinaryHeapRef heap, CFIndex handle);
+CF_EXPORT void _CFBinaryHeapUpdateValueForHandle(CFBinaryHeapRef heap, CFIndex handle, const void *value);
+CF_EXPORT void _CFBinaryHeapRemoveValueForHandle(CFBinaryHeapRef heap, CFIndex handle);
+
+/* Copies the children of tree in range into children, which must have room for range.length references; no retains are done. Together with CFTreeGetChildAtIndex() this is constant time per child once the tree has built its child index. */
+CF_EXPORT void _CFTreeGetChildrenInRange(CFTreeRef tree, CFRange range, CFTreeRef *children);
+/* Returns an allocator that hands out memory from large chunks and frees it all only when the allocator itself goes away; individual deallocations are ignored. Meant for building and discarding large trees in one piece. */
+CF_EXPORT CFAllocatorRef _CFTreeCreateArenaAllocator(void) CF_RETURNS_RETAINED;
+
+/* Persistent dictionaries and sets are immutable collections stored as hash tries. Each one shares all its storage with the persistent collection it was derived from except for the path to the changed key, so deriving a copy with one key set or removed costs O(log n) rather than a full copy. The first derivation from an ordinary collection converts it, at O(n); CFDictionaryCreateCopy() and CFSetCreateCopy() of a persistent collection cost O(1), and mutable copies are ordinary collections. Collections with weak or indirect elements are copied the ordinary way. */
+CF_EXPORT CFDictionaryRef _CFDictionaryCreatePersistentCopy(CFAllocatorRef allocator, CFDictionaryRef theDict);
+CF_EXPORT CFDictionaryRef _CFDictionaryCreateCopyBySettingValue(CFAllocatorRef allocator, CFDictionaryRef theDict, const void *key, const void *value);
+CF_EXPORT CFDictionaryRef _CFDictionaryCreateCopyByRemovingValue(CFAllocatorRef allocator, CFDictionaryRef theDict, const void *key);
+CF_EXPORT CFSetRef _CFSetCreatePersistentCopy(CFAllocatorRef allocator, CFSetRef theSet);
+CF_EXPORT CFSetRef _CFSetCreateCopyBySettingValue(CFAllocatorRef allocator, CFSetRef theSet, const void *value);
+CF_EXPORT CFSetRef _CFSetCreateCopyByRemovingValue(CFAllocatorRef allocator, CFSetRef theSet, const void *value);
+
+/* Output arrays for _CFCalendarDecomposeAbsoluteTimes(), one per calendar unit. */
+typedef struct {
+    int *era;
+    int *year;
+    int *quarter;
+    int *month;
+    int *day;
+    int *hour;
+    int *minute;
+    int *second;
+    int *weekday;
+    int *weekdayOrdinal;
+    int *weekOfMonth;
+    int *weekOfYear;
+    int *yearForWeekOfYear;
+} _CFCalendarComponentArrays;
+
+/* Decomposes count times at once: for each unit in units (kCFCalendarUnitWeek is not supported), the matching array in arrays gets one value per time, as CFCalendarDecomposeAbsoluteTime() would give it; arrays for other units are not touched. Gregorian calendars without week-based units are decomposed in chunks with straight-line arithmetic instead of going to ICU per time. Returns false if any time could not be decomposed. */
+CF_EXPORT Boolean _CFCalendarDecomposeAbsoluteTimes(CFCalendarRef calendar, const CFAbsoluteTime *times, CFIndex count, CFCalendarUnit units, const _CFCalendarComponentArrays *arrays);
+
+/* Counters for the process-wide caches behind CFLocale and CFCalendar: canonical forms of locale identifiers, and the ICU calendars that new calendars are cloned from instead of opened afresh. Each lookup counts as one hit or one miss. */
+typedef struct {
+    CFIndex identifierHits;
+    CFIndex identifierMisses;
+    CFIndex icuHits;
+    CFIndex icuMisses;
+} _CFLocaleCacheStatistics;
+
+CF_EXPORT void _CFLocaleGetCacheStatistics(_CFLocaleCacheStatistics *statistics);
+
 /* _CFExecutableLinkedOnOrAfter(releaseVersionName) will return YES if the current executable seems to be linked on or after the specified release. Example: If you specify CFSystemVersionPuma (10.1), you will get back true for executables linked on Puma or Jaguar(10.2), but false for those linked on Cheetah (10.0) or any of its software updates (10.0.x). You will also get back false for any app whose version info could not be figured out.
     This function caches its results, so no need to cache at call sites.
 
@@ -520,7 +520,7 @@ static void _XMLPlistAppendDataUsingBase64(CFMutableDataRef mData, CFDataRef inp
     }
 }
 
-extern CFStringRef __CFNumberCopyFormattingDescriptionAsFloat64(CFTypeRef cf);
+extern CFIndex __CFNumberGetFormattingDescriptionAsFloat64CString(Float64 d, char *buffer);
 
 static void _CFAppendXML0(CFTypeRef object, UInt32 indentation, CFMutableDataRef xmlString) {
     UInt32 typeID = CFGetTypeID(object);
@@ -643,9 +643,11 @@ if (date.year != y || date.month != M || date.day != d || date.hour != H || date
             _plistAppendUTF8CString(xmlString, "<");
             _plistAppendCharacters(xmlString, CFXMLPlistTagsUnicode[REAL_IX], REAL_TAG_LENGTH);
             _plistAppendUTF8CString(xmlString, ">");
-                CFStringRef s = __CFNumberCopyFormattingDescriptionAsFloat64(object);
-                _plistAppendString(xmlString, s);
-                CFRelease(s);
+            Float64 d;
+            char buffer[32];
+            CFNumberGetValue((CFNumberRef)object, kCFNumberFloat64Type, &d);
+            __CFNumberGetFormattingDescriptionAsFloat64CString(d, buffer);
+            _plistAppendUTF8CString(xmlString, buffer);
             _plistAppendUTF8CString(xmlString, "</");
             _plistAppendCharacters(xmlString, CFXMLPlistTagsUnicode[REAL_IX], REAL_TAG_LENGTH);
             _plistAppendUTF8CString(xmlString, ">\n");
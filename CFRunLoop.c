@@ -26,6 +26,11 @@
 	Responsibility: Tony Parker
 */
 
+#if DEPLOYMENT_TARGET_LINUX
+// cpu_set_t and pthread_setaffinity_np, for pinning run loop group threads; effective only if no C library header came first
+#define _GNU_SOURCE 1
+#endif
+
 #include <CoreFoundation/CFRunLoop.h>
 #include <CoreFoundation/CFSet.h>
 #include <CoreFoundation/CFBag.h>
@@ -72,6 +77,11 @@ DISPATCH_EXPORT void _dispatch_main_queue_callback_4CF(void);
 
 #endif
 
+#if DEPLOYMENT_TARGET_LINUX
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
 #if DEPLOYMENT_TARGET_WINDOWS || DEPLOYMENT_TARGET_IPHONESIMULATOR
 CF_EXPORT pthread_t _CF_pthread_main_thread_np(void);
 #define pthread_main_thread_np() _CF_pthread_main_thread_np()
@@ -80,6 +90,10 @@ CF_EXPORT pthread_t _CF_pthread_main_thread_np(void);
 #include <Block.h>
 #include <Block_private.h>
 
+#if DEPLOYMENT_TARGET_LINUX
+#include <sched.h>
+#endif
+
 #if DEPLOYMENT_TARGET_MACOSX
 #define USE_DISPATCH_SOURCE_FOR_TIMERS 1
 #define USE_MK_TIMER_TOO 1
@@ -550,6 +564,7 @@ struct __CFRunLoopMode {
 #endif
     uint64_t _timerSoftDeadline; /* TSR */
     uint64_t _timerHardDeadline; /* TSR */
+    struct __CFRunLoopModeStats * volatile _stats;	/* allocated the first time something is recorded while profiling */
 };
 
 CF_INLINE void __CFRunLoopModeLock(CFRunLoopModeRef rlm) {
@@ -562,6 +577,99 @@ CF_INLINE void __CFRunLoopModeUnlock(CFRunLoopModeRef rlm) {
     pthread_mutex_unlock(&(rlm->_lock));
 }
 
+#pragma mark Profiling
+
+/* Bucket i of a histogram counts samples of [2^i, 2^(i+1)) microseconds, except that bucket 0 also takes everything under 1us and the last bucket takes everything longer. */
+#define __CFRUNLOOP_HISTOGRAM_BUCKETS 32
+
+typedef struct {
+    uint64_t count;
+    uint64_t totalNS;
+    uint64_t maxNS;
+    uint64_t buckets[__CFRUNLOOP_HISTOGRAM_BUCKETS];
+} __CFRunLoopHistogram;
+
+enum {
+    __kCFRunLoopCalloutTimer = 0,
+    __kCFRunLoopCalloutSource0,
+    __kCFRunLoopCalloutSource1,
+    __kCFRunLoopCalloutObserver,
+    __kCFRunLoopCalloutBlock,
+    __kCFRunLoopCalloutKindCount
+};
+
+/* Only the thread running the mode records into its stats, but they can be copied or reset from any thread, so all access goes through _lock */
+struct __CFRunLoopModeStats {
+    CFLock_t _lock;
+    __CFRunLoopHistogram _callouts[__kCFRunLoopCalloutKindCount];
+    __CFRunLoopHistogram _timerLateness;
+    __CFRunLoopHistogram _sleep;
+    uint64_t _wakeups;
+    CFMutableDictionaryRef _perFunction;	/* callout function address -> malloc'd __CFRunLoopHistogram; no callbacks */
+};
+
+static void __CFRunLoopHistogramFree(const void *key, const void *value, void *context) {
+    free((void *)value);
+}
+
+static void __CFRunLoopModeStatsClear(struct __CFRunLoopModeStats *stats) {
+    memset(stats->_callouts, 0, sizeof(stats->_callouts));
+    memset(&stats->_timerLateness, 0, sizeof(stats->_timerLateness));
+    memset(&stats->_sleep, 0, sizeof(stats->_sleep));
+    stats->_wakeups = 0;
+    CFDictionaryApplyFunction(stats->_perFunction, __CFRunLoopHistogramFree, NULL);
+    CFDictionaryRemoveAllValues(stats->_perFunction);
+}
+
+static void __CFRunLoopModeStatsFree(struct __CFRunLoopModeStats *stats) {
+    CFDictionaryApplyFunction(stats->_perFunction, __CFRunLoopHistogramFree, NULL);
+    CFRelease(stats->_perFunction);
+    free(stats);
+}
+
+static struct __CFRunLoopModeStats *__CFRunLoopModeGetStats(CFRunLoopModeRef rlm) {
+    struct __CFRunLoopModeStats *stats = rlm->_stats;
+    if (stats) return stats;
+    stats = (struct __CFRunLoopModeStats *)calloc(1, sizeof(struct __CFRunLoopModeStats));
+    stats->_lock = CFLockInit;
+    stats->_perFunction = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, NULL, NULL);
+    if (!OSAtomicCompareAndSwapPtrBarrier(NULL, stats, (void * volatile *)&rlm->_stats)) {
+        __CFRunLoopModeStatsFree(stats);
+        stats = rlm->_stats;
+    }
+    return stats;
+}
+
+CF_INLINE void __CFRunLoopHistogramAdd(__CFRunLoopHistogram *histogram, uint64_t ns) {
+    uint64_t us = ns / 1000;
+    CFIndex bucket = (us < 2) ? 0 : flsl((long)__CFMin(us, (uint64_t)LONG_MAX)) - 1;
+    if (__CFRUNLOOP_HISTOGRAM_BUCKETS <= bucket) bucket = __CFRUNLOOP_HISTOGRAM_BUCKETS - 1;
+    histogram->count++;
+    histogram->totalNS += ns;
+    if (histogram->maxNS < ns) histogram->maxNS = ns;
+    histogram->buckets[bucket]++;
+}
+
+static CFDictionaryRef __CFRunLoopHistogramCopyDictionary(const __CFRunLoopHistogram *histogram) {
+    CFNumberRef buckets[__CFRUNLOOP_HISTOGRAM_BUCKETS];
+    for (CFIndex idx = 0; idx < __CFRUNLOOP_HISTOGRAM_BUCKETS; idx++) {
+        buckets[idx] = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberSInt64Type, &histogram->buckets[idx]);
+    }
+    CFArrayRef bucketArray = CFArrayCreate(kCFAllocatorSystemDefault, (const void **)buckets, __CFRUNLOOP_HISTOGRAM_BUCKETS, &kCFTypeArrayCallBacks);
+    for (CFIndex idx = 0; idx < __CFRUNLOOP_HISTOGRAM_BUCKETS; idx++) CFRelease(buckets[idx]);
+    CFNumberRef count = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberSInt64Type, &histogram->count);
+    CFNumberRef total = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberSInt64Type, &histogram->totalNS);
+    CFNumberRef max = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberSInt64Type, &histogram->maxNS);
+    const void *keys[4] = {CFSTR("count"), CFSTR("totalNanoseconds"), CFSTR("maxNanoseconds"), CFSTR("log2MicrosecondBuckets")};
+    const void *values[4] = {count, total, max, bucketArray};
+    CFDictionaryRef result = CFDictionaryCreate(kCFAllocatorSystemDefault, keys, values, 4, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    CFRelease(count);
+    CFRelease(total);
+    CFRelease(max);
+    CFRelease(bucketArray);
+    return result;
+}
+
 static Boolean __CFRunLoopModeEqual(CFTypeRef cf1, CFTypeRef cf2) {
     CFRunLoopModeRef rlm1 = (CFRunLoopModeRef)cf1;
     CFRunLoopModeRef rlm2 = (CFRunLoopModeRef)cf2;
@@ -614,6 +722,7 @@ static void __CFRunLoopModeDeallocate(CFTypeRef cf) {
 #if USE_MK_TIMER_TOO
     if (MACH_PORT_NULL != rlm->_timerPort) mk_timer_destroy(rlm->_timerPort);
 #endif
+    if (rlm->_stats) __CFRunLoopModeStatsFree(rlm->_stats);
     pthread_mutex_destroy(&rlm->_lock);
     memset((char *)cf + sizeof(CFRuntimeBase), 0x7C, sizeof(struct __CFRunLoopMode) - sizeof(CFRuntimeBase));
 }
@@ -627,6 +736,11 @@ struct _block_item {
     void (^_block)(void);
 };
 
+struct _signalled_item {
+    struct _signalled_item *_next;
+    CFRunLoopSourceRef _source;	// retained
+};
+
 typedef struct _per_run_data {
     uint32_t a;
     uint32_t b;
@@ -648,9 +762,15 @@ struct __CFRunLoop {
     CFMutableSetRef _modes;
     struct _block_item *_blocks_head;
     struct _block_item *_blocks_tail;
+    struct _block_item * volatile _blocks_posted;	// lock-free LIFO of blocks from CFRunLoopPerformBlock, not yet moved to _blocks_head
+    struct _signalled_item * volatile _signalled_posted;	// lock-free LIFO of version 0 sources from CFRunLoopSourceSignal, not yet moved to _signalled
+    struct _signalled_item *_signalled;	// version 0 sources signalled but not yet performed by this run loop
+    CFStringRef volatile _lastPostedMode;	// name of a mode CFRunLoopPerformBlock last found or created; modes are never removed
     CFAbsoluteTime _runTime;
     CFAbsoluteTime _sleepTime;
     CFTypeRef _counterpart;
+    volatile Boolean _profiling;
+    uint64_t _profilingStartTSR;
 };
 
 /* Bit 0 of the base reserved bits is used for stopped state */
@@ -754,6 +874,163 @@ CF_INLINE void __CFRunLoopLockInit(pthread_mutex_t *lock) {
 }
 
 /* call with rl locked, returns mode locked */
+static CFRunLoopModeRef __CFRunLoopFindMode(CFRunLoopRef rl, CFStringRef modeName, Boolean create);
+
+// Returns the TSR to pass to __CFRunLoopRecordCallout() after the callout, or 0 when not profiling; this check is all profiling costs while disabled
+CF_INLINE uint64_t __CFRunLoopCalloutStart(CFRunLoopRef rl) {
+    return __builtin_expect(rl->_profiling, 0) ? mach_absolute_time() : 0;
+}
+
+static void __CFRunLoopRecordCallout(CFRunLoopModeRef rlm, CFIndex kind, const void *function, uint64_t startTSR) {
+    uint64_t ns = __CFTSRToNanoseconds(mach_absolute_time() - startTSR);
+    struct __CFRunLoopModeStats *stats = __CFRunLoopModeGetStats(rlm);
+    __CFLock(&stats->_lock);
+    __CFRunLoopHistogramAdd(&stats->_callouts[kind], ns);
+    if (function) {
+        __CFRunLoopHistogram *histogram = (__CFRunLoopHistogram *)CFDictionaryGetValue(stats->_perFunction, function);
+        if (!histogram) {
+            histogram = (__CFRunLoopHistogram *)calloc(1, sizeof(__CFRunLoopHistogram));
+            CFDictionarySetValue(stats->_perFunction, function, histogram);
+        }
+        __CFRunLoopHistogramAdd(histogram, ns);
+    }
+    __CFUnlock(&stats->_lock);
+}
+
+static void __CFRunLoopRecordTimerLateness(CFRunLoopModeRef rlm, uint64_t fireTSR, uint64_t nowTSR) {
+    struct __CFRunLoopModeStats *stats = __CFRunLoopModeGetStats(rlm);
+    __CFLock(&stats->_lock);
+    __CFRunLoopHistogramAdd(&stats->_timerLateness, (fireTSR < nowTSR) ? __CFTSRToNanoseconds(nowTSR - fireTSR) : 0);
+    __CFUnlock(&stats->_lock);
+}
+
+static void __CFRunLoopRecordSleep(CFRunLoopModeRef rlm, uint64_t startTSR) {
+    uint64_t ns = __CFTSRToNanoseconds(mach_absolute_time() - startTSR);
+    struct __CFRunLoopModeStats *stats = __CFRunLoopModeGetStats(rlm);
+    __CFLock(&stats->_lock);
+    __CFRunLoopHistogramAdd(&stats->_sleep, ns);
+    stats->_wakeups++;
+    __CFUnlock(&stats->_lock);
+}
+
+void _CFRunLoopSetProfilingEnabled(CFRunLoopRef rl, Boolean enabled) {
+    CHECK_FOR_FORK();
+    __CFRunLoopLock(rl);
+    if (enabled && !rl->_profiling) rl->_profilingStartTSR = mach_absolute_time();
+    rl->_profiling = enabled;
+    __CFRunLoopUnlock(rl);
+}
+
+Boolean _CFRunLoopIsProfilingEnabled(CFRunLoopRef rl) {
+    CHECK_FOR_FORK();
+    return rl->_profiling;
+}
+
+static void __CFRunLoopResetModeStats(const void *value, void *context) {
+    CFRunLoopModeRef rlm = (CFRunLoopModeRef)value;
+    struct __CFRunLoopModeStats *stats = rlm->_stats;
+    if (!stats) return;
+    __CFLock(&stats->_lock);
+    __CFRunLoopModeStatsClear(stats);
+    __CFUnlock(&stats->_lock);
+}
+
+void _CFRunLoopResetProfilingStatistics(CFRunLoopRef rl) {
+    CHECK_FOR_FORK();
+    __CFRunLoopLock(rl);
+    CFSetApplyFunction(rl->_modes, __CFRunLoopResetModeStats, NULL);
+    rl->_profilingStartTSR = mach_absolute_time();
+    __CFRunLoopUnlock(rl);
+}
+
+static void __CFRunLoopCopyFunctionStats(const void *key, const void *value, void *context) {
+    CFStringRef name = CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("%p"), key);
+    CFDictionaryRef histogram = __CFRunLoopHistogramCopyDictionary((const __CFRunLoopHistogram *)value);
+    CFDictionarySetValue((CFMutableDictionaryRef)context, name, histogram);
+    CFRelease(histogram);
+    CFRelease(name);
+}
+
+static void __CFRunLoopCopyModeStats(const void *value, void *context) {
+    CFRunLoopModeRef rlm = (CFRunLoopModeRef)value;
+    CFMutableDictionaryRef result = ((CFMutableDictionaryRef *)context)[0];
+    CFTimeInterval elapsed = *((CFTimeInterval *)((CFMutableDictionaryRef *)context)[1]);
+    struct __CFRunLoopModeStats *stats = rlm->_stats;
+    if (!stats) return;
+    static const CFStringRef calloutKeys[__kCFRunLoopCalloutKindCount] = {CFSTR("timers"), CFSTR("sources0"), CFSTR("sources1"), CFSTR("observers"), CFSTR("blocks")};
+    CFMutableDictionaryRef modeStats = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    CFMutableDictionaryRef functionStats = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    __CFLock(&stats->_lock);
+    for (CFIndex kind = 0; kind < __kCFRunLoopCalloutKindCount; kind++) {
+        CFDictionaryRef histogram = __CFRunLoopHistogramCopyDictionary(&stats->_callouts[kind]);
+        CFDictionarySetValue(modeStats, calloutKeys[kind], histogram);
+        CFRelease(histogram);
+    }
+    CFDictionaryRef lateness = __CFRunLoopHistogramCopyDictionary(&stats->_timerLateness);
+    CFDictionaryRef sleep = __CFRunLoopHistogramCopyDictionary(&stats->_sleep);
+    uint64_t wakeups = stats->_wakeups;
+    CFDictionaryApplyFunction(stats->_perFunction, __CFRunLoopCopyFunctionStats, functionStats);
+    __CFUnlock(&stats->_lock);
+    double rate = (0.0 < elapsed) ? (double)wakeups / elapsed : 0.0;
+    CFNumberRef wakeupCount = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberSInt64Type, &wakeups);
+    CFNumberRef wakeupRate = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberDoubleType, &rate);
+    CFDictionarySetValue(modeStats, CFSTR("timerLateness"), lateness);
+    CFDictionarySetValue(modeStats, CFSTR("sleep"), sleep);
+    CFDictionarySetValue(modeStats, CFSTR("wakeups"), wakeupCount);
+    CFDictionarySetValue(modeStats, CFSTR("wakeupsPerSecond"), wakeupRate);
+    CFDictionarySetValue(modeStats, CFSTR("calloutFunctions"), functionStats);
+    CFRelease(lateness);
+    CFRelease(sleep);
+    CFRelease(wakeupCount);
+    CFRelease(wakeupRate);
+    CFRelease(functionStats);
+    CFDictionarySetValue(result, rlm->_name, modeStats);
+    CFRelease(modeStats);
+}
+
+CFDictionaryRef _CFRunLoopCopyProfilingStatistics(CFRunLoopRef rl) {
+    CHECK_FOR_FORK();
+    CFMutableDictionaryRef result = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    __CFRunLoopLock(rl);
+    CFTimeInterval elapsed = __CFTSRToTimeInterval(mach_absolute_time() - rl->_profilingStartTSR);
+    void *context[2] = {result, &elapsed};
+    CFSetApplyFunction(rl->_modes, __CFRunLoopCopyModeStats, context);
+    __CFRunLoopUnlock(rl);
+    return result;
+}
+
+// Detaches everything posted by CFRunLoopPerformBlock so far; the result is in posting order
+static struct _block_item *__CFRunLoopTakePostedBlocks(CFRunLoopRef rl) {
+    struct _block_item *posted;
+    do {
+        posted = rl->_blocks_posted;
+        if (!posted) return NULL;
+    } while (!OSAtomicCompareAndSwapPtrBarrier(posted, NULL, (void * volatile *)&rl->_blocks_posted));
+    struct _block_item *reversed = NULL;
+    while (posted) {
+        struct _block_item *next = posted->_next;
+        posted->_next = reversed;
+        reversed = posted;
+        posted = next;
+    }
+    return reversed;
+}
+
+/* Call with rl locked; rlm may be locked too. Moves the posted blocks onto the end of the run loop's block list in one batch; CFRunLoopPerformBlock has already created the modes they name. */
+static void __CFRunLoopDrainPostedBlocks(CFRunLoopRef rl) {
+    if (!rl->_blocks_posted) return;
+    struct _block_item *head = __CFRunLoopTakePostedBlocks(rl);
+    if (!head) return;
+    struct _block_item *tail = head;
+    while (tail->_next) tail = tail->_next;
+    if (!rl->_blocks_tail) {
+        rl->_blocks_head = head;
+    } else {
+        rl->_blocks_tail->_next = head;
+    }
+    rl->_blocks_tail = tail;
+}
+
 static CFRunLoopModeRef __CFRunLoopFindMode(CFRunLoopRef rl, CFStringRef modeName, Boolean create) {
     CHECK_FOR_FORK();
     CFRunLoopModeRef rlm;
@@ -785,6 +1062,7 @@ static CFRunLoopModeRef __CFRunLoopFindMode(CFRunLoopRef rl, CFStringRef modeNam
     rlm->_portSet = __CFPortSetAllocate();
     rlm->_timerSoftDeadline = UINT64_MAX;
     rlm->_timerHardDeadline = UINT64_MAX;
+    rlm->_stats = NULL;
     
     kern_return_t ret = KERN_SUCCESS;
 #if USE_DISPATCH_SOURCE_FOR_TIMERS
@@ -839,6 +1117,7 @@ static Boolean __CFRunLoopModeIsEmpty(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFR
     if (NULL != rlm->_sources0 && 0 < CFSetGetCount(rlm->_sources0)) return false;
     if (NULL != rlm->_sources1 && 0 < CFSetGetCount(rlm->_sources1)) return false;
     if (NULL != rlm->_timers && 0 < CFArrayGetCount(rlm->_timers)) return false;
+    __CFRunLoopDrainPostedBlocks(rl);
     struct _block_item *item = rl->_blocks_head;
     while (item) {
         struct _block_item *curr = item;
@@ -949,24 +1228,42 @@ struct __CFRunLoopSource {
     pthread_mutex_t _lock;
     CFIndex _order;			/* immutable */
     CFMutableBagRef _runLoops;
+    struct _signal_loops * volatile _signalLoops;	// copy of _runLoops for CFRunLoopSourceSignal, which does not take _lock
+    volatile int32_t _signalReaders;	// CFRunLoopSourceSignal calls reading _signalLoops
     union {
 	CFRunLoopSourceContext version0;	/* immutable, except invalidation */
         CFRunLoopSourceContext1 version1;	/* immutable, except invalidation */
     } _context;
 };
 
+/* The run loops a version 0 source is scheduled in, each once */
+struct _signal_loops {
+    CFIndex _count;
+    CFRunLoopRef _loops[];
+};
+
 /* Bit 1 of the base reserved bits is used for signalled state */
 
 CF_INLINE Boolean __CFRunLoopSourceIsSignaled(CFRunLoopSourceRef rls) {
     return (Boolean)__CFBitfieldGetValue(rls->_bits, 1, 1);
 }
 
-CF_INLINE void __CFRunLoopSourceSetSignaled(CFRunLoopSourceRef rls) {
-    __CFBitfieldSetValue(rls->_bits, 1, 1, 1);
+// The signalled bit is updated atomically, so that a CFRunLoopSourceSignal() that finds it already set needs no lock at all; returns true if this call set it
+CF_INLINE Boolean __CFRunLoopSourceSetSignaled(CFRunLoopSourceRef rls) {
+    uint32_t bits;
+    do {
+        bits = rls->_bits;
+        if (bits & (1U << 1)) return false;
+    } while (!OSAtomicCompareAndSwap32Barrier((int32_t)bits, (int32_t)(bits | (1U << 1)), (volatile int32_t *)&rls->_bits));
+    return true;
 }
 
 CF_INLINE void __CFRunLoopSourceUnsetSignaled(CFRunLoopSourceRef rls) {
-    __CFBitfieldSetValue(rls->_bits, 1, 1, 0);
+    uint32_t bits;
+    do {
+        bits = rls->_bits;
+        if (!(bits & (1U << 1))) return;
+    } while (!OSAtomicCompareAndSwap32Barrier((int32_t)bits, (int32_t)(bits & ~(1U << 1)), (volatile int32_t *)&rls->_bits));
 }
 
 CF_INLINE void __CFRunLoopSourceLock(CFRunLoopSourceRef rls) {
@@ -979,6 +1276,61 @@ CF_INLINE void __CFRunLoopSourceUnlock(CFRunLoopSourceRef rls) {
     pthread_mutex_unlock(&(rls->_lock));
 }
 
+/* Queues a signalled version 0 source for rl to perform; lock-free, so any number of threads may post while the loop drains. The caller keeps rl alive. Returns true if the queue was empty, that is if this starts a batch that rl has not been woken for. */
+static Boolean __CFRunLoopPostSignalledSource(CFRunLoopRef rl, CFRunLoopSourceRef rls) {
+    struct _signalled_item *new_item = (struct _signalled_item *)malloc(sizeof(struct _signalled_item));
+    new_item->_source = (CFRunLoopSourceRef)CFRetain(rls);
+    struct _signalled_item *posted;
+    do {
+        posted = rl->_signalled_posted;
+        new_item->_next = posted;
+    } while (!OSAtomicCompareAndSwapPtrBarrier(posted, new_item, (void * volatile *)&rl->_signalled_posted));
+    return (NULL == posted);
+}
+
+/* Call with rls locked, after each change to rls->_runLoops. Replaces the copy of the run loops that CFRunLoopSourceSignal reads, then waits out the signals still reading the old copy: a run loop dropped from it may be deallocated once the source is unlocked. Only the signal that sets the signalled bit reads the copy, so there are never more than a few to wait for. */
+static void __CFRunLoopSourcePublishLoops(CFRunLoopSourceRef rls) {
+    struct _signal_loops *loops = NULL;
+    CFIndex cnt = (0 == rls->_context.version0.version && NULL != rls->_runLoops) ? CFBagGetCount(rls->_runLoops) : 0;
+    if (0 < cnt) {
+        loops = (struct _signal_loops *)malloc(sizeof(struct _signal_loops) + cnt * sizeof(CFRunLoopRef));
+        STACK_BUFFER_DECL(const void *, values, cnt);
+        CFBagGetValues(rls->_runLoops, values);
+        // the bag holds a run loop once for each of its modes the source is in
+        loops->_count = 0;
+        for (CFIndex idx = 0; idx < cnt; idx++) {
+            CFIndex found = 0;
+            while (found < loops->_count && loops->_loops[found] != values[idx]) found++;
+            if (found == loops->_count) loops->_loops[loops->_count++] = (CFRunLoopRef)values[idx];
+        }
+    }
+    struct _signal_loops *old;
+    do {
+        old = rls->_signalLoops;
+    } while (!OSAtomicCompareAndSwapPtrBarrier(old, loops, (void * volatile *)&rls->_signalLoops));
+    while (0 != rls->_signalReaders) {
+#if DEPLOYMENT_TARGET_WINDOWS
+        SwitchToThread();
+#else
+        sched_yield();
+#endif
+    }
+    if (old) free(old);
+}
+
+/* Call with rl locked. Moves the sources posted so far onto rl->_signalled in one batch. */
+static void __CFRunLoopTakeSignalledSources(CFRunLoopRef rl) {
+    struct _signalled_item *posted;
+    do {
+        posted = rl->_signalled_posted;
+        if (!posted) return;
+    } while (!OSAtomicCompareAndSwapPtrBarrier(posted, NULL, (void * volatile *)&rl->_signalled_posted));
+    struct _signalled_item *last = posted;
+    while (last->_next) last = last->_next;
+    last->_next = rl->_signalled;
+    rl->_signalled = posted;
+}
+
 #pragma mark Observers
 
 struct __CFRunLoopObserver {
@@ -1144,6 +1496,7 @@ static void __CFRunLoopCleanseSources(const void *value, void *context) {
 	__CFRunLoopSourceLock(rls);
 	if (NULL != rls->_runLoops) {
 	    CFBagRemoveValue(rls->_runLoops, rl);
+	    __CFRunLoopSourcePublishLoops(rls);
 	}
 	__CFRunLoopSourceUnlock(rls);
     }
@@ -1171,6 +1524,7 @@ static void __CFRunLoopDeallocateSources(const void *value, void *context) {
         __CFRunLoopSourceLock(rls);
         if (NULL != rls->_runLoops) {
             CFBagRemoveValue(rls->_runLoops, rl);
+            __CFRunLoopSourcePublishLoops(rls);
         }
         __CFRunLoopSourceUnlock(rls);
         if (0 == rls->_context.version0.version) {
@@ -1269,6 +1623,22 @@ static void __CFRunLoopDeallocate(CFTypeRef cf) {
 	Block_release(curr->_block);
 	free(curr);
     }
+    item = __CFRunLoopTakePostedBlocks(rl);
+    while (item) {
+	struct _block_item *curr = item;
+	item = item->_next;
+	CFRelease(curr->_mode);
+	Block_release(curr->_block);
+	free(curr);
+    }
+    __CFRunLoopTakeSignalledSources(rl);
+    struct _signalled_item *signalled = rl->_signalled;
+    while (signalled) {
+	struct _signalled_item *curr = signalled;
+	signalled = signalled->_next;
+	CFRelease(curr->_source);
+	free(curr);
+    }
     if (NULL != rl->_commonModeItems) {
 	CFRelease(rl->_commonModeItems);
     }
@@ -1338,7 +1708,13 @@ static CFRunLoopRef __CFRunLoopCreate(pthread_t t) {
     loop->_modes = CFSetCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeSetCallBacks);
     loop->_blocks_head = NULL;
     loop->_blocks_tail = NULL;
+    loop->_blocks_posted = NULL;
+    loop->_signalled_posted = NULL;
+    loop->_signalled = NULL;
+    loop->_lastPostedMode = NULL;
     loop->_counterpart = NULL;
+    loop->_profiling = false;
+    loop->_profilingStartTSR = 0;
     loop->_pthread = t;
 #if DEPLOYMENT_TARGET_WINDOWS
     loop->_winthread = GetCurrentThreadId();
@@ -1616,6 +1992,7 @@ static void __CFRUNLOOP_IS_CALLING_OUT_TO_A_BLOCK__(void (^block)(void)) {
 }
 
 static Boolean __CFRunLoopDoBlocks(CFRunLoopRef rl, CFRunLoopModeRef rlm) { // Call with rl and rlm locked
+    __CFRunLoopDrainPostedBlocks(rl);
     if (!rl->_blocks_head) return false;
     if (!rlm || !rlm->_name) return false;
     Boolean did = false;
@@ -1647,7 +2024,9 @@ static Boolean __CFRunLoopDoBlocks(CFRunLoopRef rl, CFRunLoopModeRef rlm) { // C
             CFRelease(curr->_mode);
             free(curr);
 	    if (doit) {
+                uint64_t calloutStart = __CFRunLoopCalloutStart(rl);
                 __CFRUNLOOP_IS_CALLING_OUT_TO_A_BLOCK__(block);
+                if (calloutStart) __CFRunLoopRecordCallout(rlm, __kCFRunLoopCalloutBlock, NULL, calloutStart);
 	        did = true;
 	    }
             Block_release(block); // do this before relocking to prevent deadlocks where some yahoo wants to run the run loop reentrantly from their dealloc
@@ -1690,7 +2069,9 @@ static void __CFRunLoopDoObservers(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFRunL
             Boolean doInvalidate = !__CFRunLoopObserverRepeats(rlo);
             __CFRunLoopObserverSetFiring(rlo);
             __CFRunLoopObserverUnlock(rlo);
+            uint64_t calloutStart = __CFRunLoopCalloutStart(rl);
             __CFRUNLOOP_IS_CALLING_OUT_TO_AN_OBSERVER_CALLBACK_FUNCTION__(rlo->_callout, rlo, activity, rlo->_context.info);
+            if (calloutStart) __CFRunLoopRecordCallout(rlm, __kCFRunLoopCalloutObserver, (const void *)rlo->_callout, calloutStart);
             if (doInvalidate) {
                 CFRunLoopObserverInvalidate(rlo);
             }
@@ -1711,6 +2092,9 @@ static CFComparisonResult __CFRunLoopSourceComparator(const void *val1, const vo
     CFRunLoopSourceRef o2 = (CFRunLoopSourceRef)val2;
     if (o1->_order < o2->_order) return kCFCompareLessThan;
     if (o2->_order < o1->_order) return kCFCompareGreaterThan;
+    // ties are broken by address so that a source queued twice sorts next to itself
+    if ((uintptr_t)o1 < (uintptr_t)o2) return kCFCompareLessThan;
+    if ((uintptr_t)o2 < (uintptr_t)o1) return kCFCompareGreaterThan;
     return kCFCompareEqualTo;
 }
 
@@ -1764,15 +2148,50 @@ static Boolean __CFRunLoopDoSources0(CFRunLoopRef rl, CFRunLoopModeRef rlm, Bool
 static Boolean __CFRunLoopDoSources0(CFRunLoopRef rl, CFRunLoopModeRef rlm, Boolean stopAfterHandle) {	/* DOES CALLOUT */
     CHECK_FOR_FORK();
     CFTypeRef sources = NULL;
+    struct _signalled_item *dropped = NULL;
     Boolean sourceHandled = false;
 
     /* Fire the version 0 sources */
-    if (NULL != rlm->_sources0 && 0 < CFSetGetCount(rlm->_sources0)) {
-	CFSetApplyFunction(rlm->_sources0, (__CFRunLoopCollectSources0), &sources);
+    // Only the sources queued by CFRunLoopSourceSignal() are visited, rather than every source in the mode
+    __CFRunLoopTakeSignalledSources(rl);
+    struct _signalled_item **link = &rl->_signalled;
+    while (*link) {
+	struct _signalled_item *item = *link;
+	CFRunLoopSourceRef rls = item->_source;
+	Boolean keep = false;
+	if (__CFIsValid(rls) && __CFRunLoopSourceIsSignaled(rls)) {
+	    if (NULL != rlm->_sources0 && CFSetContainsValue(rlm->_sources0, rls)) {
+		__CFRunLoopCollectSources0(rls, &sources);
+	    } else {
+		// signalled for another mode; keep it for when that mode runs, unless it has left this run loop
+		__CFRunLoopSourceLock(rls);
+		keep = (NULL != rls->_runLoops && CFBagContainsValue(rls->_runLoops, rl));
+		__CFRunLoopSourceUnlock(rls);
+	    }
+	}
+	if (keep) {
+	    link = &item->_next;
+	} else {
+	    *link = item->_next;
+	    item->_next = dropped;
+	    dropped = item;
+	}
     }
-    if (NULL != sources) {
+    if (NULL != sources || NULL != dropped) {
 	__CFRunLoopModeUnlock(rlm);
 	__CFRunLoopUnlock(rl);
+	// released with the run loop unlocked, since this may be the last reference to a source
+	while (dropped) {
+	    struct _signalled_item *curr = dropped;
+	    dropped = dropped->_next;
+	    CFRelease(curr->_source);
+	    free(curr);
+	}
+	if (NULL == sources) {
+	    __CFRunLoopLock(rl);
+	    __CFRunLoopModeLock(rlm);
+	    return false;
+	}
 	// sources is either a single (retained) CFRunLoopSourceRef or an array of (retained) CFRunLoopSourceRef
 	if (CFGetTypeID(sources) == CFRunLoopSourceGetTypeID()) {
 	    CFRunLoopSourceRef rls = (CFRunLoopSourceRef)sources;
@@ -1781,7 +2200,10 @@ static Boolean __CFRunLoopDoSources0(CFRunLoopRef rl, CFRunLoopModeRef rlm, Bool
 	        __CFRunLoopSourceUnsetSignaled(rls);
 	        if (__CFIsValid(rls)) {
 	            __CFRunLoopSourceUnlock(rls);
-                    __CFRUNLOOP_IS_CALLING_OUT_TO_A_SOURCE0_PERFORM_FUNCTION__(rls->_context.version0.perform, rls->_context.version0.info);
+                    void (*perform)(void *) = rls->_context.version0.perform;
+                    uint64_t calloutStart = __CFRunLoopCalloutStart(rl);
+                    __CFRUNLOOP_IS_CALLING_OUT_TO_A_SOURCE0_PERFORM_FUNCTION__(perform, rls->_context.version0.info);
+                    if (calloutStart) __CFRunLoopRecordCallout(rlm, __kCFRunLoopCalloutSource0, (const void *)perform, calloutStart);
 	            CHECK_FOR_FORK();
 	            sourceHandled = true;
 	        } else {
@@ -1795,12 +2217,16 @@ static Boolean __CFRunLoopDoSources0(CFRunLoopRef rl, CFRunLoopModeRef rlm, Bool
 	    CFArraySortValues((CFMutableArrayRef)sources, CFRangeMake(0, cnt), (__CFRunLoopSourceComparator), NULL);
 	    for (CFIndex idx = 0; idx < cnt; idx++) {
 		CFRunLoopSourceRef rls = (CFRunLoopSourceRef)CFArrayGetValueAtIndex((CFArrayRef)sources, idx);
+		if (0 < idx && rls == (CFRunLoopSourceRef)CFArrayGetValueAtIndex((CFArrayRef)sources, idx - 1)) continue;	// queued twice
 		__CFRunLoopSourceLock(rls);
                 if (__CFRunLoopSourceIsSignaled(rls)) {
 		    __CFRunLoopSourceUnsetSignaled(rls);
 		    if (__CFIsValid(rls)) {
 		        __CFRunLoopSourceUnlock(rls);
-                        __CFRUNLOOP_IS_CALLING_OUT_TO_A_SOURCE0_PERFORM_FUNCTION__(rls->_context.version0.perform, rls->_context.version0.info);
+                        void (*perform)(void *) = rls->_context.version0.perform;
+                        uint64_t calloutStart = __CFRunLoopCalloutStart(rl);
+                        __CFRUNLOOP_IS_CALLING_OUT_TO_A_SOURCE0_PERFORM_FUNCTION__(perform, rls->_context.version0.info);
+                        if (calloutStart) __CFRunLoopRecordCallout(rlm, __kCFRunLoopCalloutSource0, (const void *)perform, calloutStart);
 		        CHECK_FOR_FORK();
 		        sourceHandled = true;
 		    } else {
@@ -1810,6 +2236,15 @@ static Boolean __CFRunLoopDoSources0(CFRunLoopRef rl, CFRunLoopModeRef rlm, Bool
                     __CFRunLoopSourceUnlock(rls);
                 }
 		if (stopAfterHandle && sourceHandled) {
+		    // the rest are still signalled; queue them again for the next pass
+		    for (idx++; idx < cnt; idx++) {
+			CFRunLoopSourceRef rest = (CFRunLoopSourceRef)CFArrayGetValueAtIndex((CFArrayRef)sources, idx);
+			__CFRunLoopSourceLock(rest);
+			if (__CFRunLoopSourceIsSignaled(rest) && NULL != rest->_runLoops && CFBagContainsValue(rest->_runLoops, rl)) {
+			    (void)__CFRunLoopPostSignalledSource(rl, rest);
+			}
+			__CFRunLoopSourceUnlock(rest);
+		    }
 		    break;
 		}
 	    }
@@ -1843,11 +2278,13 @@ static Boolean __CFRunLoopDoSource1(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFRun
 	__CFRunLoopSourceUnsetSignaled(rls);
 	__CFRunLoopSourceUnlock(rls);
         __CFRunLoopDebugInfoForRunLoopSource(rls);
+        uint64_t calloutStart = __CFRunLoopCalloutStart(rl);
         __CFRUNLOOP_IS_CALLING_OUT_TO_A_SOURCE1_PERFORM_FUNCTION__(rls->_context.version1.perform,
 #if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI
             msg, size, reply,
 #endif
             rls->_context.version1.info);
+        if (calloutStart) __CFRunLoopRecordCallout(rlm, __kCFRunLoopCalloutSource1, (const void *)rls->_context.version1.perform, calloutStart);
 	CHECK_FOR_FORK();
 	sourceHandled = true;
     } else {
@@ -2052,7 +2489,10 @@ static Boolean __CFRunLoopDoTimer(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFRunLo
 
 	__CFRunLoopModeUnlock(rlm);
 	__CFRunLoopUnlock(rl);
+        uint64_t calloutStart = __CFRunLoopCalloutStart(rl);
+        if (calloutStart) __CFRunLoopRecordTimerLateness(rlm, oldFireTSR, calloutStart);
 	__CFRUNLOOP_IS_CALLING_OUT_TO_A_TIMER_CALLBACK_FUNCTION__(rlt->_callout, rlt, context_info);
+        if (calloutStart) __CFRunLoopRecordCallout(rlm, __kCFRunLoopCalloutTimer, (const void *)rlt->_callout, calloutStart);
 	CHECK_FOR_FORK();
         if (doInvalidate) {
             CFRunLoopTimerInvalidate(rlt);      /* DOES CALLOUT */
@@ -2183,6 +2623,7 @@ CF_EXPORT Boolean _CFRunLoopFinished(CFRunLoopRef rl, CFStringRef modeName) {
     CFRunLoopModeRef rlm;
     Boolean result = false;
     __CFRunLoopLock(rl);
+    __CFRunLoopDrainPostedBlocks(rl);
     rlm = __CFRunLoopFindMode(rl, modeName, false);
     if (NULL == rlm || __CFRunLoopModeIsEmpty(rl, rlm, NULL)) {
 	result = true;
@@ -2436,6 +2877,7 @@ static int32_t __CFRunLoopRun(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFTimeInter
 	__CFRunLoopUnlock(rl);
 
         CFAbsoluteTime sleepStart = poll ? 0.0 : CFAbsoluteTimeGetCurrent();
+        uint64_t sleepStartTSR = poll ? 0 : __CFRunLoopCalloutStart(rl);
 
 #if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI
 #if USE_DISPATCH_SOURCE_FOR_TIMERS
@@ -2484,6 +2926,7 @@ static int32_t __CFRunLoopRun(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFTimeInter
         __CFRunLoopModeLock(rlm);
 
         rl->_sleepTime += (poll ? 0.0 : (CFAbsoluteTimeGetCurrent() - sleepStart));
+        if (sleepStartTSR) __CFRunLoopRecordSleep(rlm, sleepStartTSR);
 
         // Must remove the local-to-this-activation ports in on every loop
         // iteration, as this mode could be run re-entrantly and we don't
@@ -2650,6 +3093,7 @@ SInt32 CFRunLoopRunSpecific(CFRunLoopRef rl, CFStringRef modeName, CFTimeInterva
     CHECK_FOR_FORK();
     if (__CFRunLoopIsDeallocating(rl)) return kCFRunLoopRunFinished;
     __CFRunLoopLock(rl);
+    __CFRunLoopDrainPostedBlocks(rl);
     CFRunLoopModeRef currentMode = __CFRunLoopFindMode(rl, modeName, false);
     if (NULL == currentMode || __CFRunLoopModeIsEmpty(rl, currentMode, rl->_currentMode)) {
 	Boolean did = false;
@@ -2758,40 +3202,44 @@ CF_EXPORT Boolean _CFRunLoopModeContainsMode(CFRunLoopRef rl, CFStringRef modeNa
     return false;
 }
 
+/* Creates the mode if it does not exist yet, as CFRunLoopPerformBlock always has. Modes are never removed, so a post naming the same mode as the one before finds it already known and takes no lock. */
+static void __CFRunLoopEnsurePostedMode(CFRunLoopRef rl, CFStringRef modeName) {
+    CFStringRef known = rl->_lastPostedMode;
+    if (NULL != known && (known == modeName || CFEqual(known, modeName))) return;
+    __CFRunLoopLock(rl);
+    CFRunLoopModeRef currentMode = __CFRunLoopFindMode(rl, modeName, true);
+    if (currentMode) {
+        rl->_lastPostedMode = currentMode->_name;
+        __CFRunLoopModeUnlock(currentMode);
+    }
+    __CFRunLoopUnlock(rl);
+}
+
 void CFRunLoopPerformBlock(CFRunLoopRef rl, CFTypeRef mode, void (^block)(void)) {
     CHECK_FOR_FORK();
     if (CFStringGetTypeID() == CFGetTypeID(mode)) {
 	mode = CFStringCreateCopy(kCFAllocatorSystemDefault, (CFStringRef)mode);
-        __CFRunLoopLock(rl);
 	// ensure mode exists
-        CFRunLoopModeRef currentMode = __CFRunLoopFindMode(rl, (CFStringRef)mode, true);
-        if (currentMode) __CFRunLoopModeUnlock(currentMode);
-        __CFRunLoopUnlock(rl);
+	__CFRunLoopEnsurePostedMode(rl, (CFStringRef)mode);
     } else if (CFArrayGetTypeID() == CFGetTypeID(mode)) {
         CFIndex cnt = CFArrayGetCount((CFArrayRef)mode);
 	const void **values = (const void **)malloc(sizeof(const void *) * cnt);
         CFArrayGetValues((CFArrayRef)mode, CFRangeMake(0, cnt), values);
 	mode = CFSetCreate(kCFAllocatorSystemDefault, values, cnt, &kCFTypeSetCallBacks);
-        __CFRunLoopLock(rl);
 	// ensure modes exist
 	for (CFIndex idx = 0; idx < cnt; idx++) {
-            CFRunLoopModeRef currentMode = __CFRunLoopFindMode(rl, (CFStringRef)values[idx], true);
-            if (currentMode) __CFRunLoopModeUnlock(currentMode);
+	    __CFRunLoopEnsurePostedMode(rl, (CFStringRef)values[idx]);
 	}
-        __CFRunLoopUnlock(rl);
 	free(values);
     } else if (CFSetGetTypeID() == CFGetTypeID(mode)) {
         CFIndex cnt = CFSetGetCount((CFSetRef)mode);
 	const void **values = (const void **)malloc(sizeof(const void *) * cnt);
         CFSetGetValues((CFSetRef)mode, values);
 	mode = CFSetCreate(kCFAllocatorSystemDefault, values, cnt, &kCFTypeSetCallBacks);
-        __CFRunLoopLock(rl);
 	// ensure modes exist
 	for (CFIndex idx = 0; idx < cnt; idx++) {
-            CFRunLoopModeRef currentMode = __CFRunLoopFindMode(rl, (CFStringRef)values[idx], true);
-            if (currentMode) __CFRunLoopModeUnlock(currentMode);
+	    __CFRunLoopEnsurePostedMode(rl, (CFStringRef)values[idx]);
 	}
-        __CFRunLoopUnlock(rl);
 	free(values);
     } else {
 	mode = NULL;
@@ -2802,18 +3250,16 @@ void CFRunLoopPerformBlock(CFRunLoopRef rl, CFTypeRef mode, void (^block)(void))
 	if (block) Block_release(block);
 	return;
     }
-    __CFRunLoopLock(rl);
     struct _block_item *new_item = (struct _block_item *)malloc(sizeof(struct _block_item));
-    new_item->_next = NULL;
     new_item->_mode = mode;
     new_item->_block = block;
-    if (!rl->_blocks_tail) {
-	rl->_blocks_head = new_item;
-    } else {
-	rl->_blocks_tail->_next = new_item;
-    }
-    rl->_blocks_tail = new_item;
-    __CFRunLoopUnlock(rl);
+    struct _block_item *posted;
+    do {
+        posted = rl->_blocks_posted;
+        new_item->_next = posted;
+    } while (!OSAtomicCompareAndSwapPtrBarrier(posted, new_item, (void * volatile *)&rl->_blocks_posted));
+    // the loop thread takes all the posted blocks at once, so only the post that finds none pending wakes it
+    if (NULL == posted) CFRunLoopWakeUp(rl);
 }
 
 Boolean CFRunLoopContainsSource(CFRunLoopRef rl, CFRunLoopSourceRef rls, CFStringRef modeName) {
@@ -2877,6 +3323,11 @@ void CFRunLoopAddSource(CFRunLoopRef rl, CFRunLoopSourceRef rls, CFStringRef mod
 	        rls->_runLoops = CFBagCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeBagCallBacks); // sources retain run loops!
 	    }
 	    CFBagAddValue(rls->_runLoops, rl);
+	    __CFRunLoopSourcePublishLoops(rls);
+	    if (0 == rls->_context.version0.version && __CFRunLoopSourceIsSignaled(rls)) {
+	        // signalled before a signal could see this run loop, so it may not be queued here; checked after publishing, so one or the other queues it
+	        (void)__CFRunLoopPostSignalledSource(rl, rls);
+	    }
 	    __CFRunLoopSourceUnlock(rls);
 	    if (0 == rls->_context.version0.version) {
 	        if (NULL != rls->_context.version0.schedule) {
@@ -2930,6 +3381,7 @@ void CFRunLoopRemoveSource(CFRunLoopRef rl, CFRunLoopSourceRef rls, CFStringRef
             __CFRunLoopSourceLock(rls);
             if (NULL != rls->_runLoops) {
                 CFBagRemoveValue(rls->_runLoops, rl);
+                __CFRunLoopSourcePublishLoops(rls);
             }
             __CFRunLoopSourceUnlock(rls);
 	    if (0 == rls->_context.version0.version) {
@@ -3318,6 +3770,8 @@ CFRunLoopSourceRef CFRunLoopSourceCreate(CFAllocatorRef allocator, CFIndex order
     memory->_bits = 0;
     memory->_order = order;
     memory->_runLoops = NULL;
+    memory->_signalLoops = NULL;
+    memory->_signalReaders = 0;
     size = 0;
     switch (context->version) {
     case 0:
@@ -3381,6 +3835,7 @@ void CFRunLoopSourceInvalidate(CFRunLoopSourceRef rls) {
             // unlocked, which means we have to protect from object
             // invalidation.
             rls->_runLoops = NULL; // transfer ownership to local stack
+            __CFRunLoopSourcePublishLoops(rls);
             __CFRunLoopSourceUnlock(rls);
             CFTypeRef params[2] = {rls, NULL};
             CFBagApplyFunction(rloops, (__CFRunLoopSourceRemoveFromRunLoop), params);
@@ -3417,19 +3872,27 @@ void CFRunLoopSourceGetContext(CFRunLoopSourceRef rls, CFRunLoopSourceContext *c
 
 void CFRunLoopSourceSignal(CFRunLoopSourceRef rls) {
     CHECK_FOR_FORK();
-    __CFRunLoopSourceLock(rls);
-    if (__CFIsValid(rls)) {
-	__CFRunLoopSourceSetSignaled(rls);
+    // Only the signal that sets the bit queues the source, reading the run loops from the copy published for it rather than taking the source lock; a signal racing with invalidation is harmless, since __CFRunLoopDoSources0 checks validity before performing
+    if (__CFIsValid(rls) && __CFRunLoopSourceSetSignaled(rls) && 0 == rls->_context.version0.version) {
+	OSAtomicIncrement32Barrier(&rls->_signalReaders);
+	struct _signal_loops *loops = rls->_signalLoops;
+	CFIndex cnt = loops ? loops->_count : 0, woken = 0;
+	STACK_BUFFER_DECL(CFRunLoopRef, wake, (0 < cnt) ? cnt : 1);
+	for (CFIndex idx = 0; idx < cnt; idx++) {
+	    // wake a run loop once per batch, after leaving the copy, since waking takes the run loop lock and a publisher may hold it while waiting for this signal
+	    if (__CFRunLoopPostSignalledSource(loops->_loops[idx], rls)) wake[woken++] = (CFRunLoopRef)CFRetain(loops->_loops[idx]);
+	}
+	OSAtomicDecrement32Barrier(&rls->_signalReaders);
+	for (CFIndex idx = 0; idx < woken; idx++) {
+	    CFRunLoopWakeUp(wake[idx]);
+	    CFRelease(wake[idx]);
+	}
     }
-    __CFRunLoopSourceUnlock(rls);
 }
 
 Boolean CFRunLoopSourceIsSignalled(CFRunLoopSourceRef rls) {
     CHECK_FOR_FORK();
-    __CFRunLoopSourceLock(rls);
-    Boolean ret = __CFRunLoopSourceIsSignaled(rls) ? true : false;
-    __CFRunLoopSourceUnlock(rls);
-    return ret;
+    return __CFRunLoopSourceIsSignaled(rls) ? true : false;
 }
 
 CF_PRIVATE void _CFRunLoopSourceWakeUpRunLoops(CFRunLoopSourceRef rls) {
@@ -3953,3 +4416,268 @@ void CFRunLoopTimerSetTolerance(CFRunLoopTimerRef rlt, CFTimeInterval tolerance)
 #endif
 }
 
+
+#pragma mark -
+#pragma mark Run Loop Groups
+
+/* A run loop group owns a fixed set of threads, each running its own run loop in the default mode, so that sources and timers can be sharded across cores. Items are placed either on the loop with the fewest sources and timers in its default mode or on the loop a key hashes to, so that related items always share a thread. */
+
+struct __CFRunLoopGroupMember {
+    CFRunLoopRef _runLoop;
+    CFRunLoopSourceRef _keepAlive;
+    int32_t volatile _handoffs;
+    CFAbsoluteTime _startSleepTime;
+};
+
+struct __CFRunLoopGroup {
+    CFIndex _count;
+    volatile Boolean _stopping;
+    int32_t volatile _cursor;
+    dispatch_semaphore_t _started;
+    dispatch_semaphore_t _exited;
+    CFAbsoluteTime _startTime;
+    struct __CFRunLoopGroupMember _members[];
+};
+
+typedef struct {
+    struct __CFRunLoopGroup *group;
+    CFIndex index;
+} __CFRunLoopGroupThreadArgs;
+
+static void __CFRunLoopGroupKeepAlive(void *info) {
+}
+
+static void __CFRunLoopGroupPinCurrentThread(CFIndex idx) {
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI
+    // Distinct affinity tags ask the scheduler to keep the threads on distinct cores; there is no hard pinning on this platform
+    thread_affinity_policy_data_t policy = {(integer_t)(idx + 1)};
+    thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_AFFINITY_POLICY, (thread_policy_t)&policy, THREAD_AFFINITY_POLICY_COUNT);
+#elif DEPLOYMENT_TARGET_WINDOWS
+    CFIndex cpus = __CFActiveProcessorCount();
+    if (cpus > (CFIndex)(sizeof(DWORD_PTR) * 8)) cpus = sizeof(DWORD_PTR) * 8;
+    SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (idx % cpus));
+#elif DEPLOYMENT_TARGET_LINUX
+    CFIndex cpus = __CFActiveProcessorCount();
+    if (cpus <= 0) return;
+#if defined(CPU_SETSIZE)
+    if (cpus > CPU_SETSIZE) cpus = CPU_SETSIZE;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((int)(idx % cpus), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    // CoreFoundation_Prefix.h, included ahead of this file, got <sched.h> before _GNU_SOURCE was defined; the system call takes the same bit mask
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+    memset(mask, 0, sizeof(mask));
+    if (cpus > 1024) cpus = 1024;
+    CFIndex cpu = idx % cpus;
+    mask[cpu / (8 * sizeof(unsigned long))] = 1UL << (cpu % (8 * sizeof(unsigned long)));
+    syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask);
+#endif
+#endif
+}
+
+static void *__CFRunLoopGroupThread(void *arg) {
+    __CFRunLoopGroupThreadArgs *args = (__CFRunLoopGroupThreadArgs *)arg;
+    struct __CFRunLoopGroup *group = args->group;
+    struct __CFRunLoopGroupMember *member = &group->_members[args->index];
+    __CFRunLoopGroupPinCurrentThread(args->index);
+    free(args);
+
+    CFRunLoopRef rl = CFRunLoopGetCurrent();
+    CFRunLoopSourceContext context = {0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, __CFRunLoopGroupKeepAlive};
+    CFRunLoopSourceRef rls = CFRunLoopSourceCreate(kCFAllocatorSystemDefault, 0, &context);
+    CFRunLoopAddSource(rl, rls, kCFRunLoopDefaultMode);
+    member->_runLoop = (CFRunLoopRef)CFRetain(rl);
+    member->_keepAlive = rls;
+    __CFRunLoopLock(rl);
+    member->_startSleepTime = rl->_sleepTime;
+    __CFRunLoopUnlock(rl);
+    dispatch_semaphore_signal(group->_started);
+
+    while (!group->_stopping) {
+        CFRunLoopRunInMode(kCFRunLoopDefaultMode, 1.0e10, false);
+    }
+    CFRunLoopRemoveSource(rl, rls, kCFRunLoopDefaultMode);
+    dispatch_semaphore_signal(group->_exited);
+    return NULL;
+}
+
+_CFRunLoopGroupRef _CFRunLoopGroupCreate(CFIndex count) {
+    CHECK_FOR_FORK();
+    if (count <= 0) count = __CFActiveProcessorCount();
+    if (count <= 0) count = 1;
+    struct __CFRunLoopGroup *group = (struct __CFRunLoopGroup *)calloc(1, sizeof(struct __CFRunLoopGroup) + count * sizeof(struct __CFRunLoopGroupMember));
+    if (!group) return NULL;
+    group->_count = count;
+    group->_started = dispatch_semaphore_create(0);
+    group->_exited = dispatch_semaphore_create(0);
+    group->_startTime = CFAbsoluteTimeGetCurrent();
+    for (CFIndex idx = 0; idx < count; idx++) {
+        __CFRunLoopGroupThreadArgs *args = (__CFRunLoopGroupThreadArgs *)malloc(sizeof(__CFRunLoopGroupThreadArgs));
+        args->group = group;
+        args->index = idx;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI
+        pthread_attr_set_qos_class_np(&attr, qos_class_main(), 0);
+#endif
+        pthread_t thread;
+        int err = pthread_create(&thread, &attr, __CFRunLoopGroupThread, args);
+        pthread_attr_destroy(&attr);
+        if (0 != err) {
+            CRSetCrashLogMessage("Unable to create run loop group thread");
+            HALT;
+        }
+    }
+    // Every member's run loop exists once all the threads have checked in
+    for (CFIndex idx = 0; idx < count; idx++) {
+        dispatch_semaphore_wait(group->_started, DISPATCH_TIME_FOREVER);
+    }
+    return group;
+}
+
+void _CFRunLoopGroupDestroy(_CFRunLoopGroupRef group) {
+    CHECK_FOR_FORK();
+    group->_stopping = true;
+    for (CFIndex idx = 0; idx < group->_count; idx++) {
+        // A posted block is not lost if the thread is between runs, unlike a bare CFRunLoopStop()
+        CFRunLoopRef rl = group->_members[idx]._runLoop;
+        CFRunLoopPerformBlock(rl, kCFRunLoopDefaultMode, ^{ CFRunLoopStop(CFRunLoopGetCurrent()); });
+        CFRunLoopWakeUp(rl);
+    }
+    for (CFIndex idx = 0; idx < group->_count; idx++) {
+        dispatch_semaphore_wait(group->_exited, DISPATCH_TIME_FOREVER);
+    }
+    for (CFIndex idx = 0; idx < group->_count; idx++) {
+        CFRelease(group->_members[idx]._keepAlive);
+        CFRelease(group->_members[idx]._runLoop);
+    }
+    dispatch_release(group->_started);
+    dispatch_release(group->_exited);
+    free(group);
+}
+
+CFIndex _CFRunLoopGroupGetCount(_CFRunLoopGroupRef group) {
+    return group->_count;
+}
+
+CFRunLoopRef _CFRunLoopGroupGetRunLoopAtIndex(_CFRunLoopGroupRef group, CFIndex idx) {
+    if (idx < 0 || group->_count <= idx) HALT;
+    return group->_members[idx]._runLoop;
+}
+
+CFIndex _CFRunLoopGroupGetIndexForKey(_CFRunLoopGroupRef group, CFTypeRef key) {
+    CFHashCode hash = CFHash(key);
+    // Spread the high bits down so that keys differing only there still land on different loops
+    hash ^= hash >> 16;
+    return (CFIndex)(hash % (CFHashCode)group->_count);
+}
+
+// Counted from the loop itself rather than kept as a tally, so that items removed or invalidated by any path stop counting at once; the keep-alive source is not counted
+static CFIndex __CFRunLoopGroupMemberLoad(struct __CFRunLoopGroupMember *member) {
+    CFRunLoopRef rl = member->_runLoop;
+    CFIndex load = 0;
+    __CFRunLoopLock(rl);
+    CFRunLoopModeRef rlm = __CFRunLoopFindMode(rl, kCFRunLoopDefaultMode, false);
+    if (NULL != rlm) {
+        if (NULL != rlm->_sources0) load += CFSetGetCount(rlm->_sources0);
+        if (NULL != rlm->_sources1) load += CFSetGetCount(rlm->_sources1);
+        if (NULL != rlm->_timers) load += CFArrayGetCount(rlm->_timers);
+        __CFRunLoopModeUnlock(rlm);
+    }
+    __CFRunLoopUnlock(rl);
+    return (0 < load) ? load - 1 : 0;
+}
+
+CFIndex _CFRunLoopGroupGetLeastLoadedIndex(_CFRunLoopGroupRef group) {
+    // Start the scan at a rotating position so ties are spread across the loops instead of piling onto the first
+    CFIndex start = (CFIndex)((uint32_t)OSAtomicIncrement32(&group->_cursor) % (uint32_t)group->_count);
+    CFIndex best = start;
+    CFIndex bestLoad = __CFRunLoopGroupMemberLoad(&group->_members[start]);
+    for (CFIndex cnt = 1; cnt < group->_count; cnt++) {
+        CFIndex idx = (start + cnt) % group->_count;
+        CFIndex load = __CFRunLoopGroupMemberLoad(&group->_members[idx]);
+        if (load < bestLoad) {
+            best = idx;
+            bestLoad = load;
+        }
+    }
+    return best;
+}
+
+static CFIndex __CFRunLoopGroupIndexOfRunLoop(_CFRunLoopGroupRef group, CFRunLoopRef rl) {
+    for (CFIndex idx = 0; idx < group->_count; idx++) {
+        if (group->_members[idx]._runLoop == rl) return idx;
+    }
+    return kCFNotFound;
+}
+
+CFRunLoopRef _CFRunLoopGroupAddSource(_CFRunLoopGroupRef group, CFRunLoopSourceRef rls, CFTypeRef key) {
+    CHECK_FOR_FORK();
+    CFIndex idx = key ? _CFRunLoopGroupGetIndexForKey(group, key) : _CFRunLoopGroupGetLeastLoadedIndex(group);
+    CFRunLoopRef rl = group->_members[idx]._runLoop;
+    CFRunLoopAddSource(rl, rls, kCFRunLoopDefaultMode);
+    return rl;
+}
+
+void _CFRunLoopGroupRemoveSource(_CFRunLoopGroupRef group, CFRunLoopRef rl, CFRunLoopSourceRef rls) {
+    CHECK_FOR_FORK();
+    if (kCFNotFound == __CFRunLoopGroupIndexOfRunLoop(group, rl)) return;
+    CFRunLoopRemoveSource(rl, rls, kCFRunLoopDefaultMode);
+}
+
+CFRunLoopRef _CFRunLoopGroupAddTimer(_CFRunLoopGroupRef group, CFRunLoopTimerRef rlt, CFTypeRef key) {
+    CHECK_FOR_FORK();
+    CFIndex idx = key ? _CFRunLoopGroupGetIndexForKey(group, key) : _CFRunLoopGroupGetLeastLoadedIndex(group);
+    CFRunLoopRef rl = group->_members[idx]._runLoop;
+    CFRunLoopAddTimer(rl, rlt, kCFRunLoopDefaultMode);
+    return rl;
+}
+
+void _CFRunLoopGroupRemoveTimer(_CFRunLoopGroupRef group, CFRunLoopRef rl, CFRunLoopTimerRef rlt) {
+    CHECK_FOR_FORK();
+    if (kCFNotFound == __CFRunLoopGroupIndexOfRunLoop(group, rl)) return;
+    CFRunLoopRemoveTimer(rl, rlt, kCFRunLoopDefaultMode);
+}
+
+#if __BLOCKS__
+void _CFRunLoopGroupPerformBlock(_CFRunLoopGroupRef group, CFIndex idx, void (^block)(void)) {
+    CHECK_FOR_FORK();
+    if (idx < 0 || group->_count <= idx) HALT;
+    CFRunLoopRef rl = group->_members[idx]._runLoop;
+    OSAtomicIncrement32(&group->_members[idx]._handoffs);
+    CFRunLoopPerformBlock(rl, kCFRunLoopDefaultMode, block);
+    CFRunLoopWakeUp(rl);
+}
+#endif
+
+CFArrayRef _CFRunLoopGroupCopyStatistics(_CFRunLoopGroupRef group) {
+    CHECK_FOR_FORK();
+    CFMutableArrayRef result = CFArrayCreateMutable(kCFAllocatorSystemDefault, group->_count, &kCFTypeArrayCallBacks);
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - group->_startTime;
+    for (CFIndex idx = 0; idx < group->_count; idx++) {
+        struct __CFRunLoopGroupMember *member = &group->_members[idx];
+        __CFRunLoopLock(member->_runLoop);
+        CFAbsoluteTime slept = member->_runLoop->_sleepTime - member->_startSleepTime;
+        __CFRunLoopUnlock(member->_runLoop);
+        // Time spent asleep is only accounted when the loop wakes, so a loop idle since the last wakeup reads as busy for that stretch
+        double busy = (0.0 < elapsed) ? 1.0 - slept / elapsed : 0.0;
+        if (busy < 0.0) busy = 0.0;
+        CFIndex scheduled = __CFRunLoopGroupMemberLoad(member);
+        int32_t handoffs = member->_handoffs;
+        CFNumberRef scheduledNum = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberCFIndexType, &scheduled);
+        CFNumberRef handoffsNum = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberSInt32Type, &handoffs);
+        CFNumberRef busyNum = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberDoubleType, &busy);
+        const void *keys[3] = {CFSTR("scheduled"), CFSTR("handoffs"), CFSTR("busyFraction")};
+        const void *values[3] = {scheduledNum, handoffsNum, busyNum};
+        CFDictionaryRef stats = CFDictionaryCreate(kCFAllocatorSystemDefault, keys, values, 3, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        CFArrayAppendValue(result, stats);
+        CFRelease(stats);
+        CFRelease(scheduledNum);
+        CFRelease(handoffsNum);
+        CFRelease(busyNum);
+    }
+    return result;
+}
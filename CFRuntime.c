@@ -465,7 +465,21 @@ CF_EXPORT uintptr_t __CFDoExternRefOperation(uintptr_t op, id obj) {
 
 CF_EXPORT CFTypeID CFNumberGetTypeID(void);
 
+#if CF_HAVE_TAGGED_POINTERS
+// A tagged instance only comes from its class's create function, so the class is registered by now
+CF_PRIVATE CFTypeID __CFTaggedPointerGetTypeID(CFTypeRef cf) {
+    switch (__CFTaggedPointerGetTag(cf)) {
+    case __kCFTaggedObjectID_Number: return CFNumberGetTypeID();
+    case __kCFTaggedObjectID_Date: return CFDateGetTypeID();
+    }
+    return _kCFRuntimeNotATypeID;
+}
+#endif
+
 CF_INLINE CFTypeID __CFGenericTypeID_inline(const void *cf) {
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(cf)) return __CFTaggedPointerGetTypeID(cf);
+#endif
     // yes, 10 bits masked off, though 12 bits are there for the type field; __CFRuntimeClassTableSize is 1024
     uint32_t *cfinfop = (uint32_t *)&(((CFRuntimeBase *)cf)->_cfinfo);
     CFTypeID typeID = (*cfinfop >> 8) & 0x03FF; // mask up to 0x0FFF
@@ -515,6 +529,9 @@ static CFTypeRef _CFRetain(CFTypeRef cf, Boolean tryR);
 
 CFTypeRef CFRetain(CFTypeRef cf) {
     if (NULL == cf) { CRSetCrashLogMessage("*** CFRetain() called with NULL ***"); HALT; }
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(cf)) return cf;
+#endif
     if (cf) __CFGenericAssertIsCF(cf);
     return _CFRetain(cf, false);
 }
@@ -528,6 +545,9 @@ static void _CFRelease(CFTypeRef cf);
 
 void CFRelease(CFTypeRef cf) {
     if (NULL == cf) { CRSetCrashLogMessage("*** CFRelease() called with NULL ***"); HALT; }
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(cf)) return;
+#endif
 #if 0
     void **addrs[2] = {&&start, &&end};
     start:;
@@ -654,6 +674,9 @@ static uint64_t __CFGetFullRetainCount(CFTypeRef cf) {
 
 CFIndex CFGetRetainCount(CFTypeRef cf) {
     if (NULL == cf) { CRSetCrashLogMessage("*** CFGetRetainCount() called with NULL ***"); HALT; }
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(cf)) return (CFIndex)LONG_MAX;	// like constant objects
+#endif
     uint32_t cfinfo = *(uint32_t *)&(((CFRuntimeBase *)cf)->_cfinfo);
     if (cfinfo & 0x800000) { // custom ref counting for object
         CFTypeID typeID = (cfinfo >> 8) & 0x03FF; // mask up to 0x0FFF
@@ -1302,6 +1325,9 @@ CFTypeRef _CFTryRetain(CFTypeRef cf) {
     if (NULL == cf) return NULL;
 #if OBJC_HAVE_TAGGED_POINTERS
     if (_objc_isTaggedPointer(cf)) return cf; // success
+#endif
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(cf)) return cf; // success
 #endif
     return _CFRetain(cf, true);
 }
@@ -1310,6 +1336,9 @@ Boolean _CFIsDeallocating(CFTypeRef cf) {
     if (NULL == cf) return false;
 #if OBJC_HAVE_TAGGED_POINTERS
     if (_objc_isTaggedPointer(cf)) return false;
+#endif
+#if CF_HAVE_TAGGED_POINTERS
+    if (__CFIsTaggedPointer(cf)) return false;
 #endif
     uint32_t cfinfo = *(uint32_t *)&(((CFRuntimeBase *)cf)->_cfinfo);
     if (cfinfo & 0x800000) { // custom ref counting for object
@@ -297,50 +297,382 @@ void CFSortIndexes(CFIndex *indexBuffer, CFIndex count, CFOptionFlags opts, CFCo
     if (local != tmp) free(tmp);
 }
 
-/* Comparator is passed the address of the values. */
-void CFQSortArray(void *list, CFIndex count, CFIndex elementSize, CFComparatorFunction comparator, void *context) {
-    if (count < 2 || elementSize < 1) return;
-    STACK_BUFFER_DECL(CFIndex, locali, count <= 4096 ? count : 1);
-    CFIndex *indexes = (count <= 4096) ? locali : (CFIndex *)malloc(count * sizeof(CFIndex));
-    CFSortIndexes(indexes, count, 0, ^(CFIndex a, CFIndex b) { return comparator((char *)list + a * elementSize, (char *)list + b * elementSize, context); });
-    STACK_BUFFER_DECL(uint8_t, locals, count <= (16 * 1024 / elementSize) ? count * elementSize : 1);
-    void *store = (count <= (16 * 1024 / elementSize)) ? locals : malloc(count * elementSize);
-    for (CFIndex idx = 0; idx < count; idx++) {
-        if (sizeof(uintptr_t) == elementSize) {
-            uintptr_t *a = (uintptr_t *)list + indexes[idx];
-            uintptr_t *b = (uintptr_t *)store + idx;
-            *b = *a;
-        } else {
-            memmove((char *)store + idx * elementSize, (char *)list + indexes[idx] * elementSize, elementSize);
+#pragma mark -
+#pragma mark Direct Element Sorting
+
+/* CFQSortArray() and CFMergeSortArray() sort the elements in place, calling the comparator directly on the element addresses, rather than sorting an index array and gathering. Element moves take a fast path for word-sized elements, which is what nearly every caller sorts. */
+
+typedef struct {
+    char *base;
+    size_t size;
+    CFComparatorFunction comparator;
+    void *context;
+    char *tmp;		// scratch for one element, used by moves and insertion
+    char *pivot;	// scratch for one element, holds the partitioning pivot
+} __CFSortState;
+
+#define __CFSortElement(S, I) ((S)->base + (size_t)(I) * (S)->size)
+#define __CFSortLess(S, A, B) ((S)->comparator((A), (B), (S)->context) < 0)
+
+CF_INLINE void __CFSortCopy(const __CFSortState *s, void *dst, const void *src) {
+    if (sizeof(uintptr_t) == s->size) {
+        *(uintptr_t *)dst = *(const uintptr_t *)src;
+    } else if (sizeof(uint32_t) == s->size) {
+        *(uint32_t *)dst = *(const uint32_t *)src;
+    } else {
+        memmove(dst, src, s->size);
+    }
+}
+
+CF_INLINE void __CFSortSwap(const __CFSortState *s, CFIndex a, CFIndex b) {
+    char *pa = __CFSortElement(s, a), *pb = __CFSortElement(s, b);
+    if (sizeof(uintptr_t) == s->size) {
+        uintptr_t t = *(uintptr_t *)pa;
+        *(uintptr_t *)pa = *(uintptr_t *)pb;
+        *(uintptr_t *)pb = t;
+    } else {
+        __CFSortCopy(s, s->tmp, pa);
+        __CFSortCopy(s, pa, pb);
+        __CFSortCopy(s, pb, s->tmp);
+    }
+}
+
+CF_INLINE void __CFSortMove(const __CFSortState *s, CFIndex dst, CFIndex src, CFIndex cnt) {
+    if (0 < cnt) memmove(__CFSortElement(s, dst), __CFSortElement(s, src), (size_t)cnt * s->size);
+}
+
+static void __CFSortReverse(const __CFSortState *s, CFIndex lo, CFIndex hi) {
+    while (lo < --hi) {
+        __CFSortSwap(s, lo, hi);
+        lo++;
+    }
+}
+
+// Stable straight insertion of [lo, hi), given [lo, start) is already sorted
+static void __CFSortInsertion(const __CFSortState *s, CFIndex lo, CFIndex start, CFIndex hi) {
+    for (CFIndex idx = __CFMax(start, lo + 1); idx < hi; idx++) {
+        if (!__CFSortLess(s, __CFSortElement(s, idx), __CFSortElement(s, idx - 1))) continue;
+        __CFSortCopy(s, s->tmp, __CFSortElement(s, idx));
+        CFIndex j = idx;
+        do {
+            __CFSortCopy(s, __CFSortElement(s, j), __CFSortElement(s, j - 1));
+            j--;
+        } while (lo < j && __CFSortLess(s, s->tmp, __CFSortElement(s, j - 1)));
+        __CFSortCopy(s, __CFSortElement(s, j), s->tmp);
+    }
+}
+
+// Stable insertion of [start, hi) into the sorted [lo, start), finding each place by binary search, so that extending a short run to the minimum length costs about log2 of its length in comparisons per element rather than a quarter of its length
+static void __CFSortBinaryInsertion(const __CFSortState *s, CFIndex lo, CFIndex start, CFIndex hi) {
+    for (CFIndex idx = __CFMax(start, lo + 1); idx < hi; idx++) {
+        // after every element not greater than the one inserted, which keeps equal elements in order
+        CFIndex a = lo, b = idx;
+        while (a < b) {
+            CFIndex m = a + (b - a) / 2;
+            if (__CFSortLess(s, __CFSortElement(s, idx), __CFSortElement(s, m))) b = m; else a = m + 1;
         }
+        if (a == idx) continue;
+        __CFSortCopy(s, s->tmp, __CFSortElement(s, idx));
+        __CFSortMove(s, a + 1, a, idx - a);
+        __CFSortCopy(s, __CFSortElement(s, a), s->tmp);
     }
-    // no swapping or modification of the original list has occurred until this point
-    objc_memmove_collectable(list, store, count * elementSize);
-    if (locals != store) free(store);
-    if (locali != indexes) free(indexes);
 }
 
-/* Comparator is passed the address of the values. */
-void CFMergeSortArray(void *list, CFIndex count, CFIndex elementSize, CFComparatorFunction comparator, void *context) {
-    if (count < 2 || elementSize < 1) return;
-    STACK_BUFFER_DECL(CFIndex, locali, count <= 4096 ? count : 1);
-    CFIndex *indexes = (count <= 4096) ? locali : (CFIndex *)malloc(count * sizeof(CFIndex));
-    CFSortIndexes(indexes, count, kCFSortStable, ^(CFIndex a, CFIndex b) { return comparator((char *)list + a * elementSize, (char *)list + b * elementSize, context); });
-    STACK_BUFFER_DECL(uint8_t, locals, count <= (16 * 1024 / elementSize) ? count * elementSize : 1);
-    void *store = (count <= (16 * 1024 / elementSize)) ? locals : malloc(count * elementSize);
-    for (CFIndex idx = 0; idx < count; idx++) {
-        if (sizeof(uintptr_t) == elementSize) {
-            uintptr_t *a = (uintptr_t *)list + indexes[idx];
-            uintptr_t *b = (uintptr_t *)store + idx;
-            *b = *a;
+// Insertion sort that gives up once it has moved more than a few elements; returns whether [lo, hi) ended up sorted
+static Boolean __CFSortPartialInsertion(const __CFSortState *s, CFIndex lo, CFIndex hi) {
+    CFIndex moved = 0;
+    for (CFIndex idx = lo + 1; idx < hi; idx++) {
+        if (!__CFSortLess(s, __CFSortElement(s, idx), __CFSortElement(s, idx - 1))) continue;
+        __CFSortCopy(s, s->tmp, __CFSortElement(s, idx));
+        CFIndex j = idx;
+        do {
+            __CFSortCopy(s, __CFSortElement(s, j), __CFSortElement(s, j - 1));
+            j--;
+        } while (lo < j && __CFSortLess(s, s->tmp, __CFSortElement(s, j - 1)));
+        __CFSortCopy(s, __CFSortElement(s, j), s->tmp);
+        moved += idx - j;
+        if (8 < moved) return false;
+    }
+    return true;
+}
+
+static void __CFSortHeapSift(const __CFSortState *s, CFIndex lo, CFIndex root, CFIndex cnt) {
+    for (;;) {
+        CFIndex child = 2 * root + 1;
+        if (cnt <= child) return;
+        if (child + 1 < cnt && __CFSortLess(s, __CFSortElement(s, lo + child), __CFSortElement(s, lo + child + 1))) child++;
+        if (!__CFSortLess(s, __CFSortElement(s, lo + root), __CFSortElement(s, lo + child))) return;
+        __CFSortSwap(s, lo + root, lo + child);
+        root = child;
+    }
+}
+
+static void __CFSortHeap(const __CFSortState *s, CFIndex lo, CFIndex hi) {
+    CFIndex cnt = hi - lo;
+    for (CFIndex idx = cnt / 2; idx--;) __CFSortHeapSift(s, lo, idx, cnt);
+    while (1 < cnt) {
+        cnt--;
+        __CFSortSwap(s, lo, lo + cnt);
+        __CFSortHeapSift(s, lo, 0, cnt);
+    }
+}
+
+CF_INLINE void __CFSort2(const __CFSortState *s, CFIndex a, CFIndex b) {
+    if (__CFSortLess(s, __CFSortElement(s, b), __CFSortElement(s, a))) __CFSortSwap(s, a, b);
+}
+
+CF_INLINE void __CFSort3(const __CFSortState *s, CFIndex a, CFIndex b, CFIndex c) {
+    __CFSort2(s, a, b);
+    __CFSort2(s, b, c);
+    __CFSort2(s, a, b);
+}
+
+/* Partitions [lo, hi) around the pivot at lo, with elements equal to the pivot going right. Returns the final pivot position; *alreadyPartitioned is set when no elements had to be exchanged.
+   With a consistent comparator the median selection and the exchanges always leave an element to stop each scan, but the comparators come from callers, so the scans are bounded by [lo, hi) anyway: an inconsistent one then yields some permutation of the elements rather than reads and writes outside the range. */
+static CFIndex __CFSortPartitionRight(const __CFSortState *s, CFIndex lo, CFIndex hi, Boolean *alreadyPartitioned) {
+    __CFSortCopy(s, s->pivot, __CFSortElement(s, lo));
+    CFIndex first = lo, last = hi;
+    while (++first < hi && __CFSortLess(s, __CFSortElement(s, first), s->pivot));
+    if (first - 1 == lo) {
+        while (first < last && !__CFSortLess(s, __CFSortElement(s, --last), s->pivot));
+    } else {
+        while (lo < --last && !__CFSortLess(s, __CFSortElement(s, last), s->pivot));
+    }
+    *alreadyPartitioned = (last <= first);
+    while (first < last) {
+        __CFSortSwap(s, first, last);
+        while (++first < hi && __CFSortLess(s, __CFSortElement(s, first), s->pivot));
+        while (lo < --last && !__CFSortLess(s, __CFSortElement(s, last), s->pivot));
+    }
+    CFIndex pivotIdx = first - 1;
+    __CFSortCopy(s, __CFSortElement(s, lo), __CFSortElement(s, pivotIdx));
+    __CFSortCopy(s, __CFSortElement(s, pivotIdx), s->pivot);
+    return pivotIdx;
+}
+
+/* Partitions [lo, hi) around the pivot at lo with elements equal to the pivot going left; used when the pivot equals the preceding partition's pivot, so a run of equal elements is dealt with in one pass. The scans are bounded for the same reason as in __CFSortPartitionRight(). */
+static CFIndex __CFSortPartitionLeft(const __CFSortState *s, CFIndex lo, CFIndex hi) {
+    __CFSortCopy(s, s->pivot, __CFSortElement(s, lo));
+    CFIndex first = lo, last = hi;
+    while (lo < --last && __CFSortLess(s, s->pivot, __CFSortElement(s, last)));
+    if (last + 1 == hi) {
+        while (first < last && !__CFSortLess(s, s->pivot, __CFSortElement(s, ++first)));
+    } else {
+        while (++first < hi && !__CFSortLess(s, s->pivot, __CFSortElement(s, first)));
+    }
+    while (first < last) {
+        __CFSortSwap(s, first, last);
+        while (lo < --last && __CFSortLess(s, s->pivot, __CFSortElement(s, last)));
+        while (++first < hi && !__CFSortLess(s, s->pivot, __CFSortElement(s, first)));
+    }
+    __CFSortCopy(s, __CFSortElement(s, lo), __CFSortElement(s, last));
+    __CFSortCopy(s, __CFSortElement(s, last), s->pivot);
+    return last;
+}
+
+/* Pattern-defeating quicksort: introsort that notices partitions which needed no exchanges and finishes them by insertion, so presorted input is linear, and which shuffles a few elements when a partition comes out badly unbalanced, falling back to heapsort when that keeps happening. */
+static void __CFSortUnstable(const __CFSortState *s, CFIndex lo, CFIndex hi, int32_t badAllowed, Boolean leftmost) {
+    for (;;) {
+        CFIndex cnt = hi - lo;
+        if (cnt <= 24) {
+            __CFSortInsertion(s, lo, lo + 1, hi);
+            return;
+        }
+        CFIndex mid = lo + cnt / 2;
+        if (128 < cnt) {
+            __CFSort3(s, lo, mid, hi - 1);
+            __CFSort3(s, lo + 1, mid - 1, hi - 2);
+            __CFSort3(s, lo + 2, mid + 1, hi - 3);
+            __CFSort3(s, mid - 1, mid, mid + 1);
+            __CFSortSwap(s, lo, mid);
         } else {
-            memmove((char *)store + idx * elementSize, (char *)list + indexes[idx] * elementSize, elementSize);
+            __CFSort3(s, mid, lo, hi - 1);
+        }
+        // Everything in this range is at least the pivot of the partition to its left; equal pivots mean a run of equal elements
+        if (!leftmost && !__CFSortLess(s, __CFSortElement(s, lo - 1), __CFSortElement(s, lo))) {
+            lo = __CFSortPartitionLeft(s, lo, hi) + 1;
+            continue;
         }
+        Boolean alreadyPartitioned = false;
+        CFIndex pivotIdx = __CFSortPartitionRight(s, lo, hi, &alreadyPartitioned);
+        CFIndex lcnt = pivotIdx - lo, rcnt = hi - (pivotIdx + 1);
+        if (lcnt < cnt / 8 || rcnt < cnt / 8) {
+            if (--badAllowed == 0) {
+                __CFSortHeap(s, lo, hi);
+                return;
+            }
+            if (24 <= lcnt) {
+                __CFSortSwap(s, lo, lo + lcnt / 4);
+                __CFSortSwap(s, pivotIdx - 1, pivotIdx - lcnt / 4);
+            }
+            if (24 <= rcnt) {
+                __CFSortSwap(s, pivotIdx + 1, pivotIdx + 1 + rcnt / 4);
+                __CFSortSwap(s, hi - 1, hi - rcnt / 4);
+            }
+        } else if (alreadyPartitioned && __CFSortPartialInsertion(s, lo, pivotIdx) && __CFSortPartialInsertion(s, pivotIdx + 1, hi)) {
+            return;
+        }
+        // Recurse into the smaller side so the stack depth stays logarithmic
+        if (lcnt < rcnt) {
+            __CFSortUnstable(s, lo, pivotIdx, badAllowed, leftmost);
+            lo = pivotIdx + 1;
+            leftmost = false;
+        } else {
+            __CFSortUnstable(s, pivotIdx + 1, hi, badAllowed, false);
+            hi = pivotIdx;
+        }
+    }
+}
+
+// Returns the end of the run starting at lo, reversing it first if it is strictly descending
+static CFIndex __CFSortCountRun(const __CFSortState *s, CFIndex lo, CFIndex hi) {
+    CFIndex run = lo + 1;
+    if (hi <= run) return hi;
+    if (__CFSortLess(s, __CFSortElement(s, run), __CFSortElement(s, lo))) {
+        run++;
+        while (run < hi && __CFSortLess(s, __CFSortElement(s, run), __CFSortElement(s, run - 1))) run++;
+        __CFSortReverse(s, lo, run);
+    } else {
+        run++;
+        while (run < hi && !__CFSortLess(s, __CFSortElement(s, run), __CFSortElement(s, run - 1))) run++;
     }
-    // no swapping or modification of the original list has occurred until this point
-    objc_memmove_collectable(list, store, count * elementSize);
-    if (locals != store) free(store);
-    if (locali != indexes) free(indexes);
+    return run;
 }
 
+static CFIndex __CFSortMinRun(CFIndex cnt) {
+    CFIndex r = 0;
+    while (64 <= cnt) {
+        r |= cnt & 1;
+        cnt >>= 1;
+    }
+    return cnt + r;
+}
 
+/* Merges the sorted runs [lo, mid) and [mid, hi) through buf, which holds at least half the elements. Elements already in their final place at either end are found by binary search and left alone, and the shorter remaining side is the one copied out. */
+static void __CFSortMergeRuns(const __CFSortState *s, CFIndex lo, CFIndex mid, CFIndex hi, char *buf) {
+    // Skip the leading left-run elements not greater than the first right-run element
+    CFIndex a = lo, b = mid;
+    while (a < b) {
+        CFIndex m = a + (b - a) / 2;
+        if (__CFSortLess(s, __CFSortElement(s, mid), __CFSortElement(s, m))) b = m; else a = m + 1;
+    }
+    lo = a;
+    if (lo == mid) return;
+    // Skip the trailing right-run elements not less than the last left-run element
+    a = mid;
+    b = hi;
+    while (a < b) {
+        CFIndex m = a + (b - a) / 2;
+        if (__CFSortLess(s, __CFSortElement(s, m), __CFSortElement(s, mid - 1))) a = m + 1; else b = m;
+    }
+    hi = a;
+    size_t size = s->size;
+    if (mid - lo <= hi - mid) {
+        CFIndex cnt1 = mid - lo;
+        memmove(buf, __CFSortElement(s, lo), (size_t)cnt1 * size);
+        CFIndex i = 0, j = mid, d = lo;
+        while (i < cnt1 && j < hi) {
+            if (__CFSortLess(s, __CFSortElement(s, j), buf + i * size)) {
+                __CFSortCopy(s, __CFSortElement(s, d++), __CFSortElement(s, j++));
+            } else {
+                __CFSortCopy(s, __CFSortElement(s, d++), buf + i++ * size);
+            }
+        }
+        if (i < cnt1) memmove(__CFSortElement(s, d), buf + i * size, (size_t)(cnt1 - i) * size);
+    } else {
+        CFIndex cnt2 = hi - mid;
+        memmove(buf, __CFSortElement(s, mid), (size_t)cnt2 * size);
+        CFIndex i = cnt2, j = mid, d = hi;
+        while (0 < i && lo < j) {
+            if (__CFSortLess(s, buf + (i - 1) * size, __CFSortElement(s, j - 1))) {
+                __CFSortCopy(s, __CFSortElement(s, --d), __CFSortElement(s, --j));
+            } else {
+                __CFSortCopy(s, __CFSortElement(s, --d), buf + --i * size);
+            }
+        }
+        if (0 < i) memmove(__CFSortElement(s, lo), buf, (size_t)i * size);
+    }
+}
+
+/* Natural merge sort: existing ascending and strictly descending runs are kept, short runs are extended by binary insertion to a minimum length, and runs are merged under the usual stack invariants so that already-ordered input costs n - 1 comparisons. */
+static void __CFSortStable(const __CFSortState *s, CFIndex cnt, char *buf) {
+    CFIndex minRun = __CFSortMinRun(cnt);
+    CFIndex runBase[85], runLen[85];
+    CFIndex runs = 0;
+    CFIndex lo = 0;
+    while (lo < cnt) {
+        CFIndex end = __CFSortCountRun(s, lo, cnt);
+        if (end - lo < minRun) {
+            CFIndex forced = __CFMin(lo + minRun, cnt);
+            __CFSortBinaryInsertion(s, lo, end, forced);
+            end = forced;
+        }
+        runBase[runs] = lo;
+        runLen[runs] = end - lo;
+        runs++;
+        lo = end;
+        while (1 < runs) {
+            CFIndex n = runs - 2;
+            if ((0 < n && runLen[n - 1] <= runLen[n] + runLen[n + 1]) || (1 < n && runLen[n - 2] <= runLen[n - 1] + runLen[n])) {
+                if (runLen[n - 1] < runLen[n + 1]) n--;
+            } else if (runLen[n + 1] < runLen[n]) {
+                break;
+            }
+            __CFSortMergeRuns(s, runBase[n], runBase[n + 1], runBase[n + 1] + runLen[n + 1], buf);
+            runLen[n] += runLen[n + 1];
+            if (n + 2 < runs) {
+                runBase[n + 1] = runBase[n + 2];
+                runLen[n + 1] = runLen[n + 2];
+            }
+            runs--;
+        }
+    }
+    while (1 < runs) {
+        CFIndex n = runs - 2;
+        if (0 < n && runLen[n - 1] < runLen[n + 1]) n--;
+        __CFSortMergeRuns(s, runBase[n], runBase[n + 1], runBase[n + 1] + runLen[n + 1], buf);
+        runLen[n] += runLen[n + 1];
+        if (n + 2 < runs) {
+            runBase[n + 1] = runBase[n + 2];
+            runLen[n + 1] = runLen[n + 2];
+        }
+        runs--;
+    }
+}
+
+static void __CFSortStableBuffered(const __CFSortState *s, CFIndex count) {
+    // A merge never needs more than half the elements copied out
+    size_t bufSize = (size_t)(count / 2 + 1) * s->size;
+    STACK_BUFFER_DECL(uintptr_t, localb, bufSize <= 16 * 1024 ? (bufSize + sizeof(uintptr_t) - 1) / sizeof(uintptr_t) : 1);
+    char *buf = (bufSize <= 16 * 1024) ? (char *)localb : (char *)malloc(bufSize);
+    __CFSortStable(s, count, buf);
+    if ((char *)localb != buf) free(buf);
+}
+
+/* Comparator is passed the address of the values. */
+void CFQSortArray(void *list, CFIndex count, CFIndex elementSize, CFComparatorFunction comparator, void *context) {
+    if (count < 2 || elementSize < 1) return;
+    uintptr_t local[64];
+    char *scratch = (2 * (size_t)elementSize <= sizeof(local)) ? (char *)local : (char *)malloc(2 * elementSize);
+    __CFSortState s = {(char *)list, (size_t)elementSize, comparator, context, scratch, scratch + elementSize};
+    // Input that starts with a long ascending or descending run is usually made of a few long runs, which the natural merge sort handles in close to linear time where quicksort pivots would suffer
+    CFIndex run = __CFSortCountRun(&s, 0, count);
+    if (run == count) {
+        /* already sorted */
+    } else if (count / 8 <= run && 64 <= run) {
+        __CFSortStableBuffered(&s, count);
+    } else {
+        __CFSortUnstable(&s, 0, count, (int32_t)flsl(count), true);
+    }
+    if ((char *)local != scratch) free(scratch);
+}
+
+/* Comparator is passed the address of the values. */
+void CFMergeSortArray(void *list, CFIndex count, CFIndex elementSize, CFComparatorFunction comparator, void *context) {
+    if (count < 2 || elementSize < 1) return;
+    uintptr_t local[64];
+    char *scratch = (2 * (size_t)elementSize <= sizeof(local)) ? (char *)local : (char *)malloc(2 * elementSize);
+    __CFSortState s = {(char *)list, (size_t)elementSize, comparator, context, scratch, scratch + elementSize};
+    __CFSortStableBuffered(&s, count);
+    if ((char *)local != scratch) free(scratch);
+}
@@ -0,0 +1,640 @@
+/*
+ * Copyright (c) 2015 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*	CFSortedDictionary.c
+	Copyright (c) 2015, Apple Inc. All rights reserved.
+*/
+
+/*
+ B+ tree of key/value entries, ordered by a comparator.
+
+ Every node has a keys[] array.  In a leaf it holds the entries' keys, with the
+ values alongside; in a branch keys[i] is the smallest key under children[i]
+ (keys[0] included), so the smallest key of any node is simply its keys[0].
+ Branch keys are borrowed from the leaves and are never retained; they are
+ refreshed along the path of every mutation, so they never outlive the entry
+ they came from.
+
+ Each node also counts the entries beneath it, which gives indexed access
+ and key-to-index lookups in O(log n), and with them range enumeration.
+
+ Nodes other than the root hold between __CFSortedDictionaryMinSlots and
+ __CFSortedDictionaryMaxSlots slots.  The minimum is a quarter rather than a
+ half of the maximum, so a run of alternating insertions and removals at a
+ node boundary doesn't split and merge every time.
+ */
+
+#include <CoreFoundation/CFSortedDictionary.h>
+#include "CFInternal.h"
+
+enum {
+    __CFSortedDictionaryMaxSlots = 32,
+    __CFSortedDictionaryMinSlots = __CFSortedDictionaryMaxSlots / 4,
+    __CFSortedDictionaryBulkSlots = __CFSortedDictionaryMaxSlots * 3 / 4	/* fill of nodes built by bulk loading, leaving room to insert */
+};
+
+typedef struct __CFSortedDictionaryNode {
+    CFIndex count;			/* number of entries in this subtree */
+    uint32_t numSlots;			/* entries in a leaf, children in a branch */
+    bool isLeaf;
+    const void *keys[__CFSortedDictionaryMaxSlots];
+    union {
+	const void *values[__CFSortedDictionaryMaxSlots];
+	struct __CFSortedDictionaryNode *children[__CFSortedDictionaryMaxSlots];
+    } info;
+} CFSortedDictionaryNode;
+
+struct __CFSortedDictionary {
+    CFRuntimeBase _base;
+    CFIndex _count;
+    CFSortedDictionaryNode *_root;	/* NULL when empty */
+    CFComparatorFunction _comparator;
+    void *_context;
+    CFDictionaryKeyCallBacks _keyCallBacks;
+    CFDictionaryValueCallBacks _valueCallBacks;
+};
+
+CF_INLINE CFComparisonResult __CFSortedDictionaryCompare(CFSortedDictionaryRef dict, const void *key1, const void *key2) {
+    if (dict->_comparator) return (CFComparisonResult)INVOKE_CALLBACK3(dict->_comparator, key1, key2, dict->_context);
+    return (key1 < key2) ? kCFCompareLessThan : ((key1 == key2) ? kCFCompareEqualTo : kCFCompareGreaterThan);
+}
+
+/* Values may be NULL, which the callbacks are never asked to retain, release, compare or describe. */
+CF_INLINE const void *__CFSortedDictionaryRetainValue(CFSortedDictionaryRef dict, CFAllocatorRef allocator, const void *value) {
+    if (value && dict->_valueCallBacks.retain) value = (void *)INVOKE_CALLBACK2(dict->_valueCallBacks.retain, allocator, value);
+    return value;
+}
+
+CF_INLINE void __CFSortedDictionaryReleaseValue(CFSortedDictionaryRef dict, CFAllocatorRef allocator, const void *value) {
+    if (value && dict->_valueCallBacks.release) INVOKE_CALLBACK2(dict->_valueCallBacks.release, allocator, value);
+}
+
+static CFSortedDictionaryNode *__CFSortedDictionaryCreateNode(CFSortedDictionaryRef dict, bool isLeaf) {
+    CFSortedDictionaryNode *node = (CFSortedDictionaryNode *)CFAllocatorAllocate(CFGetAllocator(dict), sizeof(CFSortedDictionaryNode), 0);
+    if (NULL == node) HALT;
+    if (__CFOASafe) __CFSetLastAllocationEventName(node, "CFSortedDictionary (node)");
+    node->count = 0;
+    node->numSlots = 0;
+    node->isLeaf = isLeaf;
+    return node;
+}
+
+static void __CFSortedDictionaryDeallocateNode(CFSortedDictionaryRef dict, CFSortedDictionaryNode *node, bool releaseEntries) {
+    CFAllocatorRef allocator = CFGetAllocator(dict);
+    uint32_t idx;
+    if (node->isLeaf) {
+	if (releaseEntries) {
+	    for (idx = 0; idx < node->numSlots; idx++) {
+		if (dict->_keyCallBacks.release) INVOKE_CALLBACK2(dict->_keyCallBacks.release, allocator, node->keys[idx]);
+		__CFSortedDictionaryReleaseValue(dict, allocator, node->info.values[idx]);
+	    }
+	}
+    } else {
+	for (idx = 0; idx < node->numSlots; idx++) __CFSortedDictionaryDeallocateNode(dict, node->info.children[idx], releaseEntries);
+    }
+    CFAllocatorDeallocate(allocator, node);
+}
+
+/* Returns the first slot of the leaf whose key is not less than key, setting *found if that key is equal to it. */
+static uint32_t __CFSortedDictionaryLeafLowerBound(CFSortedDictionaryRef dict, const CFSortedDictionaryNode *node, const void *key, Boolean *found) {
+    uint32_t lo = 0, hi = node->numSlots;
+    *found = false;
+    while (lo < hi) {
+	uint32_t mid = lo + (hi - lo) / 2;
+	CFComparisonResult res = __CFSortedDictionaryCompare(dict, node->keys[mid], key);
+	if (kCFCompareLessThan == res) {
+	    lo = mid + 1;
+	} else {
+	    if (kCFCompareEqualTo == res) *found = true;
+	    hi = mid;
+	}
+    }
+    return lo;
+}
+
+/* Returns the child of the branch under which key belongs: the last one whose smallest key is not greater than key, or the first. */
+static uint32_t __CFSortedDictionaryBranchChild(CFSortedDictionaryRef dict, const CFSortedDictionaryNode *node, const void *key) {
+    uint32_t lo = 1, hi = node->numSlots;
+    while (lo < hi) {
+	uint32_t mid = lo + (hi - lo) / 2;
+	if (kCFCompareGreaterThan == __CFSortedDictionaryCompare(dict, node->keys[mid], key)) {
+	    hi = mid;
+	} else {
+	    lo = mid + 1;
+	}
+    }
+    return lo - 1;
+}
+
+/* Moves num slots of src starting at srcSlot into dst at dstSlot (whose slots from there on must already be free), adjusting the counts of both nodes. */
+static void __CFSortedDictionaryMoveSlots(CFSortedDictionaryNode *dst, uint32_t dstSlot, CFSortedDictionaryNode *src, uint32_t srcSlot, uint32_t num) {
+    CFIndex moved = num;
+    uint32_t idx;
+    if (!src->isLeaf) {
+	for (moved = 0, idx = 0; idx < num; idx++) moved += src->info.children[srcSlot + idx]->count;
+    }
+    memmove(dst->keys + dstSlot, src->keys + srcSlot, num * sizeof(const void *));
+    memmove(dst->info.values + dstSlot, src->info.values + srcSlot, num * sizeof(const void *));
+    dst->count += moved;
+    src->count -= moved;
+}
+
+CF_INLINE void __CFSortedDictionaryOpenSlot(CFSortedDictionaryNode *node, uint32_t slot) {
+    memmove(node->keys + slot + 1, node->keys + slot, (node->numSlots - slot) * sizeof(const void *));
+    memmove(node->info.values + slot + 1, node->info.values + slot, (node->numSlots - slot) * sizeof(const void *));
+    node->numSlots++;
+}
+
+CF_INLINE void __CFSortedDictionaryCloseSlot(CFSortedDictionaryNode *node, uint32_t slot) {
+    node->numSlots--;
+    memmove(node->keys + slot, node->keys + slot + 1, (node->numSlots - slot) * sizeof(const void *));
+    memmove(node->info.values + slot, node->info.values + slot + 1, (node->numSlots - slot) * sizeof(const void *));
+}
+
+/* Splits a full node in half and returns the new right half. *slot, a slot of the full node at which something is about to be inserted, is changed to the corresponding slot of whichever half *node now refers to. */
+static CFSortedDictionaryNode *__CFSortedDictionarySplitNode(CFSortedDictionaryRef dict, CFSortedDictionaryNode **node, uint32_t *slot) {
+    CFSortedDictionaryNode *left = *node;
+    CFSortedDictionaryNode *right = __CFSortedDictionaryCreateNode(dict, left->isLeaf);
+    uint32_t half = __CFSortedDictionaryMaxSlots / 2;
+    __CFSortedDictionaryMoveSlots(right, 0, left, half, __CFSortedDictionaryMaxSlots - half);
+    right->numSlots = __CFSortedDictionaryMaxSlots - half;
+    left->numSlots = half;
+    if (half < *slot) {
+	*node = right;
+	*slot -= half;
+    }
+    return right;
+}
+
+/* Adds key with value under node, or, if the key is present and replace is true, replaces its value. Returns the new right sibling of node if node had to be split to make room. */
+static CFSortedDictionaryNode *__CFSortedDictionaryNodeSetValue(CFSortedDictionaryRef dict, CFSortedDictionaryNode *node, const void *key, const void *value, bool replace, Boolean *added) {
+    CFAllocatorRef allocator = CFGetAllocator(dict);
+    CFSortedDictionaryNode *sibling = NULL, *target = node;
+    if (node->isLeaf) {
+	Boolean found;
+	uint32_t slot = __CFSortedDictionaryLeafLowerBound(dict, node, key, &found);
+	if (found) {
+	    if (replace) {
+		const void *old = node->info.values[slot];
+		node->info.values[slot] = __CFSortedDictionaryRetainValue(dict, allocator, value);
+		__CFSortedDictionaryReleaseValue(dict, allocator, old);
+	    }
+	    return NULL;
+	}
+	if (__CFSortedDictionaryMaxSlots == node->numSlots) sibling = __CFSortedDictionarySplitNode(dict, &target, &slot);
+	if (dict->_keyCallBacks.retain) key = (void *)INVOKE_CALLBACK2(dict->_keyCallBacks.retain, allocator, key);
+	value = __CFSortedDictionaryRetainValue(dict, allocator, value);
+	__CFSortedDictionaryOpenSlot(target, slot);
+	target->keys[slot] = key;
+	target->info.values[slot] = value;
+	target->count++;
+	*added = true;
+	return sibling;
+    }
+    uint32_t slot = __CFSortedDictionaryBranchChild(dict, node, key);
+    CFSortedDictionaryNode *child = node->info.children[slot];
+    CFSortedDictionaryNode *newChild = __CFSortedDictionaryNodeSetValue(dict, child, key, value, replace, added);
+    if (*added) node->count++;
+    node->keys[slot] = child->keys[0];
+    if (newChild) {
+	slot++;
+	if (__CFSortedDictionaryMaxSlots == node->numSlots) sibling = __CFSortedDictionarySplitNode(dict, &target, &slot);
+	__CFSortedDictionaryOpenSlot(target, slot);
+	target->keys[slot] = newChild->keys[0];
+	target->info.children[slot] = newChild;
+	/* newChild's entries were already counted in node, so only move the count if it landed in the sibling */
+	if (target != node) {
+	    target->count += newChild->count;
+	    node->count -= newChild->count;
+	}
+    }
+    return sibling;
+}
+
+/* Evens out, or merges, the child at slot of a branch with a neighbor, after it has dropped below the minimum number of slots. */
+static void __CFSortedDictionaryRebalanceChild(CFSortedDictionaryRef dict, CFSortedDictionaryNode *node, uint32_t slot) {
+    uint32_t leftSlot = (slot + 1 < node->numSlots) ? slot : slot - 1;
+    CFSortedDictionaryNode *left = node->info.children[leftSlot];
+    CFSortedDictionaryNode *right = node->info.children[leftSlot + 1];
+    uint32_t total = left->numSlots + right->numSlots;
+    if (total <= __CFSortedDictionaryMaxSlots) {
+	__CFSortedDictionaryMoveSlots(left, left->numSlots, right, 0, right->numSlots);
+	left->numSlots = total;
+	CFAllocatorDeallocate(CFGetAllocator(dict), right);
+	__CFSortedDictionaryCloseSlot(node, leftSlot + 1);
+    } else {
+	uint32_t half = total / 2;
+	if (left->numSlots < half) {
+	    uint32_t num = half - left->numSlots;
+	    __CFSortedDictionaryMoveSlots(left, left->numSlots, right, 0, num);
+	    left->numSlots = half;
+	    right->numSlots -= num;
+	    memmove(right->keys, right->keys + num, right->numSlots * sizeof(const void *));
+	    memmove(right->info.values, right->info.values + num, right->numSlots * sizeof(const void *));
+	} else {
+	    uint32_t num = left->numSlots - half;
+	    memmove(right->keys + num, right->keys, right->numSlots * sizeof(const void *));
+	    memmove(right->info.values + num, right->info.values, right->numSlots * sizeof(const void *));
+	    __CFSortedDictionaryMoveSlots(right, 0, left, half, num);
+	    right->numSlots += num;
+	    left->numSlots = half;
+	}
+	node->keys[leftSlot + 1] = right->keys[0];
+    }
+    node->keys[leftSlot] = left->keys[0];
+}
+
+/* Removes key from under node; returns whether it was there. */
+static Boolean __CFSortedDictionaryNodeRemoveValue(CFSortedDictionaryRef dict, CFSortedDictionaryNode *node, const void *key) {
+    if (node->isLeaf) {
+	CFAllocatorRef allocator = CFGetAllocator(dict);
+	Boolean found;
+	uint32_t slot = __CFSortedDictionaryLeafLowerBound(dict, node, key, &found);
+	if (!found) return false;
+	const void *oldKey = node->keys[slot];
+	const void *oldValue = node->info.values[slot];
+	__CFSortedDictionaryCloseSlot(node, slot);
+	node->count--;
+	if (dict->_keyCallBacks.release) INVOKE_CALLBACK2(dict->_keyCallBacks.release, allocator, oldKey);
+	__CFSortedDictionaryReleaseValue(dict, allocator, oldValue);
+	return true;
+    }
+    uint32_t slot = __CFSortedDictionaryBranchChild(dict, node, key);
+    CFSortedDictionaryNode *child = node->info.children[slot];
+    if (!__CFSortedDictionaryNodeRemoveValue(dict, child, key)) return false;
+    node->count--;
+    if (child->numSlots < __CFSortedDictionaryMinSlots && 1 < node->numSlots) {
+	__CFSortedDictionaryRebalanceChild(dict, node, slot);
+    } else if (0 < child->numSlots) {
+	node->keys[slot] = child->keys[0];
+    }
+    return true;
+}
+
+static void __CFSortedDictionarySetValue(CFSortedDictionaryRef dict, const void *key, const void *value, bool replace) {
+    Boolean added = false;
+    if (NULL == dict->_root) dict->_root = __CFSortedDictionaryCreateNode(dict, true);
+    CFSortedDictionaryNode *sibling = __CFSortedDictionaryNodeSetValue(dict, dict->_root, key, value, replace, &added);
+    if (sibling) {
+	CFSortedDictionaryNode *root = __CFSortedDictionaryCreateNode(dict, false);
+	root->numSlots = 2;
+	root->keys[0] = dict->_root->keys[0];
+	root->keys[1] = sibling->keys[0];
+	root->info.children[0] = dict->_root;
+	root->info.children[1] = sibling;
+	root->count = dict->_root->count + sibling->count;
+	dict->_root = root;
+    }
+    if (added) dict->_count++;
+}
+
+/* Builds one level of a tree bottom-up from count nodes (or, for the leaf level, entries), spreading them evenly over as few nodes as hold them at the bulk fill; returns the number of nodes made, which replace the first ones in nodes. */
+static CFIndex __CFSortedDictionaryBuildLevel(CFSortedDictionaryRef dict, CFSortedDictionaryNode **nodes, const void **keys, const void **values, CFIndex count) {
+    CFAllocatorRef allocator = CFGetAllocator(dict);
+    CFIndex numNodes = (count + __CFSortedDictionaryBulkSlots - 1) / __CFSortedDictionaryBulkSlots;
+    CFIndex idx, next = 0;
+    for (idx = 0; idx < numNodes; idx++) {
+	CFIndex end = (count * (idx + 1)) / numNodes;
+	CFSortedDictionaryNode *node = __CFSortedDictionaryCreateNode(dict, NULL != keys);
+	for (; next < end; next++) {
+	    uint32_t slot = node->numSlots++;
+	    if (keys) {
+		const void *key = keys[next], *value = values ? values[next] : NULL;
+		if (dict->_keyCallBacks.retain) key = (void *)INVOKE_CALLBACK2(dict->_keyCallBacks.retain, allocator, key);
+		value = __CFSortedDictionaryRetainValue(dict, allocator, value);
+		node->keys[slot] = key;
+		node->info.values[slot] = value;
+		node->count++;
+	    } else {
+		CFSortedDictionaryNode *child = nodes[next];
+		node->keys[slot] = child->keys[0];
+		node->info.children[slot] = child;
+		node->count += child->count;
+	    }
+	}
+	nodes[idx] = node;	/* never overtakes next, as each node takes at least one */
+    }
+    return numNodes;
+}
+
+static CFTypeID __kCFSortedDictionaryTypeID = _kCFRuntimeNotATypeID;
+
+static Boolean __CFSortedDictionaryEqual(CFTypeRef cf1, CFTypeRef cf2) {
+    CFSortedDictionaryRef dict1 = (CFSortedDictionaryRef)cf1;
+    CFSortedDictionaryRef dict2 = (CFSortedDictionaryRef)cf2;
+    CFIndex idx, cnt = dict1->_count;
+    if (cnt != dict2->_count) return false;
+    if (dict1->_comparator != dict2->_comparator || dict1->_valueCallBacks.equal != dict2->_valueCallBacks.equal) return false;
+    for (idx = 0; idx < cnt; idx++) {
+	const void *key1, *key2, *value1, *value2;
+	CFSortedDictionaryGetKeyAndValueAtIndex(dict1, idx, &key1, &value1);
+	CFSortedDictionaryGetKeyAndValueAtIndex(dict2, idx, &key2, &value2);
+	if (kCFCompareEqualTo != __CFSortedDictionaryCompare(dict1, key1, key2)) return false;
+	if (value1 != value2 && !(value1 && value2 && dict1->_valueCallBacks.equal && INVOKE_CALLBACK2(dict1->_valueCallBacks.equal, value1, value2))) return false;
+    }
+    return true;
+}
+
+static CFHashCode __CFSortedDictionaryHash(CFTypeRef cf) {
+    return ((CFSortedDictionaryRef)cf)->_count;
+}
+
+static void __CFSortedDictionaryAppendDescription(const void *key, const void *value, void *context) {
+    CFSortedDictionaryRef dict = (CFSortedDictionaryRef)((void **)context)[0];
+    CFMutableStringRef result = (CFMutableStringRef)((void **)context)[1];
+    CFStringRef keyDesc = dict->_keyCallBacks.copyDescription ? (CFStringRef)INVOKE_CALLBACK1(dict->_keyCallBacks.copyDescription, key) : NULL;
+    CFStringRef valueDesc = (value && dict->_valueCallBacks.copyDescription) ? (CFStringRef)INVOKE_CALLBACK1(dict->_valueCallBacks.copyDescription, value) : NULL;
+    if (keyDesc) {
+	CFStringAppendFormat(result, NULL, CFSTR("\t%@ = "), keyDesc);
+	CFRelease(keyDesc);
+    } else {
+	CFStringAppendFormat(result, NULL, CFSTR("\t<%p> = "), key);
+    }
+    if (valueDesc) {
+	CFStringAppendFormat(result, NULL, CFSTR("%@\n"), valueDesc);
+	CFRelease(valueDesc);
+    } else {
+	CFStringAppendFormat(result, NULL, CFSTR("<%p>\n"), value);
+    }
+}
+
+static CFStringRef __CFSortedDictionaryCopyDescription(CFTypeRef cf) {
+    CFSortedDictionaryRef dict = (CFSortedDictionaryRef)cf;
+    CFMutableStringRef result = CFStringCreateMutable(CFGetAllocator(dict), 0);
+    void *context[2] = {(void *)dict, result};
+    CFStringAppendFormat(result, NULL, CFSTR("<CFSortedDictionary %p [%p]>{count = %lu, entries = (\n"), cf, CFGetAllocator(dict), (unsigned long)dict->_count);
+    CFSortedDictionaryApplyFunction(dict, CFRangeMake(0, dict->_count), __CFSortedDictionaryAppendDescription, context);
+    CFStringAppend(result, CFSTR(")}"));
+    return result;
+}
+
+static void __CFSortedDictionaryDeallocate(CFTypeRef cf) {
+    CFSortedDictionaryRef dict = (CFSortedDictionaryRef)cf;
+    if (dict->_root) __CFSortedDictionaryDeallocateNode(dict, dict->_root, true);
+    dict->_root = NULL;
+    dict->_count = 0;
+}
+
+static const CFRuntimeClass __CFSortedDictionaryClass = {
+    0,
+    "CFSortedDictionary",
+    NULL,	// init
+    NULL,	// copy
+    __CFSortedDictionaryDeallocate,
+    __CFSortedDictionaryEqual,
+    __CFSortedDictionaryHash,
+    NULL,	// 
+    __CFSortedDictionaryCopyDescription
+};
+
+CFTypeID CFSortedDictionaryGetTypeID(void) {
+    static dispatch_once_t initOnce;
+    dispatch_once(&initOnce, ^{ __kCFSortedDictionaryTypeID = _CFRuntimeRegisterClass(&__CFSortedDictionaryClass); });
+    return __kCFSortedDictionaryTypeID;
+}
+
+CFSortedDictionaryRef CFSortedDictionaryCreateMutable(CFAllocatorRef allocator, CFComparatorFunction comparator, void *context, const CFDictionaryKeyCallBacks *keyCallBacks, const CFDictionaryValueCallBacks *valueCallBacks) {
+    CFIndex size = sizeof(struct __CFSortedDictionary) - sizeof(CFRuntimeBase);
+    struct __CFSortedDictionary *memory = (struct __CFSortedDictionary *)_CFRuntimeCreateInstance(allocator, CFSortedDictionaryGetTypeID(), size, NULL);
+    if (NULL == memory) return NULL;
+    if (__CFOASafe) __CFSetLastAllocationEventName(memory, "CFSortedDictionary (mutable)");
+    memory->_count = 0;
+    memory->_root = NULL;
+    memory->_comparator = comparator;
+    memory->_context = context;
+    if (keyCallBacks) {
+	memory->_keyCallBacks = *keyCallBacks;
+    } else {
+	memset(&memory->_keyCallBacks, 0, sizeof(memory->_keyCallBacks));
+    }
+    if (valueCallBacks) {
+	memory->_valueCallBacks = *valueCallBacks;
+    } else {
+	memset(&memory->_valueCallBacks, 0, sizeof(memory->_valueCallBacks));
+    }
+    return memory;
+}
+
+CFSortedDictionaryRef CFSortedDictionaryCreateMutableWithSortedKeysAndValues(CFAllocatorRef allocator, CFComparatorFunction comparator, void *context, const CFDictionaryKeyCallBacks *keyCallBacks, const CFDictionaryValueCallBacks *valueCallBacks, const void **keys, const void **values, CFIndex numValues) {
+    CFAssert2(0 <= numValues, __kCFLogAssertion, "%s(): numValues (%d) cannot be less than zero", __PRETTY_FUNCTION__, numValues);
+    struct __CFSortedDictionary *dict = (struct __CFSortedDictionary *)CFSortedDictionaryCreateMutable(allocator, comparator, context, keyCallBacks, valueCallBacks);
+    CFIndex idx;
+    if (NULL == dict || 0 == numValues) return dict;
+    for (idx = 1; idx < numValues; idx++) {
+	if (kCFCompareLessThan != __CFSortedDictionaryCompare(dict, keys[idx - 1], keys[idx])) break;
+    }
+    if (idx < numValues) {
+	for (idx = 0; idx < numValues; idx++) CFSortedDictionarySetValue(dict, keys[idx], values ? values[idx] : NULL);
+	return dict;
+    }
+    // each level has at most half as many nodes as the one below it has entries, so one buffer serves every level
+    CFIndex numNodes = (numValues + __CFSortedDictionaryBulkSlots - 1) / __CFSortedDictionaryBulkSlots;
+    CFSortedDictionaryNode **nodes = (CFSortedDictionaryNode **)CFAllocatorAllocate(kCFAllocatorSystemDefault, numNodes * sizeof(CFSortedDictionaryNode *), 0);
+    if (__CFOASafe) __CFSetLastAllocationEventName(nodes, "CFSortedDictionary (temp)");
+    numNodes = __CFSortedDictionaryBuildLevel(dict, nodes, keys, values, numValues);
+    while (1 < numNodes) numNodes = __CFSortedDictionaryBuildLevel(dict, nodes, NULL, NULL, numNodes);
+    dict->_root = nodes[0];
+    dict->_count = numValues;
+    CFAllocatorDeallocate(kCFAllocatorSystemDefault, nodes);
+    return dict;
+}
+
+CFIndex CFSortedDictionaryGetCount(CFSortedDictionaryRef dict) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    return dict->_count;
+}
+
+/* Finds the leaf slot where key is or would go, and the index of that slot in the whole dictionary. */
+static CFSortedDictionaryNode *__CFSortedDictionaryFindKey(CFSortedDictionaryRef dict, const void *key, uint32_t *slot, CFIndex *index, Boolean *found) {
+    CFSortedDictionaryNode *node = dict->_root;
+    CFIndex base = 0;
+    while (!node->isLeaf) {
+	uint32_t child = __CFSortedDictionaryBranchChild(dict, node, key);
+	uint32_t idx;
+	for (idx = 0; idx < child; idx++) base += node->info.children[idx]->count;
+	node = node->info.children[child];
+    }
+    *slot = __CFSortedDictionaryLeafLowerBound(dict, node, key, found);
+    if (index) *index = base + *slot;
+    return node;
+}
+
+/* Finds the leaf holding the entry at idx, and its slot there. */
+static CFSortedDictionaryNode *__CFSortedDictionaryFindIndex(CFSortedDictionaryRef dict, CFIndex idx, uint32_t *slot) {
+    CFSortedDictionaryNode *node = dict->_root;
+    while (!node->isLeaf) {
+	CFSortedDictionaryNode **child = node->info.children;
+	while ((*child)->count <= idx) idx -= (*child++)->count;
+	node = *child;
+    }
+    *slot = (uint32_t)idx;
+    return node;
+}
+
+Boolean CFSortedDictionaryGetValueIfPresent(CFSortedDictionaryRef dict, const void *key, const void **value) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    if (0 == dict->_count) return false;
+    Boolean found;
+    uint32_t slot;
+    CFSortedDictionaryNode *leaf = __CFSortedDictionaryFindKey(dict, key, &slot, NULL, &found);
+    if (found && value) *value = leaf->info.values[slot];
+    return found;
+}
+
+Boolean CFSortedDictionaryContainsKey(CFSortedDictionaryRef dict, const void *key) {
+    return CFSortedDictionaryGetValueIfPresent(dict, key, NULL);
+}
+
+void CFSortedDictionaryAddValue(CFSortedDictionaryRef dict, const void *key, const void *value) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    __CFSortedDictionarySetValue(dict, key, value, false);
+}
+
+void CFSortedDictionarySetValue(CFSortedDictionaryRef dict, const void *key, const void *value) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    __CFSortedDictionarySetValue(dict, key, value, true);
+}
+
+void CFSortedDictionaryRemoveValue(CFSortedDictionaryRef dict, const void *key) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    if (0 == dict->_count) return;
+    if (!__CFSortedDictionaryNodeRemoveValue(dict, dict->_root, key)) return;
+    dict->_count--;
+    while (!dict->_root->isLeaf && 1 == dict->_root->numSlots) {
+	CFSortedDictionaryNode *root = dict->_root;
+	dict->_root = root->info.children[0];
+	CFAllocatorDeallocate(CFGetAllocator(dict), root);
+    }
+    if (0 == dict->_count) {
+	__CFSortedDictionaryDeallocateNode(dict, dict->_root, false);
+	dict->_root = NULL;
+    }
+}
+
+void CFSortedDictionaryRemoveAllValues(CFSortedDictionaryRef dict) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    __CFSortedDictionaryDeallocate(dict);
+}
+
+CFIndex CFSortedDictionaryGetLowerBoundIndex(CFSortedDictionaryRef dict, const void *key) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    if (0 == dict->_count) return 0;
+    Boolean found;
+    uint32_t slot;
+    CFIndex idx;
+    __CFSortedDictionaryFindKey(dict, key, &slot, &idx, &found);
+    return idx;
+}
+
+CFRange CFSortedDictionaryGetRangeOfKeys(CFSortedDictionaryRef dict, const void *lowKey, const void *highKey) {
+    CFIndex low = CFSortedDictionaryGetLowerBoundIndex(dict, lowKey);
+    CFIndex high = CFSortedDictionaryGetLowerBoundIndex(dict, highKey);
+    return CFRangeMake(low, (low < high) ? high - low : 0);
+}
+
+void CFSortedDictionaryGetKeyAndValueAtIndex(CFSortedDictionaryRef dict, CFIndex idx, const void **key, const void **value) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    CFAssert2(0 <= idx && idx < dict->_count, __kCFLogAssertion, "%s(): index (%d) out of bounds", __PRETTY_FUNCTION__, idx);
+    uint32_t slot;
+    CFSortedDictionaryNode *leaf = __CFSortedDictionaryFindIndex(dict, idx, &slot);
+    if (key) *key = leaf->keys[slot];
+    if (value) *value = leaf->info.values[slot];
+}
+
+Boolean CFSortedDictionaryGetFloor(CFSortedDictionaryRef dict, const void *key, const void **foundKey, const void **value) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    if (0 == dict->_count) return false;
+    Boolean found;
+    uint32_t slot;
+    CFIndex idx;
+    CFSortedDictionaryNode *leaf = __CFSortedDictionaryFindKey(dict, key, &slot, &idx, &found);
+    if (!found) {
+	if (0 == idx) return false;
+	if (0 < slot) {
+	    slot--;
+	} else {
+	    leaf = __CFSortedDictionaryFindIndex(dict, idx - 1, &slot);
+	}
+    }
+    if (foundKey) *foundKey = leaf->keys[slot];
+    if (value) *value = leaf->info.values[slot];
+    return true;
+}
+
+Boolean CFSortedDictionaryGetCeiling(CFSortedDictionaryRef dict, const void *key, const void **foundKey, const void **value) {
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    if (0 == dict->_count) return false;
+    Boolean found;
+    uint32_t slot;
+    CFIndex idx;
+    CFSortedDictionaryNode *leaf = __CFSortedDictionaryFindKey(dict, key, &slot, &idx, &found);
+    if (dict->_count == idx) return false;
+    if (leaf->numSlots == slot) leaf = __CFSortedDictionaryFindIndex(dict, idx, &slot);
+    if (foundKey) *foundKey = leaf->keys[slot];
+    if (value) *value = leaf->info.values[slot];
+    return true;
+}
+
+/* Calls applier for the length entries under node starting with its start'th, a leaf's worth at a time. */
+static void __CFSortedDictionaryNodeApply(CFSortedDictionaryNode *node, CFIndex start, CFIndex length, CFDictionaryApplierFunction applier, void *context) {
+    uint32_t idx;
+    if (node->isLeaf) {
+	for (idx = (uint32_t)start; idx < start + length; idx++) INVOKE_CALLBACK3(applier, node->keys[idx], node->info.values[idx], context);
+	return;
+    }
+    for (idx = 0; idx < node->numSlots && 0 < length; idx++) {
+	CFSortedDictionaryNode *child = node->info.children[idx];
+	if (child->count <= start) {
+	    start -= child->count;
+	    continue;
+	}
+	CFIndex num = __CFMin(length, child->count - start);
+	__CFSortedDictionaryNodeApply(child, start, num, applier, context);
+	length -= num;
+	start = 0;
+    }
+}
+
+void CFSortedDictionaryApplyFunction(CFSortedDictionaryRef dict, CFRange range, CFDictionaryApplierFunction applier, void *context) {
+    FAULT_CALLBACK((void **)&(applier));
+    __CFGenericValidateType(dict, CFSortedDictionaryGetTypeID());
+    CFAssert1(NULL != applier, __kCFLogAssertion, "%s(): pointer to applier function may not be NULL", __PRETTY_FUNCTION__);
+    CFAssert3(0 <= range.location && 0 <= range.length && range.location + range.length <= dict->_count, __kCFLogAssertion, "%s(): range (%d, %d) out of bounds", __PRETTY_FUNCTION__, range.location, range.length);
+    if (0 < range.length) __CFSortedDictionaryNodeApply(dict->_root, range.location, range.length, applier, context);
+}
+
+struct __CFSortedDictionaryGetContext {
+    const void **keys;
+    const void **values;
+};
+
+static void __CFSortedDictionaryGetApplier(const void *key, const void *value, void *context) {
+    struct __CFSortedDictionaryGetContext *ctx = (struct __CFSortedDictionaryGetContext *)context;
+    if (ctx->keys) *ctx->keys++ = key;
+    if (ctx->values) *ctx->values++ = value;
+}
+
+void CFSortedDictionaryGetKeysAndValues(CFSortedDictionaryRef dict, CFRange range, const void **keys, const void **values) {
+    struct __CFSortedDictionaryGetContext ctx = {keys, values};
+    CFSortedDictionaryApplyFunction(dict, range, __CFSortedDictionaryGetApplier, &ctx);
+}
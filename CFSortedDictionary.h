@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2015 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*	CFSortedDictionary.h
+	Copyright (c) 2015, Apple Inc. All rights reserved.
+*/
+/*!
+        @header CFSortedDictionary
+CFSortedDictionary associates keys with values and keeps the keys in the
+order given by a CFComparatorFunction.  Two keys for which the comparator
+returns kCFCompareEqualTo are the same key; the key callbacks' equal and hash
+functions are not used.  A sorted dictionary whose values are all NULL serves
+as a sorted set.
+
+The entries are kept in a B+ tree whose nodes hold up to 32 keys, so that
+lookups, insertions and removals are O(log n) with few cache misses, and each
+node records how many entries lie beneath it, so that the entry at an index,
+and the index of a key, are also found in O(log n).  Entries are addressed by
+index for enumeration, which makes range queries a matter of finding the
+index range of the bounding keys with CFSortedDictionaryGetRangeOfKeys().
+
+Like the other mutable CF collections, a CFSortedDictionary is not safe for
+simultaneous reading and writing from different threads.
+*/
+
+#if !defined(__COREFOUNDATION_CFSORTEDDICTIONARY__)
+#define __COREFOUNDATION_CFSORTEDDICTIONARY__ 1
+
+#include <CoreFoundation/CFBase.h>
+#include <CoreFoundation/CFDictionary.h>
+
+CF_EXTERN_C_BEGIN
+
+/*!
+        @typedef CFSortedDictionaryRef
+	This is the type of a reference to a CFSortedDictionary instance.
+*/
+typedef struct __CFSortedDictionary *CFSortedDictionaryRef;
+
+/*!
+        @function CFSortedDictionaryGetTypeID
+        Returns the type identifier of all CFSortedDictionary instances.
+*/
+CF_EXPORT CFTypeID CFSortedDictionaryGetTypeID(void);
+
+/*!
+        @function CFSortedDictionaryCreateMutable
+        Creates a new empty mutable sorted dictionary.
+	@param allocator The CFAllocator which should be used to allocate
+		memory for the dictionary and its nodes. This parameter may
+		be NULL in which case the current default CFAllocator is used.
+	@param comparator The function which orders the keys. If NULL,
+		the keys are ordered by their pointer values.
+	@param context The context pointer passed to the comparator.
+	@param keyCallBacks The callbacks used to retain, release and
+		describe the keys. Only the retain, release and
+		copyDescription fields are used. If NULL, the keys are not
+		retained or released.
+	@param valueCallBacks The callbacks used to retain, release,
+		describe and compare the values. If NULL, the values are not
+		retained or released. NULL values are never passed to
+		these callbacks, so kCFTypeDictionaryValueCallBacks may be
+		used with a dictionary that serves as a set.
+	@result A reference to the new CFSortedDictionary.
+*/
+CF_EXPORT CFSortedDictionaryRef CFSortedDictionaryCreateMutable(CFAllocatorRef allocator, CFComparatorFunction comparator, void *context, const CFDictionaryKeyCallBacks *keyCallBacks, const CFDictionaryValueCallBacks *valueCallBacks);
+
+/*!
+        @function CFSortedDictionaryCreateMutableWithSortedKeysAndValues
+        Creates a new mutable sorted dictionary holding the given entries.
+		If the keys are in strictly ascending order the tree is built
+		bottom-up in O(n); otherwise they are inserted one at a time,
+		later duplicates replacing earlier ones.
+	@param keys A C array of numValues keys.
+	@param values A C array of numValues values, or NULL to give every
+		key a NULL value.
+	@param numValues The number of entries. If this is negative, the
+		behavior is undefined.
+	The other parameters are as for CFSortedDictionaryCreateMutable().
+	@result A reference to the new CFSortedDictionary.
+*/
+CF_EXPORT CFSortedDictionaryRef CFSortedDictionaryCreateMutableWithSortedKeysAndValues(CFAllocatorRef allocator, CFComparatorFunction comparator, void *context, const CFDictionaryKeyCallBacks *keyCallBacks, const CFDictionaryValueCallBacks *valueCallBacks, const void **keys, const void **values, CFIndex numValues);
+
+/*!
+	@function CFSortedDictionaryGetCount
+	Returns the number of entries in the sorted dictionary.
+*/
+CF_EXPORT CFIndex CFSortedDictionaryGetCount(CFSortedDictionaryRef dict);
+
+/*!
+	@function CFSortedDictionaryGetValueIfPresent
+	Looks up a key.
+	@param value If not NULL and the key is present, set to the value
+		associated with the key.
+	@result true if the key is present.
+*/
+CF_EXPORT Boolean CFSortedDictionaryGetValueIfPresent(CFSortedDictionaryRef dict, const void *key, const void **value);
+
+/*!
+	@function CFSortedDictionaryContainsKey
+	Returns whether the key is present in the sorted dictionary.
+*/
+CF_EXPORT Boolean CFSortedDictionaryContainsKey(CFSortedDictionaryRef dict, const void *key);
+
+/*!
+	@function CFSortedDictionaryAddValue
+	Adds the key and value if the key is not already present; otherwise
+	does nothing.
+*/
+CF_EXPORT void CFSortedDictionaryAddValue(CFSortedDictionaryRef dict, const void *key, const void *value);
+
+/*!
+	@function CFSortedDictionarySetValue
+	Adds the key and value if the key is not already present; otherwise
+	replaces the value associated with the key. The existing key object
+	is kept.
+*/
+CF_EXPORT void CFSortedDictionarySetValue(CFSortedDictionaryRef dict, const void *key, const void *value);
+
+/*!
+	@function CFSortedDictionaryRemoveValue
+	Removes the entry for the key, if present.
+*/
+CF_EXPORT void CFSortedDictionaryRemoveValue(CFSortedDictionaryRef dict, const void *key);
+
+/*!
+	@function CFSortedDictionaryRemoveAllValues
+	Removes all the entries.
+*/
+CF_EXPORT void CFSortedDictionaryRemoveAllValues(CFSortedDictionaryRef dict);
+
+/*!
+	@function CFSortedDictionaryGetLowerBoundIndex
+	Returns the index of the first key which is not less than the given
+	key; this is the count of the dictionary if every key is less.
+*/
+CF_EXPORT CFIndex CFSortedDictionaryGetLowerBoundIndex(CFSortedDictionaryRef dict, const void *key);
+
+/*!
+	@function CFSortedDictionaryGetRangeOfKeys
+	Returns the range of indexes of the keys which are not less than
+	lowKey and less than highKey. If highKey is not greater than lowKey
+	the range is empty.
+*/
+CF_EXPORT CFRange CFSortedDictionaryGetRangeOfKeys(CFSortedDictionaryRef dict, const void *lowKey, const void *highKey);
+
+/*!
+	@function CFSortedDictionaryGetKeyAndValueAtIndex
+	Returns the entry at the given index in key order. Either out
+	parameter may be NULL. If the index is outside 0 to N-1 inclusive,
+	where N is the count of the dictionary, the behavior is undefined.
+*/
+CF_EXPORT void CFSortedDictionaryGetKeyAndValueAtIndex(CFSortedDictionaryRef dict, CFIndex idx, const void **key, const void **value);
+
+/*!
+	@function CFSortedDictionaryGetFloor
+	Finds the greatest key which is not greater than the given key.
+	Either out parameter may be NULL.
+	@result true if there is such a key.
+*/
+CF_EXPORT Boolean CFSortedDictionaryGetFloor(CFSortedDictionaryRef dict, const void *key, const void **foundKey, const void **value);
+
+/*!
+	@function CFSortedDictionaryGetCeiling
+	Finds the least key which is not less than the given key.
+	Either out parameter may be NULL.
+	@result true if there is such a key.
+*/
+CF_EXPORT Boolean CFSortedDictionaryGetCeiling(CFSortedDictionaryRef dict, const void *key, const void **foundKey, const void **value);
+
+/*!
+	@function CFSortedDictionaryGetKeysAndValues
+	Copies the entries in the given index range, in key order, into
+	the C arrays keys and values. Either array may be NULL. If the range
+	is outside the index space of the dictionary, the behavior is undefined.
+*/
+CF_EXPORT void CFSortedDictionaryGetKeysAndValues(CFSortedDictionaryRef dict, CFRange range, const void **keys, const void **values);
+
+/*!
+	@function CFSortedDictionaryApplyFunction
+	Calls a function once for each entry in the given index range, in
+	key order. The dictionary must not be mutated by the applier. If the
+	range is outside the index space of the dictionary, the behavior is
+	undefined.
+*/
+CF_EXPORT void CFSortedDictionaryApplyFunction(CFSortedDictionaryRef dict, CFRange range, CFDictionaryApplierFunction applier, void *context);
+
+CF_EXTERN_C_END
+
+#endif /* ! __COREFOUNDATION_CFSORTEDDICTIONARY__ */
+
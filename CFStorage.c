@@ -982,7 +982,7 @@ static CFStringRef __CFStorageCopyDescription(CFTypeRef cf) {
 }
 
 /* Returns true if enumeration should stop, false if it should continue. */
-static bool __CFStorageEnumerateNodesInByteRangeWithBlock(CFStorageRef storage, CFStorageNode *node, CFIndex globalOffsetOfNode, CFRange range, CFIndex concurrencyToken, CFStorageApplierBlock applier) {
+static bool __CFStorageEnumerateNodesInByteRangeWithBlock(CFStorageRef storage, CFStorageNode *node, CFIndex globalOffsetOfNode, CFRange range, CFStorageApplierBlock applier) {
     bool stop = false;
     if (node->isLeaf) {
 	CFIndex start = range.location;
@@ -997,49 +997,89 @@ static bool __CFStorageEnumerateNodesInByteRangeWithBlock(CFStorageRef storage,
 	const CFIndex lengths[3] = {children[0]->numBytes, children[1] ? children[1]->numBytes : 0, children[2] ? children[2]->numBytes : 0};
 	const CFIndex offsets[3] = {0, lengths[0], lengths[0] + lengths[1]};	
 	const CFRange overlaps[3] = {intersectionRange(CFRangeMake(offsets[0], lengths[0]), range), intersectionRange(CFRangeMake(offsets[1], lengths[1]), range), intersectionRange(CFRangeMake(offsets[2], lengths[2]), range)};
-	CFIndex numOverlappingChildren = (!! overlaps[0].length + !! overlaps[1].length + !! overlaps[2].length);
-	if (numOverlappingChildren > 1) concurrencyToken--;
-	
-	if (concurrencyToken >= 0 && numOverlappingChildren > 1) {
-	    CFIndex numChildren = 1 + !!children[1] + !!children[2];
-	    const CFRange * overlapsPtr = overlaps; //blocks don't let us reference arrays :(
-	    const CFIndex * offsetsPtr = offsets;
-	    CFStorageNode ** childrenPtr = children;
-#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_WINDOWS
-	    __block bool blockStop = false;
-	    dispatch_apply(numChildren, __CFDispatchQueueGetGenericMatchingCurrent(), ^(size_t ind) {
-		if (! blockStop && overlapsPtr[ind].length > 0) {
-		    if (__CFStorageEnumerateNodesInByteRangeWithBlock(storage, childrenPtr[ind], globalOffsetOfNode + offsetsPtr[ind], CFRangeMake(overlapsPtr[ind].location - offsetsPtr[ind], overlapsPtr[ind].length), concurrencyToken, applier)) {
-			blockStop = true;
-		    }
-		}
-	    });
-	    stop = blockStop;
-#else
-        for (CFIndex ind = 0; ind < numChildren; ind++) {
-            if (overlapsPtr[ind].length > 0) {
-                if (__CFStorageEnumerateNodesInByteRangeWithBlock(storage, childrenPtr[ind], globalOffsetOfNode + offsetsPtr[ind], CFRangeMake(overlapsPtr[ind].location - offsetsPtr[ind], overlapsPtr[ind].length), concurrencyToken, applier)) {
-                    stop = true;
-                    break;
-		        }
-		    }
-	    }
-#endif
-	} else {
-	    if (overlaps[0].length > 0) {
-		stop = stop || __CFStorageEnumerateNodesInByteRangeWithBlock(storage, children[0], globalOffsetOfNode + offsets[0], CFRangeMake(overlaps[0].location - offsets[0], overlaps[0].length), concurrencyToken, applier);
-	    }
-	    if (overlaps[1].length > 0) {
-		stop = stop || __CFStorageEnumerateNodesInByteRangeWithBlock(storage, children[1], globalOffsetOfNode + offsets[1], CFRangeMake(overlaps[1].location - offsets[1], overlaps[1].length), concurrencyToken, applier);
-	    }
-	    if (overlaps[2].length > 0) {
-		stop = stop || __CFStorageEnumerateNodesInByteRangeWithBlock(storage, children[2], globalOffsetOfNode + offsets[2], CFRangeMake(overlaps[2].location - offsets[2], overlaps[2].length), concurrencyToken, applier);
-	    }
+	if (overlaps[0].length > 0) {
+	    stop = stop || __CFStorageEnumerateNodesInByteRangeWithBlock(storage, children[0], globalOffsetOfNode + offsets[0], CFRangeMake(overlaps[0].location - offsets[0], overlaps[0].length), applier);
+	}
+	if (overlaps[1].length > 0) {
+	    stop = stop || __CFStorageEnumerateNodesInByteRangeWithBlock(storage, children[1], globalOffsetOfNode + offsets[1], CFRangeMake(overlaps[1].location - offsets[1], overlaps[1].length), applier);
+	}
+	if (overlaps[2].length > 0) {
+	    stop = stop || __CFStorageEnumerateNodesInByteRangeWithBlock(storage, children[2], globalOffsetOfNode + offsets[2], CFRangeMake(overlaps[2].location - offsets[2], overlaps[2].length), applier);
 	}
     }
     return stop;
 }
 
+/* The part of one leaf that falls in a byte range being enumerated or copied.  Operations over large ranges first list these spans in order with a single walk of the tree, then work through them without going back to the tree, possibly concurrently. */
+typedef struct {
+    CFStorageNode *leaf;
+    CFIndex globalOffsetOfNode;	/* byte offset of the leaf in the storage */
+    CFRange range;		/* bytes of the leaf in the range, relative to the leaf */
+} CFStorageLeafSpan;
+
+typedef struct {
+    CFStorageLeafSpan *spans;
+    CFIndex count;
+    CFIndex capacity;
+    CFStorageLeafSpan inlineSpans[32];
+} CFStorageLeafSpanList;
+
+static void __CFStorageAddLeafSpan(CFStorageLeafSpanList *list, CFStorageNode *leaf, CFIndex globalOffsetOfNode, CFRange range) {
+    if (list->count == list->capacity) {
+	CFIndex capacity = 2 * list->capacity;
+	CFStorageLeafSpan *spans = (CFStorageLeafSpan *)CFAllocatorAllocate(kCFAllocatorSystemDefault, capacity * sizeof(CFStorageLeafSpan), 0);
+	if (__CFOASafe) __CFSetLastAllocationEventName(spans, "CFStorage (temp)");
+	memmove(spans, list->spans, list->count * sizeof(CFStorageLeafSpan));
+	if (list->spans != list->inlineSpans) CFAllocatorDeallocate(kCFAllocatorSystemDefault, list->spans);
+	list->spans = spans;
+	list->capacity = capacity;
+    }
+    CFStorageLeafSpan *span = list->spans + list->count++;
+    span->leaf = leaf;
+    span->globalOffsetOfNode = globalOffsetOfNode;
+    span->range = range;
+}
+
+/* Lists the leaf spans covering range, which is relative to node, allocating any lazily-allocated leaf memory on the way so the spans can then be read from any thread. */
+static void __CFStorageCollectLeafSpansInByteRange(CFStorageRef storage, CFStorageNode *node, CFIndex globalOffsetOfNode, CFRange range, CFStorageLeafSpanList *list) {
+    if (node->isLeaf) {
+	if (! node->info.leaf.memory) {
+	    __CFStorageAllocLeafNodeMemory(CFGetAllocator(storage), storage, node, node->numBytes, false);
+	}
+	__CFStorageAddLeafSpan(list, node, globalOffsetOfNode, CFRangeMake(range.location, __CFMin(range.length, node->numBytes - range.location)));
+    } else {
+	CFIndex offset = 0;
+	for (CFIndex ind = 0; ind < 3 && node->info.notLeaf.child[ind]; ind++) {
+	    CFStorageNode *child = node->info.notLeaf.child[ind];
+	    CFRange overlap = intersectionRange(CFRangeMake(offset, child->numBytes), range);
+	    if (overlap.length > 0) __CFStorageCollectLeafSpansInByteRange(storage, child, globalOffsetOfNode + offset, CFRangeMake(overlap.location - offset, overlap.length), list);
+	    offset += child->numBytes;
+	}
+    }
+}
+
+static void __CFStorageInitLeafSpanList(CFStorageRef storage, CFRange byteRange, CFStorageLeafSpanList *list) {
+    list->spans = list->inlineSpans;
+    list->count = 0;
+    list->capacity = sizeof(list->inlineSpans) / sizeof(list->inlineSpans[0]);
+    __CFStorageCollectLeafSpansInByteRange(storage, &storage->rootNode, 0, byteRange, list);
+}
+
+static void __CFStorageDestroyLeafSpanList(CFStorageLeafSpanList *list) {
+    if (list->spans != list->inlineSpans) CFAllocatorDeallocate(kCFAllocatorSystemDefault, list->spans);
+}
+
+/* Number of pieces to cut a list of spans into for __CFApplyConcurrently(); a few per processor, so a slow piece doesn't hold up the rest. */
+static CFIndex __CFStorageNumberOfConcurrentChunks(CFIndex numSpans) {
+    return __CFMin(numSpans, 4 * __CFActiveProcessorCount());
+}
+
+#if __GNUC__
+#define __CFStoragePrefetch(P) __builtin_prefetch((P))
+#else
+#define __CFStoragePrefetch(P) do { } while (0)
+#endif
+
 static CFStorageNode *_CFStorageFindNodeContainingByteRange(ConstCFStorageRef storage, const CFStorageNode *node, CFRange nodeRange, CFIndex globalOffsetOfNode, CFRange *outGlobalByteRangeOfResult) {
     if (! node->isLeaf) {
 	/* See how many children are overlapped by this range.  If it's only 1, call us recursively on that node; otherwise we're it! */
@@ -1323,8 +1363,58 @@ void CFStorageDeleteValues(CFStorageRef storage, CFRange range) {
     CHECK_INTEGRITY();
 }
 
+struct __CFStorageSpanContext {
+    CFStorageRef storage;
+    CFStorageLeafSpan *spans;
+    CFIndex numSpans;
+    CFIndex numChunks;
+    uint8_t *values;		/* copying: destination of the first byte of the range */
+    CFIndex firstByte;		/* copying: offset of the range in the storage */
+    CFStorageApplierBlock applier;	/* enumerating */
+    volatile bool stop;		/* enumerating */
+};
+
+static void __CFStorageCopyOutSpans(void *context, size_t chunk) {
+    struct __CFStorageSpanContext *ctx = (struct __CFStorageSpanContext *)context;
+    CFIndex idx = (ctx->numSpans * chunk) / ctx->numChunks, end = (ctx->numSpans * (chunk + 1)) / ctx->numChunks;
+    for (; idx < end; idx++) {
+	CFStorageLeafSpan *span = ctx->spans + idx;
+	if (idx + 1 < end) __CFStoragePrefetch(span[1].leaf->info.leaf.memory + span[1].range.location);
+	COPYMEM(span->leaf->info.leaf.memory + span->range.location, ctx->values + (span->globalOffsetOfNode + span->range.location - ctx->firstByte), span->range.length);
+    }
+}
+
+static void __CFStorageApplyBlockToSpans(void *context, size_t chunk) {
+    struct __CFStorageSpanContext *ctx = (struct __CFStorageSpanContext *)context;
+    CFIndex idx = (ctx->numSpans * chunk) / ctx->numChunks, end = (ctx->numSpans * (chunk + 1)) / ctx->numChunks;
+    for (; idx < end && !ctx->stop; idx++) {
+	CFStorageLeafSpan *span = ctx->spans + idx;
+	bool stop = false;
+	ctx->applier(span->leaf->info.leaf.memory + span->range.location, __CFStorageConvertBytesToValueRange(ctx->storage, span->globalOffsetOfNode + span->range.location, span->range.length), &stop);
+	if (stop) ctx->stop = true;
+    }
+}
+
+/* Copies of at least this many bytes walk the tree once and stream whole leaves out, rather than looking up each leaf from the root; copies of at least __CFStorageConcurrentCopyBytes are also split across processors. */
+#define __CFStorageBulkCopyBytes (4 * __CFStorageMaxLeafCapacity)
+#define __CFStorageConcurrentCopyBytes (4 * 1024 * 1024)
+
 void CFStorageGetValues(CFStorageRef storage, CFRange range, void *values) {
     CHECK_INTEGRITY();
+    CFRange byteRange = __CFStorageConvertValuesToByteRange(storage, range.location, range.length);
+    if (byteRange.length >= __CFStorageBulkCopyBytes) {
+	CFStorageLeafSpanList list;
+	__CFStorageInitLeafSpanList(storage, byteRange, &list);
+	struct __CFStorageSpanContext ctx = {storage, list.spans, list.count, 1, (uint8_t *)values, byteRange.location, NULL, false};
+	if (byteRange.length >= __CFStorageConcurrentCopyBytes) ctx.numChunks = __CFStorageNumberOfConcurrentChunks(list.count);
+	if (1 < ctx.numChunks) {
+	    __CFApplyConcurrently(ctx.numChunks, &ctx, __CFStorageCopyOutSpans);
+	} else {
+	    __CFStorageCopyOutSpans(&ctx, 0);
+	}
+	__CFStorageDestroyLeafSpanList(&list);
+	return;
+    }
     while (range.length > 0) {
         CFRange leafRange;
         void *storagePtr = __CFStorageGetValueAtIndex(storage, range.location, &leafRange, false/*requireUnfreezing*/);
@@ -1363,12 +1453,16 @@ void CFStorageApplyFunction(CFStorageRef storage, CFRange range, CFStorageApplie
 void CFStorageApplyBlock(CFStorageRef storage, CFRange range, CFStorageEnumerationOptionFlags options, CFStorageApplierBlock applier) {
     if (! range.length) return;
     CFRange byteRange = __CFStorageConvertValuesToByteRange(storage, range.location, range.length);
-    /* As we descend the tree, if we find we need to go down two or more children, and the concurrency token is not zero, then we decrement the concurrency token and do it concurrently.  Since we have 3 children, a concurrency token of 3 yields up to 3**3 == 27 threads, which is a lot!  Concurrency benefits start to kick in around one million elements */
-    CFIndex concurrencyToken = 0;
+    /* Concurrent enumeration lists the leaves in the range and hands out runs of them to __CFApplyConcurrently(), so every processor gets work however the 2-3 tree happens to be shaped.  Concurrency benefits start to kick in around one million elements */
     if ((options & kCFStorageEnumerationConcurrent) && (range.length >= 1024 * 1024)) {
-	concurrencyToken = 3;
-    }
-    __CFStorageEnumerateNodesInByteRangeWithBlock(storage, &storage->rootNode, 0/*globalOffsetOfNode*/, byteRange, concurrencyToken, applier);
+	CFStorageLeafSpanList list;
+	__CFStorageInitLeafSpanList(storage, byteRange, &list);
+	struct __CFStorageSpanContext ctx = {storage, list.spans, list.count, __CFStorageNumberOfConcurrentChunks(list.count), NULL, 0, applier, false};
+	__CFApplyConcurrently(ctx.numChunks, &ctx, __CFStorageApplyBlockToSpans);
+	__CFStorageDestroyLeafSpanList(&list);
+	return;
+    }
+    __CFStorageEnumerateNodesInByteRangeWithBlock(storage, &storage->rootNode, 0/*globalOffsetOfNode*/, byteRange, applier);
 }
 
 void CFStorageReplaceValues(CFStorageRef storage, CFRange range, const void *values) {
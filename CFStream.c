@@ -396,6 +396,10 @@ CF_EXPORT void* _CFStreamGetInfoPointer(struct _CFStream* stream) {
     return stream == NULL? NULL : stream->info;
 }
 
+CF_PRIVATE Boolean _CFStreamHasConstantCallBacks(struct _CFStream *stream, const struct _CFStreamCallBacks *cb) {
+    return (stream != NULL && __CFBitIsSet(stream->flags, CONSTANT_CALLBACKS) && stream->callBacks == cb);
+}
+
 CF_PRIVATE struct _CFStream *_CFStreamCreateWithConstantCallbacks(CFAllocatorRef alloc, void *info,  const struct _CFStreamCallBacks *cb, Boolean isReading) {
     struct _CFStream *newStream;
     if (cb->version != 1) return NULL;
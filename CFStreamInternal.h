@@ -63,6 +63,9 @@ struct _CFStreamCallBacksV1 {
     void (*unschedule)(struct _CFStream *stream, CFRunLoopRef runLoop, CFStringRef runLoopMode, void *info);
 };
 
+// True if stream was created by _CFStreamCreateWithConstantCallbacks() with exactly these callbacks
+CF_PRIVATE Boolean _CFStreamHasConstantCallBacks(struct _CFStream *stream, const struct _CFStreamCallBacks *cb);
+
 // These two are defined in CFSocketStream.c because that's where the glue for CFNetwork is.
 CF_PRIVATE CFErrorRef _CFErrorFromStreamError(CFAllocatorRef alloc, CFStreamError *err);
 CF_PRIVATE CFStreamError _CFStreamErrorFromError(CFErrorRef error);
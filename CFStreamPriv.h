@@ -152,6 +152,20 @@ CFReadStreamRef _CFReadStreamCreateFromFileDescriptor(CFAllocatorRef alloc, int
 CF_EXPORT
 CFWriteStreamRef _CFWriteStreamCreateFromFileDescriptor(CFAllocatorRef alloc, int fd);
 
+/*
+** _CFWriteStreamWriteDataWrittenToFileDescriptor
+**
+** For a stream created with CFWriteStreamCreateWithAllocatedBuffers(), writes
+** everything written to the stream so far to fd with writev(), straight from
+** the stream's internal buffers, without first flattening them into a CFData.
+** Returns the number of bytes written, or -1 with errno set.  Any other kind
+** of stream fails with EINVAL.
+*/
+#if TARGET_OS_MAC || TARGET_OS_EMBEDDED || TARGET_OS_IPHONE || TARGET_OS_LINUX
+CF_EXPORT
+CFIndex _CFWriteStreamWriteDataWrittenToFileDescriptor(CFWriteStreamRef stream, int fd);
+#endif
+
 
 
 #define SECURITY_NONE   (0)
@@ -245,7 +245,12 @@ CF_PRIVATE Boolean __CFStringScanDouble(CFStringInlineBuffer *buf, CFTypeRef loc
     };
     charPtr[numChars] = 0;	// Null byte for strtod
 
-    result = strtod_l(charPtr, &endCharPtr, NULL);
+    CFIndex parsed = __CFDoubleParseDecimal(charPtr, numChars, &result);
+    if (0 < parsed) {
+        endCharPtr = charPtr + parsed;
+    } else {
+        result = strtod_l(charPtr, &endCharPtr, NULL);
+    }
 
     if (tmpAlloc) CFAllocatorDeallocate(tmpAlloc, charPtr);
     if (charPtr == endCharPtr) return false;
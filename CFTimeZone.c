@@ -232,12 +232,34 @@ typedef struct _CFTZPeriod {
     uint32_t info;
 } CFTZPeriod;
 
+/* The POSIX TZ string at the end of version 2 and later data gives the
+ * rule for all times after the last transition in the data */
+typedef struct _CFTZRuleDate {
+    char kind;			/* 'J', 'D' or 'M' */
+    uint8_t month;
+    uint8_t week;		/* 5 == last */
+    uint8_t weekday;		/* 0 == Sunday */
+    int16_t day;
+    int32_t time;		/* seconds after local midnight */
+} CFTZRuleDate;
+
+typedef struct _CFTZRule {
+    CFStringRef stdAbbrev;
+    CFStringRef dstAbbrev;	/* NULL if the rule has no DST */
+    int32_t stdOffset;
+    int32_t dstOffset;
+    CFTZRuleDate start;
+    CFTZRuleDate end;
+} CFTZRule;
+
 struct __CFTimeZone {
     CFRuntimeBase _base;
     CFStringRef _name;		/* immutable */
     CFDataRef _data;		/* immutable */
     CFTZPeriod *_periods;	/* immutable */
     int32_t _periodCnt;		/* immutable */
+    int32_t _hint;		/* index of the last period looked up; unsynchronized, so only ever a guess */
+    CFTZRule *_rule;		/* immutable; may be NULL */
 };
 
 /* startSec is the whole integer seconds from a CFAbsoluteTime, giving dates
@@ -283,16 +305,105 @@ static CFComparisonResult __CFCompareTZPeriods(const void *val1, const void *val
     return kCFCompareGreaterThan;
 }
 
-static CFIndex __CFBSearchTZPeriods(CFTimeZoneRef tz, CFAbsoluteTime at) {
-    CFTZPeriod elem;
-    __CFTZPeriodInit(&elem, (int32_t)floor(at + 1.0), NULL, 0, false);
-    CFIndex idx = CFBSearch(&elem, sizeof(CFTZPeriod), tz->_periods, tz->_periodCnt, __CFCompareTZPeriods, NULL);
-    if (tz->_periodCnt <= idx) {
-	idx = tz->_periodCnt;
-    } else if (0 == idx) {
-	idx = 1;
+CF_INLINE void __CFTZPeriodInitFromRule(CFTZPeriod *period, const CFTZRule *rule, Boolean isDST) {
+    __CFTZPeriodInit(period, 0, NULL, isDST ? rule->dstOffset : rule->stdOffset, isDST);
+    period->abbrev = isDST ? rule->dstAbbrev : rule->stdAbbrev;	/* not retained; the rule owns it */
+}
+
+static CFAbsoluteTime __CFTZRuleDateLocalTime(const CFTZRuleDate *date, int64_t year) {
+    int64_t days = __CFDaysFromGregorianYMD(year, 1, 1);
+    if ('J' == date->kind) {
+	// Jn counts from 1 and never names February 29
+	Boolean isLeap = (29 == __CFDaysFromGregorianYMD(year, 3, 1) - __CFDaysFromGregorianYMD(year, 2, 1));
+	days += date->day - 1 + ((isLeap && 60 <= date->day) ? 1 : 0);
+    } else if ('D' == date->kind) {
+	days += date->day;
+    } else {
+	int64_t first = __CFDaysFromGregorianYMD(year, date->month, 1);
+	int64_t limit = __CFDaysFromGregorianYMD(year, date->month + 1, 1);
+	int64_t weekday = ((first % 7) + 8) % 7;	// 2001-01-01 was a Monday
+	days = first + (date->weekday - weekday + 7) % 7 + 7 * (date->week - 1);
+	while (limit <= days) days -= 7;
+    }
+    return (CFAbsoluteTime)days * 86400.0 + date->time;
+}
+
+static void __CFTZRuleGetPeriod(const CFTZRule *rule, CFAbsoluteTime at, CFTZPeriod *period, CFAbsoluteTime *next) {
+    CFAbsoluteTime times[6];
+    Boolean toDST[6];
+    CFIndex cnt = 0, idx, found = -1;
+    int64_t year, y;
+    if (NULL == rule->dstAbbrev) {
+	__CFTZPeriodInitFromRule(period, rule, false);
+	if (next) *next = 0.0;
+	return;
+    }
+    CFAbsoluteTime day = floor((at + rule->stdOffset) / 86400.0);
+    if (!(-1.0e9 < day)) day = -1.0e9;
+    if (1.0e9 < day) day = 1.0e9;
+    __CFGregorianYMDFromDays((int64_t)day, &year, NULL, NULL);
+    // Sort the transitions of the years around at; whether DST starts
+    // or ends first in a year depends on the hemisphere.  On a tie, as
+    // in rules for permanent DST, the end sorts first.
+    for (y = year - 1; y <= year + 1; y++) {
+	for (CFIndex which = 0; which < 2; which++) {
+	    Boolean isStart = (0 == which);
+	    CFAbsoluteTime t = isStart ? __CFTZRuleDateLocalTime(&rule->start, y) - rule->stdOffset : __CFTZRuleDateLocalTime(&rule->end, y) - rule->dstOffset;
+	    for (idx = cnt; 0 < idx && (t < times[idx - 1] || (t == times[idx - 1] && !isStart && toDST[idx - 1])); idx--) {
+		times[idx] = times[idx - 1];
+		toDST[idx] = toDST[idx - 1];
+	    }
+	    times[idx] = t;
+	    toDST[idx] = isStart;
+	    cnt++;
+	}
+    }
+    for (idx = 0; idx < cnt && times[idx] <= at; idx++) found = idx;
+    Boolean isDST = (0 <= found) ? toDST[found] : !toDST[0];
+    __CFTZPeriodInitFromRule(period, rule, isDST);
+    if (next) {
+	*next = 0.0;
+	// the next transition is at most the first of the following year's,
+	// so the last, whose neighbour in the year after isn't known, is skipped;
+	// the zero-length periods between years of permanent DST don't count
+	for (idx = found + 1; idx + 1 < cnt; idx++) {
+	    if (times[idx + 1] == times[idx]) continue;
+	    if (toDST[idx] != isDST) {
+		*next = times[idx];
+		break;
+	    }
+	}
+    }
+}
+
+/* Returns the period containing at.  From the start of the last period
+ * in the table on, the data's rule, if it has one, decides instead: the
+ * period is built in *scratch.  If next is not NULL, it gets the start
+ * of the following period, or 0.0 if there is none. */
+static const CFTZPeriod *__CFTimeZoneGetPeriod(CFTimeZoneRef tz, CFAbsoluteTime at, CFTZPeriod *scratch, CFAbsoluteTime *next) {
+    const CFTZPeriod *periods = tz->_periods;
+    int32_t cnt = tz->_periodCnt, idx = tz->_hint;
+    // lookups tend to come in runs close together, so try the last hit first
+    if (!(0 <= idx && idx < cnt && __CFTZPeriodStartSeconds(periods + idx) <= at && (cnt <= idx + 1 || at < __CFTZPeriodStartSeconds(periods + idx + 1)))) {
+	int32_t lo = 0, hi = cnt - 1;
+	// the first period also covers all times before it
+	while (lo < hi) {
+	    int32_t mid = lo + (hi - lo + 1) / 2;
+	    if (__CFTZPeriodStartSeconds(periods + mid) <= at) {
+		lo = mid;
+	    } else {
+		hi = mid - 1;
+	    }
+	}
+	idx = lo;
+	((struct __CFTimeZone *)tz)->_hint = idx;
+    }
+    if (idx + 1 == cnt && NULL != tz->_rule && __CFTZPeriodStartSeconds(periods + idx) <= at) {
+	__CFTZRuleGetPeriod(tz->_rule, at, scratch, next);
+	return scratch;
     }
-    return idx - 1;
+    if (next) *next = (idx + 1 < cnt) ? (CFAbsoluteTime)__CFTZPeriodStartSeconds(periods + idx + 1) : 0.0;
+    return periods + idx;
 }
 
 
@@ -305,6 +416,10 @@ CF_INLINE int32_t __CFDetzcode(const unsigned char *bufp) {
     return result;
 }
 
+CF_INLINE int64_t __CFDetzcode64(const unsigned char *bufp) {
+    return (int64_t)(((uint64_t)(uint32_t)__CFDetzcode(bufp) << 32) | (uint32_t)__CFDetzcode(bufp + 4));
+}
+
 CF_INLINE void __CFEntzcode(int32_t value, unsigned char *bufp) {
     bufp[0] = (value >> 24) & 0xff;
     bufp[1] = (value >> 16) & 0xff;
@@ -312,19 +427,185 @@ CF_INLINE void __CFEntzcode(int32_t value, unsigned char *bufp) {
     bufp[3] = (value >> 0) & 0xff;
 }
 
-static Boolean __CFParseTimeZoneData(CFAllocatorRef allocator, CFDataRef data, CFTZPeriod **tzpp, CFIndex *cntp) {
-    int32_t len, timecnt, typecnt, charcnt, idx, cnt;
-    const uint8_t *p, *timep, *typep, *ttisp, *charp;
+static Boolean __CFParseTZRuleNumber(const char **pp, const char *end, int32_t max, int32_t *value) {
+    const char *p = *pp;
+    int32_t v = 0;
+    if (p == end || *p < '0' || '9' < *p) return false;
+    while (p < end && '0' <= *p && *p <= '9') {
+	v = v * 10 + (*p++ - '0');
+	if (max < v) return false;
+    }
+    *pp = p;
+    *value = v;
+    return true;
+}
+
+/* [+-]hh[:mm[:ss]] */
+static Boolean __CFParseTZRuleTime(const char **pp, const char *end, int32_t maxHours, int32_t *seconds) {
+    const char *p = *pp;
+    int32_t sign = 1, hours, minutes = 0, secs = 0;
+    if (p < end && ('+' == *p || '-' == *p)) sign = ('-' == *p++) ? -1 : 1;
+    if (!__CFParseTZRuleNumber(&p, end, maxHours, &hours)) return false;
+    if (p < end && ':' == *p) {
+	p++;
+	if (!__CFParseTZRuleNumber(&p, end, 59, &minutes)) return false;
+	if (p < end && ':' == *p) {
+	    p++;
+	    if (!__CFParseTZRuleNumber(&p, end, 59, &secs)) return false;
+	}
+    }
+    *pp = p;
+    *seconds = sign * (hours * 3600 + minutes * 60 + secs);
+    return true;
+}
+
+static Boolean __CFParseTZRuleName(CFAllocatorRef allocator, const char **pp, const char *end, CFStringRef *name) {
+    const char *p = *pp, *start;
+    CFIndex length;
+    if (p < end && '<' == *p) {
+	// quoted names, such as <+0330>, may hold digits and signs
+	start = ++p;
+	while (p < end && '>' != *p) p++;
+	if (p == end) return false;
+	length = p - start;
+	p++;
+    } else {
+	start = p;
+	while (p < end && (('A' <= *p && *p <= 'Z') || ('a' <= *p && *p <= 'z'))) p++;
+	length = p - start;
+    }
+    if (length < 3) return false;
+    *name = CFStringCreateWithBytes(allocator, (const UInt8 *)start, length, kCFStringEncodingASCII, false);
+    *pp = p;
+    return (NULL != *name);
+}
+
+/* Mm.w.d, Jn or n, then an optional /time */
+static Boolean __CFParseTZRuleDate(const char **pp, const char *end, CFTZRuleDate *date) {
+    const char *p = *pp;
+    int32_t month, week, weekday, day;
+    memset(date, 0, sizeof(CFTZRuleDate));
+    if (p < end && 'M' == *p) {
+	p++;
+	if (!__CFParseTZRuleNumber(&p, end, 12, &month) || month < 1 || p == end || '.' != *p++) return false;
+	if (!__CFParseTZRuleNumber(&p, end, 5, &week) || week < 1 || p == end || '.' != *p++) return false;
+	if (!__CFParseTZRuleNumber(&p, end, 6, &weekday)) return false;
+	date->kind = 'M';
+	date->month = (uint8_t)month;
+	date->week = (uint8_t)week;
+	date->weekday = (uint8_t)weekday;
+    } else if (p < end && 'J' == *p) {
+	p++;
+	if (!__CFParseTZRuleNumber(&p, end, 365, &day) || day < 1) return false;
+	date->kind = 'J';
+	date->day = (int16_t)day;
+    } else {
+	if (!__CFParseTZRuleNumber(&p, end, 365, &day)) return false;
+	date->kind = 'D';
+	date->day = (int16_t)day;
+    }
+    date->time = 2 * 3600;
+    if (p < end && '/' == *p) {
+	p++;
+	// version 3 data allows -167 to 167 hours, for rules like permanent DST
+	if (!__CFParseTZRuleTime(&p, end, 167, &date->time)) return false;
+    }
+    *pp = p;
+    return true;
+}
+
+static void __CFTZRuleDestroy(CFAllocatorRef allocator, CFTZRule *rule) {
+    if (NULL != rule->stdAbbrev) CFRelease(rule->stdAbbrev);
+    if (NULL != rule->dstAbbrev) CFRelease(rule->dstAbbrev);
+    if (allocator) CFAllocatorDeallocate(allocator, rule);
+}
+
+/* Parses a POSIX TZ string like "EST5EDT,M3.2.0,M11.1.0".  Offsets in
+ * the string are hours west of GMT, the opposite sign to CFTimeZone's. */
+static CFTZRule *__CFParseTZRule(CFAllocatorRef allocator, const char *p, const char *end) {
+    CFTZRule rule, *result;
+    int32_t offset;
+    Boolean ok;
+    memset(&rule, 0, sizeof(CFTZRule));
+    ok = __CFParseTZRuleName(allocator, &p, end, &rule.stdAbbrev) && __CFParseTZRuleTime(&p, end, 24, &offset);
+    if (ok) {
+	rule.stdOffset = rule.dstOffset = -offset;
+    }
+    if (ok && p < end) {
+	ok = __CFParseTZRuleName(allocator, &p, end, &rule.dstAbbrev);
+	rule.dstOffset = rule.stdOffset + 3600;
+	if (ok && p < end && ',' != *p) {
+	    ok = __CFParseTZRuleTime(&p, end, 24, &offset);
+	    rule.dstOffset = -offset;
+	}
+	if (ok && p < end) {
+	    ok = (',' == *p++) && __CFParseTZRuleDate(&p, end, &rule.start) && p < end && (',' == *p++) && __CFParseTZRuleDate(&p, end, &rule.end) && p == end;
+	} else if (ok) {
+	    // POSIX leaves the dates up to the implementation; use the US
+	    // ones, M3.2.0 and M11.1.0
+	    rule.start.kind = rule.end.kind = 'M';
+	    rule.start.month = 3;
+	    rule.start.week = 2;
+	    rule.end.month = 11;
+	    rule.end.week = 1;
+	    rule.start.time = rule.end.time = 2 * 3600;
+	}
+    }
+    if (!ok) {
+	__CFTZRuleDestroy(NULL, &rule);
+	return NULL;
+    }
+    result = CFAllocatorAllocate(allocator, sizeof(CFTZRule), 0);
+    if (__CFOASafe) __CFSetLastAllocationEventName(result, "CFTimeZone (rule)");
+    *result = rule;
+    return result;
+}
+
+/* Length of the data block following the TZif header at p, for times of
+ * timesize bytes, or -1 if the counts are bad */
+static int32_t __CFTZifDataLength(const uint8_t *p, int32_t timesize) {
+    int32_t ttisgmtcnt = __CFDetzcode(p + 20), ttisstdcnt = __CFDetzcode(p + 24), leapcnt = __CFDetzcode(p + 28);
+    int32_t timecnt = __CFDetzcode(p + 32), typecnt = __CFDetzcode(p + 36), charcnt = __CFDetzcode(p + 40);
+    if (ttisgmtcnt < 0 || ttisstdcnt < 0 || leapcnt < 0 || timecnt < 0 || typecnt < 0 || charcnt < 0) return -1;
+    if (65535 < ttisgmtcnt || 65535 < ttisstdcnt || 65535 < leapcnt || 65535 < timecnt || 65535 < typecnt || 65535 < charcnt) return -1;
+    return (timesize + 1) * timecnt + (4 + 1 + 1) * typecnt + charcnt + (timesize + 4) * leapcnt + ttisstdcnt + ttisgmtcnt;
+}
+
+static Boolean __CFParseTimeZoneData(CFAllocatorRef allocator, CFDataRef data, CFTZPeriod **tzpp, CFIndex *cntp, CFTZRule **rulep) {
+    int32_t len, timecnt, typecnt, charcnt, idx, cnt, timesize = 4;
+    const uint8_t *bytes, *p, *timep, *typep, *ttisp, *charp;
     CFStringRef *abbrs;
     Boolean result = true;
 
-    p = CFDataGetBytePtr(data);
+    *rulep = NULL;
+    p = bytes = CFDataGetBytePtr(data);
     len = CFDataGetLength(data);
     if (len < (int32_t)sizeof(struct tzhead)) {
 	return false;
     }
     
     if (!(p[0] == 'T' && p[1] == 'Z' && p[2] == 'i' && p[3] == 'f')) return false;  /* Don't parse without TZif at head of file */
+
+    if ('2' <= p[4]) {
+	// Version 2 and later data repeats the tables with 64-bit times
+	// after the version 1 ones, then ends with a rule for later times;
+	// use those, and fall back to the version 1 tables if they're bad.
+	int32_t v1len = __CFTZifDataLength(p, 4);
+	int32_t h2off = (int32_t)sizeof(struct tzhead) + v1len;
+	if (0 <= v1len && h2off + (int32_t)sizeof(struct tzhead) <= len && 0 == memcmp(p + h2off, "TZif", 4)) {
+	    int32_t v2len = __CFTZifDataLength(p + h2off, 8);
+	    int32_t footoff = h2off + (int32_t)sizeof(struct tzhead) + v2len;
+	    if (0 <= v2len && footoff <= len) {
+		p += h2off;
+		timesize = 8;
+		if (footoff < len && '\n' == bytes[footoff]) {
+		    const uint8_t *footer = bytes + footoff + 1;
+		    const uint8_t *footerEnd = memchr(footer, '\n', len - footoff - 1);
+		    if (footerEnd && footer < footerEnd) *rulep = __CFParseTZRule(allocator, (const char *)footer, (const char *)footerEnd);
+		}
+	    }
+	}
+    }
    
     p += 20 + 4 + 4 + 4;	/* skip reserved, ttisgmtcnt, ttisstdcnt, leapcnt */
     timecnt = __CFDetzcode(p);
@@ -333,19 +614,17 @@ static Boolean __CFParseTimeZoneData(CFAllocatorRef allocator, CFDataRef data, C
     p += 4;
     charcnt = __CFDetzcode(p);
     p += 4;
-    if (typecnt <= 0 || timecnt < 0 || charcnt < 0) {
-	return false;
-    }
-    if (1024 < timecnt || 32 < typecnt || 128 < charcnt) {
+    if (typecnt <= 0 || timecnt < 0 || charcnt < 0 ||
 	// reject excessive timezones to avoid arithmetic overflows for
 	// security reasons and to reject potentially corrupt files
-	return false;
-    }
-    if (len - (int32_t)sizeof(struct tzhead) < (4 + 1) * timecnt + (4 + 1 + 1) * typecnt + charcnt) {
+	1024 < timecnt || 32 < typecnt || 128 < charcnt ||
+	(bytes + len) - p < (timesize + 1) * timecnt + (4 + 1 + 1) * typecnt + charcnt) {
+	if (NULL != *rulep) __CFTZRuleDestroy(allocator, *rulep);
+	*rulep = NULL;
 	return false;
     }
     timep = p;
-    typep = timep + 4 * timecnt;
+    typep = timep + timesize * timecnt;
     ttisp = typep + timecnt;
     charp = ttisp + (4 + 1 + 1) * typecnt;
     cnt = (0 < timecnt) ? timecnt : 1;
@@ -362,12 +641,12 @@ static Boolean __CFParseTimeZoneData(CFAllocatorRef allocator, CFDataRef data, C
 	int32_t itime, offset;
 	uint8_t type, dst, abbridx;
 
-	at = (CFAbsoluteTime)(__CFDetzcode(timep) + 0.0) - kCFAbsoluteTimeIntervalSince1970;
+	at = ((8 == timesize) ? (CFAbsoluteTime)__CFDetzcode64(timep) : (CFAbsoluteTime)(__CFDetzcode(timep) + 0.0)) - kCFAbsoluteTimeIntervalSince1970;
 	if (0 == timecnt) itime = INT_MIN;
 	else if (at < (CFAbsoluteTime)INT_MIN) itime = INT_MIN;
 	else if ((CFAbsoluteTime)INT_MAX < at) itime = INT_MAX;
 	else itime = (int32_t)at;
-	timep += 4;	/* harmless if 0 == timecnt */
+	timep += timesize;	/* harmless if 0 == timecnt */
 	type = (0 < timecnt) ? (uint8_t)*typep++ : 0;
 	if (typecnt <= type) {
 	    result = false;
@@ -425,6 +704,8 @@ static Boolean __CFParseTimeZoneData(CFAllocatorRef allocator, CFDataRef data, C
     } else {
 	CFAllocatorDeallocate(allocator, *tzpp);
 	*tzpp = NULL;
+	if (NULL != *rulep) __CFTZRuleDestroy(allocator, *rulep);
+	*rulep = NULL;
     }
     return result;
 }
@@ -463,6 +744,7 @@ static void __CFTimeZoneDeallocate(CFTypeRef cf) {
 	if (NULL != tz->_periods[idx].abbrev) CFRelease(tz->_periods[idx].abbrev);
     }
     if (NULL != tz->_periods) CFAllocatorDeallocate(allocator, tz->_periods);
+    if (NULL != tz->_rule) __CFTZRuleDestroy(allocator, tz->_rule);
 }
 
 static CFTypeID __kCFTimeZoneTypeID = _kCFRuntimeNotATypeID;
@@ -970,11 +1252,25 @@ void CFTimeZoneSetAbbreviationDictionary(CFDictionaryRef dict) {
     __CFTimeZoneUnlockGlobal();
 }
 
+CF_PRIVATE Boolean __CFTimeZoneGetFixedOffset(CFTimeZoneRef tz, int32_t *seconds) {
+    if (1 != tz->_periodCnt) return false;
+    int32_t offset = __CFTZPeriodGMTOffset(tz->_periods);
+    if (NULL != tz->_rule && (NULL != tz->_rule->dstAbbrev || tz->_rule->stdOffset != offset)) return false;
+    if (seconds) *seconds = offset;
+    return true;
+}
+
+CF_PRIVATE CFAbsoluteTime __CFTimeZoneGetDataStart(CFTimeZoneRef tz) {
+    if (__CFTimeZoneGetFixedOffset(tz, NULL)) return -DBL_MAX;
+    return (CFAbsoluteTime)__CFTZPeriodStartSeconds(tz->_periods);
+}
+
 CFTimeZoneRef CFTimeZoneCreate(CFAllocatorRef allocator, CFStringRef name, CFDataRef data) {
 // assert:    (NULL != name && NULL != data);
     CFTimeZoneRef memory;
     uint32_t size;
     CFTZPeriod *tzp = NULL;
+    CFTZRule *rule = NULL;
     CFIndex idx, cnt = 0;
 
     if (allocator == NULL) allocator = __CFGetDefaultAllocator();
@@ -986,7 +1282,7 @@ CFTimeZoneRef CFTimeZoneCreate(CFAllocatorRef allocator, CFStringRef name, CFDat
 	__CFTimeZoneUnlockGlobal();
 	return (CFTimeZoneRef)CFRetain(memory);
     }
-    if (!__CFParseTimeZoneData(allocator, data, &tzp, &cnt)) {
+    if (!__CFParseTimeZoneData(allocator, data, &tzp, &cnt, &rule)) {
 	__CFTimeZoneUnlockGlobal();
 	return NULL;
     }
@@ -998,12 +1294,15 @@ CFTimeZoneRef CFTimeZoneCreate(CFAllocatorRef allocator, CFStringRef name, CFDat
 	    if (NULL != tzp[idx].abbrev) CFRelease(tzp[idx].abbrev);
 	}
 	if (NULL != tzp) CFAllocatorDeallocate(allocator, tzp);
+	if (NULL != rule) __CFTZRuleDestroy(allocator, rule);
         return NULL;
     }
     ((struct __CFTimeZone *)memory)->_name = (CFStringRef)CFStringCreateCopy(allocator, name);
     ((struct __CFTimeZone *)memory)->_data = CFDataCreateCopy(allocator, data);
     ((struct __CFTimeZone *)memory)->_periods = tzp;
     ((struct __CFTimeZone *)memory)->_periodCnt = cnt;
+    ((struct __CFTimeZone *)memory)->_hint = 0;
+    ((struct __CFTimeZone *)memory)->_rule = rule;
     if (NULL == __CFTimeZoneCache) {
 	__CFTimeZoneCache = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
     }
@@ -1214,34 +1513,36 @@ BOOL __CFTimeZoneGetWin32SystemTime(SYSTEMTIME * sys_time, CFAbsoluteTime time)
 #endif
 
 CFTimeInterval CFTimeZoneGetSecondsFromGMT(CFTimeZoneRef tz, CFAbsoluteTime at) {
-    CFIndex idx;
+    CFTZPeriod scratch;
     __CFGenericValidateType(tz, CFTimeZoneGetTypeID());
-    idx = __CFBSearchTZPeriods(tz, at);
-    return __CFTZPeriodGMTOffset(&(tz->_periods[idx]));
+    return __CFTZPeriodGMTOffset(__CFTimeZoneGetPeriod(tz, at, &scratch, NULL));
 }
 
 CFStringRef CFTimeZoneCopyAbbreviation(CFTimeZoneRef tz, CFAbsoluteTime at) {
     CFStringRef result;
-    CFIndex idx;
+    CFTZPeriod scratch;
     __CFGenericValidateType(tz, CFTimeZoneGetTypeID());
-    idx = __CFBSearchTZPeriods(tz, at);
-    result = __CFTZPeriodAbbreviation(&(tz->_periods[idx]));
+    result = __CFTZPeriodAbbreviation(__CFTimeZoneGetPeriod(tz, at, &scratch, NULL));
     return result ? (CFStringRef)CFRetain(result) : NULL;
 }
 
 Boolean CFTimeZoneIsDaylightSavingTime(CFTimeZoneRef tz, CFAbsoluteTime at) {
-    CFIndex idx;
+    CFTZPeriod scratch;
     __CFGenericValidateType(tz, CFTimeZoneGetTypeID());
-    idx = __CFBSearchTZPeriods(tz, at);
-    return __CFTZPeriodIsDST(&(tz->_periods[idx]));
+    return __CFTZPeriodIsDST(__CFTimeZoneGetPeriod(tz, at, &scratch, NULL));
 }
 
 CFTimeInterval CFTimeZoneGetDaylightSavingTimeOffset(CFTimeZoneRef tz, CFAbsoluteTime at) {
     CF_OBJC_FUNCDISPATCHV(CFTimeZoneGetTypeID(), CFTimeInterval, (NSTimeZone *)tz, _daylightSavingTimeOffsetForAbsoluteTime:at);
     __CFGenericValidateType(tz, CFTimeZoneGetTypeID());
-    CFIndex idx = __CFBSearchTZPeriods(tz, at);
-    if (__CFTZPeriodIsDST(&(tz->_periods[idx]))) {
-	CFTimeInterval offset = __CFTZPeriodGMTOffset(&(tz->_periods[idx]));
+    CFTZPeriod scratch;
+    const CFTZPeriod *period = __CFTimeZoneGetPeriod(tz, at, &scratch, NULL);
+    if (__CFTZPeriodIsDST(period)) {
+	CFTimeInterval offset = __CFTZPeriodGMTOffset(period);
+	if (period == &scratch) {
+	    return offset - tz->_rule->stdOffset;
+	}
+	CFIndex idx = period - tz->_periods;
 	if (idx + 1 < tz->_periodCnt) {
 	    return offset - __CFTZPeriodGMTOffset(&(tz->_periods[idx + 1]));
 	} else if (0 < idx) {
@@ -1254,11 +1555,10 @@ CFTimeInterval CFTimeZoneGetDaylightSavingTimeOffset(CFTimeZoneRef tz, CFAbsolut
 CFAbsoluteTime CFTimeZoneGetNextDaylightSavingTimeTransition(CFTimeZoneRef tz, CFAbsoluteTime at) {
     CF_OBJC_FUNCDISPATCHV(CFTimeZoneGetTypeID(), CFTimeInterval, (NSTimeZone *)tz, _nextDaylightSavingTimeTransitionAfterAbsoluteTime:at);
     __CFGenericValidateType(tz, CFTimeZoneGetTypeID());
-    CFIndex idx = __CFBSearchTZPeriods(tz, at);
-    if (tz->_periodCnt <= idx + 1) {
-        return 0.0;
-    }
-    return (CFAbsoluteTime)__CFTZPeriodStartSeconds(&(tz->_periods[idx + 1]));
+    CFTZPeriod scratch;
+    CFAbsoluteTime next;
+    __CFTimeZoneGetPeriod(tz, at, &scratch, &next);
+    return next;
 }
 
 extern UCalendar *__CFCalendarCreateUCalendar(CFStringRef calendarID, CFStringRef localeID, CFTimeZoneRef tz);
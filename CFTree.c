@@ -42,6 +42,10 @@ struct __CFTree {
     CFTreeRef _sibling;	/* Not retained */
     CFTreeRef _child;	/* All children get a retain from the parent */
     CFTreeRef _rightmostChild;	/* Not retained */
+    CFIndex _childCount;
+    /* Children in order, built and published by the first indexed access and kept in step by appends; dropped by any other change to the children. Not retained. */
+    CFTreeRef *_childIndex;
+    CFIndex _childIndexCapacity;
     /* This is the context, exploded.
      * Currently the only valid version is 0, so we do not store that.
      * _callbacks initialized if not a special form. */
@@ -74,6 +78,31 @@ CF_INLINE const struct __CFTreeCallBacks *__CFTreeGetCallBacks(CFTreeRef tree) {
     return tree->_callbacks;
 }
 
+CF_INLINE void __CFTreeInvalidateChildIndex(CFTreeRef tree) {
+    if (tree->_childIndex) {
+        CFAllocatorDeallocate(kCFAllocatorSystemDefault, tree->_childIndex);
+        tree->_childIndex = NULL;
+        tree->_childIndexCapacity = 0;
+    }
+}
+
+static CFTreeRef *__CFTreeGetChildIndex(CFTreeRef tree) {
+    if (tree->_childIndex) return tree->_childIndex;
+    CFIndex capacity = __CFMax(tree->_childCount, 4);
+    CFTreeRef *index = (CFTreeRef *)CFAllocatorAllocate(kCFAllocatorSystemDefault, capacity * sizeof(CFTreeRef), 0);
+    if (NULL == index) return NULL;
+    if (__CFOASafe) __CFSetLastAllocationEventName(index, "CFTree (child index)");
+    CFIndex idx = 0;
+    for (CFTreeRef child = tree->_child; NULL != child; child = child->_sibling) index[idx++] = child;
+    // Readers may race to build the index; the first to publish wins and the others free their copy
+    if (!OSAtomicCompareAndSwapPtrBarrier(NULL, index, (void * volatile *)&tree->_childIndex)) {
+        CFAllocatorDeallocate(kCFAllocatorSystemDefault, index);
+        return tree->_childIndex;
+    }
+    tree->_childIndexCapacity = capacity;
+    return index;
+}
+
 CF_INLINE bool __CFTreeCallBacksMatchNull(const CFTreeContext *c) {
     return (NULL == c || (c->retain == NULL && c->release == NULL && c->copyDescription == NULL));
 }   
@@ -112,6 +141,7 @@ static void __CFTreeDeallocate(CFTypeRef cf) {
         CFTreeRemoveAllChildren(tree);
     }
 #endif
+    __CFTreeInvalidateChildIndex(tree);
     cb = __CFTreeGetCallBacks(tree);
     if (NULL != cb->release) {
         INVOKE_CALLBACK1(cb->release, tree->_info);
@@ -157,6 +187,9 @@ CFTreeRef CFTreeCreate(CFAllocatorRef allocator, const CFTreeContext *context) {
     memory->_sibling = NULL;
     memory->_child = NULL;
     memory->_rightmostChild = NULL;
+    memory->_childCount = 0;
+    memory->_childIndex = NULL;
+    memory->_childIndexCapacity = 0;
 
     /* Start the context off in a recognizable state */
     __CFBitfieldSetValue(memory->_base._cfinfo[CF_INFO_BITS], 1, 0, __kCFTreeHasNullCallBacks);
@@ -165,14 +198,8 @@ CFTreeRef CFTreeCreate(CFAllocatorRef allocator, const CFTreeContext *context) {
 }
 
 CFIndex CFTreeGetChildCount(CFTreeRef tree) {
-    SInt32 cnt = 0;
     __CFGenericValidateType(tree, CFTreeGetTypeID());
-    tree = tree->_child;
-    while (NULL != tree) {
-	cnt++;
-	tree = tree->_sibling;
-    }
-    return cnt;
+    return tree->_childCount;
 }
 
 CFTreeRef CFTreeGetParent(CFTreeRef tree) {
@@ -294,6 +321,13 @@ CFTreeRef CFTreeFind(CFTreeRef tree, const void *info) {
 
 CFTreeRef CFTreeGetChildAtIndex(CFTreeRef tree, CFIndex idx) {
     __CFGenericValidateType(tree, CFTreeGetTypeID());
+    if (idx < 0 || tree->_childCount <= idx) return NULL;
+    if (idx == tree->_childCount - 1) return tree->_rightmostChild;
+    // Walking a few siblings is cheaper than building the index
+    if (8 <= idx) {
+        CFTreeRef *index = __CFTreeGetChildIndex(tree);
+        if (index) return index[idx];
+    }
     tree = tree->_child;
     while (NULL != tree) {
 	if (0 == idx) return tree;
@@ -312,6 +346,23 @@ void CFTreeGetChildren(CFTreeRef tree, CFTreeRef *children) {
     }
 }
 
+void _CFTreeGetChildrenInRange(CFTreeRef tree, CFRange range, CFTreeRef *children) {
+    __CFGenericValidateType(tree, CFTreeGetTypeID());
+    CFAssert3(0 <= range.location && 0 <= range.length && range.location + range.length <= tree->_childCount, __kCFLogAssertion, "%s(): range {%d, %d} out of bounds", __PRETTY_FUNCTION__, range.location, range.length);
+    if (range.length <= 0) return;
+    CFTreeRef *index = (8 <= range.location) ? __CFTreeGetChildIndex(tree) : tree->_childIndex;
+    if (index) {
+        memmove(children, index + range.location, range.length * sizeof(CFTreeRef));
+        return;
+    }
+    CFTreeRef child = tree->_child;
+    for (CFIndex idx = 0; idx < range.location; idx++) child = child->_sibling;
+    for (CFIndex idx = 0; idx < range.length; idx++) {
+        *children++ = child;
+        child = child->_sibling;
+    }
+}
+
 void CFTreeApplyFunctionToChildren(CFTreeRef tree, CFTreeApplierFunction applier, void *context) {
     __CFGenericValidateType(tree, CFTreeGetTypeID());
     CFAssert1(NULL != applier, __kCFLogAssertion, "%s(): pointer to applier function may not be NULL", __PRETTY_FUNCTION__);
@@ -334,6 +385,8 @@ void CFTreePrependChild(CFTreeRef tree, CFTreeRef newChild) {
         __CFAssignWithWriteBarrier((void **)&tree->_rightmostChild, newChild);
     }
     __CFAssignWithWriteBarrier((void **)&tree->_child, newChild);
+    tree->_childCount++;
+    __CFTreeInvalidateChildIndex(tree);
 }
 
 void CFTreeAppendChild(CFTreeRef tree, CFTreeRef newChild) {
@@ -355,6 +408,17 @@ void CFTreeAppendChild(CFTreeRef tree, CFTreeRef newChild) {
         __CFAssignWithWriteBarrier((void **)&tree->_rightmostChild->_sibling, newChild);
     }
     __CFAssignWithWriteBarrier((void **)&tree->_rightmostChild, newChild);
+    if (tree->_childIndex) {
+        if (tree->_childIndexCapacity <= tree->_childCount) {
+            CFIndex capacity = 2 * tree->_childIndexCapacity;
+            CFTreeRef *index = (CFTreeRef *)CFAllocatorReallocate(kCFAllocatorSystemDefault, tree->_childIndex, capacity * sizeof(CFTreeRef), 0);
+            if (NULL == index) HALT;
+            tree->_childIndex = index;
+            tree->_childIndexCapacity = capacity;
+        }
+        tree->_childIndex[tree->_childCount] = newChild;
+    }
+    tree->_childCount++;
 }
 
 void CFTreeInsertSibling(CFTreeRef tree, CFTreeRef newSibling) {
@@ -373,6 +437,8 @@ void CFTreeInsertSibling(CFTreeRef tree, CFTreeRef newSibling) {
         if (tree->_parent->_rightmostChild == tree) {
             __CFAssignWithWriteBarrier((void **)&tree->_parent->_rightmostChild, newSibling);
         }
+        tree->_parent->_childCount++;
+        __CFTreeInvalidateChildIndex(tree->_parent);
     }
 }
 
@@ -396,6 +462,8 @@ void CFTreeRemove(CFTreeRef tree) {
 		}
 	    }
 	}
+	tree->_parent->_childCount--;
+	__CFTreeInvalidateChildIndex(tree->_parent);
 	tree->_parent = NULL;
 	tree->_sibling = NULL;
         if (!kCFUseCollectableAllocator) CFRelease(tree);
@@ -408,6 +476,8 @@ void CFTreeRemoveAllChildren(CFTreeRef tree) {
     nextChild = tree->_child;
     tree->_child = NULL;
     tree->_rightmostChild = NULL;
+    tree->_childCount = 0;
+    __CFTreeInvalidateChildIndex(tree);
     while (NULL != nextChild) {
 	CFTreeRef nextSibling = nextChild->_sibling;
 	nextChild->_parent = NULL;
@@ -457,7 +527,87 @@ void CFTreeSortChildren(CFTreeRef tree, CFComparatorFunction comparator, void *c
         }
         list[idx - 1]->_sibling = NULL;
         tree->_rightmostChild = list[children - 1];
+        __CFTreeInvalidateChildIndex(tree);
         if (list != buffer) CFAllocatorDeallocate(kCFAllocatorSystemDefault, list); // XXX_PCB GC OK
     }
 }
 
+#pragma mark -
+#pragma mark Arena Allocator
+
+/* An allocator that carves allocations out of large chunks and never frees them individually; everything goes at once when the allocator itself is deallocated, which happens after the last object created with it is. Building a large tree with it costs one malloc per chunk rather than per node, and tearing the tree down costs none. */
+
+#define __CFTREE_ARENA_CHUNK_SIZE (64 * 1024)
+#define __CFTREE_ARENA_ALIGNMENT 16
+
+struct __CFTreeArenaChunk {
+    struct __CFTreeArenaChunk *_next;
+    size_t _used;
+    size_t _size;
+    uintptr_t _pad;	/* keeps the header a multiple of __CFTREE_ARENA_ALIGNMENT on 32- and 64-bit */
+};
+
+#define __CFTreeArenaChunkBytes(chunk) ((uint8_t *)(chunk) + sizeof(struct __CFTreeArenaChunk))
+
+typedef struct {
+    CFLock_t _lock;
+    struct __CFTreeArenaChunk *_chunks;	/* most recent first; only the first has room to allocate from */
+} __CFTreeArena;
+
+// Each block is preceded by its size, for reallocation
+static void *__CFTreeArenaAllocate(CFIndex size, CFOptionFlags hint, void *info) {
+    __CFTreeArena *arena = (__CFTreeArena *)info;
+    if (size <= 0) return NULL;
+    size_t need = __CFTREE_ARENA_ALIGNMENT + (((size_t)size + __CFTREE_ARENA_ALIGNMENT - 1) & ~(size_t)(__CFTREE_ARENA_ALIGNMENT - 1));
+    __CFLock(&arena->_lock);
+    struct __CFTreeArenaChunk *chunk = arena->_chunks;
+    if (NULL == chunk || chunk->_size - chunk->_used < need) {
+        size_t chunkSize = __CFMax(need, (size_t)__CFTREE_ARENA_CHUNK_SIZE);
+        chunk = (struct __CFTreeArenaChunk *)malloc(sizeof(struct __CFTreeArenaChunk) + chunkSize);
+        if (NULL == chunk) {
+            __CFUnlock(&arena->_lock);
+            return NULL;
+        }
+        chunk->_used = 0;
+        chunk->_size = chunkSize;
+        chunk->_next = arena->_chunks;
+        arena->_chunks = chunk;
+    }
+    uint8_t *block = __CFTreeArenaChunkBytes(chunk) + chunk->_used;
+    chunk->_used += need;
+    __CFUnlock(&arena->_lock);
+    *(size_t *)block = (size_t)size;
+    return block + __CFTREE_ARENA_ALIGNMENT;
+}
+
+static void *__CFTreeArenaReallocate(void *ptr, CFIndex newsize, CFOptionFlags hint, void *info) {
+    size_t oldsize = *(size_t *)((uint8_t *)ptr - __CFTREE_ARENA_ALIGNMENT);
+    if ((size_t)newsize <= oldsize) return ptr;
+    void *result = __CFTreeArenaAllocate(newsize, hint, info);
+    if (result) memmove(result, ptr, oldsize);
+    return result;
+}
+
+static void __CFTreeArenaDeallocate(void *ptr, void *info) {
+}
+
+static void __CFTreeArenaRelease(const void *info) {
+    __CFTreeArena *arena = (__CFTreeArena *)info;
+    struct __CFTreeArenaChunk *chunk = arena->_chunks;
+    while (chunk) {
+        struct __CFTreeArenaChunk *next = chunk->_next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+CFAllocatorRef _CFTreeCreateArenaAllocator(void) {
+    __CFTreeArena *arena = (__CFTreeArena *)calloc(1, sizeof(__CFTreeArena));
+    if (NULL == arena) return NULL;
+    CF_LOCK_INIT_FOR_STRUCTS(arena->_lock);
+    CFAllocatorContext context = {0, arena, NULL, __CFTreeArenaRelease, NULL, __CFTreeArenaAllocate, __CFTreeArenaReallocate, __CFTreeArenaDeallocate, NULL};
+    CFAllocatorRef allocator = CFAllocatorCreate(kCFAllocatorSystemDefault, &context);
+    if (NULL == allocator) free(arena);
+    return allocator;
+}
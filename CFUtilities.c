@@ -404,6 +404,9 @@ CF_PRIVATE CFIndex __CFActiveProcessorCount() {
     if (result != 0) {
         pcnt = 0;
     }
+#elif DEPLOYMENT_TARGET_LINUX
+    pcnt = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+    if (pcnt < 1) pcnt = 1;
 #else
     // Assume the worst
     pcnt = 1;
@@ -411,6 +414,103 @@ CF_PRIVATE CFIndex __CFActiveProcessorCount() {
     return pcnt;
 }
 
+#if DEPLOYMENT_TARGET_LINUX
+/* Without libdispatch, __CFApplyConcurrently() runs on a small pool of worker
+   threads, started on first use, one fewer than the processors (at most 15).
+   Only one job runs on the pool at a time; a call made while it is busy,
+   including a nested call from inside a job, runs serially on the calling
+   thread, so jobs can never wait on each other. The caller always works on its
+   own job too, so a job finishes even if no worker gets to it. */
+
+typedef struct {
+    void (*work)(void *context, size_t idx);
+    void *context;
+    int32_t count;
+    volatile int32_t next;	/* next index to claim */
+    int32_t joined;		/* workers currently running this job; guarded by the pool lock */
+} __CFApplyJob;
+
+static pthread_mutex_t __CFApplyLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t __CFApplyWorkCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t __CFApplyDoneCond = PTHREAD_COND_INITIALIZER;
+static __CFApplyJob *__CFApplyCurrentJob = NULL;	/* the running job, or NULL when no more workers may join */
+static uint64_t __CFApplyGeneration = 0;		/* bumped for each job posted */
+static int32_t __CFApplyNumWorkers = -1;		/* -1 until the pool is started */
+static Boolean __CFApplyBusy = false;
+
+static void __CFApplyRunJob(__CFApplyJob *job) {
+    for (;;) {
+	int32_t idx = OSAtomicIncrement32Barrier(&job->next) - 1;
+	if (job->count <= idx) break;
+	job->work(job->context, (size_t)idx);
+    }
+}
+
+static void *__CFApplyWorker(void *arg) {
+    uint64_t seen = 0;
+    pthread_mutex_lock(&__CFApplyLock);
+    for (;;) {
+	while (__CFApplyGeneration == seen) pthread_cond_wait(&__CFApplyWorkCond, &__CFApplyLock);
+	seen = __CFApplyGeneration;
+	__CFApplyJob *job = __CFApplyCurrentJob;
+	if (!job) continue;
+	job->joined++;
+	pthread_mutex_unlock(&__CFApplyLock);
+	__CFApplyRunJob(job);
+	pthread_mutex_lock(&__CFApplyLock);
+	if (0 == --job->joined) pthread_cond_signal(&__CFApplyDoneCond);
+    }
+    return NULL;
+}
+
+static void __CFApplyStartPool(void) {
+    CFIndex cnt = __CFMin(__CFActiveProcessorCount() - 1, 15);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    __CFApplyNumWorkers = 0;
+    for (CFIndex idx = 0; idx < cnt; idx++) {
+	pthread_t thread;
+	if (0 != pthread_create(&thread, &attr, __CFApplyWorker, NULL)) break;
+	__CFApplyNumWorkers++;
+    }
+    pthread_attr_destroy(&attr);
+}
+#endif
+
+/* Calls work(context, idx) for each idx from 0 to count - 1, concurrently where possible, and returns when all calls have finished; count must be less than 2^31. This is dispatch_apply_f() on the generic queue matching the current QOS, or a private thread pool where there is no libdispatch. */
+CF_PRIVATE void __CFApplyConcurrently(size_t count, void *context, void (*work)(void *context, size_t idx)) {
+    if (0 == count) return;
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_WINDOWS
+    dispatch_apply_f(count, __CFDispatchQueueGetGenericMatchingCurrent(), context, work);
+#elif DEPLOYMENT_TARGET_LINUX
+    __CFApplyJob job = {work, context, (int32_t)count, 0, 0};
+    Boolean concurrent = false;
+    if (1 < count) {
+	pthread_mutex_lock(&__CFApplyLock);
+	if (__CFApplyNumWorkers < 0) __CFApplyStartPool();
+	if (!__CFApplyBusy && 0 < __CFApplyNumWorkers) {
+	    __CFApplyBusy = true;
+	    __CFApplyCurrentJob = &job;
+	    __CFApplyGeneration++;
+	    pthread_cond_broadcast(&__CFApplyWorkCond);
+	    concurrent = true;
+	}
+	pthread_mutex_unlock(&__CFApplyLock);
+    }
+    __CFApplyRunJob(&job);
+    if (concurrent) {
+	pthread_mutex_lock(&__CFApplyLock);
+	__CFApplyCurrentJob = NULL;
+	while (0 < job.joined) pthread_cond_wait(&__CFApplyDoneCond, &__CFApplyLock);
+	__CFApplyBusy = false;
+	pthread_mutex_unlock(&__CFApplyLock);
+    }
+#else
+    for (size_t idx = 0; idx < count; idx++) work(context, idx);
+#endif
+}
+
 CF_PRIVATE void __CFGetUGIDs(uid_t *euid, gid_t *egid) {
 #if 1 && (DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI)
     uid_t uid;
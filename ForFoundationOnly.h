@@ -484,6 +484,13 @@ CF_EXPORT void CFCharacterSetFast(CFMutableCharacterSetRef theSet);
 CF_EXPORT const void *_CFArrayCheckAndGetValueAtIndex(CFArrayRef array, CFIndex idx);
 CF_EXPORT void _CFArrayReplaceValues(CFMutableArrayRef array, CFRange range, const void **newValues, CFIndex newCount);
 
+/* Removes up to maxCount values from the front of a mutable array and stores
+ them in values, transferring the array's reference to each one to the caller
+ instead of releasing it. Returns the number of values removed. This is the
+ queue-draining counterpart to CFArrayAppendValue(): the array is a ring
+ buffer, so pushing and popping at either end never moves the other values. */
+CF_EXPORT CFIndex _CFArrayDrainValues(CFMutableArrayRef array, CFIndex maxCount, const void **values);
+
 
 /* Enumeration
  Call CFStartSearchPathEnumeration() once, then call
@@ -0,0 +1,55 @@
+// Shared by the programs in Tests: a failure count of which only the first few are printed, the PASS/FAIL summary
+// that gives the exit status, a fixed-seed random source so that every run checks the same values, and for the
+// benchmarks a best-of-several timer.  Include it after the CoreFoundation headers.
+
+#if !defined(__CFLITE_TESTSUPPORT__)
+#define __CFLITE_TESTSUPPORT__ 1
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define MAX_PRINTED_FAILURES 20
+
+static unsigned long failures = 0;
+
+// Counts a failure; the first MAX_PRINTED_FAILURES are printed, with printf() style arguments
+#define FAIL(...) do { \
+    if (failures++ < MAX_PRINTED_FAILURES) { \
+        printf("FAIL "); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+// Prints the summary line and returns the exit status for main()
+CF_INLINE int reportFailures(void) {
+    printf("%s: %lu failure%s\n", (0 == failures) ? "PASS" : "FAIL", failures, (1 == failures) ? "" : "s");
+    return (0 == failures) ? 0 : 1;
+}
+
+static uint64_t randomState = 88172645463325252ULL;
+
+CF_INLINE uint64_t nextRandom(void) {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return randomState;
+}
+
+#define BENCHMARK_RUNS 5
+
+// Calls work(context) BENCHMARK_RUNS times and returns the fastest run in seconds; setup(context), if not NULL, runs
+// untimed before each run, to put back whatever the previous run changed
+CF_INLINE double bestTime(void (*setup)(void *), void (*work)(void *), void *context) {
+    double best = 0.0;
+    for (int run = 0; run < BENCHMARK_RUNS; run++) {
+        if (setup) setup(context);
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        work(context);
+        double elapsed = CFAbsoluteTimeGetCurrent() - start;
+        if (0 == run || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+#endif /* ! __CFLITE_TESTSUPPORT__ */
@@ -0,0 +1,78 @@
+// Times a mutable CFArray used as a queue at a steady length: appending at one end and removing from the other, in
+// both directions, then CFArrayGetValueAtIndex() and CFArrayGetValues() on the array the queue leaves behind, whose
+// values by then wrap around the end of its store.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation arrayqueuebenchmark.c -o arrayqueuebenchmark
+// Linux: clang -O2 -I/usr/local/include -L/usr/local/lib -lCoreFoundation arrayqueuebenchmark.c -o arrayqueuebenchmark
+//
+// Run with an optional count of operations per measurement (default 1000000).
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TestSupport.h"
+
+typedef struct {
+    CFMutableArrayRef array;
+    CFIndex length;
+    CFIndex operations;
+    const void **values;
+} Run;
+
+static void fill(void *context) {
+    Run *run = (Run *)context;
+    CFArrayRemoveAllValues(run->array);
+    for (CFIndex idx = 0; idx < run->length; idx++) CFArrayAppendValue(run->array, (const void *)(uintptr_t)(idx + 1));
+}
+
+static void appendAndRemoveFirst(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->operations; idx++) {
+        CFArrayAppendValue(run->array, (const void *)(uintptr_t)(idx + 1));
+        CFArrayRemoveValueAtIndex(run->array, 0);
+    }
+}
+
+static void prependAndRemoveLast(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->operations; idx++) {
+        CFArrayInsertValueAtIndex(run->array, 0, (const void *)(uintptr_t)(idx + 1));
+        CFArrayRemoveValueAtIndex(run->array, run->length);
+    }
+}
+
+static void getValues(void *context) {
+    Run *run = (Run *)context;
+    uintptr_t sum = 0;
+    for (CFIndex idx = 0; idx < run->operations; idx++) sum += (uintptr_t)CFArrayGetValueAtIndex(run->array, idx % run->length);
+    if (0 == sum) FAIL("no values");
+}
+
+static void copyValues(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->operations; idx += run->length) CFArrayGetValues(run->array, CFRangeMake(0, run->length), run->values);
+}
+
+int main(int argc, char **argv) {
+    static const CFIndex lengths[] = {16, 1000, 100000};
+    CFIndex operations = (1 < argc) ? atol(argv[1]) : 1000000;
+    printf("%ld operations, best of %d runs\n", (long)operations, BENCHMARK_RUNS);
+    for (unsigned idx = 0; idx < sizeof(lengths) / sizeof(lengths[0]); idx++) {
+        Run run = {CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, NULL), lengths[idx], operations, (const void **)malloc(lengths[idx] * sizeof(void *))};
+        double seconds = bestTime(fill, appendAndRemoveFirst, &run);
+        printf("%6ld values: append, remove first  %8.1f ns/operation\n", (long)run.length, seconds * 1.0e9 / operations);
+        seconds = bestTime(fill, prependAndRemoveLast, &run);
+        printf("%6ld values: prepend, remove last  %8.1f ns/operation\n", (long)run.length, seconds * 1.0e9 / operations);
+        fill(&run);
+        appendAndRemoveFirst(&run);
+        seconds = bestTime(NULL, getValues, &run);
+        printf("%6ld values: CFArrayGetValueAtIndex %8.2f ns/value\n", (long)run.length, seconds * 1.0e9 / operations);
+        seconds = bestTime(NULL, copyValues, &run);
+        printf("%6ld values: CFArrayGetValues       %8.2f ns/value\n", (long)run.length, seconds * 1.0e9 / operations);
+        free(run.values);
+        CFRelease(run.array);
+    }
+    return reportFailures();
+}
@@ -0,0 +1,112 @@
+// Times _CFBigDecimal arithmetic on arrays of prices, two-place decimals below a million, against the same arithmetic
+// on doubles: _CFBigDecimalOperateOnArrays() for each operation, _CFBigDecimalRoundArray() of the quotients to cents,
+// and _CFBigDecimalSum().
+// _CFBigDecimal is private to CoreFoundation and not built into the Linux library, so this includes its source along
+// with CFDoubleConversion.c, which it uses, and builds with the library's own flags.
+//
+// Mac OS X: clang -O2 -std=gnu99 -DCF_BUILDING_CF=1 -DDEPLOYMENT_TARGET_MACOSX=1 -I<path-to-CFLite-build>/CoreFoundation -include ../CoreFoundation_Prefix.h -F<path-to-CFLite-framework> -framework CoreFoundation bigdecimalbenchmark.c -o bigdecimalbenchmark
+// Linux: clang -O2 -std=gnu99 -fblocks -DCF_BUILDING_CF=1 -DDEPLOYMENT_TARGET_LINUX=1 -I/usr/local/include -I/usr/local/include/CoreFoundation -include ../CoreFoundation_Prefix.h -L/usr/local/lib -lCoreFoundation bigdecimalbenchmark.c -o bigdecimalbenchmark
+//
+// Run with an optional count of values (default 100000).
+
+#include "../CFDoubleConversion.c"
+#include "../CFBigNumber.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TestSupport.h"
+
+typedef struct {
+    CFIndex count;
+    _CFBigDecimal *a, *b, *results, *quotients;
+    double *da, *db, *dresults, *dquotients;
+    _CFBigDecimalOperation op;
+    _CFBigDecimal sum;
+    double dsum;
+} Run;
+
+static const char *const operationNames[] = {"add", "subtract", "multiply", "divide"};
+
+static void operate(void *context) {
+    Run *run = (Run *)context;
+    _CFBigDecimalOperateOnArrays(run->op, run->results, run->a, run->b, run->count, _kCFBigDecimalRoundBankers);
+}
+
+static void operateOnDoubles(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) {
+        switch (run->op) {
+        case _kCFBigDecimalOperationAdd: run->dresults[idx] = run->da[idx] + run->db[idx]; break;
+        case _kCFBigDecimalOperationSubtract: run->dresults[idx] = run->da[idx] - run->db[idx]; break;
+        case _kCFBigDecimalOperationMultiply: run->dresults[idx] = run->da[idx] * run->db[idx]; break;
+        case _kCFBigDecimalOperationDivide: run->dresults[idx] = run->da[idx] / run->db[idx]; break;
+        }
+    }
+}
+
+static void roundToCents(void *context) {
+    Run *run = (Run *)context;
+    _CFBigDecimalRoundArray(run->results, run->quotients, run->count, 2, _kCFBigDecimalRoundBankers);
+}
+
+static void roundDoublesToCents(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) run->dresults[idx] = nearbyint(run->dquotients[idx] * 100.0) / 100.0;
+}
+
+static void sum(void *context) {
+    Run *run = (Run *)context;
+    _CFBigDecimalSum(&run->sum, run->a, run->count, _kCFBigDecimalRoundBankers);
+}
+
+static void sumDoubles(void *context) {
+    Run *run = (Run *)context;
+    double total = 0.0;
+    for (CFIndex idx = 0; idx < run->count; idx++) total += run->da[idx];
+    run->dsum = total;
+}
+
+static void report(const char *what, Run *run, void (*decimalWork)(void *), void (*doubleWork)(void *)) {
+    double decimal = bestTime(NULL, decimalWork, run) * 1.0e9 / run->count;
+    double binary = bestTime(NULL, doubleWork, run) * 1.0e9 / run->count;
+    printf("%-10s %8.2f ns/value, double %6.2f ns/value, %6.1fx\n", what, decimal, binary, decimal / binary);
+}
+
+int main(int argc, char **argv) {
+    Run run = {(1 < argc) ? atol(argv[1]) : 100000};
+    run.a = (_CFBigDecimal *)malloc(run.count * sizeof(_CFBigDecimal));
+    run.b = (_CFBigDecimal *)malloc(run.count * sizeof(_CFBigDecimal));
+    run.results = (_CFBigDecimal *)malloc(run.count * sizeof(_CFBigDecimal));
+    run.da = (double *)malloc(run.count * sizeof(double));
+    run.db = (double *)malloc(run.count * sizeof(double));
+    run.dresults = (double *)malloc(run.count * sizeof(double));
+    for (CFIndex idx = 0; idx < run.count; idx++) {
+        int64_t a = (int64_t)(nextRandom() % 100000000), b = 1 + (int64_t)(nextRandom() % 100000000);
+        _CFBigDecimalInitWithInt64(run.a + idx, a, -2);
+        _CFBigDecimalInitWithInt64(run.b + idx, b, -2);
+        run.da[idx] = a / 100.0;
+        run.db[idx] = b / 100.0;
+    }
+    printf("%ld values, best of %d runs\n", (long)run.count, BENCHMARK_RUNS);
+    for (int op = _kCFBigDecimalOperationAdd; op <= _kCFBigDecimalOperationDivide; op++) {
+        run.op = (_CFBigDecimalOperation)op;
+        report(operationNames[op], &run, operate, operateOnDoubles);
+    }
+    run.quotients = run.results;
+    run.dquotients = run.dresults;
+    run.results = (_CFBigDecimal *)malloc(run.count * sizeof(_CFBigDecimal));
+    run.dresults = (double *)malloc(run.count * sizeof(double));
+    report("round", &run, roundToCents, roundDoublesToCents);
+    report("sum", &run, sum, sumDoubles);
+    if (_kCFBigDecimalInvalidOperation != _CFBigDecimalOperateOnArrays((_CFBigDecimalOperation)99, run.results, run.a, run.b, 1, _kCFBigDecimalRoundPlain) || !_CFBigDecimalIsNaN(run.results)) FAIL("an unknown operation did not give NaN");
+    free(run.a);
+    free(run.b);
+    free(run.results);
+    free(run.quotients);
+    free(run.da);
+    free(run.db);
+    free(run.dresults);
+    free(run.dquotients);
+    return reportFailures();
+}
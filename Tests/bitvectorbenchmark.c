@@ -0,0 +1,79 @@
+// Times the CFBitVector operations that work on ranges: counting bits in a random vector, finding the first and last
+// set bit in an empty one, setting, clearing and flipping, each over the whole vector less a few bits at either end so
+// that neither end falls on a byte boundary.  Times are per 1000 bits.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation bitvectorbenchmark.c -o bitvectorbenchmark
+// Linux: clang -O2 -I/usr/local/include -L/usr/local/lib -lCoreFoundation bitvectorbenchmark.c -o bitvectorbenchmark
+//
+// Run with an optional bit count (default 16000000).
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TestSupport.h"
+
+#define REPEATS 20
+
+typedef struct {
+    CFMutableBitVectorRef bv;
+    CFRange range;
+} Run;
+
+static void clearAll(void *context) {
+    CFBitVectorSetAllBits(((Run *)context)->bv, 0);
+}
+
+static void countBits(void *context) {
+    Run *run = (Run *)context;
+    for (int idx = 0; idx < REPEATS; idx++) CFBitVectorGetCountOfBit(run->bv, run->range, 1);
+}
+
+static void findFirst(void *context) {
+    Run *run = (Run *)context;
+    for (int idx = 0; idx < REPEATS; idx++) CFBitVectorGetFirstIndexOfBit(run->bv, run->range, 1);
+}
+
+static void findLast(void *context) {
+    Run *run = (Run *)context;
+    for (int idx = 0; idx < REPEATS; idx++) CFBitVectorGetLastIndexOfBit(run->bv, run->range, 1);
+}
+
+static void containsBit(void *context) {
+    Run *run = (Run *)context;
+    for (int idx = 0; idx < REPEATS; idx++) CFBitVectorContainsBit(run->bv, run->range, 1);
+}
+
+static void setAndClear(void *context) {
+    Run *run = (Run *)context;
+    for (int idx = 0; idx < REPEATS; idx++) CFBitVectorSetBits(run->bv, run->range, (CFBit)(~idx & 1));
+}
+
+static void flipBits(void *context) {
+    Run *run = (Run *)context;
+    for (int idx = 0; idx < REPEATS; idx++) CFBitVectorFlipBits(run->bv, run->range);
+}
+
+static void report(const char *what, Run *run, void (*setup)(void *), void (*work)(void *)) {
+    double seconds = bestTime(setup, work, run);
+    printf("%-32s %8.2f ns/1000 bits\n", what, seconds * 1.0e12 / ((double)REPEATS * run->range.length));
+}
+
+int main(int argc, char **argv) {
+    CFIndex count = (1 < argc) ? atol(argv[1]) : 16000000;
+    Run run = {CFBitVectorCreateMutable(kCFAllocatorSystemDefault, count), CFRangeMake(3, count - 8)};
+    CFBitVectorSetCount(run.bv, count);
+    printf("%ld bits, best of %d runs\n", (long)count, BENCHMARK_RUNS);
+    for (CFIndex idx = 0; idx < count; idx++) {
+        if (nextRandom() & 1) CFBitVectorSetBitAtIndex(run.bv, idx, 1);
+    }
+    report("CFBitVectorGetCountOfBit", &run, NULL, countBits);
+    report("CFBitVectorGetFirstIndexOfBit", &run, clearAll, findFirst);
+    report("CFBitVectorGetLastIndexOfBit", &run, clearAll, findLast);
+    report("CFBitVectorContainsBit", &run, clearAll, containsBit);
+    report("CFBitVectorSetBits", &run, NULL, setAndClear);
+    report("CFBitVectorFlipBits", &run, NULL, flipBits);
+    CFRelease(run.bv);
+    return 0;
+}
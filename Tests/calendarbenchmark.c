@@ -0,0 +1,63 @@
+// Times CFCalendarDecomposeAbsoluteTime() and CFCalendarComposeAbsoluteTime() with the Gregorian calendar on random
+// times between 1950 and 2050, for year, month, day, hour, minute and second, in a fixed-offset zone and two zones
+// with daylight saving time.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation calendarbenchmark.c -o calendarbenchmark
+// Linux: clang -O2 -I/usr/local/include -L/usr/local/lib -lCoreFoundation calendarbenchmark.c -o calendarbenchmark
+//
+// Run with an optional count of times per measurement (default 200000).
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TestSupport.h"
+
+typedef struct {
+    CFCalendarRef calendar;
+    CFIndex count;
+    CFAbsoluteTime *times;
+    int *fields;	// six per time
+} Run;
+
+static void decompose(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) {
+        int *f = run->fields + 6 * idx;
+        if (!CFCalendarDecomposeAbsoluteTime(run->calendar, run->times[idx], "yMdHms", f, f + 1, f + 2, f + 3, f + 4, f + 5)) FAIL("decompose failed");
+    }
+}
+
+static void compose(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) {
+        const int *f = run->fields + 6 * idx;
+        CFAbsoluteTime at;
+        if (!CFCalendarComposeAbsoluteTime(run->calendar, &at, "yMdHms", f[0], f[1], f[2], f[3], f[4], f[5])) FAIL("compose failed");
+    }
+}
+
+int main(int argc, char **argv) {
+    static const char *const zoneNames[] = {"GMT", "America/Los_Angeles", "Europe/Berlin"};
+    Run run = {CFCalendarCreateWithIdentifier(kCFAllocatorSystemDefault, kCFGregorianCalendar), (1 < argc) ? atol(argv[1]) : 200000};
+    run.times = (CFAbsoluteTime *)malloc(run.count * sizeof(CFAbsoluteTime));
+    run.fields = (int *)malloc(6 * run.count * sizeof(int));
+    for (CFIndex idx = 0; idx < run.count; idx++) run.times[idx] = (double)(int64_t)(nextRandom() % 3155760000ULL) - 1609459200.0;
+    printf("%ld times, best of %d runs\n", (long)run.count, BENCHMARK_RUNS);
+    for (unsigned idx = 0; idx < sizeof(zoneNames) / sizeof(zoneNames[0]); idx++) {
+        CFStringRef name = CFStringCreateWithCString(kCFAllocatorSystemDefault, zoneNames[idx], kCFStringEncodingASCII);
+        CFTimeZoneRef zone = CFTimeZoneCreateWithName(kCFAllocatorSystemDefault, name, true);
+        CFCalendarSetTimeZone(run.calendar, zone);
+        double seconds = bestTime(NULL, decompose, &run);
+        printf("%-20s CFCalendarDecomposeAbsoluteTime %8.1f ns/time\n", zoneNames[idx], seconds * 1.0e9 / run.count);
+        seconds = bestTime(NULL, compose, &run);
+        printf("%-20s CFCalendarComposeAbsoluteTime   %8.1f ns/time\n", zoneNames[idx], seconds * 1.0e9 / run.count);
+        CFRelease(zone);
+        CFRelease(name);
+    }
+    free(run.times);
+    free(run.fields);
+    CFRelease(run.calendar);
+    return reportFailures();
+}
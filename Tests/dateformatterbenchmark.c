@@ -0,0 +1,76 @@
+// Times an en_US_POSIX CFDateFormatter round trip through machine date formats: CFDateFormatterCreateStringWithAbsoluteTime()
+// then CFDateFormatterGetAbsoluteTimeFromString() on random whole-millisecond times between 1970 and 2100, in GMT and in
+// America/New_York, and checks that every time parses back to itself.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation dateformatterbenchmark.c -o dateformatterbenchmark
+// Linux: clang -O2 -I/usr/local/include -L/usr/local/lib -lCoreFoundation dateformatterbenchmark.c -o dateformatterbenchmark
+//
+// Run with an optional count of times per measurement (default 20000).
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "TestSupport.h"
+
+typedef struct {
+    CFDateFormatterRef formatter;
+    CFIndex count;
+    CFAbsoluteTime *times;
+    const char *format;
+    Boolean wholeSeconds;
+} Run;
+
+static void roundTrip(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) {
+        CFStringRef string = CFDateFormatterCreateStringWithAbsoluteTime(kCFAllocatorSystemDefault, run->formatter, run->times[idx]);
+        CFAbsoluteTime at = 0.0;
+        Boolean parsed = CFDateFormatterGetAbsoluteTimeFromString(run->formatter, string, NULL, &at);
+        CFAbsoluteTime expected = run->wholeSeconds ? floor(run->times[idx]) : run->times[idx];
+        if (!parsed || 0.0005 < fabs(at - expected)) FAIL("%s: %.3f did not round trip", run->format, run->times[idx]);
+        CFRelease(string);
+    }
+}
+
+int main(int argc, char **argv) {
+    static const struct {
+        const char *format;
+        Boolean wholeSeconds;
+    } formats[] = {
+        {"yyyy-MM-dd'T'HH:mm:ss.SSSXXXXX", false},
+        {"yyyy-MM-dd'T'HH:mm:ssZ", true},
+        {"EEE, dd MMM yyyy HH:mm:ss 'GMT'", true},
+    };
+    static const char *const zoneNames[] = {"GMT", "America/New_York"};
+    Run run = {NULL, (1 < argc) ? atol(argv[1]) : 20000};
+    run.times = (CFAbsoluteTime *)malloc(run.count * sizeof(CFAbsoluteTime));
+    for (CFIndex idx = 0; idx < run.count; idx++) run.times[idx] = (double)(int64_t)(nextRandom() % 4102444800000ULL) / 1000.0 - kCFAbsoluteTimeIntervalSince1970;
+    CFLocaleRef locale = CFLocaleCreate(kCFAllocatorSystemDefault, CFSTR("en_US_POSIX"));
+    printf("%ld times, best of %d runs\n", (long)run.count, BENCHMARK_RUNS);
+    for (unsigned zoneIdx = 0; zoneIdx < sizeof(zoneNames) / sizeof(zoneNames[0]); zoneIdx++) {
+        CFStringRef name = CFStringCreateWithCString(kCFAllocatorSystemDefault, zoneNames[zoneIdx], kCFStringEncodingASCII);
+        CFTimeZoneRef zone = CFTimeZoneCreateWithName(kCFAllocatorSystemDefault, name, true);
+        for (unsigned idx = 0; idx < sizeof(formats) / sizeof(formats[0]); idx++) {
+            // RFC 1123 dates are always written in GMT
+            if (0 != zoneIdx && 'E' == formats[idx].format[0]) continue;
+            CFStringRef format = CFStringCreateWithCString(kCFAllocatorSystemDefault, formats[idx].format, kCFStringEncodingASCII);
+            run.formatter = CFDateFormatterCreate(kCFAllocatorSystemDefault, locale, kCFDateFormatterNoStyle, kCFDateFormatterNoStyle);
+            CFDateFormatterSetProperty(run.formatter, kCFDateFormatterTimeZone, zone);
+            CFDateFormatterSetFormat(run.formatter, format);
+            run.format = formats[idx].format;
+            run.wholeSeconds = formats[idx].wholeSeconds;
+            double seconds = bestTime(NULL, roundTrip, &run);
+            printf("%-18s %-32s %8.0f ns/round trip\n", zoneNames[zoneIdx], formats[idx].format, seconds * 1.0e9 / run.count);
+            CFRelease(run.formatter);
+            CFRelease(format);
+        }
+        CFRelease(zone);
+        CFRelease(name);
+    }
+    CFRelease(locale);
+    free(run.times);
+    return reportFailures();
+}
@@ -0,0 +1,86 @@
+// Times the public paths that format and parse doubles: a Float64 CFNumber formatted with "%@", CFStringGetDoubleValue(),
+// and an XML property list of reals written and read back.  Half the values are random bit patterns and half are short
+// decimals like prices, since the two stress different paths.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation doublebenchmark.c -o doublebenchmark
+// Linux: clang -O2 -I/usr/local/include -L/usr/local/lib -lCoreFoundation doublebenchmark.c -o doublebenchmark
+//
+// Run with an optional count of values (default 100000).
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "TestSupport.h"
+
+typedef struct {
+    CFIndex count;
+    CFNumberRef *numbers;
+    CFStringRef *strings;
+    CFArrayRef array;
+    CFDataRef data;
+} Run;
+
+static void formatNumbers(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) CFRelease(CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("%@"), run->numbers[idx]));
+}
+
+static void parseStrings(void *context) {
+    Run *run = (Run *)context;
+    double sum = 0.0;
+    for (CFIndex idx = 0; idx < run->count; idx++) sum += CFStringGetDoubleValue(run->strings[idx]);
+    if (isnan(sum)) FAIL("parsed a NaN");
+}
+
+static void writePropertyList(void *context) {
+    Run *run = (Run *)context;
+    CFRelease(CFPropertyListCreateData(kCFAllocatorSystemDefault, run->array, kCFPropertyListXMLFormat_v1_0, 0, NULL));
+}
+
+static void readPropertyList(void *context) {
+    Run *run = (Run *)context;
+    CFPropertyListRef plist = CFPropertyListCreateWithData(kCFAllocatorSystemDefault, run->data, kCFPropertyListImmutable, NULL, NULL);
+    if (!plist || !CFEqual(plist, run->array)) FAIL("property list did not read back");
+    if (plist) CFRelease(plist);
+}
+
+int main(int argc, char **argv) {
+    Run run = {(1 < argc) ? atol(argv[1]) : 100000};
+    run.numbers = (CFNumberRef *)malloc(run.count * sizeof(CFNumberRef));
+    run.strings = (CFStringRef *)malloc(run.count * sizeof(CFStringRef));
+    for (CFIndex idx = 0; idx < run.count; idx++) {
+        double value;
+        do {
+            uint64_t bits = nextRandom();
+            if (idx & 1) {
+                value = (double)(bits % 10000000) / 100.0;
+            } else {
+                memmove(&value, &bits, sizeof(value));
+            }
+        } while (!isfinite(value));
+        char text[32];
+        snprintf(text, sizeof(text), "%.17g", value);
+        run.numbers[idx] = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberFloat64Type, &value);
+        run.strings[idx] = CFStringCreateWithCString(kCFAllocatorSystemDefault, text, kCFStringEncodingASCII);
+    }
+    run.array = CFArrayCreate(kCFAllocatorSystemDefault, (const void **)run.numbers, run.count, &kCFTypeArrayCallBacks);
+    run.data = CFPropertyListCreateData(kCFAllocatorSystemDefault, run.array, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+    printf("%ld values, best of %d runs\n", (long)run.count, BENCHMARK_RUNS);
+    printf("CFStringCreateWithFormat %%@     %8.1f ns/value\n", bestTime(NULL, formatNumbers, &run) * 1.0e9 / run.count);
+    printf("CFStringGetDoubleValue          %8.1f ns/value\n", bestTime(NULL, parseStrings, &run) * 1.0e9 / run.count);
+    printf("CFPropertyListCreateData, XML   %8.1f ns/value\n", bestTime(NULL, writePropertyList, &run) * 1.0e9 / run.count);
+    printf("CFPropertyListCreateWithData    %8.1f ns/value\n", bestTime(NULL, readPropertyList, &run) * 1.0e9 / run.count);
+    for (CFIndex idx = 0; idx < run.count; idx++) {
+        CFRelease(run.numbers[idx]);
+        CFRelease(run.strings[idx]);
+    }
+    free(run.numbers);
+    free(run.strings);
+    CFRelease(run.array);
+    CFRelease(run.data);
+    return reportFailures();
+}
@@ -0,0 +1,162 @@
+// Checks __CFDoubleFormatShortest() and __CFDoubleParseDecimal() against the C library's printf() and strtod().
+// The conversions are private to CoreFoundation, so this includes CFDoubleConversion.c and builds with the library's own flags.
+//
+// Mac OS X: clang -std=gnu99 -DCF_BUILDING_CF=1 -DDEPLOYMENT_TARGET_MACOSX=1 -I<path-to-CFLite-build>/CoreFoundation -include ../CoreFoundation_Prefix.h -F<path-to-CFLite-framework> -framework CoreFoundation doubleconversion.c -o doubleconversion
+// Linux: clang -std=gnu99 -fblocks -DCF_BUILDING_CF=1 -DDEPLOYMENT_TARGET_LINUX=1 -I/usr/local/include -I/usr/local/include/CoreFoundation -include ../CoreFoundation_Prefix.h -L/usr/local/lib -lCoreFoundation doubleconversion.c -o doubleconversion
+//
+// Run with an optional count of random doubles to check (default 1000000); exits nonzero on any mismatch.
+
+#include "../CFDoubleConversion.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "TestSupport.h"
+
+#define SIGNIFICAND_BITS 52
+
+static bool sameDouble(double a, double b) {
+    return __CFDoubleGetBits(a) == __CFDoubleGetBits(b);
+}
+
+static void fail(const char *what, const char *text, double got, double expected) {
+    FAIL("%s: \"%s\" gave %.17g, expected %.17g", what, text, got, expected);
+}
+
+// Significant digits in a formatted double, ignoring the sign, the exponent and leading or trailing zeros
+static int significantDigits(const char *text) {
+    char digits[64];
+    int length = 0;
+    for (const char *p = text; *p && 'e' != *p; p++) {
+        if ('0' <= *p && *p <= '9') digits[length++] = *p;
+    }
+    int first = 0;
+    while (first < length && '0' == digits[first]) first++;
+    while (first < length && '0' == digits[length - 1]) length--;
+    return (first < length) ? length - first : 1;
+}
+
+// Formats value and checks that the text reads back, is as short as possible and is laid out as %.17g would
+static void checkFormat(double value) {
+    char buffer[32], reference[32];
+    CFIndex length = __CFDoubleFormatShortest(value, buffer);
+    if ((CFIndex)strlen(buffer) != length) {
+        fail("format length", buffer, (double)length, (double)strlen(buffer));
+        return;
+    }
+    if (!sameDouble(strtod(buffer, NULL), value)) {
+        fail("format round trip", buffer, strtod(buffer, NULL), value);
+        return;
+    }
+    int precision;
+    for (precision = 1; precision < 17; precision++) {
+        snprintf(reference, sizeof(reference), "%.*e", precision - 1, value);
+        if (sameDouble(strtod(reference, NULL), value)) break;
+    }
+    snprintf(reference, sizeof(reference), "%.*e", precision - 1, value);
+    if (precision < significantDigits(buffer)) fail("format shortest", buffer, value, strtod(reference, NULL));
+    int exponent = atoi(strchr(reference, 'e') + 1);
+    bool scientific = (exponent < -4 || 17 <= exponent);
+    if (0.0 != value && scientific != (NULL != strchr(buffer, 'e'))) fail("format layout", buffer, value, value);
+    double parsed;
+    if (__CFDoubleParseDecimal(buffer, length, &parsed) != length || !sameDouble(parsed, value)) fail("parse formatted", buffer, parsed, value);
+}
+
+// Parses text and checks it against strtod(); returns the length parsed, 0 meaning the caller must use strtod()
+static CFIndex checkParse(const char *text) {
+    char *end;
+    double expected = strtod(text, &end);
+    double parsed = 0.0;
+    CFIndex used = __CFDoubleParseDecimal(text, strlen(text), &parsed);
+    if (0 != used && (used != end - text || !sameDouble(parsed, expected))) fail("parse", text, parsed, expected);
+    return used;
+}
+
+static void checkSubnormals(void) {
+    checkFormat(4.9406564584124654e-324);
+    checkFormat(-4.9406564584124654e-324);
+    checkFormat(2.2250738585072009e-308);	// largest subnormal
+    checkFormat(2.2250738585072014e-308);	// smallest normal
+    for (int idx = 0; idx < 100000; idx++) {
+        checkFormat(__CFDoubleFromBits(nextRandom() & ((1ULL << SIGNIFICAND_BITS) - 1)));
+        checkFormat(__CFDoubleFromBits(nextRandom() & 0xFFFULL));
+    }
+    static const char *const texts[] = {
+        "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324", "7.4109846876186982e-324",
+        "2.2250738585072011e-308", "2.2250738585072012e-308", "1e-320", "1e-324", "1e-400", "0.000000000000000000000000000000000000001e-290",
+    };
+    for (unsigned idx = 0; idx < sizeof(texts) / sizeof(texts[0]); idx++) checkParse(texts[idx]);
+}
+
+// Decimals exactly halfway between two adjacent doubles must round to the one with the even significand
+static void checkHalfwayCases(void) {
+    static const char *const texts[] = {
+        "9007199254740993", "9007199254740995", "-9007199254740993", "9007199254740992.5", "18014398509481986", "18014398509481990",
+        "1e23", "8.98846567431158e307", "1.7976931348623158e308", "1.7976931348623157e308", "7.2057594037927933e16", "0.5", "2.5e-1",
+    };
+    for (unsigned idx = 0; idx < sizeof(texts) / sizeof(texts[0]); idx++) checkParse(texts[idx]);
+    char text[64];
+    for (int idx = 0; idx < 100000; idx++) {
+        // between 2^53 and 2^63 the midpoints are integers short enough for the exact path
+        int shift = 1 + (int)(nextRandom() % 10);
+        uint64_t significand = (1ULL << SIGNIFICAND_BITS) | (nextRandom() & ((1ULL << SIGNIFICAND_BITS) - 1));
+        uint64_t midpoint = (significand << shift) + (1ULL << (shift - 1));
+        int digits = snprintf(text, sizeof(text), "%llu", (unsigned long long)midpoint);
+        if (0 == checkParse(text)) fail("halfway took the fallback", text, 0.0, strtod(text, NULL));
+        // the same value with a decimal point and an exponent
+        int point = (int)(nextRandom() % digits);
+        memmove(text + point + 1, text + point, digits - point);
+        text[point] = '.';
+        snprintf(text + digits + 1, sizeof(text) - digits - 1, "e%d", digits - point);
+        if (0 == checkParse(text)) fail("halfway took the fallback", text, 0.0, strtod(text, NULL));
+    }
+}
+
+// More than 19 significant digits are only handled when the dropped digits cannot change the result
+static void checkFallback(void) {
+    static const char *const needed[] = {
+        "9007199254740993.0000000000000000001", "9007199254740994.9999999999999999999",
+        "2.47032822920623272088284396434110686182529901307162382212792841250337753635104375932649918180817996189898282347722858865463328355177969898199387398005390939063150356595155702263922908583924491051844359318028499365361525003193704576782492193656236698636584807570015857692699037063119282795585513329278343384093519780155312465972635795746227664652728272200563740064854999770965994704540208281662262378573934507363390079677619305775067401763246736009689513405355374585166611342237666786041621596804619144672918403005300575308490487653917113865916462395249126236538818796362393732804238910186723484976682350898633885879256283027559956575244555072551893136908362547791869486679949683240497058210285131854513962138377228261454376934125320985913276672363281255e-324",
+    };
+    for (unsigned idx = 0; idx < sizeof(needed) / sizeof(needed[0]); idx++) {
+        if (0 != checkParse(needed[idx])) fail("missed the fallback", needed[idx], 0.0, strtod(needed[idx], NULL));
+    }
+    static const char *const avoided[] = {
+        "0.1000000000000000000000000001", "123456789012345678901234567890", "3.14159265358979323846264338327950288",
+        "00000000000000000000000000000000000001.5", "0.000000000000000000000000000000000000001",
+    };
+    for (unsigned idx = 0; idx < sizeof(avoided) / sizeof(avoided[0]); idx++) {
+        if (0 == checkParse(avoided[idx])) fail("needlessly took the fallback", avoided[idx], 0.0, strtod(avoided[idx], NULL));
+    }
+    // and whatever is not a plain decimal is left to strtod() or parsed only as far as strtod() would
+    static const char *const malformed[] = {"", ".", "+", "-", "e5", "1e", "1e+", "1.2.3", "5.", "-.5", "1e400", "-1e400"};
+    for (unsigned idx = 0; idx < sizeof(malformed) / sizeof(malformed[0]); idx++) checkParse(malformed[idx]);
+}
+
+int main(int argc, char **argv) {
+    long count = (1 < argc) ? atol(argv[1]) : 1000000;
+    static const double samples[] = {0.0, -0.0, 0.1, 1.5, 100, 1e16, 1e17, 1e20, 1e21, 1e22, 1e23, 0.0001, 0.00001, -2.5, 1.0 / 3, 2.0 / 3, 123456789012345678.0, 1.7976931348623157e308};
+    for (unsigned idx = 0; idx < sizeof(samples) / sizeof(samples[0]); idx++) checkFormat(samples[idx]);
+    char text[80];
+    for (long idx = 0; idx < count; idx++) {
+        uint64_t bits = nextRandom();
+        double value = (0 == idx % 4) ? (double)(nextRandom() % 100000) / (double)(1 + nextRandom() % 1000) : __CFDoubleFromBits(bits);
+        if (isfinite(value)) checkFormat(value);
+        // random decimal text, some of it past the 19 digits the exact paths handle
+        int length = 1 + (int)(nextRandom() % 25), point = (int)(nextRandom() % (length + 1)), used = 0;
+        if (nextRandom() & 1) text[used++] = '-';
+        for (int digit = 0; digit < length; digit++) {
+            if (digit == point) text[used++] = '.';
+            text[used++] = (char)('0' + nextRandom() % 10);
+        }
+        if (nextRandom() & 1) used += snprintf(text + used, sizeof(text) - used, "e%d", (int)(nextRandom() % 700) - 350);
+        text[used] = '\0';
+        checkParse(text);
+    }
+    checkSubnormals();
+    checkHalfwayCases();
+    checkFallback();
+    return reportFailures();
+}
@@ -0,0 +1,177 @@
+// Compares CFCalendar's Gregorian compose and decompose, which mostly take an arithmetic path, with ICU's own calendar.
+// Covers dates on both sides of the 1582 Julian cutover, negative absolute times and the wall times around every
+// daylight saving transition in a handful of zones, and checks _CFCalendarDecomposeAbsoluteTimes() against single decomposes.
+//
+// Mac OS X: clang -I<path-to-ICU-headers> -F<path-to-CFLite-framework> -framework CoreFoundation -licucore gregoriancalendar.c -o gregoriancalendar
+// Linux: clang -I/usr/local/include -L/usr/local/lib -lCoreFoundation -licui18n -licuuc gregoriancalendar.c -o gregoriancalendar
+//
+// Run with an optional count of random times to check per zone (default 200000); exits nonzero on any mismatch.
+// The fast path reads offsets from CFTimeZone and ICU from its own zone data, so both must come from the same tz release.
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreFoundation/CFPriv.h>
+#include <unicode/ucal.h>
+#include <unicode/ustring.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "TestSupport.h"
+
+static double randomBetween(double low, double high) {
+    return low + (high - low) * ((double)(nextRandom() >> 11) / 9007199254740992.0);
+}
+
+// The fields CFCalendar decomposes without ICU, in the order of decomposeDesc
+static const char *const decomposeDesc = "GyMdHhamsSEDg";
+static const UCalendarDateFields decomposeFields[] = {
+    UCAL_ERA, UCAL_YEAR, UCAL_MONTH, UCAL_DATE, UCAL_HOUR_OF_DAY, UCAL_HOUR, UCAL_AM_PM,
+    UCAL_MINUTE, UCAL_SECOND, UCAL_MILLISECOND, UCAL_DAY_OF_WEEK, UCAL_DAY_OF_YEAR, UCAL_JULIAN_DAY,
+};
+
+static void checkDecompose(CFCalendarRef calendar, UCalendar *reference, const char *zone, CFAbsoluteTime at) {
+    int got[13];
+    if (!CFCalendarDecomposeAbsoluteTime(calendar, at, decomposeDesc, &got[0], &got[1], &got[2], &got[3], &got[4], &got[5], &got[6], &got[7], &got[8], &got[9], &got[10], &got[11], &got[12])) {
+        FAIL("decompose %s %.3f: CFCalendar failed", zone, at);
+        return;
+    }
+    UErrorCode status = U_ZERO_ERROR;
+    ucal_clear(reference);
+    ucal_setMillis(reference, floor((at + kCFAbsoluteTimeIntervalSince1970) * 1000.0), &status);
+    for (int idx = 0; idx < 13; idx++) {
+        int expected = ucal_get(reference, decomposeFields[idx], &status);
+        if (UCAL_MONTH == decomposeFields[idx]) expected++;
+        if (U_SUCCESS(status) && got[idx] != expected) {
+            FAIL("decompose %s %.3f: '%c' is %d, expected %d", zone, at, decomposeDesc[idx], got[idx], expected);
+            return;
+        }
+    }
+}
+
+static void checkCompose(CFCalendarRef calendar, UCalendar *reference, const char *zone, const int *fields) {
+    CFAbsoluteTime at;
+    if (!CFCalendarComposeAbsoluteTime(calendar, &at, "yMdHmsS", fields[0], fields[1], fields[2], fields[3], fields[4], fields[5], fields[6])) {
+        FAIL("compose %s %d-%d-%d %d:%d:%d.%d: CFCalendar failed", zone, fields[0], fields[1], fields[2], fields[3], fields[4], fields[5], fields[6]);
+        return;
+    }
+    // set the fields as CFCalendar does when it defers to ICU
+    static const UCalendarDateFields composeFields[] = {UCAL_YEAR, UCAL_MONTH, UCAL_DATE, UCAL_HOUR_OF_DAY, UCAL_MINUTE, UCAL_SECOND, UCAL_MILLISECOND};
+    UErrorCode status = U_ZERO_ERROR;
+    ucal_clear(reference);
+    ucal_set(reference, UCAL_YEAR, 1);
+    ucal_set(reference, UCAL_MONTH, 0);
+    ucal_set(reference, UCAL_DATE, 1);
+    ucal_set(reference, UCAL_HOUR_OF_DAY, 0);
+    ucal_set(reference, UCAL_MINUTE, 0);
+    ucal_set(reference, UCAL_SECOND, 0);
+    for (int idx = 0; idx < 7; idx++) ucal_set(reference, composeFields[idx], (UCAL_MONTH == composeFields[idx]) ? fields[idx] - 1 : fields[idx]);
+    CFAbsoluteTime expected = ucal_getMillis(reference, &status) / 1000.0 - kCFAbsoluteTimeIntervalSince1970;
+    if (U_SUCCESS(status) && at != expected) FAIL("compose %s %d-%d-%d %d:%d:%d.%d: %.3f, expected %.3f", zone, fields[0], fields[1], fields[2], fields[3], fields[4], fields[5], fields[6], at, expected);
+}
+
+// Decomposes times in one batch and each time on its own, which must agree
+static void checkBatch(CFCalendarRef calendar, const char *zone, const CFAbsoluteTime *times, CFIndex count) {
+    int *values = (int *)malloc(9 * count * sizeof(int));
+    _CFCalendarComponentArrays arrays = {
+        values, values + count, NULL, values + 2 * count, values + 3 * count, values + 4 * count,
+        values + 5 * count, values + 6 * count, values + 7 * count, values + 8 * count, NULL, NULL, NULL,
+    };
+    CFCalendarUnit units = kCFCalendarUnitEra | kCFCalendarUnitYear | kCFCalendarUnitMonth | kCFCalendarUnitDay | kCFCalendarUnitHour | kCFCalendarUnitMinute | kCFCalendarUnitSecond | kCFCalendarUnitWeekday | kCFCalendarUnitWeekdayOrdinal;
+    if (!_CFCalendarDecomposeAbsoluteTimes(calendar, times, count, units, &arrays)) FAIL("batch %s: _CFCalendarDecomposeAbsoluteTimes failed", zone);
+    for (CFIndex idx = 0; idx < count; idx++) {
+        int got[9];
+        CFCalendarDecomposeAbsoluteTime(calendar, times[idx], "GyMdHmsEF", &got[0], &got[1], &got[2], &got[3], &got[4], &got[5], &got[6], &got[7], &got[8]);
+        for (int field = 0; field < 9; field++) {
+            if (values[field * count + idx] != got[field]) {
+                FAIL("batch %s %.3f: '%c' is %d, expected %d", zone, times[idx], "GyMdHmsEF"[field], values[field * count + idx], got[field]);
+                break;
+            }
+        }
+    }
+    free(values);
+}
+
+// Random fields, some of them out of range so the lenient roll over is exercised too
+static void checkRandomCompose(CFCalendarRef calendar, UCalendar *reference, const char *zone, int lowYear, int highYear) {
+    int fields[7] = {
+        lowYear + (int)(nextRandom() % (highYear - lowYear + 1)),
+        (int)(nextRandom() % 14), (int)(nextRandom() % 33), (int)(nextRandom() % 25),
+        (int)(nextRandom() % 61), (int)(nextRandom() % 61), (int)(nextRandom() % 1000),
+    };
+    checkCompose(calendar, reference, zone, fields);
+}
+
+// Decomposes the instants around each transition, and composes the wall times on either side of it
+static void checkTransitions(CFCalendarRef calendar, UCalendar *reference, const char *zone) {
+    static const double offsets[] = {-3600000.0, -1000.0, -1.0, 0.0, 1.0, 1000.0, 1800000.0, 3600000.0};
+    UErrorCode status = U_ZERO_ERROR;
+    UChar gmtName[4];
+    u_uastrcpy(gmtName, "GMT");
+    UCalendar *gmt = ucal_open(gmtName, -1, "en_US@calendar=gregorian", UCAL_GREGORIAN, &status);
+    UDate transition = -3786825600000.0;	// 1850
+    int count = 0;
+    while (count++ < 1000) {
+        ucal_setMillis(reference, transition, &status);
+        UDate next;
+        if (!ucal_getTimeZoneTransitionDate(reference, UCAL_TZ_TRANSITION_NEXT, &next, &status) || U_FAILURE(status) || 2240611200000.0 < next) break;	// 2041
+        transition = next;
+        for (unsigned idx = 0; idx < sizeof(offsets) / sizeof(offsets[0]); idx++) {
+            CFAbsoluteTime at = (transition + offsets[idx]) / 1000.0 - kCFAbsoluteTimeIntervalSince1970;
+            checkDecompose(calendar, reference, zone, at);
+            // the local wall time of at, read with the offsets before and after the transition
+            for (int side = -1; side <= 1; side += 2) {
+                ucal_setMillis(reference, transition + side * 7200000.0, &status);
+                UDate local = transition + offsets[idx] + ucal_get(reference, UCAL_ZONE_OFFSET, &status) + ucal_get(reference, UCAL_DST_OFFSET, &status);
+                ucal_setMillis(gmt, local, &status);
+                int fields[7] = {
+                    ucal_get(gmt, UCAL_YEAR, &status), ucal_get(gmt, UCAL_MONTH, &status) + 1, ucal_get(gmt, UCAL_DATE, &status),
+                    ucal_get(gmt, UCAL_HOUR_OF_DAY, &status), ucal_get(gmt, UCAL_MINUTE, &status), ucal_get(gmt, UCAL_SECOND, &status), ucal_get(gmt, UCAL_MILLISECOND, &status),
+                };
+                checkCompose(calendar, reference, zone, fields);
+            }
+        }
+    }
+    ucal_close(gmt);
+}
+
+static void checkZone(const char *zone, long count) {
+    CFCalendarRef calendar = CFCalendarCreateWithIdentifier(kCFAllocatorSystemDefault, kCFGregorianCalendar);
+    CFStringRef name = CFStringCreateWithCString(kCFAllocatorSystemDefault, zone, kCFStringEncodingASCII);
+    CFTimeZoneRef tz = CFTimeZoneCreateWithName(kCFAllocatorSystemDefault, name, true);
+    UChar uzone[64];
+    u_uastrcpy(uzone, zone);
+    UErrorCode status = U_ZERO_ERROR;
+    UCalendar *reference = ucal_open(uzone, -1, "en_US@calendar=gregorian", UCAL_GREGORIAN, &status);
+    if (NULL == calendar || NULL == tz || U_FAILURE(status)) {
+        FAIL("%s: cannot create the calendars", zone);
+    } else {
+        CFCalendarSetTimeZone(calendar, tz);
+        checkTransitions(calendar, reference, zone);
+        // around the start of 2001, where absolute times turn negative, and on both sides of the cutover
+        static const CFAbsoluteTime fixed[] = {0.0, -0.0005, -0.001, -0.5, -1.0, -86400.0, -86400.0005, -978307200.0, -978307200.001, -13197600000.0, -13197686400.0, -13197600000.001};
+        for (unsigned idx = 0; idx < sizeof(fixed) / sizeof(fixed[0]); idx++) checkDecompose(calendar, reference, zone, fixed[idx]);
+        CFAbsoluteTime *batch = (CFAbsoluteTime *)malloc(count * sizeof(CFAbsoluteTime));
+        for (long idx = 0; idx < count; idx++) batch[idx] = randomBetween(-1.0e10, 1.0e10);		// 1684 to 2317
+        checkBatch(calendar, zone, batch, count);
+        free(batch);
+        for (long idx = 0; idx < count; idx++) {
+            checkDecompose(calendar, reference, zone, randomBetween(-1.0e11, 1.0e11));		// about 1200 BC to 5200 AD
+            checkDecompose(calendar, reference, zone, randomBetween(-3.16e10, -1.26e10));	// 1000 to 1600
+            checkDecompose(calendar, reference, zone, randomBetween(-1.0e6, 0.0));
+            checkRandomCompose(calendar, reference, zone, 1, 9999);
+            checkRandomCompose(calendar, reference, zone, 1500, 1700);
+        }
+    }
+    if (reference) ucal_close(reference);
+    if (tz) CFRelease(tz);
+    if (name) CFRelease(name);
+    if (calendar) CFRelease(calendar);
+}
+
+int main(int argc, char **argv) {
+    long count = (1 < argc) ? atol(argv[1]) : 200000;
+    static const char *const zones[] = {"GMT", "America/New_York", "Europe/London", "Australia/Lord_Howe", "America/Sao_Paulo", "Pacific/Apia", "Asia/Kolkata"};
+    for (unsigned idx = 0; idx < sizeof(zones) / sizeof(zones[0]); idx++) checkZone(zones[idx], count);
+    return reportFailures();
+}
@@ -0,0 +1,118 @@
+// Times the per-locale objects a server creates per request, cycling through eight locales:
+// CFLocaleCreateCanonicalLocaleIdentifierFromString() on identifiers in non-canonical forms, a Gregorian CFCalendar
+// set to the locale and asked for its first weekday (which opens its ICU calendar), a medium-style CFDateFormatter and
+// a decimal CFNumberFormatter.  Each created object is released.  Afterwards it checks that calendars and formatters
+// created again still agree with the first ones made for each locale, and prints the cache counters from CFPriv.h.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation localebenchmark.c -o localebenchmark
+// Linux: clang -O2 -I/usr/local/include -L/usr/local/lib -lCoreFoundation localebenchmark.c -o localebenchmark
+//
+// Run with an optional count of objects per measurement (default 20000).
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreFoundation/CFPriv.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TestSupport.h"
+
+#define LOCALE_COUNT 8
+
+typedef struct {
+    CFIndex count;
+    CFStringRef identifiers[LOCALE_COUNT];
+    CFLocaleRef locales[LOCALE_COUNT];
+    CFIndex weekdays[LOCALE_COUNT];
+    CFStringRef dates[LOCALE_COUNT];
+    CFStringRef numbers[LOCALE_COUNT];
+} Run;
+
+static const CFAbsoluteTime sampleTime = 400000000.5;
+static const double sampleNumber = 1234567.891;
+
+static CFCalendarRef createCalendar(CFLocaleRef locale) {
+    CFCalendarRef calendar = CFCalendarCreateWithIdentifier(kCFAllocatorSystemDefault, kCFGregorianCalendar);
+    CFCalendarSetLocale(calendar, locale);
+    return calendar;
+}
+
+static CFDateFormatterRef createDateFormatter(CFLocaleRef locale) {
+    return CFDateFormatterCreate(kCFAllocatorSystemDefault, locale, kCFDateFormatterMediumStyle, kCFDateFormatterMediumStyle);
+}
+
+static CFNumberFormatterRef createNumberFormatter(CFLocaleRef locale) {
+    return CFNumberFormatterCreate(kCFAllocatorSystemDefault, locale, kCFNumberFormatterDecimalStyle);
+}
+
+static void canonicalize(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) CFRelease(CFLocaleCreateCanonicalLocaleIdentifierFromString(kCFAllocatorSystemDefault, run->identifiers[idx % LOCALE_COUNT]));
+}
+
+static void calendars(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) {
+        CFCalendarRef calendar = createCalendar(run->locales[idx % LOCALE_COUNT]);
+        if (CFCalendarGetFirstWeekday(calendar) < 1) FAIL("calendar has no first weekday");
+        CFRelease(calendar);
+    }
+}
+
+static void dateFormatters(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) CFRelease(createDateFormatter(run->locales[idx % LOCALE_COUNT]));
+}
+
+static void numberFormatters(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) CFRelease(createNumberFormatter(run->locales[idx % LOCALE_COUNT]));
+}
+
+// What the calendar and formatters for one locale give, to compare later ones against the first
+static void sample(CFLocaleRef locale, CFIndex *weekday, CFStringRef *date, CFStringRef *number) {
+    CFCalendarRef calendar = createCalendar(locale);
+    CFDateFormatterRef dateFormatter = createDateFormatter(locale);
+    CFNumberFormatterRef numberFormatter = createNumberFormatter(locale);
+    *weekday = CFCalendarGetFirstWeekday(calendar);
+    *date = CFDateFormatterCreateStringWithAbsoluteTime(kCFAllocatorSystemDefault, dateFormatter, sampleTime);
+    *number = CFNumberFormatterCreateStringWithValue(kCFAllocatorSystemDefault, numberFormatter, kCFNumberDoubleType, &sampleNumber);
+    CFRelease(calendar);
+    CFRelease(dateFormatter);
+    CFRelease(numberFormatter);
+}
+
+int main(int argc, char **argv) {
+    static const char *const identifiers[LOCALE_COUNT] = {"en-us", "de_DE", "fr-CA", "ja_JP", "zh-Hans-CN", "pt_BR", "es-419", "ar_EG"};
+    Run run = {(1 < argc) ? atol(argv[1]) : 20000};
+    for (int idx = 0; idx < LOCALE_COUNT; idx++) {
+        run.identifiers[idx] = CFStringCreateWithCString(kCFAllocatorSystemDefault, identifiers[idx], kCFStringEncodingASCII);
+        CFStringRef canonical = CFLocaleCreateCanonicalLocaleIdentifierFromString(kCFAllocatorSystemDefault, run.identifiers[idx]);
+        run.locales[idx] = CFLocaleCreate(kCFAllocatorSystemDefault, canonical);
+        CFRelease(canonical);
+        sample(run.locales[idx], run.weekdays + idx, run.dates + idx, run.numbers + idx);
+    }
+    printf("%ld objects, %d locales, best of %d runs\n", (long)run.count, LOCALE_COUNT, BENCHMARK_RUNS);
+    printf("CFLocaleCreateCanonicalLocaleIdentifierFromString %8.0f ns\n", bestTime(NULL, canonicalize, &run) * 1.0e9 / run.count);
+    printf("CFCalendarCreateWithIdentifier+SetLocale          %8.0f ns\n", bestTime(NULL, calendars, &run) * 1.0e9 / run.count);
+    printf("CFDateFormatterCreate                             %8.0f ns\n", bestTime(NULL, dateFormatters, &run) * 1.0e9 / run.count);
+    printf("CFNumberFormatterCreate                           %8.0f ns\n", bestTime(NULL, numberFormatters, &run) * 1.0e9 / run.count);
+    for (int idx = 0; idx < LOCALE_COUNT; idx++) {
+        CFIndex weekday;
+        CFStringRef date, number;
+        sample(run.locales[idx], &weekday, &date, &number);
+        if (weekday != run.weekdays[idx]) FAIL("%s: first weekday %ld, was %ld", identifiers[idx], (long)weekday, (long)run.weekdays[idx]);
+        if (!date || !run.dates[idx] || !CFEqual(date, run.dates[idx])) FAIL("%s: date formatted differently", identifiers[idx]);
+        if (!number || !run.numbers[idx] || !CFEqual(number, run.numbers[idx])) FAIL("%s: number formatted differently", identifiers[idx]);
+        if (date) CFRelease(date);
+        if (number) CFRelease(number);
+        if (run.dates[idx]) CFRelease(run.dates[idx]);
+        if (run.numbers[idx]) CFRelease(run.numbers[idx]);
+        CFRelease(run.locales[idx]);
+        CFRelease(run.identifiers[idx]);
+    }
+    _CFLocaleCacheStatistics statistics;
+    _CFLocaleGetCacheStatistics(&statistics);
+    printf("identifier cache %ld hits, %ld misses; ICU object cache %ld hits, %ld misses\n", (long)statistics.identifierHits, (long)statistics.identifierMisses, (long)statistics.icuHits, (long)statistics.icuMisses);
+    return reportFailures();
+}
@@ -0,0 +1,82 @@
+// Times the CFNumber core on three kinds of value: small integers, integers too large for a tagged pointer, and
+// doubles.  For each it times CFNumberCreate() and CFRelease(), CFNumberCompare() of neighbouring numbers,
+// CFHash() and CFNumberGetValue().
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation numberbenchmark.c -o numberbenchmark
+// Linux: clang -O2 -I/usr/local/include -L/usr/local/lib -lCoreFoundation numberbenchmark.c -o numberbenchmark
+//
+// Run with an optional count of numbers (default 1000000).
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TestSupport.h"
+
+enum {
+    SmallInts,		// 0 to 999
+    LargeInts,		// beyond 2^56
+    Doubles,
+    KindCount
+};
+
+static const char *const kindNames[] = {"small integers", "large integers", "doubles"};
+
+typedef struct {
+    CFIndex count;
+    CFNumberType type;
+    void *values;	// int64_t or double
+    CFNumberRef *numbers;
+    uintptr_t result;
+} Run;
+
+static void createAndRelease(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) CFRelease(CFNumberCreate(kCFAllocatorSystemDefault, run->type, (const char *)run->values + 8 * idx));
+}
+
+static void compare(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 1; idx < run->count; idx++) run->result += CFNumberCompare(run->numbers[idx - 1], run->numbers[idx], NULL);
+}
+
+static void hash(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) run->result += CFHash(run->numbers[idx]);
+}
+
+static void getValue(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) {
+        int64_t value;
+        CFNumberGetValue(run->numbers[idx], kCFNumberSInt64Type, &value);
+        run->result += (uintptr_t)value;
+    }
+}
+
+int main(int argc, char **argv) {
+    Run run = {(1 < argc) ? atol(argv[1]) : 1000000};
+    run.values = malloc(run.count * 8);
+    run.numbers = (CFNumberRef *)malloc(run.count * sizeof(CFNumberRef));
+    printf("%ld numbers, best of %d runs\n", (long)run.count, BENCHMARK_RUNS);
+    for (int kind = 0; kind < KindCount; kind++) {
+        run.type = (Doubles == kind) ? kCFNumberFloat64Type : kCFNumberSInt64Type;
+        for (CFIndex idx = 0; idx < run.count; idx++) {
+            if (Doubles == kind) {
+                ((double *)run.values)[idx] = (double)(nextRandom() % 100000000) / 1000.0;
+            } else {
+                ((int64_t *)run.values)[idx] = (SmallInts == kind) ? (int64_t)(nextRandom() % 1000) : (int64_t)((nextRandom() >> 4) | (1ULL << 59));
+            }
+            run.numbers[idx] = CFNumberCreate(kCFAllocatorSystemDefault, run.type, (const char *)run.values + 8 * idx);
+        }
+        printf("%-15s CFNumberCreate+CFRelease %7.1f ns\n", kindNames[kind], bestTime(NULL, createAndRelease, &run) * 1.0e9 / run.count);
+        printf("%-15s CFNumberCompare          %7.1f ns\n", kindNames[kind], bestTime(NULL, compare, &run) * 1.0e9 / run.count);
+        printf("%-15s CFHash                   %7.1f ns\n", kindNames[kind], bestTime(NULL, hash, &run) * 1.0e9 / run.count);
+        printf("%-15s CFNumberGetValue         %7.1f ns\n", kindNames[kind], bestTime(NULL, getValue, &run) * 1.0e9 / run.count);
+        for (CFIndex idx = 0; idx < run.count; idx++) CFRelease(run.numbers[idx]);
+    }
+    free(run.values);
+    free(run.numbers);
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Compares persistent CFDictionaries with ordinary ones for the one thing they are for: deriving a copy that differs by
+// one key.  Times _CFDictionaryCreateCopyBySettingValue() against CFDictionaryCreateMutableCopy() plus
+// CFDictionarySetValue(), both from a dictionary of CFNumber keys, along with the one-off conversion by
+// _CFDictionaryCreatePersistentCopy() and CFDictionaryGetValue() on each kind.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation persistentdictionarybenchmark.c -o persistentdictionarybenchmark
+// Linux: clang -O2 -I/usr/local/include -L/usr/local/lib -lCoreFoundation persistentdictionarybenchmark.c -o persistentdictionarybenchmark
+//
+// Run with an optional key count (default 10000).
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreFoundation/CFPriv.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TestSupport.h"
+
+#define DERIVATIONS 1000
+
+typedef struct {
+    CFIndex count;
+    CFNumberRef *keys;
+    CFDictionaryRef ordinary;
+    CFDictionaryRef persistent;
+    CFDictionaryRef source;
+} Run;
+
+static void mutableCopies(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < DERIVATIONS; idx++) {
+        CFMutableDictionaryRef copy = CFDictionaryCreateMutableCopy(kCFAllocatorSystemDefault, 0, run->ordinary);
+        CFDictionarySetValue(copy, run->keys[idx % run->count], kCFBooleanFalse);
+        CFRelease(copy);
+    }
+}
+
+static void persistentCopies(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < DERIVATIONS; idx++) {
+        CFRelease(_CFDictionaryCreateCopyBySettingValue(kCFAllocatorSystemDefault, run->persistent, run->keys[idx % run->count], kCFBooleanFalse));
+    }
+}
+
+// Each version derived from the last, the way persistent collections are usually used
+static void persistentChain(void *context) {
+    Run *run = (Run *)context;
+    CFDictionaryRef version = CFRetain(run->persistent);
+    for (CFIndex idx = 0; idx < DERIVATIONS; idx++) {
+        CFDictionaryRef next = _CFDictionaryCreateCopyBySettingValue(kCFAllocatorSystemDefault, version, run->keys[idx % run->count], kCFBooleanFalse);
+        CFRelease(version);
+        version = next;
+    }
+    CFRelease(version);
+}
+
+static void convert(void *context) {
+    Run *run = (Run *)context;
+    CFRelease(_CFDictionaryCreatePersistentCopy(kCFAllocatorSystemDefault, run->ordinary));
+}
+
+static void lookUp(void *context) {
+    Run *run = (Run *)context;
+    for (CFIndex idx = 0; idx < run->count; idx++) {
+        if (!CFDictionaryGetValue(run->source, run->keys[idx])) FAIL("key %ld is missing", (long)idx);
+    }
+}
+
+int main(int argc, char **argv) {
+    Run run = {(1 < argc) ? atol(argv[1]) : 10000};
+    run.keys = (CFNumberRef *)malloc(run.count * sizeof(CFNumberRef));
+    CFMutableDictionaryRef dict = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    for (CFIndex idx = 0; idx < run.count; idx++) {
+        int64_t key = (int64_t)(nextRandom() >> 1);
+        run.keys[idx] = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberSInt64Type, &key);
+        CFDictionarySetValue(dict, run.keys[idx], kCFBooleanTrue);
+    }
+    run.ordinary = CFDictionaryCreateCopy(kCFAllocatorSystemDefault, dict);
+    run.persistent = _CFDictionaryCreatePersistentCopy(kCFAllocatorSystemDefault, dict);
+    printf("%ld keys, best of %d runs\n", (long)run.count, BENCHMARK_RUNS);
+    double seconds = bestTime(NULL, mutableCopies, &run);
+    printf("CFDictionaryCreateMutableCopy + set         %10.0f ns/copy\n", seconds * 1.0e9 / DERIVATIONS);
+    seconds = bestTime(NULL, persistentCopies, &run);
+    printf("_CFDictionaryCreateCopyBySettingValue       %10.0f ns/copy\n", seconds * 1.0e9 / DERIVATIONS);
+    seconds = bestTime(NULL, persistentChain, &run);
+    printf("_CFDictionaryCreateCopyBySettingValue chain %10.0f ns/copy\n", seconds * 1.0e9 / DERIVATIONS);
+    seconds = bestTime(NULL, convert, &run);
+    printf("_CFDictionaryCreatePersistentCopy           %10.0f ns/key\n", seconds * 1.0e9 / run.count);
+    run.source = run.ordinary;
+    seconds = bestTime(NULL, lookUp, &run);
+    printf("CFDictionaryGetValue, ordinary              %10.1f ns/lookup\n", seconds * 1.0e9 / run.count);
+    run.source = run.persistent;
+    seconds = bestTime(NULL, lookUp, &run);
+    printf("CFDictionaryGetValue, persistent            %10.1f ns/lookup\n", seconds * 1.0e9 / run.count);
+    for (CFIndex idx = 0; idx < run.count; idx++) CFRelease(run.keys[idx]);
+    free(run.keys);
+    CFRelease(run.ordinary);
+    CFRelease(run.persistent);
+    CFRelease(dict);
+    return reportFailures();
+}
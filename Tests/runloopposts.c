@@ -0,0 +1,80 @@
+// Measures how fast 16 threads can post work to one run loop while its thread drains it: CFRunLoopPerformBlock()
+// calls, and CFRunLoopSourceSignal() calls on one version 0 source, each reported in posts per second over all producers.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation runloopposts.c -o runloopposts
+// MakefileLinux does not build the run loop, so there is no Linux build of this one.
+//
+// Run with an optional count of posts per producer (default 200000).
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define PRODUCER_COUNT 16
+
+static CFRunLoopRef loop = NULL;
+static CFRunLoopSourceRef source = NULL;
+static long postCount = 0;
+static volatile int started = 0;
+static volatile int32_t producing = 0;
+static volatile long blocksRun = 0;
+static volatile long performs = 0;
+
+static void perform(void *info) {
+    performs++;
+}
+
+static void *postBlocks(void *arg) {
+    while (!started) {}
+    for (long idx = 0; idx < postCount; idx++) {
+        CFRunLoopPerformBlock(loop, kCFRunLoopDefaultMode, ^{ blocksRun++; });
+    }
+    __sync_fetch_and_sub(&producing, 1);
+    return NULL;
+}
+
+static void *postSignals(void *arg) {
+    while (!started) {}
+    for (long idx = 0; idx < postCount; idx++) {
+        CFRunLoopSourceSignal(source);
+    }
+    __sync_fetch_and_sub(&producing, 1);
+    return NULL;
+}
+
+// Starts the producers together and runs the loop until they are done and, for blocks, everything posted has run;
+// the loop runs in short slices so that it does not depend on being woken
+static void measure(const char *what, void *(*producer)(void *), Boolean drainBlocks) {
+    pthread_t threads[PRODUCER_COUNT];
+    started = 0;
+    producing = PRODUCER_COUNT;
+    blocksRun = 0;
+    performs = 0;
+    for (int idx = 0; idx < PRODUCER_COUNT; idx++) pthread_create(&threads[idx], NULL, producer, NULL);
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent(), posted = 0.0;
+    started = 1;
+    while (0 != producing || (drainBlocks && blocksRun < PRODUCER_COUNT * postCount)) {
+        CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.001, false);
+        if (0 == producing && 0.0 == posted) posted = CFAbsoluteTimeGetCurrent();
+    }
+    CFAbsoluteTime drained = CFAbsoluteTimeGetCurrent();
+    for (int idx = 0; idx < PRODUCER_COUNT; idx++) pthread_join(threads[idx], NULL);
+    double total = (double)PRODUCER_COUNT * postCount;
+    printf("%-28s %12.0f posts/s while posting, %12.0f posts/s to drained, %ld performs\n", what, total / (posted - start), total / (drained - start), drainBlocks ? blocksRun : performs);
+}
+
+int main(int argc, char **argv) {
+    postCount = (1 < argc) ? atol(argv[1]) : 200000;
+    loop = CFRunLoopGetCurrent();
+    CFRunLoopSourceContext context = {0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, perform};
+    source = CFRunLoopSourceCreate(kCFAllocatorSystemDefault, 0, &context);
+    CFRunLoopAddSource(loop, source, kCFRunLoopDefaultMode);
+    printf("%d producers, %ld posts each\n", PRODUCER_COUNT, postCount);
+    measure("CFRunLoopPerformBlock", postBlocks, true);
+    measure("CFRunLoopSourceSignal", postSignals, false);
+    CFRunLoopSourceInvalidate(source);
+    CFRelease(source);
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Times CFQSortArray() and CFMergeSortArray() on random, sorted, reverse sorted and few-unique input, for word-sized
+// elements and for 24-byte records, and reports the comparisons each sort makes along with its time per element.
+// Then times CFArraySortValues() on random input, for arrays with no callbacks and with a retain callback only.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation sortbenchmark.c -o sortbenchmark
+// Linux: clang -O2 -I/usr/local/include -L/usr/local/lib -lCoreFoundation sortbenchmark.c -o sortbenchmark
+//
+// Run with an optional element count (default 1000000).
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreFoundation/CFPriv.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TestSupport.h"
+
+enum {
+    Random,
+    Sorted,
+    Reverse,
+    FewUnique,		// 16 distinct keys
+    OrderCount
+};
+
+static const char *const orderNames[] = {"random", "sorted", "reverse", "few unique"};
+
+typedef struct {
+    CFIndex key;
+    CFIndex payload[2];
+} Record;
+
+typedef struct {
+    CFIndex count;
+    CFIndex elementSize;
+    void *input;
+    void *list;
+    Boolean merge;
+    long comparisons;
+} Run;
+
+static CFComparisonResult compareIndexes(const void *a, const void *b, void *info) {
+    ((Run *)info)->comparisons++;
+    CFIndex x = *(const CFIndex *)a, y = *(const CFIndex *)b;
+    return (x < y) ? kCFCompareLessThan : (x > y) ? kCFCompareGreaterThan : kCFCompareEqualTo;
+}
+
+static CFComparisonResult compareRecords(const void *a, const void *b, void *info) {
+    ((Run *)info)->comparisons++;
+    CFIndex x = ((const Record *)a)->key, y = ((const Record *)b)->key;
+    return (x < y) ? kCFCompareLessThan : (x > y) ? kCFCompareGreaterThan : kCFCompareEqualTo;
+}
+
+static CFComparisonResult compareValues(const void *a, const void *b, void *info) {
+    ((Run *)info)->comparisons++;
+    return ((uintptr_t)a < (uintptr_t)b) ? kCFCompareLessThan : ((uintptr_t)a > (uintptr_t)b) ? kCFCompareGreaterThan : kCFCompareEqualTo;
+}
+
+static const void *retainValue(CFAllocatorRef allocator, const void *value) {
+    return value;
+}
+
+static CFIndex keyAt(int order, CFIndex idx, CFIndex count) {
+    switch (order) {
+    case Sorted: return idx;
+    case Reverse: return count - idx;
+    case FewUnique: return (CFIndex)(nextRandom() % 16);
+    }
+    return (CFIndex)(nextRandom() >> 1);
+}
+
+static void setup(void *context) {
+    Run *run = (Run *)context;
+    memmove(run->list, run->input, run->count * run->elementSize);
+    run->comparisons = 0;
+}
+
+static void sort(void *context) {
+    Run *run = (Run *)context;
+    CFComparatorFunction comparator = (sizeof(CFIndex) == run->elementSize) ? compareIndexes : compareRecords;
+    if (run->merge) {
+        CFMergeSortArray(run->list, run->count, run->elementSize, comparator, run);
+    } else {
+        CFQSortArray(run->list, run->count, run->elementSize, comparator, run);
+    }
+}
+
+typedef struct {
+    CFMutableArrayRef array;
+    const void **values;
+    CFIndex count;
+    Run run;
+} ArrayRun;
+
+static void setupArray(void *context) {
+    ArrayRun *arrayRun = (ArrayRun *)context;
+    CFArrayRemoveAllValues(arrayRun->array);
+    CFArrayReplaceValues(arrayRun->array, CFRangeMake(0, 0), arrayRun->values, arrayRun->count);
+    arrayRun->run.comparisons = 0;
+}
+
+static void sortArray(void *context) {
+    ArrayRun *arrayRun = (ArrayRun *)context;
+    CFArraySortValues(arrayRun->array, CFRangeMake(0, arrayRun->count), compareValues, &arrayRun->run);
+}
+
+// Arrays whose callbacks set only one of retain and release took a quadratic path, hence the smaller counts
+static void measureArraySort(void) {
+    static const CFIndex counts[] = {1000, 4000, 16000};
+    for (int retainOnly = 0; retainOnly <= 1; retainOnly++) {
+        CFArrayCallBacks callBacks = {0, retainOnly ? retainValue : NULL, NULL, NULL, NULL};
+        for (unsigned idx = 0; idx < sizeof(counts) / sizeof(counts[0]); idx++) {
+            ArrayRun arrayRun = {CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &callBacks), (const void **)malloc(counts[idx] * sizeof(void *)), counts[idx], {0}};
+            for (CFIndex value = 0; value < counts[idx]; value++) arrayRun.values[value] = (const void *)(uintptr_t)(1 + nextRandom() % 1000000000);
+            double seconds = bestTime(setupArray, sortArray, &arrayRun);
+            printf("CFArraySortValues %-11s %6ld values %8.1f ns/element %8.2f comparisons/element\n", retainOnly ? "retain only" : "no retain", (long)counts[idx], seconds * 1.0e9 / counts[idx], (double)arrayRun.run.comparisons / counts[idx]);
+            free(arrayRun.values);
+            CFRelease(arrayRun.array);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    CFIndex count = (1 < argc) ? atol(argv[1]) : 1000000;
+    static const CFIndex elementSizes[] = {sizeof(CFIndex), sizeof(Record)};
+    printf("%ld elements, best of %d runs\n", (long)count, BENCHMARK_RUNS);
+    for (unsigned size = 0; size < sizeof(elementSizes) / sizeof(elementSizes[0]); size++) {
+        Run run = {count, elementSizes[size], malloc(count * elementSizes[size]), malloc(count * elementSizes[size]), false, 0};
+        for (int order = 0; order < OrderCount; order++) {
+            for (CFIndex idx = 0; idx < count; idx++) {
+                CFIndex key = keyAt(order, idx, count);
+                if (sizeof(CFIndex) == run.elementSize) {
+                    ((CFIndex *)run.input)[idx] = key;
+                } else {
+                    Record record = {key, {idx, -idx}};
+                    ((Record *)run.input)[idx] = record;
+                }
+            }
+            for (int merge = 0; merge <= 1; merge++) {
+                run.merge = merge;
+                double seconds = bestTime(setup, sort, &run);
+                printf("%-16s %2ld-byte %-10s %8.1f ns/element %6.2f comparisons/element\n", merge ? "CFMergeSortArray" : "CFQSortArray", (long)run.elementSize, orderNames[order], seconds * 1.0e9 / count, (double)run.comparisons / count);
+            }
+        }
+        free(run.input);
+        free(run.list);
+    }
+    measureArraySort();
+    return 0;
+}
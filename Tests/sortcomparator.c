@@ -0,0 +1,166 @@
+// Sorts with comparators where cmp(a, b) and cmp(b, a) disagree. CFArraySortValues(), CFQSortArray() and CFMergeSortArray()
+// must still finish, touch nothing outside the range they were given and leave the values a permutation of what they were.
+// Writes outside the range are caught by guard values and reads by checking every value the comparator is passed;
+// build with -fsanitize=address as well to have any other stray access reported.
+//
+// Mac OS X: clang -F<path-to-CFLite-framework> -framework CoreFoundation sortcomparator.c -o sortcomparator
+// Linux: clang -I/usr/local/include -L/usr/local/lib -lCoreFoundation sortcomparator.c -o sortcomparator
+//
+// Exits nonzero on any failure, or if a sort has not finished within a minute.
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreFoundation/CFPriv.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "TestSupport.h"
+
+#define VALUE_BASE 0x10000
+#define GUARD_VALUE ((uintptr_t)0xDEADBEEF)
+#define GUARD_COUNT 8
+
+enum {
+    AlwaysLess,		// cmp(a, b) and cmp(b, a) both say less
+    AlwaysGreater,	// and both say greater
+    LessOnTies,		// orders by a coarse key, but equal keys always compare less
+    Random,
+    LiesLater,		// consistent at first, random once the sort is well under way
+    ModeCount
+};
+
+static const char *const modeNames[] = {"always less", "always greater", "less on ties", "random", "lies later"};
+
+typedef struct {
+    int mode;
+    CFIndex count;
+    CFIndex calls;
+    const char *test;
+} Context;
+
+static void fail(const Context *context, const char *what) {
+    FAIL("%s, %s comparator, %ld values: %s", context->test, modeNames[context->mode], (long)context->count, what);
+}
+
+static void checkValue(Context *context, uintptr_t value) {
+    if (value < VALUE_BASE || VALUE_BASE + context->count <= value) fail(context, "comparator was passed a value from outside the range");
+}
+
+static CFComparisonResult compare(uintptr_t a, uintptr_t b, Context *context) {
+    checkValue(context, a);
+    checkValue(context, b);
+    context->calls++;
+    switch (context->mode) {
+    case AlwaysLess: return kCFCompareLessThan;
+    case AlwaysGreater: return kCFCompareGreaterThan;
+    case LessOnTies: return (a % 5 < b % 5) ? kCFCompareLessThan : (a % 5 > b % 5) ? kCFCompareGreaterThan : kCFCompareLessThan;
+    case LiesLater: if (context->calls < context->count) return (a < b) ? kCFCompareLessThan : (a > b) ? kCFCompareGreaterThan : kCFCompareEqualTo;
+    }
+    return (CFComparisonResult)((int)(nextRandom() % 3) - 1);
+}
+
+static CFComparisonResult compareValues(const void *a, const void *b, void *info) {
+    return compare((uintptr_t)a, (uintptr_t)b, (Context *)info);
+}
+
+// The sorts may also pass pointers to their own copies of elements, so only the values are checked
+static CFComparisonResult compareElements(const void *a, const void *b, void *info) {
+    return compare(*(const uintptr_t *)a, *(const uintptr_t *)b, (Context *)info);
+}
+
+// Whether values holds each of VALUE_BASE ..< VALUE_BASE + count exactly once
+static void checkPermutation(Context *context, const uintptr_t *values) {
+    unsigned char *seen = (unsigned char *)calloc(context->count + 1, 1);
+    for (CFIndex idx = 0; idx < context->count; idx++) {
+        uintptr_t value = values[idx];
+        if (value < VALUE_BASE || VALUE_BASE + context->count <= value || seen[value - VALUE_BASE]++) {
+            fail(context, "values are no longer a permutation of the input");
+            break;
+        }
+    }
+    free(seen);
+}
+
+static void shuffle(uintptr_t *values, CFIndex count) {
+    for (CFIndex idx = 0; idx < count; idx++) values[idx] = VALUE_BASE + idx;
+    for (CFIndex idx = count - 1; 0 < idx; idx--) {
+        CFIndex other = (CFIndex)(nextRandom() % (idx + 1));
+        uintptr_t value = values[idx];
+        values[idx] = values[other];
+        values[other] = value;
+    }
+}
+
+static void checkListSort(int mode, CFIndex count, Boolean merge) {
+    uintptr_t *storage = (uintptr_t *)malloc((count + 2 * GUARD_COUNT) * sizeof(uintptr_t));
+    uintptr_t *list = storage + GUARD_COUNT;
+    for (CFIndex idx = 0; idx < GUARD_COUNT; idx++) storage[idx] = list[count + idx] = GUARD_VALUE;
+    shuffle(list, count);
+    Context context = {mode, count, 0, merge ? "CFMergeSortArray" : "CFQSortArray"};
+    if (merge) {
+        CFMergeSortArray(list, count, sizeof(uintptr_t), compareElements, &context);
+    } else {
+        CFQSortArray(list, count, sizeof(uintptr_t), compareElements, &context);
+    }
+    for (CFIndex idx = 0; idx < GUARD_COUNT; idx++) {
+        if (GUARD_VALUE != storage[idx] || GUARD_VALUE != list[count + idx]) {
+            fail(&context, "wrote outside the list");
+            break;
+        }
+    }
+    checkPermutation(&context, list);
+    free(storage);
+}
+
+static CFIndex retainCount = 0;
+
+static const void *countingRetain(CFAllocatorRef allocator, const void *value) {
+    retainCount++;
+    return value;
+}
+
+// Sorts all but the first and last values, so a stray write shows up in them
+static void checkArraySort(int mode, CFIndex count, Boolean retainOnly) {
+    CFArrayCallBacks callBacks = {0, retainOnly ? countingRetain : NULL, NULL, NULL, NULL};
+    CFMutableArrayRef array = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &callBacks);
+    uintptr_t *values = (uintptr_t *)malloc((count + 2) * sizeof(uintptr_t));
+    shuffle(values + 1, count);
+    values[0] = values[count + 1] = GUARD_VALUE;
+    for (CFIndex idx = 0; idx < count + 2; idx++) CFArrayAppendValue(array, (const void *)values[idx]);
+    CFIndex retained = retainCount;
+    Context context = {mode, count, 0, retainOnly ? "CFArraySortValues (retain only)" : "CFArraySortValues"};
+    CFArraySortValues(array, CFRangeMake(1, count), compareValues, &context);
+    if (CFArrayGetCount(array) != count + 2) fail(&context, "count changed");
+    CFArrayGetValues(array, CFRangeMake(0, count + 2), (const void **)values);
+    if (GUARD_VALUE != values[0] || GUARD_VALUE != values[count + 1]) fail(&context, "wrote outside the range");
+    if (retainCount != retained) fail(&context, "retained values while sorting");
+    checkPermutation(&context, values + 1);
+    free(values);
+    CFRelease(array);
+}
+
+static void timedOut(int signal) {
+    static const char message[] = "FAIL: a sort did not finish\n";
+    write(STDOUT_FILENO, message, sizeof(message) - 1);
+    _exit(1);
+}
+
+int main(int argc, char **argv) {
+    static const CFIndex counts[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 12, 16, 17, 23, 24, 25, 31, 32, 33, 40, 64, 100, 257, 1000, 4096, 50000};
+    signal(SIGALRM, timedOut);
+    alarm(60);
+    for (int mode = 0; mode < ModeCount; mode++) {
+        for (unsigned idx = 0; idx < sizeof(counts) / sizeof(counts[0]); idx++) {
+            for (int repeat = 0; repeat < ((counts[idx] < 1000) ? 20 : 2); repeat++) {
+                checkListSort(mode, counts[idx], false);
+                checkListSort(mode, counts[idx], true);
+                checkArraySort(mode, counts[idx], false);
+                checkArraySort(mode, counts[idx], true);
+            }
+        }
+    }
+    return reportFailures();
+}
@@ -0,0 +1,127 @@
+// Checks that CFSortedDictionary never passes a NULL value to its value callbacks, on any path that stores or drops a
+// value: adding, replacing in either direction, removing, bulk creation with and without a values array, comparing,
+// describing and deallocating.  The callbacks count what they are given, so the retains and releases must also balance.
+//
+// Mac OS X: clang -F<path-to-CFLite-framework> -framework CoreFoundation sorteddictionary.c -o sorteddictionary
+// Linux: clang -I/usr/local/include -L/usr/local/lib -lCoreFoundation sorteddictionary.c -o sorteddictionary
+//
+// Exits nonzero on any failure.
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreFoundation/CFSortedDictionary.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TestSupport.h"
+
+#define COUNT 1000
+
+static long retained = 0;
+
+static const void *retainValue(CFAllocatorRef allocator, const void *value) {
+    if (!value) FAIL("retain was passed NULL");
+    retained++;
+    return value;
+}
+
+static void releaseValue(CFAllocatorRef allocator, const void *value) {
+    if (!value) FAIL("release was passed NULL");
+    retained--;
+}
+
+static CFStringRef describeValue(const void *value) {
+    if (!value) FAIL("copyDescription was passed NULL");
+    return CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("value %p"), value);
+}
+
+static Boolean equalValues(const void *a, const void *b) {
+    if (!a || !b) FAIL("equal was passed NULL");
+    return a == b;
+}
+
+static const CFDictionaryValueCallBacks callBacks = {0, retainValue, releaseValue, describeValue, equalValues};
+
+// Every third key gets a NULL value, the others a value derived from the key
+static const void *valueFor(uintptr_t key) {
+    return (0 == key % 3) ? NULL : (const void *)(key * 16);
+}
+
+static CFSortedDictionaryRef create(void) {
+    CFSortedDictionaryRef dict = CFSortedDictionaryCreateMutable(kCFAllocatorSystemDefault, NULL, NULL, NULL, &callBacks);
+    for (uintptr_t key = 1; key <= COUNT; key++) CFSortedDictionaryAddValue(dict, (const void *)key, valueFor(key));
+    return dict;
+}
+
+static void checkBalance(const char *what, long expected) {
+    if (retained != expected) FAIL("%s: %ld values retained, expected %ld", what, retained, expected);
+}
+
+// Values that are not NULL, as valueFor() gives them for keys 1 ... count
+static long retainedFor(long count) {
+    return count - count / 3;
+}
+
+static void checkMutations(void) {
+    CFSortedDictionaryRef dict = create();
+    checkBalance("add", retainedFor(COUNT));
+    for (uintptr_t key = 1; key <= COUNT; key++) {
+        const void *value = NULL;
+        if (!CFSortedDictionaryGetValueIfPresent(dict, (const void *)key, &value) || value != valueFor(key)) FAIL("key %lu has the wrong value", (unsigned long)key);
+    }
+    // NULL replaced by a value and a value by NULL, then both put back
+    for (uintptr_t key = 1; key <= COUNT; key++) CFSortedDictionarySetValue(dict, (const void *)key, valueFor(key) ? NULL : (const void *)(key * 16));
+    checkBalance("set", COUNT - retainedFor(COUNT));
+    for (uintptr_t key = 1; key <= COUNT; key++) CFSortedDictionarySetValue(dict, (const void *)key, valueFor(key));
+    checkBalance("set back", retainedFor(COUNT));
+    CFSortedDictionaryRef other = create();
+    if (!CFEqual(dict, other)) FAIL("equal dictionaries compare unequal");
+    CFSortedDictionarySetValue(other, (const void *)3, (const void *)48);
+    if (CFEqual(dict, other)) FAIL("a NULL value compared equal to another value");
+    CFRelease(other);
+    CFRelease(CFCopyDescription(dict));
+    for (uintptr_t key = 1; key <= COUNT; key += 2) CFSortedDictionaryRemoveValue(dict, (const void *)key);
+    long left = 0;
+    for (uintptr_t key = 2; key <= COUNT; key += 2) left += (NULL != valueFor(key));
+    checkBalance("remove", left);
+    CFSortedDictionaryRemoveAllValues(dict);
+    checkBalance("remove all", 0);
+    CFSortedDictionaryAddValue(dict, (const void *)1, NULL);
+    CFSortedDictionaryAddValue(dict, (const void *)2, (const void *)32);
+    CFRelease(dict);
+    checkBalance("deallocate", 0);
+}
+
+static void checkBulkCreation(void) {
+    const void *keys[COUNT], *values[COUNT];
+    for (uintptr_t idx = 0; idx < COUNT; idx++) {
+        keys[idx] = (const void *)(idx + 1);
+        values[idx] = valueFor(idx + 1);
+    }
+    CFSortedDictionaryRef dict = CFSortedDictionaryCreateMutableWithSortedKeysAndValues(kCFAllocatorSystemDefault, NULL, NULL, NULL, &callBacks, keys, NULL, COUNT);
+    checkBalance("bulk creation without values", 0);
+    CFRelease(dict);
+    dict = CFSortedDictionaryCreateMutableWithSortedKeysAndValues(kCFAllocatorSystemDefault, NULL, NULL, NULL, &callBacks, keys, values, COUNT);
+    checkBalance("bulk creation", retainedFor(COUNT));
+    CFRelease(dict);
+    checkBalance("bulk deallocate", 0);
+}
+
+// A sorted set of CFStrings, with the standard callbacks for values that are all NULL
+static void checkTypeCallBacks(void) {
+    CFSortedDictionaryRef set = CFSortedDictionaryCreateMutable(kCFAllocatorSystemDefault, (CFComparatorFunction)CFStringCompare, NULL, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    CFSortedDictionaryAddValue(set, CFSTR("b"), NULL);
+    CFSortedDictionaryAddValue(set, CFSTR("a"), NULL);
+    CFSortedDictionarySetValue(set, CFSTR("a"), NULL);
+    CFSortedDictionaryRemoveValue(set, CFSTR("b"));
+    CFRelease(CFCopyDescription(set));
+    if (1 != CFSortedDictionaryGetCount(set) || !CFSortedDictionaryContainsKey(set, CFSTR("a"))) FAIL("sorted set has the wrong keys");
+    CFRelease(set);
+}
+
+int main(int argc, char **argv) {
+    checkMutations();
+    checkBulkCreation();
+    checkTypeCallBacks();
+    return reportFailures();
+}
@@ -0,0 +1,106 @@
+// Times CFStorage at 1MB, 10MB and 100MB of 8-byte values: single values inserted and deleted at random indexes,
+// random CFStorageGetValueAtIndex() calls, CFStorageGetValues() of the whole storage, and enumeration of the whole
+// storage by CFStorageApplyFunction() and by CFStorageApplyBlock(), serial and concurrent.
+//
+// Mac OS X: clang -O2 -F<path-to-CFLite-framework> -framework CoreFoundation storagebenchmark.c -o storagebenchmark
+// Linux: clang -O2 -fblocks -I/usr/local/include -L/usr/local/lib -lCoreFoundation storagebenchmark.c -o storagebenchmark
+//
+// Run with an optional largest size in bytes (default 100000000).
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreFoundation/CFStorage.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TestSupport.h"
+
+#define EDITS 1000
+#define LOOKUPS 1000000
+
+typedef struct {
+    CFStorageRef storage;
+    CFIndex count;
+    uint64_t *values;
+    uint64_t sum;
+} Run;
+
+static void insertValues(void *context) {
+    Run *run = (Run *)context;
+    for (int idx = 0; idx < EDITS; idx++) {
+        CFIndex at = (CFIndex)(nextRandom() % (run->count + 1));
+        CFStorageInsertValues(run->storage, CFRangeMake(at, 1));
+        *(uint64_t *)CFStorageGetValueAtIndex(run->storage, at, NULL) = at;
+        run->count++;
+    }
+}
+
+static void deleteValues(void *context) {
+    Run *run = (Run *)context;
+    for (int idx = 0; idx < EDITS; idx++) {
+        CFStorageDeleteValues(run->storage, CFRangeMake((CFIndex)(nextRandom() % run->count), 1));
+        run->count--;
+    }
+}
+
+static void getValueAtIndex(void *context) {
+    Run *run = (Run *)context;
+    for (int idx = 0; idx < LOOKUPS; idx++) run->sum += *(const uint64_t *)CFStorageGetConstValueAtIndex(run->storage, (CFIndex)(nextRandom() % run->count), NULL);
+}
+
+static void getValues(void *context) {
+    Run *run = (Run *)context;
+    CFStorageGetValues(run->storage, CFRangeMake(0, run->count), run->values);
+}
+
+static void addValue(const void *value, void *context) {
+    ((Run *)context)->sum += *(const uint64_t *)value;
+}
+
+static void applyFunction(void *context) {
+    Run *run = (Run *)context;
+    CFStorageApplyFunction(run->storage, CFRangeMake(0, run->count), addValue, run);
+}
+
+static void applyBlock(Run *run, CFStorageEnumerationOptionFlags options) {
+    __block uint64_t sum = 0;
+    CFStorageApplyBlock(run->storage, CFRangeMake(0, run->count), options, ^(const void *vals, CFRange range, bool *stop) {
+        uint64_t partial = 0;
+        for (CFIndex idx = 0; idx < range.length; idx++) partial += ((const uint64_t *)vals)[idx];
+        __sync_fetch_and_add(&sum, partial);
+    });
+    run->sum += sum;
+}
+
+static void applyBlockSerially(void *context) {
+    applyBlock((Run *)context, 0);
+}
+
+static void applyBlockConcurrently(void *context) {
+    applyBlock((Run *)context, kCFStorageEnumerationConcurrent);
+}
+
+static void measure(CFIndex bytes) {
+    Run run = {CFStorageCreate(kCFAllocatorSystemDefault, sizeof(uint64_t)), bytes / sizeof(uint64_t), (uint64_t *)malloc(bytes), 0};
+    for (CFIndex idx = 0; idx < run.count; idx++) run.values[idx] = idx;
+    CFStorageInsertValues(run.storage, CFRangeMake(0, run.count));
+    CFStorageReplaceValues(run.storage, CFRangeMake(0, run.count), run.values);
+    double megabytes = bytes / 1.0e6;
+    printf("%6.0fMB: insert at random index  %8.0f ns/value\n", megabytes, bestTime(NULL, insertValues, &run) * 1.0e9 / EDITS);
+    printf("%6.0fMB: delete at random index  %8.0f ns/value\n", megabytes, bestTime(NULL, deleteValues, &run) * 1.0e9 / EDITS);
+    printf("%6.0fMB: GetValueAtIndex, random %8.1f ns/value\n", megabytes, bestTime(NULL, getValueAtIndex, &run) * 1.0e9 / LOOKUPS);
+    printf("%6.0fMB: GetValues, all          %8.3f ms/MB\n", megabytes, bestTime(NULL, getValues, &run) * 1.0e3 / megabytes);
+    printf("%6.0fMB: ApplyFunction, all      %8.3f ms/MB\n", megabytes, bestTime(NULL, applyFunction, &run) * 1.0e3 / megabytes);
+    printf("%6.0fMB: ApplyBlock, serial      %8.3f ms/MB\n", megabytes, bestTime(NULL, applyBlockSerially, &run) * 1.0e3 / megabytes);
+    printf("%6.0fMB: ApplyBlock, concurrent  %8.3f ms/MB\n", megabytes, bestTime(NULL, applyBlockConcurrently, &run) * 1.0e3 / megabytes);
+    if (0 == run.sum) FAIL("no values were read");
+    free(run.values);
+    CFRelease(run.storage);
+}
+
+int main(int argc, char **argv) {
+    CFIndex largest = (1 < argc) ? atol(argv[1]) : 100000000;
+    printf("best of %d runs\n", BENCHMARK_RUNS);
+    for (CFIndex bytes = 1000000; bytes <= largest; bytes *= 10) measure(bytes);
+    return reportFailures();
+}